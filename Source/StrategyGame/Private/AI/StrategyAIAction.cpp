@@ -7,36 +7,44 @@
 
 UStrategyAIAction::UStrategyAIAction(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
-	, bIsExecuted(false)
 {
 }
 
-bool UStrategyAIAction::Tick(float DeltaTime) 
-{ 
-	return false; 
+bool UStrategyAIAction::Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const
+{
+	return false;
 }
 
-bool UStrategyAIAction::ShouldActivate() const 
-{ 
-	return false; 
+bool UStrategyAIAction::ShouldActivate(AStrategyAIController* Controller) const
+{
+	return false;
 }
 
-void UStrategyAIAction::Abort() 
+void UStrategyAIAction::Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	bIsExecuted = false; 
+	State.bIsExecuted = false;
 }
 
-bool UStrategyAIAction::IsSafeToAbort() const 
-{ 
-	return true; 
+bool UStrategyAIAction::IsSafeToAbort(const FStrategyAIActionState& State) const
+{
+	return true;
 }
 
-void UStrategyAIAction::Activate()
-{ 		
-	bIsExecuted = true; 
+void UStrategyAIAction::Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const
+{
+	State.Reset();
+	State.bIsExecuted = true;
 }
 
-void UStrategyAIAction::SetController(AStrategyAIController* InOwner)
-{ 
-	MyAIController = InOwner; 
+void UStrategyAIAction::OnMoveCompleted(AStrategyAIController* Controller, FStrategyAIActionState& State) const
+{
+}
+
+void UStrategyAIAction::NotifyBump(AStrategyAIController* Controller, FStrategyAIActionState& State, FHitResult const& Hit) const
+{
+}
+
+const UStrategyAIAction* UStrategyAIAction::GetShared(TSubclassOf<UStrategyAIAction> ActionClass)
+{
+	return ActionClass ? ActionClass->GetDefaultObject<UStrategyAIAction>() : nullptr;
 }
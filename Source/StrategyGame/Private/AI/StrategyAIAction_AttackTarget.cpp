@@ -3,82 +3,92 @@
 #include "StrategyGame.h"
 #include "StrategyAIAction_AttackTarget.h"
 #include "StrategyAIController.h"
+#include "StrategyAttackSlots.h"
 #include "VisualLogger/VisualLogger.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Attack move requests"), STAT_StrategyAttackMoveRequests, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Attack move bump stops"), STAT_StrategyAttackBumpStops, STATGROUP_StrategyGame);
+
+/** slot moving this far from our move destination makes us follow it */
+static const float SlotRepathDistance = 100.0f;
+
 UStrategyAIAction_AttackTarget::UStrategyAIAction_AttackTarget(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
-, MeleeAttackAnimationEndTime(0)
-, bIsPlayingAnimation(false)
-, bMovingToTarget(false)
 {
 	// Non-property initialization
 }
 
 /** function to register as Update delegate for this action */
-bool UStrategyAIAction_AttackTarget::Tick(float DeltaTime)
+bool UStrategyAIAction_AttackTarget::Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const
 {
-	check(MyAIController.IsValid());
-	Super::Tick(DeltaTime);
+	check(Controller);
+	Super::Tick(Controller, State, DeltaTime);
 
-	UpdateTargetInformation();
+	UpdateTargetInformation(Controller, State);
 
-	bIsPlayingAnimation = MyAIController->GetWorld()->GetTimeSeconds() < MeleeAttackAnimationEndTime;
-	if (!bIsPlayingAnimation)
+	State.bIsPlayingAnimation = Controller->GetWorld()->GetTimeSeconds() < State.MeleeAttackAnimationEndTime;
+	if (!State.bIsPlayingAnimation)
 	{
-		if (!TargetActor.IsValid())
+		if (GetTargetActor(Controller, State) == nullptr)
 		{
 			return false;
 		}
 
 		// try move closer if needed again
-		MoveCloser();
+		UpdateSlotMove(Controller, State);
+		MoveCloser(Controller, State);
 
-		if (!bMovingToTarget)
+		if (!State.bIsMoving && !State.bWaitingForSlot)
 		{
-			ABaseCharacter* const MyChar = Cast<ABaseCharacter>(MyAIController->GetPawn());
+			ABaseCharacter* const MyChar = Cast<ABaseCharacter>(Controller->GetPawn());
 			if (MyChar != NULL)
 			{
-				MeleeAttackAnimationEndTime = MyAIController->GetWorld()->GetTimeSeconds() + MyChar->PlayAttackAnim();
-				bIsPlayingAnimation = true;
+				State.MeleeAttackAnimationEndTime = Controller->GetWorld()->GetTimeSeconds() + MyChar->PlayAttackAnim();
+				State.bIsPlayingAnimation = true;
 			}
 		}
 
-		return MyAIController->IsTargetValid(TargetActor.Get());
+		return Controller->IsTargetValid(GetTargetActor(Controller, State));
 	}
 
 	return true;
 }
 
-void UStrategyAIAction_AttackTarget::UpdateTargetInformation()
+void UStrategyAIAction_AttackTarget::UpdateTargetInformation(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	AActor* const OldTargetActor = TargetActor.Get();
-	if (MyAIController->CurrentTarget != TargetActor.Get())
-	{
-		TargetActor = MyAIController->CurrentTarget;
-	}
+	const FStrategyEntityHandle OldTarget = State.Target;
+	State.Target = FStrategyEntityTable::GetHandle(Controller->CurrentTarget);
 
-	if (OldTargetActor != TargetActor.Get() && bMovingToTarget)
+	if (OldTarget != State.Target)
 	{
-		bMovingToTarget = false;
+		if (State.bIsMoving)
+		{
+			Controller->CancelAsyncMove();
+		}
+		State.bIsMoving = false;
+		State.bWaitingForSlot = false;
+		ReleaseSlot(Controller, State);
 	}
 
-	if (MyAIController->IsTargetValid(TargetActor.Get()) )
+	AActor* const TargetActor = GetTargetActor(Controller, State);
+	if (Controller->IsTargetValid(TargetActor))
 	{
-		MyAIController->SetFocus(TargetActor.Get());
+		Controller->SetFocus(TargetActor);
 	}
 }
 
-void UStrategyAIAction_AttackTarget::MoveCloser()
+void UStrategyAIAction_AttackTarget::MoveCloser(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
+	check(Controller);
 
-	if (bIsPlayingAnimation || bMovingToTarget || TargetActor == nullptr)
+	AActor* const TargetActor = GetTargetActor(Controller, State);
+	if (State.bIsPlayingAnimation || State.bIsMoving || TargetActor == nullptr)
 	{
 		return;
 	}
 		
-	TargetDestination = TargetActor->GetActorLocation();
-	ABaseCharacter* const MyChar = Cast<ABaseCharacter>(MyAIController->GetPawn());
+	State.Destination = TargetActor->GetActorLocation();
+	ABaseCharacter* const MyChar = Cast<ABaseCharacter>(Controller->GetPawn());
 	if( MyChar == nullptr )
 	{
 		UE_LOG(LogStrategyAI, Warning, TEXT("Invalid Char/Pawn in Move Closer")); 
@@ -88,82 +98,168 @@ void UStrategyAIAction_AttackTarget::MoveCloser()
 	check(MyChar->GetDefaultPawnData());
 
 	const float AttackDistance = MyChar->GetDefaultPawnData()->AttackDistance;
-	const float Dist = (TargetDestination - MyAIController->GetAdjustLocation()).Size2D();
+	const float Dist = (State.Destination - Controller->GetAdjustLocation()).Size2D();
 
 	if (Dist > AttackDistance)
 	{
-		UE_VLOG(MyAIController.Get(), LogStrategyAI, Log, TEXT("Let's move closer")); 
-		bMovingToTarget = true;
-		MyAIController->MoveToActor(TargetActor.Get(), 0.9 * AttackDistance);
+		// spread around the target instead of everybody walking to the same spot
+		FStrategyAttackSlots* const AttackSlots = GetAttackSlots(Controller);
+		if (AttackSlots != nullptr)
+		{
+			// waiting attackers try for a closer spot every time
+			if (State.bWaitingForSlot)
+			{
+				AttackSlots->Release(MyChar);
+			}
+			State.bHasSlot = AttackSlots->Claim(TargetActor, MyChar, AttackDistance, State.Destination);
+		}
+		State.bWaitingForSlot = false;
+
+		const float Radius = MyChar->GetSimpleCollisionRadius();
+		if (State.bHasSlot && (State.Destination - Controller->GetAdjustLocation()).Size2D() <= 2.0f * Radius)
+		{
+			// standing on our slot already, attack from here unless it's a queue spot out of reach
+			float TargetRadius = 0.0f;
+			float TargetHalfHeight = 0.0f;
+			TargetActor->GetSimpleCollisionCylinder(TargetRadius, TargetHalfHeight);
+			const float SlotDist = (State.Destination - TargetActor->GetActorLocation()).Size2D();
+			State.bWaitingForSlot = SlotDist > FMath::Max(AttackDistance, TargetRadius + 2.0f * Radius);
+			return;
+		}
+
+		UE_VLOG(Controller, LogStrategyAI, Log, TEXT("Let's move closer")); 
+		INC_DWORD_STAT(STAT_StrategyAttackMoveRequests);
+		State.bIsMoving = true;
+		if (State.bHasSlot)
+		{
+			Controller->MoveToLocationAsync(State.Destination, Radius, false, false);
+		}
+		else
+		{
+			Controller->MoveToActorAsync(TargetActor, 0.9f * AttackDistance, true);
+		}
+	}
+	else
+	{
+		State.bWaitingForSlot = false;
+	}
+}
+
+void UStrategyAIAction_AttackTarget::UpdateSlotMove(AStrategyAIController* Controller, FStrategyAIActionState& State) const
+{
+	check(Controller);
+
+	FStrategyAttackSlots* const AttackSlots = GetAttackSlots(Controller);
+	APawn* const MyPawn = Controller->GetPawn();
+	AActor* const TargetActor = GetTargetActor(Controller, State);
+	if (!State.bIsMoving || !State.bHasSlot || AttackSlots == nullptr || MyPawn == nullptr || TargetActor == nullptr)
+	{
+		return;
+	}
+
+	const ABaseCharacter* const MyChar = Cast<ABaseCharacter>(MyPawn);
+	const float AttackDistance = MyChar ? MyChar->GetDefaultPawnData()->AttackDistance : 0.0f;
+
+	FVector SlotLocation;
+	if (!AttackSlots->Claim(TargetActor, MyPawn, AttackDistance, SlotLocation) || (SlotLocation - State.Destination).Size2D() < SlotRepathDistance)
+	{
+		return;
+	}
+
+	// target moved, take the best free spot from where we are now
+	AttackSlots->Release(MyPawn);
+	State.bHasSlot = AttackSlots->Claim(TargetActor, MyPawn, AttackDistance, State.Destination);
+	if (State.bHasSlot)
+	{
+		INC_DWORD_STAT(STAT_StrategyAttackMoveRequests);
+		Controller->MoveToLocationAsync(State.Destination, MyPawn->GetSimpleCollisionRadius(), false, false);
+	}
+}
+
+void UStrategyAIAction_AttackTarget::ReleaseSlot(AStrategyAIController* Controller, FStrategyAIActionState& State) const
+{
+	FStrategyAttackSlots* const AttackSlots = State.bHasSlot ? GetAttackSlots(Controller) : nullptr;
+	if (AttackSlots != nullptr && Controller->GetPawn() != nullptr)
+	{
+		AttackSlots->Release(Controller->GetPawn());
 	}
+	State.bHasSlot = false;
+}
+
+FStrategyAttackSlots* UStrategyAIAction_AttackTarget::GetAttackSlots(const AStrategyAIController* Controller)
+{
+	UWorld* const World = Controller ? Controller->GetWorld() : nullptr;
+	AStrategyGameState* const MyGameState = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	return MyGameState ? &MyGameState->GetAttackSlots() : nullptr;
+}
+
+AActor* UStrategyAIAction_AttackTarget::GetTargetActor(const AStrategyAIController* Controller, const FStrategyAIActionState& State)
+{
+	const FStrategyEntityTable* const Entities = Controller ? FStrategyEntityTable::Get(Controller->GetWorld()) : nullptr;
+	return Entities ? Entities->Get(State.Target) : nullptr;
 }
 
-void UStrategyAIAction_AttackTarget::OnMoveCompleted()
+void UStrategyAIAction_AttackTarget::OnMoveCompleted(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	bMovingToTarget = false;
-	if (MyAIController->GetPathFollowingComponent())
+	State.bIsMoving = false;
+	if (Controller->GetPathFollowingComponent())
 	{
-		MyAIController->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
+		Controller->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
 	}
 }
 
-void UStrategyAIAction_AttackTarget::NotifyBump(FHitResult const& Hit)
+void UStrategyAIAction_AttackTarget::NotifyBump(AStrategyAIController* Controller, FStrategyAIActionState& State, FHitResult const& Hit) const
 {
-	check(MyAIController.IsValid());
+	check(Controller);
 
 	// if we hit our target, just stop movement
+	// other enemies are walked around, stopping for them made us path again right away
 	ABaseCharacter* const HitChar = Cast<ABaseCharacter>(Hit.Actor.Get());
-	if (HitChar != NULL && AStrategyGameMode::OnEnemyTeam(HitChar, MyAIController->GetPawn()) && bMovingToTarget)
+	if (HitChar != NULL && AStrategyGameMode::OnEnemyTeam(HitChar, Controller->GetPawn()) && State.bIsMoving
+		&& (!State.bHasSlot || HitChar->GetEntityHandle() == State.Target))
 	{
-		bMovingToTarget = false;
-		if (MyAIController->GetPathFollowingComponent())
+		INC_DWORD_STAT(STAT_StrategyAttackBumpStops);
+		State.bIsMoving = false;
+		Controller->CancelAsyncMove();
+		if (Controller->GetPathFollowingComponent())
 		{
-			MyAIController->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
+			Controller->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
 		}
 	}
 }
 
-void UStrategyAIAction_AttackTarget::Activate()
+void UStrategyAIAction_AttackTarget::Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
-	Super::Activate();
-
-	bIsPlayingAnimation = false;
-	MeleeAttackAnimationEndTime = 0;
-	TargetActor = MyAIController->CurrentTarget;
-
-	FOnBumpEvent BumpDelegate;
-	BumpDelegate.BindUObject(this, &UStrategyAIAction_AttackTarget::NotifyBump);
-	MyAIController->RegisterBumpEventDelegate(BumpDelegate);
+	check(Controller);
+	Super::Activate(Controller, State);
 
-	FOnMovementEvent MovementDelegate;
-	MovementDelegate.BindUObject(this, &UStrategyAIAction_AttackTarget::OnMoveCompleted);
-	MyAIController->RegisterMovementEventDelegate(MovementDelegate);
+	State.Target = FStrategyEntityTable::GetHandle(Controller->CurrentTarget);
 }
 
 
-bool UStrategyAIAction_AttackTarget::IsSafeToAbort() const
+bool UStrategyAIAction_AttackTarget::IsSafeToAbort(const FStrategyAIActionState& State) const
 {
-	return !bIsPlayingAnimation;
+	return !State.bIsPlayingAnimation;
 }
 
-void UStrategyAIAction_AttackTarget::Abort()
+void UStrategyAIAction_AttackTarget::Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
-	Super::Abort();
+	check(Controller);
+	Super::Abort(Controller, State);
 
-	if (bMovingToTarget && MyAIController->GetPathFollowingComponent())
+	if (State.bIsMoving && Controller->GetPathFollowingComponent())
 	{
-		MyAIController->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
+		Controller->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
 	}
-	bMovingToTarget = false;
-	MyAIController->ClearFocus(EAIFocusPriority::Gameplay);
-	MyAIController->UnregisterBumpEventDelegate();
-	MyAIController->UnregisterMovementEventDelegate();
+	Controller->CancelAsyncMove();
+	State.bIsMoving = false;
+	State.bWaitingForSlot = false;
+	ReleaseSlot(Controller, State);
+	Controller->ClearFocus(EAIFocusPriority::Gameplay);
 }
 
-bool UStrategyAIAction_AttackTarget::ShouldActivate() const
+bool UStrategyAIAction_AttackTarget::ShouldActivate(AStrategyAIController* Controller) const
 {
-	check(MyAIController.IsValid());
-	return MyAIController->CurrentTarget != NULL && MyAIController->IsTargetValid(MyAIController->CurrentTarget);
+	check(Controller);
+	return Controller->CurrentTarget != NULL && Controller->IsTargetValid(Controller->CurrentTarget);
 }
@@ -9,114 +9,109 @@
 
 #include "VisualLogger/VisualLogger.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Stuck move aborts"), STAT_StrategyStuckMoveAborts, STATGROUP_StrategyGame);
+
 UStrategyAIAction_MoveToBrewery::UStrategyAIAction_MoveToBrewery(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 	, TargetAcceptanceRadius(150)
-	, Destination(FVector::ZeroVector)
-	, bIsMoving(false)
-	, NotMovingFromTime(0)
 {
 }
 
-bool UStrategyAIAction_MoveToBrewery::IsSafeToAbort() const
+bool UStrategyAIAction_MoveToBrewery::IsSafeToAbort(const FStrategyAIActionState& State) const
 {
 	return true;
 }
 
-void UStrategyAIAction_MoveToBrewery::Abort()
+void UStrategyAIAction_MoveToBrewery::Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
-	Super::Abort();
+	check(Controller);
+	Super::Abort(Controller, State);
 
-	bIsMoving = false;
-	Destination = FVector::ZeroVector;
-	if (MyAIController->GetPathFollowingComponent())
+	State.bIsMoving = false;
+	State.Destination = FVector::ZeroVector;
+	Controller->CancelAsyncMove();
+	if (Controller->GetPathFollowingComponent())
 	{
-		MyAIController->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
+		Controller->GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::OwnerFinished);
 	}
-	MyAIController->UnregisterMovementEventDelegate();
 }
 
-void UStrategyAIAction_MoveToBrewery::Activate()
+FVector UStrategyAIAction_MoveToBrewery::GetEnemyBreweryLocation(const AStrategyAIController* Controller)
 {
-	check(MyAIController.IsValid());
-	Super::Activate();
-
-	NotMovingFromTime = 0;
 	// find brewery base and cache it's destination
-	const FPlayerData* TeamData = MyAIController->GetTeamData();
+	const FPlayerData* TeamData = Controller->GetTeamData();
 	if (TeamData != NULL && TeamData->Brewery != NULL && TeamData->Brewery->GetAIDirector() != NULL)
 	{
 		const AActor* Actor = TeamData->Brewery->GetAIDirector()->GetEnemyBrewery();
 		if (Actor != NULL)
 		{
-			bIsMoving = true;
-			Destination = Actor->GetActorLocation();
-			MyAIController->MoveToLocation(Destination, TargetAcceptanceRadius, true, true, true);
+			return Actor->GetActorLocation();
 		}
 	}
+	return FVector::ZeroVector;
+}
+
+void UStrategyAIAction_MoveToBrewery::Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const
+{
+	check(Controller);
+	Super::Activate(Controller, State);
 
-	FOnMovementEvent MovementDelegate;
-	MovementDelegate.BindUObject(this, &UStrategyAIAction_MoveToBrewery::OnMoveCompleted);
-	MyAIController->RegisterMovementEventDelegate(MovementDelegate);
+	State.Destination = GetEnemyBreweryLocation(Controller);
+	if (State.Destination != FVector::ZeroVector)
+	{
+		State.bIsMoving = true;
+		// every unit of the team walks the same way, share the corridor
+		Controller->MoveToLocationAsync(State.Destination, TargetAcceptanceRadius, true, true);
+	}
 }
 
-bool UStrategyAIAction_MoveToBrewery::Tick(float DeltaTime)
+bool UStrategyAIAction_MoveToBrewery::Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const
 {
-	if (bIsMoving && MyAIController.IsValid())
+	if (State.bIsMoving && Controller != NULL)
 	{
-		const bool bNoMove = (MyAIController->GetMoveStatus() != EPathFollowingStatus::Moving);
+		const bool bNoMove = (Controller->GetMoveStatus() != EPathFollowingStatus::Moving) && !Controller->HasPendingAsyncMove();
 		if (!bNoMove)
 		{
-			NotMovingFromTime = 0;
+			State.NotMovingFromTime = 0;
 		}
-		else if (NotMovingFromTime == 0)
+		else if (State.NotMovingFromTime == 0)
 		{
-			NotMovingFromTime = MyAIController->GetWorld()->TimeSeconds;
+			State.NotMovingFromTime = Controller->GetWorld()->TimeSeconds;
 		}
 
-		if (bNoMove && (MyAIController->GetWorld()->TimeSeconds - NotMovingFromTime) > 2)
+		if (bNoMove && (Controller->GetWorld()->TimeSeconds - State.NotMovingFromTime) > 2)
 		{
-			Abort();
+			INC_DWORD_STAT(STAT_StrategyStuckMoveAborts);
+			Abort(Controller, State);
 		}
 	}
-	return bIsExecuted && Destination != FVector::ZeroVector && bIsMoving;
+	return State.bIsExecuted && State.Destination != FVector::ZeroVector && State.bIsMoving;
 }
 
-bool UStrategyAIAction_MoveToBrewery::ShouldActivate() const
+bool UStrategyAIAction_MoveToBrewery::ShouldActivate(AStrategyAIController* Controller) const
 {
-	check(MyAIController.IsValid());
-
-	FVector DesiredDestination = FVector::ZeroVector;
-	const FPlayerData* TeamData = MyAIController->GetTeamData();
-	if (TeamData != NULL && TeamData->Brewery != NULL && TeamData->Brewery->GetAIDirector() != NULL)
-	{
-		const AActor* Actor = TeamData->Brewery->GetAIDirector()->GetEnemyBrewery();
-		if (Actor != NULL)
-		{
-			DesiredDestination = Actor->GetActorLocation();
-		}
-	}
+	check(Controller);
 
+	const FVector DesiredDestination = GetEnemyBreweryLocation(Controller);
 	if (DesiredDestination != FVector::ZeroVector)
 	{
-		return ((DesiredDestination - MyAIController->GetAdjustLocation()).Size2D() > TargetAcceptanceRadius);
+		return ((DesiredDestination - Controller->GetAdjustLocation()).Size2D() > TargetAcceptanceRadius);
 	}
 	return false;
 }
 
-void UStrategyAIAction_MoveToBrewery::OnMoveCompleted()
+void UStrategyAIAction_MoveToBrewery::OnMoveCompleted(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	bIsMoving = false;
+	State.bIsMoving = false;
 }
 
-void UStrategyAIAction_MoveToBrewery::OnPathUpdated(INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType)
+void UStrategyAIAction_MoveToBrewery::OnPathUpdated(AStrategyAIController* Controller, FStrategyAIActionState& State, INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType) const
 {
-	check(MyAIController.IsValid());
+	check(Controller);
 
 	if (inType != EPathUpdate::Update)
 	{
-		UE_VLOG(MyAIController.Get(), LogStrategyAI, Log, TEXT("WARRNING, OnPathUpdated with error - PathUpdateTyp %d"), int32(inType)); 
-		Abort();
+		UE_VLOG(Controller, LogStrategyAI, Log, TEXT("WARRNING, OnPathUpdated with error - PathUpdateTyp %d"), int32(inType)); 
+		Abort(Controller, State);
 	}
 }
@@ -6,8 +6,11 @@
 #include "StrategyAISensingComponent.h"
 #include "StrategyAIAction_AttackTarget.h"
 #include "StrategyAIAction_MoveToBrewery.h"
+#include "StrategyPathService.h"
 
 #include "VisualLogger/VisualLogger.h"
+#include "Misc/ScopeExit.h"
+#include "StrategyTelemetry.h"
 
 
 DEFINE_LOG_CATEGORY(LogStrategyAI);
@@ -17,6 +20,7 @@ DEFINE_LOG_CATEGORY(LogStrategyAI);
  */
 AStrategyAIController::AStrategyAIController(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
+	, CurrentAction(nullptr)
 	, bLogicEnabled(true)
 {
 	SensingComponent = CreateDefaultSubobject<UStrategyAISensingComponent>(TEXT("SensingComp"));
@@ -35,20 +39,19 @@ void AStrategyAIController::OnPossess(APawn* inPawn)
 {
 	Super::OnPossess(inPawn);
 	
-	/** Create instances of our possible actions */
+	/** Actions are shared, our state of the running one is kept in ActionState */
 	AllActions.Reset();
 	for(int32 Idx=0; Idx < AllowedActions.Num(); Idx++ )
 	{
-		UStrategyAIAction* Action = NewObject<UStrategyAIAction>(this, AllowedActions[Idx]);
+		const UStrategyAIAction* Action = UStrategyAIAction::GetShared(AllowedActions[Idx]);
 		check(Action);
-		Action->SetController(this);
 		AllActions.Add(Action);
 	}
 
 	ABaseCharacter* const MyChar = Cast<ABaseCharacter>(GetPawn());
 	if (MyChar != NULL && MyChar->GetCharacterMovement() != NULL)
 	{
-		MyChar->GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+		MyChar->GetCharacterMovement()->SetMovementMode(MyChar->GetCharacterMovement()->DefaultLandMovementMode);
 	}
 
 	SetActorTickEnabled(true);
@@ -70,6 +73,7 @@ void AStrategyAIController::OnUnPossess()
 		}
 	}
 
+	CancelAsyncMove();
 	SetActorTickEnabled(false);
 	EnableLogic(false);
 	Super::OnUnPossess();
@@ -85,16 +89,16 @@ void AStrategyAIController::OnMoveCompleted(FAIRequestID RequestID, const FPathF
 {
 	if (CurrentAction != NULL && !Result.IsInterrupted())
 	{
-		OnMoveCompletedDelegate.ExecuteIfBound();
+		CurrentAction->OnMoveCompleted(this, ActionState);
 	}
 }
 
 /** Pawn has hit something */
 void AStrategyAIController::NotifyBump(FHitResult const& Hit)
 {
-	if (CurrentAction != NULL && OnNotifyBumpDelegate.IsBound())
+	if (CurrentAction != NULL)
 	{
-		OnNotifyBumpDelegate.Execute(Hit);
+		CurrentAction->NotifyBump(this, ActionState, Hit);
 	}
 }
 
@@ -111,7 +115,7 @@ bool AStrategyAIController::IsActionAllowed(TSubclassOf<UStrategyAIAction> inCla
 	return false;
 }
 
-UStrategyAIAction* AStrategyAIController::GetInstanceOfAction(TSubclassOf<UStrategyAIAction> inClass) const
+const UStrategyAIAction* AStrategyAIController::GetInstanceOfAction(TSubclassOf<UStrategyAIAction> inClass) const
 {
 	int32 Idx = 0;
 	for (Idx=0; Idx < AllowedActions.Num(); Idx++)
@@ -130,6 +134,20 @@ UStrategyAIAction* AStrategyAIController::GetInstanceOfAction(TSubclassOf<UStrat
 	return NULL;
 }
 
+void AStrategyAIController::ActivateAction(const UStrategyAIAction* NewAction)
+{
+	if (CurrentAction != NULL)
+	{
+		CurrentAction->Abort(this, ActionState);
+	}
+
+	CurrentAction = NewAction;
+	if (CurrentAction != NULL)
+	{
+		CurrentAction->Activate(this, ActionState);
+	}
+}
+
 bool AStrategyAIController::IsTargetValid(AActor* InActor) const
 {
 	// try to find a character
@@ -162,9 +180,10 @@ void AStrategyAIController::SelectTarget()
 	AActor* BestUnit = NULL;
 	float BestUnitScore = 10000;
 
-	for (int32 Idx = 0; Idx < SensingComponent->KnownTargets.Num(); Idx++)
+	const FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	for (int32 Idx = 0; Entities && Idx < SensingComponent->KnownTargets.Num(); Idx++)
 	{
-		AActor* const TestTarget = SensingComponent->KnownTargets[Idx].Get();
+		AActor* const TestTarget = Entities->Get(SensingComponent->KnownTargets[Idx]);
 		if (TestTarget == NULL || !IsTargetValid(TestTarget) )
 		{
 			continue;
@@ -225,44 +244,64 @@ void AStrategyAIController::SelectTarget()
 	UE_VLOG(this, LogStrategyAI, Log, TEXT("Selected target: %s"), CurrentTarget != NULL ? *CurrentTarget->GetName() : TEXT("NONE") ); 
 }
 
-void AStrategyAIController::ClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController)
-{
-	ClaimedBy.AddUnique(InController);
-}
-
-void AStrategyAIController::UnClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController)
+void AStrategyAIController::ClaimAsTarget(const AStrategyAIController* InController)
 {
-	for (int32 Idx = ClaimedBy.Num() - 1; Idx >= 0; Idx--)
+	const FStrategyEntityHandle Handle = InController ? FStrategyEntityTable::GetHandle(InController->GetPawn()) : FStrategyEntityHandle();
+	if (Handle.IsSet())
 	{
-		const AStrategyAIController* TestC = Cast<AStrategyAIController>(ClaimedBy[Idx].Get());
-		if (TestC != NULL && TestC == InController.Get())
+		// drop claims of attackers which are gone, before adding new one
+		const FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+		if (Entities)
 		{
-			ClaimedBy.RemoveAt(Idx);
+			ClaimedBy.RemoveAllSwap([Entities](const FStrategyEntityHandle& Claim) { return !Entities->IsValid(Claim); });
 		}
+		ClaimedBy.AddUnique(Handle);
 	}
 }
 
-bool AStrategyAIController::IsClaimedBy(TWeakObjectPtr<AStrategyAIController> InController) const
+void AStrategyAIController::UnClaimAsTarget(const AStrategyAIController* InController)
 {
-	for (int32 Idx = ClaimedBy.Num() - 1; Idx >= 0; Idx--)
-	{
-		const AStrategyAIController* TestC = Cast<AStrategyAIController>(ClaimedBy[Idx].Get());
-		if (TestC != NULL && TestC == InController.Get())
-		{
-			return true;
-		}
-	}
+	const FStrategyEntityHandle Handle = InController ? FStrategyEntityTable::GetHandle(InController->GetPawn()) : FStrategyEntityHandle();
+	ClaimedBy.RemoveSwap(Handle);
+}
 
-	return false;
+bool AStrategyAIController::IsClaimedBy(const AStrategyAIController* InController) const
+{
+	const FStrategyEntityHandle Handle = InController ? FStrategyEntityTable::GetHandle(InController->GetPawn()) : FStrategyEntityHandle();
+	return Handle.IsSet() && ClaimedBy.Contains(Handle);
 }
 
 int32 AStrategyAIController::GetNumberOfAttackers() const
 {
-	return ClaimedBy.Num();
+	// attackers which died or left play don't count
+	const FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	int32 NumAttackers = 0;
+	for (const FStrategyEntityHandle& Handle : ClaimedBy)
+	{
+		NumAttackers += (Entities && Entities->IsValid(Handle)) ? 1 : 0;
+	}
+	return NumAttackers;
+}
+
+void AStrategyAIController::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(AllActions.GetAllocatedSize() + ClaimedBy.GetAllocatedSize());
 }
 
 void AStrategyAIController::Tick(float DeltaTime)
 {
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	FStrategyTelemetryRecorder* const TelemetryRecorder = MyGameState ? MyGameState->GetTelemetryRecorder() : nullptr;
+	const double StartTime = TelemetryRecorder ? FPlatformTime::Seconds() : 0.0;
+	ON_SCOPE_EXIT
+	{
+		if (TelemetryRecorder)
+		{
+			TelemetryRecorder->AddAITime(FPlatformTime::Seconds() - StartTime);
+		}
+	};
+
 	const ABaseCharacter* MyChar = Cast<ABaseCharacter>(GetPawn());
 	if (!IsLogicEnabled() || MyChar == NULL || (MyChar != NULL && MyChar->GetHealth() <= 0))
 	{
@@ -270,7 +309,7 @@ void AStrategyAIController::Tick(float DeltaTime)
 		{
 			if (CurrentAction != NULL)
 			{
-				CurrentAction->Abort();
+				CurrentAction->Abort(this, ActionState);
 				CurrentAction= NULL;
 			}
 		}
@@ -278,40 +317,35 @@ void AStrategyAIController::Tick(float DeltaTime)
 	}
 	Super::Tick(DeltaTime);
 
-	if (CurrentAction != NULL && !CurrentAction->Tick(DeltaTime) && CurrentAction->IsSafeToAbort() )
+	if (CurrentAction != NULL && !CurrentAction->Tick(this, ActionState, DeltaTime) && CurrentAction->IsSafeToAbort(ActionState) )
 	{
-		UE_VLOG(this, LogStrategyAI, Log, TEXT("Break on '%s' action after Update"), *CurrentAction->GetName()); 
-		CurrentAction->Abort();
+		UE_VLOG(this, LogStrategyAI, Log, TEXT("Break on '%s' action after Update"), *CurrentAction->GetClass()->GetName()); 
+		CurrentAction->Abort(this, ActionState);
 		CurrentAction = NULL;
 	}
 
 	// select best action to execute
-	const bool bCanBreakCurrentAction = CurrentAction != NULL ? CurrentAction->IsSafeToAbort() : true;
+	const bool bCanBreakCurrentAction = CurrentAction != NULL ? CurrentAction->IsSafeToAbort(ActionState) : true;
 	if (bCanBreakCurrentAction)
 	{
 		for (int32 Idx = 0; Idx < AllActions.Num(); Idx++)
 		{
-			if (CurrentAction == AllActions[Idx] && AllActions[Idx]->ShouldActivate())
+			if (CurrentAction == AllActions[Idx] && AllActions[Idx]->ShouldActivate(this))
 			{
 				break;
 			}
 
-			const volatile bool shouldActivate = AllActions[Idx]->ShouldActivate();
+			const volatile bool shouldActivate = AllActions[Idx]->ShouldActivate(this);
 			if (CurrentAction != AllActions[Idx] && shouldActivate)
 			{
 				if (CurrentAction != NULL)
 				{
-					UE_VLOG(this, LogStrategyAI, Log, TEXT("Break on '%s' action, found better one '%s'"), *CurrentAction->GetName(), *AllActions[Idx]->GetName()); 
-					CurrentAction->Abort();
+					UE_VLOG(this, LogStrategyAI, Log, TEXT("Break on '%s' action, found better one '%s'"), *CurrentAction->GetClass()->GetName(), *AllActions[Idx]->GetClass()->GetName()); 
 				}
 
-				CurrentAction = AllActions[Idx];
-				if (CurrentAction != NULL)
-				{
-					UE_VLOG(this, LogStrategyAI, Log, TEXT("Execute on '%s' action"), *CurrentAction->GetName(), *AllActions[Idx]->GetName()); 
-					CurrentAction->Activate();
-					break;
-				}
+				ActivateAction(AllActions[Idx]);
+				UE_VLOG(this, LogStrategyAI, Log, TEXT("Execute on '%s' action"), *CurrentAction->GetClass()->GetName()); 
+				break;
 			}
 		}
 	}
@@ -334,6 +368,53 @@ FVector AStrategyAIController::GetAdjustLocation()
 	return GetPawn() ? GetPawn()->GetActorLocation() : (RootComponent ? RootComponent->GetComponentLocation() : FVector::ZeroVector);
 }
 
+void AStrategyAIController::MoveToLocationAsync(const FVector& Dest, float AcceptanceRadius, bool bStopOnOverlap, bool bCacheCorridor)
+{
+	FStrategyPathService* const PathService = GetPathService();
+	if (PathService != nullptr && GetPawn() != nullptr)
+	{
+		PathService->RequestMove(this, Dest, AcceptanceRadius, bStopOnOverlap, bCacheCorridor);
+	}
+	else
+	{
+		MoveToLocation(Dest, AcceptanceRadius, bStopOnOverlap, true, true);
+	}
+}
+
+void AStrategyAIController::MoveToActorAsync(AActor* Goal, float AcceptanceRadius, bool bStopOnOverlap)
+{
+	FStrategyPathService* const PathService = GetPathService();
+	if (PathService != nullptr && GetPawn() != nullptr && Goal != nullptr)
+	{
+		PathService->RequestMoveToActor(this, Goal, AcceptanceRadius, bStopOnOverlap);
+	}
+	else
+	{
+		MoveToActor(Goal, AcceptanceRadius, bStopOnOverlap);
+	}
+}
+
+void AStrategyAIController::CancelAsyncMove()
+{
+	FStrategyPathService* const PathService = GetPathService();
+	if (PathService != nullptr)
+	{
+		PathService->Cancel(this);
+	}
+}
+
+bool AStrategyAIController::HasPendingAsyncMove() const
+{
+	const FStrategyPathService* const PathService = GetPathService();
+	return PathService != nullptr && PathService->IsPending(this);
+}
+
+FStrategyPathService* AStrategyAIController::GetPathService() const
+{
+	AStrategyGameState* const MyGameState = GetWorld() ? GetWorld()->GetGameState<AStrategyGameState>() : nullptr;
+	return MyGameState ? &MyGameState->GetPathService() : nullptr;
+}
+
 
 #if ENABLE_VISUAL_LOG
 
@@ -343,7 +424,7 @@ void AStrategyAIController::GrabDebugSnapshot(FVisualLogEntry* Snapshot) const
 
 	FVisualLogStatusCategory MyCategory;
 	MyCategory.Category = TEXT("StrategyAIController");
-	MyCategory.Add(TEXT("CurrentAction"), CurrentAction != NULL ? *CurrentAction->GetName() : TEXT("NONE"));
+	MyCategory.Add(TEXT("CurrentAction"), CurrentAction != NULL ? *CurrentAction->GetClass()->GetName() : TEXT("NONE"));
 	MyCategory.Add(TEXT("CurrentTarget"), *GetDebugName(CurrentTarget));
 
 	AStrategyChar* MyChar = Cast<AStrategyChar>(GetPawn());
@@ -360,25 +441,3 @@ void AStrategyAIController::GrabDebugSnapshot(FVisualLogEntry* Snapshot) const
 }
 #endif // ENABLE_VISUAL_LOG
 
-
-void AStrategyAIController::RegisterMovementEventDelegate(FOnMovementEvent InDelegate)
-{
-	OnMoveCompletedDelegate = InDelegate;
-}
-
-void AStrategyAIController::RegisterBumpEventDelegate(FOnBumpEvent InDelegate)
-{
-	OnNotifyBumpDelegate = InDelegate;
-}
-
-void AStrategyAIController::UnregisterMovementEventDelegate()
-{
-	OnMoveCompletedDelegate.Unbind();
-}
-
-void AStrategyAIController::UnregisterBumpEventDelegate()
-{
-	OnNotifyBumpDelegate.Unbind();
-}
-
-
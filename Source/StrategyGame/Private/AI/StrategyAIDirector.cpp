@@ -8,6 +8,7 @@
 #include "StrategyGameBlueprintLibrary.h"
 #include "StrategyAttachment.h"
 #include "ZombieCharacter.h"
+#include "StrategyStressRun.h"
 
 UStrategyAIDirector::UStrategyAIDirector(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -18,6 +19,9 @@ UStrategyAIDirector::UStrategyAIDirector(const FObjectInitializer& ObjectInitial
 	, NextDwarfSpawnTime(0)
 	, NextZombieSpawnTime(0)
 	, MyTeamNum(EStrategyTeam::Unknown)
+	, ScheduledWave(INDEX_NONE)
+	, ScheduledWaveStartTime(0)
+	, NextScheduledSpawn(0)
 {
 	PrimaryComponentTick.bCanEverTick = true;
 	PrimaryComponentTick.bStartWithTickEnabled = false;
@@ -49,12 +53,17 @@ void UStrategyAIDirector::OnGameplayStateChange(EGameplayState::Type NewState)
 	{
 		Activate();
 		NextDwarfSpawnTime = 0;
+		if (WaveSchedule)
+		{
+			StartScheduledWave(0);
+		}
 	}
 }
 
 AStrategyBuilding_Brewery* UStrategyAIDirector::GetEnemyBrewery() const
 {
-	return EnemyBrewery.Get();
+	const FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	return Entities ? Entities->Get<AStrategyBuilding_Brewery>(EnemyBrewery) : nullptr;
 }
 
 void UStrategyAIDirector::SetDefaultArmor(UBlueprint* InArmor)
@@ -120,111 +129,179 @@ struct OffsetsGeneratorHelper
 	}
 };
 
-#pragma optimize("", off)
-void UStrategyAIDirector::SpawnDwarfs()
+void UStrategyAIDirector::SpawnUnit(const FStrategyUnitSpawn& Spawn)
 {
 	static OffsetsGeneratorHelper OffsetsGenerator;
 
+	// find best place on ground to spawn at
+	const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
+	check(Owner);
+	check(Spawn.UnitClass);
+
+	FStrategyUnitSpawn TracedSpawn = Spawn;
+	TracedSpawn.Location = Owner->GetActorLocation();
+	const FVector X = Owner->GetTransform().GetScaledAxis( EAxis::X );
+	const FVector Y = Owner->GetTransform().GetScaledAxis( EAxis::Y );
+	TracedSpawn.Location += X * RadiusToSpawnOn +  Y * OffsetsGenerator.GetOffset();
+
+	// unit is spawned when the ground is found, next frame
+	const FVector TraceOffset(0.0f,0.0f,RadiusToSpawnOn * 0.5 * Spawn.Scale);
+	FCollisionObjectQueryParams ObjectParams( FCollisionObjectQueryParams::AllStaticObjects );
+	FStrategySceneQueries::LineTraceSingleByObjectType(GetWorld(), TracedSpawn.Location + TraceOffset, TracedSpawn.Location - TraceOffset, ObjectParams, FCollisionQueryParams::DefaultQueryParam,
+		FOnStrategySceneQueryDone::CreateUObject(this, &UStrategyAIDirector::OnSpawnGroundFound, TracedSpawn));
+}
+
+void UStrategyAIDirector::OnSpawnGroundFound(const TArray<FHitResult>& Hits, FStrategyUnitSpawn Spawn)
+{
+	ABaseCharacter* const UnitChar = FinishSpawnUnit(Hits, Spawn);
+	if (!Spawn.bRequestedMinion)
+	{
+		if (UnitChar == nullptr)
+		{
+			UE_LOG(LogGame, Warning, TEXT("Failed to spawn scheduled %s."), *GetNameSafe(Spawn.UnitClass));
+		}
+		if (Spawn.WaveIndex != INDEX_NONE)
+		{
+			OnWaveSpawnDone(Spawn.WaveIndex);
+		}
+		return;
+	}
+
+	if (UnitChar != nullptr)
+	{
+		WaveSize -= 1;
+		WaveSize = FMath::Max(WaveSize, 0);
+		if (WaveSize <= 0)
+		{
+			NotifyWaveSpawned();
+		}
+	}
+	else
+	{
+		// If we failed to spawn a minion try again soon
+		UE_LOG(LogGame, Warning, TEXT("Failed to spawn minion.") );
+		NextDwarfSpawnTime = GetWorld()->GetTimeSeconds() + 0.1f;
+	}
+}
+
+ABaseCharacter* UStrategyAIDirector::FinishSpawnUnit(const TArray<FHitResult>& Hits, const FStrategyUnitSpawn& Spawn)
+{
+	const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
+	if (Owner == nullptr || Owner->IsPendingKill())
+	{
+		return nullptr;
+	}
+
+	FVector Loc = Spawn.Location;
+	const FVector Scale(Spawn.Scale);
+	const FHitResult* const Hit = Hits.FindByPredicate([](const FHitResult& Item) { return Item.Actor.IsValid(); });
+	if (Hit)
+	{
+		Loc = Hit->Location + FVector(0.0f,0.0f,Scale.Z * 10.0f);
+	}
+	ABaseCharacter* UnitCDO = Spawn.UnitClass->GetDefaultObject<ABaseCharacter>();
+	const float CapsuleHalfHeight = UnitCDO->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	const float CapsuleRadius = UnitCDO->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
+	Loc = Loc + FVector( 0.0f,0.0f,Scale.Z * CapsuleHalfHeight);
+
+	// and spawn our unit
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ABaseCharacter* const UnitChar = GetWorld()->SpawnActor<ABaseCharacter>(Spawn.UnitClass, Loc, Owner->GetActorRotation(), SpawnInfo);
+	// don't continue if he died right away on spawn
+	if (UnitChar == nullptr || UnitChar->bIsDying)
+	{
+		return nullptr;
+	}
+
+	UnitChar->SetTeamNum(GetTeamNum());
+
+	UnitChar->SpawnDefaultController();
+	UnitChar->GetCapsuleComponent()->SetRelativeScale3D(Scale);
+	UnitChar->GetCapsuleComponent()->SetCapsuleSize(CapsuleRadius, CapsuleHalfHeight);
+	UnitChar->GetMesh()->GlobalAnimRateScale = Spawn.AnimationRate;
+
+	FStrategyGameplayEvent SpawnEvent;
+	SpawnEvent.Type = EStrategyGameplayEvent::CharSpawned;
+	SpawnEvent.TeamNum = UnitChar->GetTeamNum();
+	SpawnEvent.Actor = UnitChar;
+	FStrategyGameplayEventBus::Post(GetWorld(), SpawnEvent);
+
+	// buffs and equipment are for minions only
+	AStrategyChar* const MinionChar = Cast<AStrategyChar>(UnitChar);
+	if (MinionChar)
+	{
+		MinionChar->ApplyBuff(Spawn.Buff);
+		if (Spawn.Weapon != nullptr)
+		{
+			UStrategyGameBlueprintLibrary::GiveWeaponFromClass(MinionChar, Spawn.Weapon);
+		}
+		if (Spawn.Armor != nullptr)
+		{
+			UStrategyGameBlueprintLibrary::GiveArmorFromClass(MinionChar, Spawn.Armor);
+		}
+	}
+	return UnitChar;
+}
+
+void UStrategyAIDirector::NotifyWaveSpawned()
+{
+	FStrategyGameplayEvent WaveEvent;
+	WaveEvent.Type = EStrategyGameplayEvent::WaveSpawned;
+	WaveEvent.TeamNum = GetTeamNum();
+	WaveEvent.Actor = GetOwner();
+	FStrategyGameplayEventBus::Post(GetWorld(), WaveEvent);
+
+	const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
+	if (Owner != nullptr && MyTeamNum==EStrategyTeam::Enemy)
+	{
+		Owner->OnWaveSpawned.Broadcast();
+	}
+}
+
+#pragma optimize("", off)
+void UStrategyAIDirector::SpawnDwarfs()
+{
 	const bool bShoudSpawnNewUnits = GetWorld()->GetTimeSeconds() > NextDwarfSpawnTime;
 	if (!bShoudSpawnNewUnits)
 	{
 		return;
 	}
 
-	if (EnemyBrewery == nullptr)
+	if (GetEnemyBrewery() == nullptr)
 	{
 		const EStrategyTeam::Type EnemyTeamNum = (MyTeamNum == EStrategyTeam::Player ? EStrategyTeam::Enemy : EStrategyTeam::Player);
 		const FPlayerData* const EnemyTeamData = GetWorld()->GetGameState<AStrategyGameState>()->GetPlayerData(EnemyTeamNum);
-		if (EnemyTeamData != nullptr && EnemyTeamData->Brewery != nullptr)
+		if (EnemyTeamData != nullptr && EnemyTeamData->Brewery.IsValid())
 		{
-			EnemyBrewery = EnemyTeamData->Brewery;
+			EnemyBrewery = EnemyTeamData->Brewery->GetEntityHandle();
 		}
 	}
 
 	if(WaveSize > 0)
 	{
-		// find best place on ground to spawn at
 		const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
 		check(Owner);
-		bool bSpawnedNewMinion = false;
 		if( Owner->DwarfCharClass != nullptr )
 		{
-			FVector Loc = Owner->GetActorLocation();
-			const FVector X = Owner->GetTransform().GetScaledAxis( EAxis::X );
-			const FVector Y = Owner->GetTransform().GetScaledAxis( EAxis::Y );
-			Loc += X * RadiusToSpawnOn +  Y * OffsetsGenerator.GetOffset();
-
-			const FVector Scale(CustomScale);
-			const FVector TraceOffset(0.0f,0.0f,RadiusToSpawnOn * 0.5 * Scale.Z);
-			FHitResult Hit;
-			FCollisionObjectQueryParams ObjectParams( FCollisionObjectQueryParams::AllStaticObjects );
-			GetWorld()->LineTraceSingleByObjectType(Hit, Loc + TraceOffset, Loc - TraceOffset, ObjectParams);
-			if (Hit.Actor.IsValid())
-			{
-				Loc = Hit.Location + FVector(0.0f,0.0f,Scale.Z * 10.0f);
-			}
-			AStrategyChar* StrategyChar = Owner->DwarfCharClass->GetDefaultObject<AStrategyChar>();
-			const float CapsuleHalfHeight = StrategyChar->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
-			const float CapsuleRadius = StrategyChar->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
-			Loc = Loc + FVector( 0.0f,0.0f,Scale.Z * CapsuleHalfHeight);
-
-			// and spawn our minion
-			FActorSpawnParameters SpawnInfo;
-			SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-
-			auto rot = Owner->GetActorRotation();
-			doNotOptimizeAway(rot);
-			AStrategyChar* const MinionChar =  GetWorld()->SpawnActor<AStrategyChar>(Owner->DwarfCharClass, Loc, rot, SpawnInfo);
-			// don't continue if he died right away on spawn
-			if ( (MinionChar != nullptr) && (MinionChar->bIsDying == false) )
-			{
-				// Flag a successful spawn
-				bSpawnedNewMinion = true;
-
-				MinionChar->SetTeamNum(GetTeamNum());
-
-				MinionChar->SpawnDefaultController();
-				MinionChar->GetCapsuleComponent()->SetRelativeScale3D(Scale);
-				MinionChar->GetCapsuleComponent()->SetCapsuleSize(CapsuleRadius, CapsuleHalfHeight);
-				MinionChar->GetMesh()->GlobalAnimRateScale = AnimationRate;
-
-				AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
-				if (GameState != nullptr)
-				{
-					GameState->OnCharSpawned(MinionChar);
-				}
-
-				MinionChar->ApplyBuff(BuffModifier);
-				if (DefaultWeapon != nullptr)
-				{
-					UStrategyGameBlueprintLibrary::GiveWeaponFromClass(MinionChar, DefaultWeapon);
-				}
-				if (DefaultArmor != nullptr)
-				{
-					UStrategyGameBlueprintLibrary::GiveArmorFromClass(MinionChar, DefaultArmor);
-				}
-
-				WaveSize -= 1;
-				WaveSize = FMath::Max(WaveSize, 0);
-				if (Owner != nullptr && WaveSize <= 0 && MyTeamNum==EStrategyTeam::Enemy)
-				{
-					Owner->OnWaveSpawned.Broadcast();
-				}
-				NextDwarfSpawnTime = GetWorld()->GetTimeSeconds() + FMath::FRandRange(2.0f, 3.0f);
-			}
-			else
-			{
-				UE_LOG(LogGame, Warning, TEXT("Failed to spawn minion.") );
-			}
+			FStrategyUnitSpawn Spawn;
+			Spawn.UnitClass = Owner->DwarfCharClass;
+			Spawn.Buff = BuffModifier;
+			Spawn.Weapon = DefaultWeapon;
+			Spawn.Armor = DefaultArmor;
+			Spawn.Scale = CustomScale;
+			Spawn.AnimationRate = AnimationRate;
+			Spawn.bRequestedMinion = true;
+			SpawnUnit(Spawn);
+
+			// minion is counted when spawned, failed spawn retries sooner
+			NextDwarfSpawnTime = GetWorld()->GetTimeSeconds() + FMath::FRandRange(2.0f, 3.0f);
 		}
 		else
 		{
 			// If we dont have a class type we cannot spawn a minion. 
 			UE_LOG(LogGame, Warning, TEXT("No minion class specified in %s. Cannot spawn minion"), *Owner->GetName() );			
-		}
-		// If we failed to spawn a minion try again soon
-		if( bSpawnedNewMinion == false )
-		{
 			NextDwarfSpawnTime = GetWorld()->GetTimeSeconds() + 0.1f;
 		}
 	}
@@ -264,11 +341,11 @@ void UStrategyAIDirector::SpawnZombies()
 		//ZombieChar->GetCapsuleComponent()->SetCapsuleSize(CapsuleRadius, CapsuleHalfHeight);
 		//ZombieChar->GetMesh()->GlobalAnimRateScale = AnimationRate;
 
-		AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
-		if (GameState != nullptr)
-		{
-			GameState->OnCharSpawned(ZombieChar);
-		}
+		FStrategyGameplayEvent SpawnEvent;
+		SpawnEvent.Type = EStrategyGameplayEvent::CharSpawned;
+		SpawnEvent.TeamNum = ZombieChar->GetTeamNum();
+		SpawnEvent.Actor = ZombieChar;
+		FStrategyGameplayEventBus::Post(GetWorld(), SpawnEvent);
 		/*
 //		ZombieChar->ApplyBuff(BuffModifier);
 		ZombieWaveSize -= 1;
@@ -284,14 +361,116 @@ void UStrategyAIDirector::SpawnZombies()
 }
 #pragma optimize("", on)
 
+void UStrategyAIDirector::StartScheduledWave(int32 WaveIndex)
+{
+	check(WaveSchedule);
+	ScheduledWave = WaveIndex;
+	NextScheduledSpawn = 0;
+	WaveSchedule->PlanWave(WaveIndex, ScheduledSpawns);
+
+	const FStrategyWave* const Wave = WaveSchedule->GetWave(WaveIndex);
+	ScheduledWaveStartTime = GetWorld()->GetTimeSeconds() + (Wave ? Wave->StartDelay : 0.0f);
+
+	// held until all spawns are issued
+	WaveSpawnsInFlight.FindOrAdd(WaveIndex)++;
+}
+
+void UStrategyAIDirector::OnWaveSpawnDone(int32 WaveIndex)
+{
+	int32* const NumInFlight = WaveSpawnsInFlight.Find(WaveIndex);
+	if (NumInFlight == nullptr)
+	{
+		// schedule was replaced since
+		return;
+	}
+
+	if (--(*NumInFlight) <= 0)
+	{
+		WaveSpawnsInFlight.Remove(WaveIndex);
+		NotifyWaveSpawned();
+	}
+}
+
+void UStrategyAIDirector::SpawnScheduledWaves()
+{
+	const float TimeSeconds = GetWorld()->GetTimeSeconds();
+	const FStrategyWave* const Wave = WaveSchedule->GetWave(ScheduledWave);
+	if (Wave == nullptr || TimeSeconds < ScheduledWaveStartTime)
+	{
+		return;
+	}
+
+	// spawns due this frame, over the budget shared with other directors they wait for next frames
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	const float WaveTime = TimeSeconds - ScheduledWaveStartTime;
+	while (NextScheduledSpawn < ScheduledSpawns.Num() && ScheduledSpawns[NextScheduledSpawn].Time <= WaveTime && MyGameState && MyGameState->ConsumeUnitSpawn())
+	{
+		const FStrategyWaveUnit& Unit = Wave->Units[ScheduledSpawns[NextScheduledSpawn].UnitIndex];
+		FStrategyUnitSpawn Spawn;
+		Spawn.UnitClass = Unit.UnitClass;
+		Spawn.Buff = Unit.Buff;
+		Spawn.Weapon = Unit.Weapon;
+		Spawn.Armor = Unit.Armor;
+		Spawn.Scale = Unit.Scale;
+		Spawn.AnimationRate = Unit.AnimationRate;
+		Spawn.bRequestedMinion = false;
+		Spawn.WaveIndex = ScheduledWave;
+		WaveSpawnsInFlight.FindOrAdd(ScheduledWave)++;
+		SpawnUnit(Spawn);
+		NextScheduledSpawn++;
+	}
+
+	// wave is out once the units of its last spawns find their ground
+	if (NextScheduledSpawn >= ScheduledSpawns.Num())
+	{
+		const int32 IssuedWave = ScheduledWave;
+		if (ScheduledSpawns.Num() == 0)
+		{
+			// nothing spawned, nothing to announce; a repeated empty last wave would come back every frame
+			WaveSpawnsInFlight.Remove(IssuedWave);
+			if (IssuedWave < WaveSchedule->Waves.Num() - 1)
+			{
+				StartScheduledWave(IssuedWave + 1);
+			}
+			else
+			{
+				ScheduledWave = INDEX_NONE;
+			}
+			return;
+		}
+
+		StartScheduledWave(IssuedWave + 1);
+		OnWaveSpawnDone(IssuedWave);
+	}
+}
+
 void UStrategyAIDirector::RequestSpawn()
 {
 	WaveSize += 1;
 }
 
+void UStrategyAIDirector::StartWaveSchedule(UStrategyWaveSchedule* Schedule)
+{
+	WaveSchedule = Schedule;
+	WaveSpawnsInFlight.Reset();
+	if (WaveSchedule)
+	{
+		StartScheduledWave(0);
+	}
+}
+
 void UStrategyAIDirector::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	STRATEGY_SUBSYSTEM_SCOPE(Spawning);
 	SpawnDwarfs();
-	SpawnZombies();
+	if (WaveSchedule)
+	{
+		SpawnScheduledWaves();
+	}
+	else
+	{
+		SpawnZombies();
+	}
 }
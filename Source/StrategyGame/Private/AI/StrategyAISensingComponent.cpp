@@ -21,6 +21,12 @@ void UStrategyAISensingComponent::InitializeComponent()
 	SightRadius = SightDistance;
 }
 
+void UStrategyAISensingComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(KnownTargets.GetAllocatedSize());
+}
+
 bool UStrategyAISensingComponent::ShouldCheckVisibilityOf(APawn *Pawn) const
 {
 	ABaseCharacter* const TestChar = Cast<ABaseCharacter>(Pawn);
@@ -41,23 +47,39 @@ void UStrategyAISensingComponent::UpdateAISensing()
 		return;
 	}
 
+	const FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(Owner->GetWorld());
+	if (Entities == NULL)
+	{
+		return;
+	}
+
+	// team visibility raster replaces per unit line of sight traces, once it's built
+	const AStrategyGameState* const GameState = Owner->GetWorld()->GetGameState<AStrategyGameState>();
+	const FStrategyVisibilityGrid* const VisibilityGrid = (GameState && GameState->GetVisibilityGrid().IsValid()) ? &GameState->GetVisibilityGrid() : nullptr;
+	const IStrategyTeamInterface* const OwnerTeam = Cast<const IStrategyTeamInterface>(Owner);
+	const uint8 OwnerTeamNum = OwnerTeam ? OwnerTeam->GetTeamNum() : EStrategyTeam::Unknown;
+	const FVector SensorLocation = GetSensorLocation();
+	const float SightRadiusSquared = FMath::Square(SightRadius);
+
 	for (ABaseCharacter* const TestChar : TActorRange<ABaseCharacter>(Owner->GetWorld()))
 	{
 		if (!IsSensorActor(TestChar) && ShouldCheckVisibilityOf(TestChar))
 		{
-			if (CouldSeePawn(TestChar, true))
+			const bool bCanSee = VisibilityGrid
+				? (FVector::DistSquared(SensorLocation, TestChar->GetActorLocation()) <= SightRadiusSquared && VisibilityGrid->IsVisible(OwnerTeamNum, TestChar->GetActorLocation()))
+				: CouldSeePawn(TestChar, true);
+			if (bCanSee)
 			{
-				KnownTargets.AddUnique(TestChar);
+				KnownTargets.AddUnique(TestChar->GetEntityHandle());
 			}
 		}
 	}
 
 	for (int32 i = KnownTargets.Num() - 1; i >= 0; i--)
 	{
-		const ABaseCharacter* TestChar = Cast<ABaseCharacter>(KnownTargets[i].Get());
-		if (TestChar == NULL)
+		if (!Entities->IsValid(KnownTargets[i]))
 		{
-			KnownTargets.RemoveAt(i);
+			KnownTargets.RemoveAtSwap(i);
 		}
 	}
 }
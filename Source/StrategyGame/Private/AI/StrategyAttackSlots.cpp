@@ -0,0 +1,184 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyAttackSlots.h"
+
+/** inner ring is this fraction of attack distance, so attackers in slots are in range */
+static const float SlotAttackDistanceScale = 0.8f;
+
+/** room around each attacker, in its capsule diameters */
+static const float SlotSpacing = 1.1f;
+
+/** rings around single target, attackers beyond wait on the last one */
+static const int32 MaxRings = 3;
+
+static const int32 MinSlotsPerRing = 3;
+
+bool FStrategyAttackSlots::Claim(const AActor* Target, const AActor* Attacker, float AttackDistance, FVector& OutLocation)
+{
+	if (!IsAlive(Target) || Attacker == nullptr)
+	{
+		return false;
+	}
+
+	const AActor** const CurrentTarget = AttackerTargets.Find(Attacker);
+	if (CurrentTarget != nullptr && *CurrentTarget != Target)
+	{
+		Release(Attacker);
+	}
+
+	FTargetSlots& TargetSlots = Targets.FindOrAdd(Target);
+	if (TargetSlots.Target.Get() != Target)
+	{
+		// new target, or a stale entry of destroyed one at the same address
+		TargetSlots.Target = Target;
+		TargetSlots.Slots.Reset();
+	}
+
+	const FVector TargetLocation = Target->GetActorLocation();
+	const FSlot* const CurrentSlot = TargetSlots.Slots.FindByPredicate([Attacker](const FSlot& Slot) { return Slot.Attacker.Get() == Attacker; });
+	if (CurrentSlot != nullptr)
+	{
+		OutLocation = TargetLocation + FVector(CurrentSlot->Offset, 0.0f);
+		return true;
+	}
+
+	float TargetRadius = 0.0f;
+	float TargetHalfHeight = 0.0f;
+	Target->GetSimpleCollisionCylinder(TargetRadius, TargetHalfHeight);
+	const float Radius = Attacker->GetSimpleCollisionRadius();
+	const float InnerRadius = FMath::Max(AttackDistance * SlotAttackDistanceScale, TargetRadius + Radius);
+
+	// try spots on the side the attacker comes from first
+	const FVector2D ToAttacker(Attacker->GetActorLocation() - TargetLocation);
+	const float PreferredAngle = ToAttacker.IsNearlyZero() ? 0.0f : FMath::Atan2(ToAttacker.Y, ToAttacker.X);
+
+	FSlot NewSlot;
+	NewSlot.Attacker = Attacker;
+	NewSlot.Radius = Radius;
+	NewSlot.Offset = FVector2D::ZeroVector;
+
+	bool bFound = false;
+	for (int32 Ring = 0; Ring < MaxRings && !bFound; Ring++)
+	{
+		const float RingRadius = InnerRadius + Ring * 2.0f * Radius * SlotSpacing;
+		const int32 NumSlots = FMath::Max(MinSlotsPerRing, FMath::FloorToInt(2.0f * PI * RingRadius / (2.0f * Radius * SlotSpacing)));
+		const float StepAngle = 2.0f * PI / NumSlots;
+
+		for (int32 Step = 0; Step < NumSlots; Step++)
+		{
+			// alternate both ways from the preferred angle
+			const int32 StepIndex = (Step + 1) / 2 * ((Step % 2) ? 1 : -1);
+			const float Angle = PreferredAngle + StepIndex * StepAngle;
+			const FVector2D Offset = FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * RingRadius;
+			if (IsFree(TargetSlots, Offset, Radius))
+			{
+				NewSlot.Offset = Offset;
+				bFound = true;
+				break;
+			}
+		}
+	}
+
+	if (!bFound)
+	{
+		// crowded, queue behind the outer ring
+		const float QueueRadius = InnerRadius + MaxRings * 2.0f * Radius * SlotSpacing;
+		NewSlot.Offset = FVector2D(FMath::Cos(PreferredAngle), FMath::Sin(PreferredAngle)) * QueueRadius;
+	}
+
+	TargetSlots.Slots.Add(NewSlot);
+	AttackerTargets.Add(Attacker, Target);
+	OutLocation = TargetLocation + FVector(NewSlot.Offset, 0.0f);
+	return true;
+}
+
+void FStrategyAttackSlots::Release(const AActor* Attacker)
+{
+	const AActor* Target = nullptr;
+	if (!AttackerTargets.RemoveAndCopyValue(Attacker, Target))
+	{
+		return;
+	}
+
+	FTargetSlots* const TargetSlots = Targets.Find(Target);
+	if (TargetSlots != nullptr)
+	{
+		TargetSlots->Slots.RemoveAllSwap([Attacker](const FSlot& Slot) { return Slot.Attacker.Get() == Attacker || !Slot.Attacker.IsValid(); });
+		if (TargetSlots->Slots.Num() == 0)
+		{
+			Targets.Remove(Target);
+		}
+	}
+}
+
+void FStrategyAttackSlots::Tick()
+{
+	for (auto It = Targets.CreateIterator(); It; ++It)
+	{
+		FTargetSlots& TargetSlots = It.Value();
+		const bool bTargetAlive = IsAlive(TargetSlots.Target.Get());
+
+		for (int32 Idx = TargetSlots.Slots.Num() - 1; Idx >= 0; Idx--)
+		{
+			const AActor* const Attacker = TargetSlots.Slots[Idx].Attacker.Get();
+			if (!bTargetAlive || !IsAlive(Attacker))
+			{
+				if (Attacker != nullptr)
+				{
+					AttackerTargets.Remove(Attacker);
+				}
+				TargetSlots.Slots.RemoveAtSwap(Idx, 1, false);
+			}
+		}
+
+		if (TargetSlots.Slots.Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// attackers destroyed before their entries could be matched
+	for (auto It = AttackerTargets.CreateIterator(); It; ++It)
+	{
+		if (!Targets.Contains(It.Value()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FStrategyAttackSlots::Reset()
+{
+	Targets.Reset();
+	AttackerTargets.Reset();
+}
+
+int32 FStrategyAttackSlots::GetNumAttackers(const AActor* Target) const
+{
+	const FTargetSlots* const TargetSlots = Targets.Find(Target);
+	return (TargetSlots && TargetSlots->Target.Get() == Target) ? TargetSlots->Slots.Num() : 0;
+}
+
+bool FStrategyAttackSlots::IsFree(const FTargetSlots& TargetSlots, const FVector2D& Offset, float Radius)
+{
+	for (const FSlot& Slot : TargetSlots.Slots)
+	{
+		if ((Slot.Offset - Offset).SizeSquared() < FMath::Square((Slot.Radius + Radius) * SlotSpacing))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FStrategyAttackSlots::IsAlive(const AActor* Actor)
+{
+	if (Actor == nullptr || Actor->IsPendingKill())
+	{
+		return false;
+	}
+
+	const ABaseCharacter* const TestChar = Cast<const ABaseCharacter>(Actor);
+	return TestChar == nullptr || (!TestChar->bIsDying && TestChar->GetHealth() > 0);
+}
@@ -0,0 +1,490 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyPathService.h"
+#include "StrategyAIController.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+
+DECLARE_CYCLE_STAT(TEXT("Path service"), STAT_StrategyPathService, STATGROUP_StrategyPath);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Move requests"), STAT_StrategyPathRequests, STATGROUP_StrategyPath);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path queries"), STAT_StrategyPathQueries, STATGROUP_StrategyPath);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Merged requests"), STAT_StrategyPathMerged, STATGROUP_StrategyPath);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corridor cache hits"), STAT_StrategyPathCacheHits, STATGROUP_StrategyPath);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Waiting requests"), STAT_StrategyPathWaiting, STATGROUP_StrategyPath);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unjoinable shared paths"), STAT_StrategyPathUnjoinable, STATGROUP_StrategyPath);
+
+/** goals this close count as the same */
+static const float SameGoalDistance = 1.0f;
+
+FStrategyPathService::FStrategyPathService()
+	: MaxQueriesPerFrame(8)
+	, MergeDistance(150.0f)
+	, CacheSize(64)
+	, CacheLifetime(20.0f)
+	, NextSerial(0)
+	, bWasBuildingNavigation(false)
+{
+}
+
+FStrategyPathService::~FStrategyPathService()
+{
+	Reset();
+}
+
+void FStrategyPathService::Configure(int32 InMaxQueriesPerFrame, float InMergeDistance, int32 InCacheSize, float InCacheLifetime)
+{
+	MaxQueriesPerFrame = FMath::Max(InMaxQueriesPerFrame, 1);
+	MergeDistance = FMath::Max(InMergeDistance, 1.0f);
+	CacheSize = FMath::Max(InCacheSize, 0);
+	CacheLifetime = InCacheLifetime;
+	Reset();
+}
+
+void FStrategyPathService::RequestMove(AStrategyAIController* Controller, const FVector& Goal, float AcceptanceRadius, bool bStopOnOverlap, bool bCacheCorridor)
+{
+	check(Controller);
+
+	FRequest Request;
+	Request.Controller = Controller;
+	Request.Start = Controller->GetNavAgentLocation();
+	Request.Goal = Goal;
+	Request.AcceptanceRadius = AcceptanceRadius;
+	Request.bStopOnOverlap = bStopOnOverlap;
+	Request.bCacheCorridor = bCacheCorridor;
+	Request.bExclusive = false;
+	AddRequest(Request);
+}
+
+void FStrategyPathService::RequestMoveToActor(AStrategyAIController* Controller, AActor* GoalActor, float AcceptanceRadius, bool bStopOnOverlap)
+{
+	check(Controller && GoalActor);
+
+	FRequest Request;
+	Request.Controller = Controller;
+	Request.GoalActor = GoalActor;
+	Request.Start = Controller->GetNavAgentLocation();
+	Request.Goal = GoalActor->GetActorLocation();
+	Request.AcceptanceRadius = AcceptanceRadius;
+	Request.bStopOnOverlap = bStopOnOverlap;
+	Request.bCacheCorridor = false;
+	Request.bExclusive = false;
+	AddRequest(Request);
+}
+
+void FStrategyPathService::AddRequest(const FRequest& InRequest)
+{
+	INC_DWORD_STAT(STAT_StrategyPathRequests);
+
+	FRequest Request = InRequest;
+	Request.Serial = ++NextSerial;
+
+	// one request per controller, the newest wins
+	const AStrategyAIController* const Controller = Request.Controller.Get();
+	FRequest* const PendingRequest = PendingRequests.FindByPredicate([Controller](const FRequest& Item) { return Item.Controller.Get() == Controller; });
+	if (PendingRequest != nullptr)
+	{
+		*PendingRequest = Request;
+	}
+	else
+	{
+		PendingRequests.Add(Request);
+	}
+	LatestSerials.Add(Controller, Request.Serial);
+}
+
+void FStrategyPathService::Cancel(const AStrategyAIController* Controller)
+{
+	if (LatestSerials.Remove(Controller) > 0)
+	{
+		PendingRequests.RemoveAll([Controller](const FRequest& Item) { return Item.Controller.Get() == Controller; });
+	}
+}
+
+bool FStrategyPathService::IsPending(const AStrategyAIController* Controller) const
+{
+	return LatestSerials.Contains(Controller);
+}
+
+bool FStrategyPathService::IsCurrent(const FRequest& Request) const
+{
+	const AStrategyAIController* const Controller = Request.Controller.Get();
+	const uint32* const Serial = Controller ? LatestSerials.Find(Controller) : nullptr;
+	return Serial != nullptr && *Serial == Request.Serial && Controller->GetPawn() != nullptr;
+}
+
+FStrategyPathService::FPathKey FStrategyPathService::GetKey(const FVector& Start, const FVector& Goal) const
+{
+	FPathKey Key;
+	Key.StartCell = FIntPoint(FMath::FloorToInt(Start.X / MergeDistance), FMath::FloorToInt(Start.Y / MergeDistance));
+	Key.GoalCell = FIntVector(FMath::FloorToInt(Goal.X / MergeDistance), FMath::FloorToInt(Goal.Y / MergeDistance), FMath::FloorToInt(Goal.Z / MergeDistance));
+	return Key;
+}
+
+void FStrategyPathService::Tick(UWorld* World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_StrategyPathService);
+
+	UNavigationSystemV1* const NavSys = World ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(World) : nullptr;
+	ANavigationData* const CurrentNavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	if (CurrentNavData == nullptr)
+	{
+		// nothing to query, let the controllers fail their moves as usual
+		TArray<FRequest> Requests = MoveTemp(PendingRequests);
+		for (const FRequest& Request : Requests)
+		{
+			if (IsCurrent(Request))
+			{
+				Fallback(Request);
+			}
+		}
+		return;
+	}
+
+	// corridors found while tiles were rebuilt may cross the old navmesh
+	const bool bIsBuildingNavigation = NavSys->IsNavigationBuildInProgress();
+	if (bWasBuildingNavigation && !bIsBuildingNavigation)
+	{
+		if (RebuildingAreas.Num() > 0)
+		{
+			InvalidateCorridors(RebuildingAreas);
+			RebuildingAreas.Reset();
+		}
+		else
+		{
+			// rebuilt for something else than buildings
+			InvalidateCorridors();
+		}
+	}
+	bWasBuildingNavigation = bIsBuildingNavigation;
+
+	QueryWorld = World;
+	NavData = CurrentNavData;
+
+	const float Now = World->GetTimeSeconds();
+	TMap<FPathKey, uint32> FrameQueries;
+	TArray<FRequest> DeferredRequests;
+	int32 NumQueries = 0;
+
+	// fallbacks may queue new requests while we go through these
+	const TArray<FRequest> Requests = MoveTemp(PendingRequests);
+	PendingRequests.Reset();
+
+	for (const FRequest& Request : Requests)
+	{
+		if (!IsCurrent(Request))
+		{
+			continue;
+		}
+
+		const FPathKey Key = GetKey(Request.Start, Request.Goal);
+
+		const FCorridor* const Corridor = (Request.bCacheCorridor && !Request.bExclusive) ? FindCorridor(Key, Now) : nullptr;
+		if (Corridor != nullptr)
+		{
+			INC_DWORD_STAT(STAT_StrategyPathCacheHits);
+			const FCorridor CorridorCopy = *Corridor;
+			Deliver(Request, CorridorCopy.Points, CorridorCopy.Start, CorridorCopy.Goal);
+			continue;
+		}
+
+		const uint32* const SharedQueryID = Request.bExclusive ? nullptr : FrameQueries.Find(Key);
+		if (SharedQueryID != nullptr)
+		{
+			INC_DWORD_STAT(STAT_StrategyPathMerged);
+			Queries.FindChecked(*SharedQueryID).Requests.Add(Request);
+			continue;
+		}
+
+		if (NumQueries >= MaxQueriesPerFrame)
+		{
+			// over budget, wait for the next frame
+			DeferredRequests.Add(Request);
+			continue;
+		}
+
+		FPathFindingQuery Query(Request.Controller.Get(), *CurrentNavData, Request.Start, Request.Goal, CurrentNavData->GetDefaultQueryFilter());
+		Query.SetAllowPartialPaths(true);
+		const uint32 QueryID = NavSys->FindPathAsync(Request.Controller->GetNavAgentPropertiesRef(), Query,
+			FNavPathQueryDelegate::CreateRaw(this, &FStrategyPathService::OnPathFound), EPathFindingMode::Regular);
+		if (QueryID == INVALID_NAVQUERYID)
+		{
+			Fallback(Request);
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_StrategyPathQueries);
+		NumQueries++;
+		if (!Request.bExclusive)
+		{
+			FrameQueries.Add(Key, QueryID);
+		}
+
+		FQuery& NewQuery = Queries.Add(QueryID);
+		NewQuery.Key = Key;
+		NewQuery.Start = Request.Start;
+		NewQuery.Goal = Request.Goal;
+		NewQuery.bCacheCorridor = Request.bCacheCorridor;
+		NewQuery.Requests.Add(Request);
+	}
+
+	// deferred requests go first next frame
+	DeferredRequests.Append(PendingRequests);
+	PendingRequests = MoveTemp(DeferredRequests);
+	SET_DWORD_STAT(STAT_StrategyPathWaiting, PendingRequests.Num());
+}
+
+void FStrategyPathService::OnPathFound(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FQuery Query;
+	if (!Queries.RemoveAndCopyValue(QueryID, Query))
+	{
+		return;
+	}
+
+	const bool bSuccess = Result == ENavigationQueryResult::Success && Path.IsValid() && Path->IsValid();
+	TArray<FVector> PathPoints;
+	if (bSuccess)
+	{
+		for (const FNavPathPoint& PathPoint : Path->GetPathPoints())
+		{
+			PathPoints.Add(PathPoint.Location);
+		}
+
+		if (Query.bCacheCorridor && !Path->IsPartial())
+		{
+			UWorld* const World = QueryWorld.Get();
+			AddCorridor(Query.Key, Query, PathPoints, World ? World->GetTimeSeconds() : 0.0f);
+		}
+	}
+
+	for (const FRequest& Request : Query.Requests)
+	{
+		if (!IsCurrent(Request))
+		{
+			continue;
+		}
+
+		if (bSuccess)
+		{
+			Deliver(Request, PathPoints, Query.Start, Query.Goal);
+		}
+		else
+		{
+			Fallback(Request);
+		}
+	}
+}
+
+bool FStrategyPathService::IsDirectlyReachable(const FVector& From, const FVector& To, const AStrategyAIController* Controller) const
+{
+	const ANavigationData* const CurrentNavData = NavData.Get();
+	FVector HitLocation;
+	return CurrentNavData != nullptr && !CurrentNavData->Raycast(From, To, HitLocation, CurrentNavData->GetDefaultQueryFilter(), Controller);
+}
+
+void FStrategyPathService::Deliver(const FRequest& Request, const TArray<FVector>& PathPoints, const FVector& PathStart, const FVector& PathGoal)
+{
+	AStrategyAIController* const Controller = Request.Controller.Get();
+	LatestSerials.Remove(Controller);
+	if (PathPoints.Num() < 2)
+	{
+		Fallback(Request);
+		return;
+	}
+
+	TArray<FVector> ControllerPoints = PathPoints;
+	const FVector Location = Controller->GetNavAgentLocation();
+	bool bJoined = true;
+	if (Request.Start.Equals(PathStart))
+	{
+		// our own path, we moved a little since asking
+		ControllerPoints[0] = Location;
+	}
+	else if (IsDirectlyReachable(Location, ControllerPoints[1], Controller))
+	{
+		// shared path starts somewhere close, cut the corner when it's clear
+		ControllerPoints[0] = Location;
+	}
+	else if (IsDirectlyReachable(Location, ControllerPoints[0], Controller))
+	{
+		ControllerPoints.Insert(Location, 0);
+	}
+	else
+	{
+		bJoined = false;
+	}
+
+	// shared path ends at the goal of whoever asked first
+	if (bJoined && !Request.Goal.Equals(PathGoal, SameGoalDistance))
+	{
+		bJoined = IsDirectlyReachable(ControllerPoints.Last(), Request.Goal, Controller);
+		if (bJoined)
+		{
+			ControllerPoints.Add(Request.Goal);
+		}
+	}
+
+	if (!bJoined)
+	{
+		if (Request.bExclusive)
+		{
+			Fallback(Request);
+			return;
+		}
+
+		// obstacle between us and the shared path, find one of our own
+		INC_DWORD_STAT(STAT_StrategyPathUnjoinable);
+		FRequest ExclusiveRequest = Request;
+		ExclusiveRequest.Start = Location;
+		ExclusiveRequest.bExclusive = true;
+		AddRequest(ExclusiveRequest);
+		return;
+	}
+
+	FNavPathSharedPtr Path = MakeShareable(new FNavigationPath(ControllerPoints, nullptr));
+	Path->SetNavigationDataUsed(NavData.Get());
+	Path->SetTimeStamp(QueryWorld.IsValid() ? QueryWorld->GetTimeSeconds() : 0.0f);
+
+	AActor* const GoalActor = Request.GoalActor.Get();
+	FAIMoveRequest MoveRequest(Request.Goal);
+	if (GoalActor != nullptr)
+	{
+		// path following repaths when the actor moves away
+		MoveRequest.SetGoalActor(GoalActor);
+		Path->SetGoalActorObservation(*GoalActor, 100.0f);
+	}
+	MoveRequest.SetAcceptanceRadius(Request.AcceptanceRadius);
+	MoveRequest.SetReachTestIncludesAgentRadius(Request.bStopOnOverlap);
+	MoveRequest.SetUsePathfinding(true);
+	MoveRequest.SetProjectGoalLocation(false);
+	Controller->RequestMove(MoveRequest, Path);
+}
+
+void FStrategyPathService::Fallback(const FRequest& Request)
+{
+	AStrategyAIController* const Controller = Request.Controller.Get();
+	LatestSerials.Remove(Controller);
+	if (Request.GoalActor.IsValid())
+	{
+		Controller->MoveToActor(Request.GoalActor.Get(), Request.AcceptanceRadius, Request.bStopOnOverlap);
+	}
+	else
+	{
+		Controller->MoveToLocation(Request.Goal, Request.AcceptanceRadius, Request.bStopOnOverlap, true, true);
+	}
+}
+
+const FStrategyPathService::FCorridor* FStrategyPathService::FindCorridor(const FPathKey& Key, float Now)
+{
+	FCorridor* const Corridor = Corridors.Find(Key);
+	if (Corridor == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (CacheLifetime > 0.0f && Now - Corridor->CreationTime > CacheLifetime)
+	{
+		Corridors.Remove(Key);
+		return nullptr;
+	}
+
+	Corridor->LastUsedFrame = GFrameCounter;
+	return Corridor;
+}
+
+void FStrategyPathService::AddCorridor(const FPathKey& Key, const FQuery& Query, const TArray<FVector>& PathPoints, float Now)
+{
+	if (CacheSize <= 0)
+	{
+		return;
+	}
+
+	if (Corridors.Num() >= CacheSize && !Corridors.Contains(Key))
+	{
+		const FPathKey* OldestKey = nullptr;
+		uint64 OldestFrame = MAX_uint64;
+		for (const TPair<FPathKey, FCorridor>& Pair : Corridors)
+		{
+			if (Pair.Value.LastUsedFrame < OldestFrame)
+			{
+				OldestFrame = Pair.Value.LastUsedFrame;
+				OldestKey = &Pair.Key;
+			}
+		}
+		if (OldestKey != nullptr)
+		{
+			const FPathKey KeyToRemove = *OldestKey;
+			Corridors.Remove(KeyToRemove);
+		}
+	}
+
+	FCorridor& Corridor = Corridors.FindOrAdd(Key);
+	Corridor.Points = PathPoints;
+	Corridor.Start = Query.Start;
+	Corridor.Goal = Query.Goal;
+	Corridor.CreationTime = Now;
+	Corridor.LastUsedFrame = GFrameCounter;
+}
+
+void FStrategyPathService::InvalidateCorridors()
+{
+	Corridors.Reset();
+}
+
+void FStrategyPathService::InvalidateCorridors(const TArray<FBox>& Areas)
+{
+	for (auto It = Corridors.CreateIterator(); It; ++It)
+	{
+		const TArray<FVector>& Points = It.Value().Points;
+		bool bCrossesArea = false;
+		for (int32 Idx = 1; Idx < Points.Num() && !bCrossesArea; Idx++)
+		{
+			const FVector SegmentStart = Points[Idx - 1];
+			const FVector SegmentEnd = Points[Idx];
+			for (const FBox& Area : Areas)
+			{
+				// path points lie on the navmesh, somewhere within the height of the area
+				const FBox TestArea = Area.ExpandBy(FVector(MergeDistance, MergeDistance, MergeDistance));
+				if (FMath::LineBoxIntersection(TestArea, SegmentStart, SegmentEnd, SegmentEnd - SegmentStart))
+				{
+					bCrossesArea = true;
+					break;
+				}
+			}
+		}
+
+		if (bCrossesArea)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FStrategyPathService::OnNavTilesChanged(const TArray<FIntPoint>& Tiles, const TArray<FBox>& Areas)
+{
+	InvalidateCorridors(Areas);
+	RebuildingAreas.Append(Areas);
+}
+
+void FStrategyPathService::Reset()
+{
+	UWorld* const World = QueryWorld.Get();
+	UNavigationSystemV1* const NavSys = World ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(World) : nullptr;
+	if (NavSys != nullptr)
+	{
+		for (const TPair<uint32, FQuery>& Pair : Queries)
+		{
+			NavSys->AbortAsyncFindPathRequest(Pair.Key);
+		}
+	}
+
+	Queries.Reset();
+	PendingRequests.Reset();
+	LatestSerials.Reset();
+	Corridors.Reset();
+	QueryWorld.Reset();
+	NavData.Reset();
+	RebuildingAreas.Reset();
+	bWasBuildingNavigation = false;
+}
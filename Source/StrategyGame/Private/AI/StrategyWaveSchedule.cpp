@@ -0,0 +1,94 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyWaveSchedule.h"
+
+UStrategyWaveSchedule::UStrategyWaveSchedule(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	bRepeatLastWave = false;
+}
+
+const FStrategyWave* UStrategyWaveSchedule::GetWave(int32 WaveIndex) const
+{
+	if (Waves.IsValidIndex(WaveIndex))
+	{
+		return &Waves[WaveIndex];
+	}
+	return (bRepeatLastWave && WaveIndex >= Waves.Num() && Waves.Num() > 0) ? &Waves.Last() : nullptr;
+}
+
+bool UStrategyWaveSchedule::PlanWave(int32 WaveIndex, TArray<FStrategyWaveSpawn>& OutSpawns) const
+{
+	OutSpawns.Reset();
+	const FStrategyWave* const Wave = GetWave(WaveIndex);
+	if (Wave == nullptr)
+	{
+		return false;
+	}
+
+	// every group is spread evenly over the wave, groups are interleaved by their progress
+	TArray<TPair<float, int32>> Slots;
+	for (int32 UnitIndex = 0; UnitIndex < Wave->Units.Num(); UnitIndex++)
+	{
+		const FStrategyWaveUnit& Unit = Wave->Units[UnitIndex];
+		if (Unit.UnitClass == nullptr)
+		{
+			continue;
+		}
+		for (int32 Idx = 0; Idx < Unit.Count; Idx++)
+		{
+			Slots.Emplace((Idx + 0.5f) / Unit.Count, UnitIndex);
+		}
+	}
+	Slots.StableSort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	OutSpawns.Reserve(Slots.Num());
+	for (int32 Idx = 0; Idx < Slots.Num(); Idx++)
+	{
+		FStrategyWaveSpawn& Spawn = OutSpawns[OutSpawns.AddUninitialized()];
+		Spawn.Time = Slots.Num() > 1 ? Wave->Duration * Idx / (Slots.Num() - 1) : 0.0f;
+		Spawn.UnitIndex = Slots[Idx].Value;
+	}
+	return true;
+}
+
+bool UStrategyWaveSchedule::Validate(TArray<FString>& OutErrors) const
+{
+	OutErrors.Reset();
+	if (Waves.Num() == 0)
+	{
+		OutErrors.Add(TEXT("Schedule has no waves."));
+	}
+
+	for (int32 WaveIndex = 0; WaveIndex < Waves.Num(); WaveIndex++)
+	{
+		const FStrategyWave& Wave = Waves[WaveIndex];
+		if (Wave.Units.Num() == 0)
+		{
+			OutErrors.Add(FString::Printf(TEXT("Wave %d has no units."), WaveIndex));
+		}
+		if (Wave.StartDelay < 0.0f || Wave.Duration < 0.0f)
+		{
+			OutErrors.Add(FString::Printf(TEXT("Wave %d has negative timing."), WaveIndex));
+		}
+		for (int32 UnitIndex = 0; UnitIndex < Wave.Units.Num(); UnitIndex++)
+		{
+			const FStrategyWaveUnit& Unit = Wave.Units[UnitIndex];
+			if (Unit.UnitClass == nullptr)
+			{
+				OutErrors.Add(FString::Printf(TEXT("Wave %d, group %d has no unit class."), WaveIndex, UnitIndex));
+			}
+			if (Unit.Count < 1)
+			{
+				OutErrors.Add(FString::Printf(TEXT("Wave %d, group %d has count %d."), WaveIndex, UnitIndex, Unit.Count));
+			}
+			if (Unit.Scale <= 0.0f || Unit.AnimationRate <= 0.0f)
+			{
+				OutErrors.Add(FString::Printf(TEXT("Wave %d, group %d has zero scale or animation rate."), WaveIndex, UnitIndex));
+			}
+		}
+	}
+
+	return OutErrors.Num() == 0;
+}
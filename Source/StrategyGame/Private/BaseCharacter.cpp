@@ -4,10 +4,11 @@
 #include "BaseCharacter.h"
 
 #include "StrategyAIController.h"
+#include "StrategyCharMovement.h"
 
 // Sets default values
 ABaseCharacter::ABaseCharacter(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UStrategyCharMovement>(ACharacter::CharacterMovementComponentName))
 	, ResourcesToGather(10)
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
@@ -26,6 +27,42 @@ void ABaseCharacter::PostInitializeComponents()
 void ABaseCharacter::BeginPlay()
 {
 	Super::BeginPlay();
+
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities)
+	{
+		EntityHandle = Entities->Add(this, EStrategyEntity::Unit, GetTeamNum());
+	}
+}
+
+void ABaseCharacter::GetMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	if (AttackAnim)
+	{
+		OutMontages.AddUnique(AttackAnim);
+	}
+	if (DeathAnim)
+	{
+		OutMontages.AddUnique(DeathAnim);
+	}
+}
+
+void ABaseCharacter::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(ActiveBuffs.GetAllocatedSize());
+}
+
+void ABaseCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities)
+	{
+		Entities->Remove(EntityHandle);
+		EntityHandle = FStrategyEntityHandle();
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 float ABaseCharacter::PlayAttackAnim()
@@ -113,6 +150,12 @@ uint8 ABaseCharacter::GetTeamNum() const
 void ABaseCharacter::SetTeamNum(uint8 NewTeamNum)
 {
 	MyTeamNum = NewTeamNum;
+
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities)
+	{
+		Entities->SetTeamNum(EntityHandle, NewTeamNum);
+	}
 }
 
 
@@ -130,7 +173,6 @@ int32 ABaseCharacter::GetMaxHealth() const
 void ABaseCharacter::OnMeleeAttackFinishedNotify()
 {
 	const int32 MeleeDamage = FMath::RandRange(PawnData.AttackMin, PawnData.AttackMax);
-	const TSubclassOf<UDamageType> MeleeDmgType = UDamageType::StaticClass();
 
 	// Do a trace to see what we hit
 	const float CollisionRadius = GetCapsuleComponent() ? GetCapsuleComponent()->GetScaledCapsuleRadius() : 0.f;
@@ -138,17 +180,27 @@ void ABaseCharacter::OnMeleeAttackFinishedNotify()
 	const FVector TraceStart = GetActorLocation();
 	const FVector TraceDir = GetActorForwardVector();
 	const FVector TraceEnd = TraceStart + TraceDir * TraceDistance;
-	TArray<FHitResult> Hits;
 	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(MeleeHit), false, this);
 	FCollisionResponseParams ResponseParam(ECollisionResponse::ECR_Overlap);
-	GetWorld()->SweepMultiByChannel(Hits, TraceStart, TraceEnd, FQuat::Identity, COLLISION_WEAPON, FCollisionShape::MakeBox(FVector(80.f)), TraceParams, ResponseParam);
+	FStrategySceneQueries::SweepMultiByChannel(GetWorld(), TraceStart, TraceEnd, COLLISION_WEAPON, FCollisionShape::MakeBox(FVector(80.f)), TraceParams, ResponseParam,
+		FOnStrategySceneQueryDone::CreateUObject(this, &ABaseCharacter::OnMeleeSweepDone, MeleeDamage, TraceDir));
+}
+
+void ABaseCharacter::OnMeleeSweepDone(const TArray<FHitResult>& Hits, int32 MeleeDamage, FVector TraceDir)
+{
+	// sweep may finish a frame after the blow, dead don't deal damage
+	if (bIsDying || Health <= 0)
+	{
+		return;
+	}
 
+	const TSubclassOf<UDamageType> MeleeDmgType = UDamageType::StaticClass();
 	for (int32 i = 0; i < Hits.Num(); i++)
 	{
 		FHitResult const& Hit = Hits[i];
 		if (AStrategyGameMode::OnEnemyTeam(this, Hit.GetActor()))
 		{
-			UGameplayStatics::ApplyPointDamage(Hit.GetActor(), MeleeDamage, TraceDir, Hit, Controller, this, MeleeDmgType);
+			FStrategyDamageQueue::ApplyPointDamage(Hit.GetActor(), MeleeDamage, TraceDir, Hit, Controller, this, MeleeDmgType);
 
 			// only damage first hit
 			break;
@@ -181,12 +233,16 @@ float ABaseCharacter::TakeDamage(float Damage, struct FDamageEvent const& Damage
 		// broadcast AI-detectable noise
 		MakeNoise(1.0f, EventInstigator ? EventInstigator->GetPawn() : this);
 
-		// our gamestate wants to know when damage happens
-		AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
-		if (GameState)
-		{
-			GameState->OnActorDamaged(this, ActualDamage, EventInstigator);
-		}
+		// let the listeners know when damage happens
+		IStrategyTeamInterface* const InstigatorTeam = Cast<IStrategyTeamInterface>(EventInstigator);
+		FStrategyGameplayEvent DamagedEvent;
+		DamagedEvent.Type = EStrategyGameplayEvent::ActorDamaged;
+		DamagedEvent.TeamNum = GetTeamNum();
+		DamagedEvent.InstigatorTeamNum = InstigatorTeam ? InstigatorTeam->GetTeamNum() : EStrategyTeam::Unknown;
+		DamagedEvent.Value = ActualDamage;
+		DamagedEvent.Actor = this;
+		DamagedEvent.Instigator = EventInstigator;
+		FStrategyGameplayEventBus::Post(GetWorld(), DamagedEvent);
 	}
 
 	return ActualDamage;
@@ -213,16 +269,25 @@ void ABaseCharacter::Die(float KillingDamage, FDamageEvent const& DamageEvent, A
 	// forcibly end any timers that may be in flight
 	GetWorldTimerManager().ClearAllTimersForObject(this);
 
-	// notify the game mode if an Enemy dies
-	if (GetTeamNum() == EStrategyTeam::Enemy)
+	// handles held by others go stale right now, not when the corpse is gone
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities)
 	{
-		AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
-		if (GameState)
-		{
-			GameState->OnCharDied(this);
-		}
+		Entities->Remove(EntityHandle);
+		EntityHandle = FStrategyEntityHandle();
 	}
 
+	// let the listeners know about the death
+	IStrategyTeamInterface* const KillerTeam = Cast<IStrategyTeamInterface>(Killer);
+	FStrategyGameplayEvent DeathEvent;
+	DeathEvent.Type = EStrategyGameplayEvent::CharDied;
+	DeathEvent.TeamNum = GetTeamNum();
+	DeathEvent.InstigatorTeamNum = KillerTeam ? KillerTeam->GetTeamNum() : EStrategyTeam::Unknown;
+	DeathEvent.Value = ResourcesToGather;
+	DeathEvent.Actor = this;
+	DeathEvent.Instigator = Killer;
+	FStrategyGameplayEventBus::Post(GetWorld(), DeathEvent);
+
 	// disable any AI
 	AStrategyAIController* const AIController = Cast<AStrategyAIController>(Controller);
 	if (AIController)
@@ -6,6 +6,7 @@
 #include "SStrategySlateHUDWidget.h"
 #include "SStrategyButtonWidget.h"
 #include "StrategySelectionInterface.h"
+#include "AI/NavigationSystemBase.h"
 
 
 AStrategyBuilding::AStrategyBuilding(const FObjectInitializer& ObjectInitializer) 
@@ -19,7 +20,10 @@ AStrategyBuilding::AStrategyBuilding(const FObjectInitializer& ObjectInitializer
 	, bIsContructionFinished(false)
 	, bIsBeingBuild(false)
 	, bIsActionMenuDisplayed(false)
+	, bIsNavFootprint(false)
 	, MyTeamNum(EStrategyTeam::Unknown)
+	, RegisteredTeamNum(EStrategyTeam::Unknown)
+	, TeamBuildingIndex(INDEX_NONE)
 	, RemainingBuildTime(0)
 {
 	PrimaryActorTick.bCanEverTick = true;
@@ -42,11 +46,8 @@ AStrategyBuilding::AStrategyBuilding(const FObjectInitializer& ObjectInitializer
 
 	SetCanBeDamaged(false);
 
-	static ConstructorHelpers::FObjectFinder<USoundCue> StartCueObj(TEXT("/Game/Sounds/Interactive_Objects/Building_ConstructionStart_Cue"));
-	ConstructionStartStinger = StartCueObj.Object;
-
-	static ConstructorHelpers::FObjectFinder<USoundCue> EndCueObj(TEXT("/Game/Sounds/Interactive_Objects/Building_ConstructionFinished_Cue"));
-	ConstructionEndStinger = EndCueObj.Object;
+	ConstructionStartStinger = TSoftObjectPtr<USoundCue>(FSoftObjectPath(TEXT("/Game/Sounds/Interactive_Objects/Building_ConstructionStart_Cue.Building_ConstructionStart_Cue")));
+	ConstructionEndStinger = TSoftObjectPtr<USoundCue>(FSoftObjectPath(TEXT("/Game/Sounds/Interactive_Objects/Building_ConstructionFinished_Cue.Building_ConstructionFinished_Cue")));
 }
 
 void AStrategyBuilding::PostLoad()
@@ -60,22 +61,71 @@ void AStrategyBuilding::PostLoad()
 	}
 }
 
+void AStrategyBuilding::PostActorCreated()
+{
+	Super::PostActorCreated();
+
+	// level buildings are in the baked navmesh already, only the ones spawned while playing need carving
+	if (GetWorld() && GetWorld()->IsGameWorld())
+	{
+		bIsNavFootprint = true;
+
+		// native components registered with navigation before we knew
+		FNavigationSystem::UpdateActorAndComponentData(*this);
+	}
+}
+
+bool AStrategyBuilding::IsComponentRelevantForNavigation(UActorComponent* Component) const
+{
+	return !bIsNavFootprint && Super::IsComponentRelevantForNavigation(Component);
+}
+
 void AStrategyBuilding::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
+	// in the entity table before joining a team, team building lists keep handles
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities != nullptr && !EntityHandle.IsSet())
+	{
+		EntityHandle = Entities->Add(this, EStrategyEntity::Building, GetTeamNum());
+	}
+
 	if (SpawnTeamNum != EStrategyTeam::Unknown)
 	{
 		SetTeamNum(SpawnTeamNum);
 	}
 }
 
+void AStrategyBuilding::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AStrategyGameState* const StrategyGame = GetWorld()->GetGameState<AStrategyGameState>();
+	if (StrategyGame != nullptr && bIsNavFootprint)
+	{
+		StrategyGame->GetNavFootprints().AddBuilding(this);
+	}
+}
+
 void AStrategyBuilding::Destroyed()
 {
-	FPlayerData* const PlayerData = GetTeamData();
+	AStrategyGameState* const StrategyGame = GetWorld()->GetGameState<AStrategyGameState>();
+	FPlayerData* const PlayerData = StrategyGame ? StrategyGame->GetPlayerData(RegisteredTeamNum) : nullptr;
 	if (PlayerData != nullptr)
 	{
-		PlayerData->BuildingsList.Remove(this);
+		PlayerData->RemoveBuilding(this);
+	}
+	RegisteredTeamNum = EStrategyTeam::Unknown;
+
+	if (StrategyGame != nullptr)
+	{
+		if (bIsNavFootprint)
+		{
+			StrategyGame->GetNavFootprints().RemoveBuilding(this);
+		}
+		StrategyGame->GetEntities().Remove(EntityHandle);
+		EntityHandle = FStrategyEntityHandle();
 	}
 
 	Super::Destroyed();
@@ -161,11 +211,69 @@ bool AStrategyBuilding::CanAffectChar(AStrategyChar const* InChar) const
 void AStrategyBuilding::SetTeamNum(uint8 NewTeamNum)
 {
 	MyTeamNum = NewTeamNum;
-	FPlayerData* const PlayerData = GetTeamData();
-	if (PlayerData != nullptr)
+
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities != nullptr && !EntityHandle.IsSet())
+	{
+		// deferred spawn not finished yet, team building lists need the handle
+		SpawnTeamNum = (EStrategyTeam::Type)NewTeamNum;
+		return;
+	}
+
+	if (Entities != nullptr)
+	{
+		Entities->SetTeamNum(EntityHandle, NewTeamNum);
+	}
+
+	if (RegisteredTeamNum == NewTeamNum)
+	{
+		return;
+	}
+
+	AStrategyGameState* const StrategyGame = GetWorld()->GetGameState<AStrategyGameState>();
+	if (StrategyGame != nullptr)
+	{
+		FPlayerData* const OldPlayerData = StrategyGame->GetPlayerData(RegisteredTeamNum);
+		if (OldPlayerData != nullptr)
+		{
+			OldPlayerData->RemoveBuilding(this);
+		}
+		RegisteredTeamNum = EStrategyTeam::Unknown;
+
+		FPlayerData* const PlayerData = StrategyGame->GetPlayerData(NewTeamNum);
+		if (PlayerData != nullptr)
+		{
+			PlayerData->AddBuilding(this);
+			RegisteredTeamNum = NewTeamNum;
+		}
+	}
+}
+
+TArray<ABaseCharacter*> AStrategyBuilding::FindNearestEnemies(float Radius, int32 MaxCount)
+{
+	TArray<ABaseCharacter*> Enemies;
+	AStrategyGameState* const StrategyGame = GetWorld()->GetGameState<AStrategyGameState>();
+	if (StrategyGame != nullptr)
 	{
-		PlayerData->BuildingsList.Add(this);
+		StrategyGame->GetTargetIndex().FindNearestEnemies(GetWorld(), EntityHandle, GetActorLocation(), GetTeamNum(), Radius, MaxCount, Enemies);
 	}
+	return Enemies;
+}
+
+ABaseCharacter* AStrategyBuilding::FindWeakestEnemy(float Radius)
+{
+	AStrategyGameState* const StrategyGame = GetWorld()->GetGameState<AStrategyGameState>();
+	return StrategyGame ? StrategyGame->GetTargetIndex().FindWeakestEnemy(GetWorld(), EntityHandle, GetActorLocation(), GetTeamNum(), Radius) : nullptr;
+}
+
+bool AStrategyBuilding::GetInterceptPoint(const AActor* Target, const FVector& ShotOrigin, float ProjectileSpeed, FVector& InterceptPoint) const
+{
+	if (Target == nullptr)
+	{
+		InterceptPoint = ShotOrigin;
+		return false;
+	}
+	return FStrategyTargetIndex::PredictIntercept(ShotOrigin, ProjectileSpeed, Target->GetActorLocation(), Target->GetVelocity(), InterceptPoint);
 }
 
 FPlayerData* AStrategyBuilding::GetTeamData() const
@@ -219,7 +327,7 @@ void AStrategyBuilding::ShowActionMenu()
 						} 
 						else
 						{
-							UpgradeAction->Widget->SetImage(MyHUD->DefaultActionTexture);
+							UpgradeAction->Widget->SetImage(MyHUD->DefaultActionTexture.Get());
 							UpgradeAction->Data.StrButtonText = FText::FromString(DefBuilding->GetBuildingName());
 						}
 					}
@@ -247,20 +355,9 @@ void AStrategyBuilding::HideActionMenu()
 
 int32 AStrategyBuilding::GetBuildingCost(UWorld *World) const
 {
-	int32 BuildingsCounter = 0;
-
-	const APlayerController* MyOwner = GEngine->GetFirstLocalPlayerController(World);
-	FPlayerData* const PlayerData = World ? World->GetGameState<AStrategyGameState>()->GetPlayerData(EStrategyTeam::Player) : nullptr;
-	if (PlayerData != nullptr)
-	{
-		for (int32 Idx = 0; Idx < PlayerData->BuildingsList.Num(); Idx++)
-		{
-			if (PlayerData->BuildingsList[Idx]->GetClass() == this->GetClass())
-			{
-				BuildingsCounter++;
-			}
-		}
-	}
+	AStrategyGameState* const StrategyGame = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	const FPlayerData* const PlayerData = StrategyGame ? StrategyGame->GetPlayerData(EStrategyTeam::Player) : nullptr;
+	const int32 BuildingsCounter = PlayerData ? PlayerData->GetBuildingCount(GetClass()) : 0;
 
 	return Cost + BuildingsCounter * AdditionalCost;
 }
@@ -281,21 +378,22 @@ bool AStrategyBuilding::ReplaceBuilding(TSubclassOf<AStrategyBuilding> NewBuildi
 		AStrategyBuilding* const NewBuilding = GetWorld()->SpawnActorDeferred<AStrategyBuilding>(NewBuildingClass, GetTransform(), nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
 		if (NewBuilding)
 		{
-			NewBuilding->SetTeamNum(GetTeamNum());
+			// joins the team once it's in the entity table
+			NewBuilding->SpawnTeamNum = (EStrategyTeam::Type)GetTeamNum();
 			UGameplayStatics::FinishSpawningActor(NewBuilding, GetTransform());
 
-			FPlayerData* const TeamData = NewBuilding->GetTeamData();
-			check(TeamData);
-			if(TeamData != nullptr )
+			AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+			check(MyGameState);
+			if (MyGameState != nullptr)
 			{
-				TeamData->ResourcesAvailable -= BuildingCost;
+				MyGameState->AddResources(NewBuilding->GetTeamNum(), -BuildingCost);
 			}
 
 			AStrategyGameMode const* const MyGame = GetWorld()->GetAuthGameMode<AStrategyGameMode>();
 			check(MyGame);
 			if( MyGame != nullptr )
 			{
-				if (NewBuildingClass != MyGame->EmptyWallSlotClass)
+				if (NewBuildingClass != MyGame->EmptyWallSlotClass.Get())
 				{
 					NewBuilding->StartBuild();
 				}
@@ -326,9 +424,10 @@ bool AStrategyBuilding::StartBuild()
 		OnBuildStarted();
 
 		SetActorTickEnabled(true);
-		if (ConstructionStartStinger)
+		USoundCue* const StartStinger = ConstructionStartStinger.Get();
+		if (StartStinger)
 		{
-			UGameplayStatics::PlaySoundAtLocation(this, ConstructionStartStinger, GetActorLocation());
+			FStrategyAudioRouter::PlaySoundAtLocation(this, StartStinger, GetActorLocation(), EStrategySoundCategory::Building);
 		}
 		return true;
 	}
@@ -365,12 +464,19 @@ void AStrategyBuilding::FinishBuild()
 		RemainingBuildTime = 0;
 		Health = GetMaxHealth();
 
-		if (ConstructionEndStinger)
+		USoundCue* const EndStinger = ConstructionEndStinger.Get();
+		if (EndStinger)
 		{
-			UGameplayStatics::PlaySoundAtLocation(this, ConstructionEndStinger, GetActorLocation());
+			FStrategyAudioRouter::PlaySoundAtLocation(this, EndStinger, GetActorLocation(), EStrategySoundCategory::Building);
 		}
 		OnBuildFinished();
 		BuildFinishedDelegate.ExecuteIfBound(this);
+
+		FStrategyGameplayEvent FinishedEvent;
+		FinishedEvent.Type = EStrategyGameplayEvent::BuildingFinished;
+		FinishedEvent.TeamNum = GetTeamNum();
+		FinishedEvent.Actor = this;
+		FStrategyGameplayEventBus::Post(GetWorld(), FinishedEvent);
 	}
 }
 
@@ -411,3 +517,15 @@ int32 AStrategyBuilding::GetMaxHealth() const
 {
 	return GetClass()->GetDefaultObject<AStrategyBuilding>()->GetHealth();
 }
+
+void AStrategyBuilding::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	const TSoftObjectPtr<USoundCue>* const Stingers[] = { &ConstructionStartStinger, &ConstructionEndStinger, &UpgradeStinger };
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Stingers); i++)
+	{
+		if (!Stingers[i]->IsNull())
+		{
+			OutAssets.AddUnique(Stingers[i]->ToSoftObjectPath());
+		}
+	}
+}
@@ -28,12 +28,12 @@ void AStrategyBuilding_Brewery::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
 	FPlayerData* const MyData = GetTeamData();
 	if (MyData)
 	{
 		int32 ResourceInitial = 0;
 
-		AStrategyGameState const* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
 		if (MyGameState)
 		{
 			switch (MyGameState->GameDifficulty)
@@ -52,11 +52,40 @@ void AStrategyBuilding_Brewery::PostInitializeComponents()
 			}
 		}
 
-		MyData->ResourcesAvailable = ResourceInitial;
+		MyGameState->SetResources(GetTeamNum(), ResourceInitial);
 		MyData->Brewery = this;
 	}
 }
 
+void AStrategyBuilding_Brewery::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (MyGameState)
+	{
+		GameplayStateHandle = MyGameState->GetEventBus().Subscribe(EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::GameplayStateChanged), EStrategyTeam::AllMask,
+			FOnStrategyGameplayEvent::CreateUObject(this, &AStrategyBuilding_Brewery::OnGameplayEvent));
+	}
+}
+
+void AStrategyBuilding_Brewery::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (MyGameState)
+	{
+		MyGameState->GetEventBus().Unsubscribe(GameplayStateHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AStrategyBuilding_Brewery::OnGameplayEvent(const FStrategyGameplayEvent& Event)
+{
+	// every change is passed on, even when several happen in one frame
+	OnGameplayStateChange((EGameplayState::Type)FMath::TruncToInt(Event.Value));
+}
+
 void AStrategyBuilding_Brewery::OnGameplayStateChange(EGameplayState::Type NewState)
 {
 	if (AIDirector != nullptr)
@@ -112,9 +141,10 @@ bool AStrategyBuilding_Brewery::ReplaceBuilding(TSubclassOf<AStrategyBuilding> N
 	if (NewBuilding)
 	{
 		NewBuilding->BuildFinishedDelegate.BindUObject(this, &AStrategyBuilding_Brewery::OnConstructedBuilding);
-		if (UpgradeStinger)
+		USoundCue* const Stinger = UpgradeStinger.Get();
+		if (Stinger)
 		{
-			UGameplayStatics::PlaySoundAtLocation(this, UpgradeStinger, GetActorLocation());
+			FStrategyAudioRouter::PlaySoundAtLocation(this, Stinger, GetActorLocation(), EStrategySoundCategory::Building);
 		}
 	}
 
@@ -137,7 +167,7 @@ void AStrategyBuilding_Brewery::ShowActionMenu()
 		{
 			TSharedPtr<FActionButtonInfo> const CenterAction = MyHUD->GetActionButton(4);
 			CenterAction->Widget->DeferredShow();
-			CenterAction->Widget->SetImage(MyHUD->DefaultCenterActionTexture);
+			CenterAction->Widget->SetImage(MyHUD->DefaultCenterActionTexture.Get());
 			CenterAction->Data.ActionCost = SpawnCost;
 			CenterAction->Data.Visibility = EVisibility::Visible;
 			CenterAction->Data.GetQueueLengthDelegate.BindUObject(this, &AStrategyBuilding_Brewery::GetSpawnQueueLength);
@@ -158,7 +188,7 @@ bool AStrategyBuilding_Brewery::SpawnDwarf()
 	if (MyData && int32(MyData->ResourcesAvailable) >= SpawnCost && AIDirector != nullptr)
 	{
 		AIDirector->RequestSpawn();
-		MyData->ResourcesAvailable -= SpawnCost;
+		GetWorld()->GetGameState<AStrategyGameState>()->AddResources(GetTeamNum(), -SpawnCost);
 	}
 
 	return false;
@@ -0,0 +1,269 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyNavFootprints.h"
+#include "StrategyBuilding.h"
+#include "NavigationSystem.h"
+#include "AI/NavigationModifier.h"
+#include "NavAreas/NavArea_Null.h"
+#include "NavMesh/RecastNavMesh.h"
+
+DECLARE_CYCLE_STAT(TEXT("Nav footprints flush"), STAT_StrategyNavFootprintsFlush, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav footprints changed"), STAT_StrategyNavFootprintsChanged, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav footprints kept"), STAT_StrategyNavFootprintsKept, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav tiles dirtied"), STAT_StrategyNavTilesDirtied, STATGROUP_StrategyGame);
+
+/** building locations are matched at this precision */
+static const float FootprintKeyPrecision = 10.0f;
+
+/** footprints differing less than this are the same */
+static const float FootprintTolerance = 1.0f;
+
+UStrategyNavFootprint::UStrategyNavFootprint(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	Bounds.Init();
+	LocalBounds.Init();
+	AreaClass = UNavArea_Null::StaticClass();
+}
+
+void UStrategyNavFootprint::GetNavigationData(FNavigationRelevantData& Data) const
+{
+	if (Bounds.IsValid)
+	{
+		// rotated box is exported as convex shape
+		Data.Modifiers.Add(FAreaNavModifier(LocalBounds, Transform, AreaClass));
+	}
+}
+
+void UStrategyNavFootprint::SetFootprint(const FBox& InLocalBounds, const FTransform& InTransform)
+{
+	LocalBounds = InLocalBounds;
+	Transform = InTransform;
+	Bounds = LocalBounds.TransformBy(Transform);
+}
+
+bool UStrategyNavFootprint::IsSameFootprint(const FBox& InLocalBounds, const FTransform& InTransform) const
+{
+	return Bounds.IsValid && InLocalBounds.IsValid
+		&& LocalBounds.Min.Equals(InLocalBounds.Min, FootprintTolerance) && LocalBounds.Max.Equals(InLocalBounds.Max, FootprintTolerance)
+		&& Transform.GetLocation().Equals(InTransform.GetLocation(), FootprintTolerance)
+		&& Transform.GetRotation().Equals(InTransform.GetRotation(), KINDA_SMALL_NUMBER);
+}
+
+FStrategyNavFootprints::FStrategyNavFootprints()
+	: RebuildDelay(0.2f)
+	, Padding(0.0f)
+	, TimeToFlush(-1.0f)
+{
+}
+
+void FStrategyNavFootprints::Configure(float InRebuildDelay, float InPadding)
+{
+	// buildings may have registered already, keep them
+	RebuildDelay = FMath::Max(InRebuildDelay, 0.0f);
+	Padding = FMath::Max(InPadding, 0.0f);
+}
+
+FIntVector FStrategyNavFootprints::GetKey(const AStrategyBuilding* Building)
+{
+	const FVector Location = Building->GetActorLocation();
+	return FIntVector(FMath::RoundToInt(Location.X / FootprintKeyPrecision), FMath::RoundToInt(Location.Y / FootprintKeyPrecision),
+		FMath::RoundToInt(Location.Z / FootprintKeyPrecision));
+}
+
+void FStrategyNavFootprints::AddBuilding(AStrategyBuilding* Building)
+{
+	check(Building);
+	const FIntVector Key = GetKey(Building);
+
+	// replacement takes over the footprint of the building it replaces
+	FFootprint* Footprint = Footprints.Find(Key);
+	if (Footprint == nullptr)
+	{
+		Footprint = &Footprints.Add(Key);
+		Footprint->Element = nullptr;
+	}
+	Footprint->Building = Building;
+
+	DirtyKeys.Add(Key);
+	if (TimeToFlush < 0.0f)
+	{
+		TimeToFlush = RebuildDelay;
+	}
+}
+
+void FStrategyNavFootprints::RemoveBuilding(AStrategyBuilding* Building)
+{
+	const FIntVector Key = GetKey(Building);
+	FFootprint* const Footprint = Footprints.Find(Key);
+	if (Footprint == nullptr || (Footprint->Building.IsValid() && Footprint->Building.Get() != Building))
+	{
+		// replaced already
+		return;
+	}
+
+	Footprint->Building = nullptr;
+	DirtyKeys.Add(Key);
+	if (TimeToFlush < 0.0f)
+	{
+		TimeToFlush = RebuildDelay;
+	}
+}
+
+void FStrategyNavFootprints::Tick(UWorld* World, float DeltaSeconds)
+{
+	if (TimeToFlush < 0.0f)
+	{
+		return;
+	}
+
+	TimeToFlush -= DeltaSeconds;
+	if (TimeToFlush <= 0.0f)
+	{
+		TimeToFlush = -1.0f;
+		Flush(World);
+	}
+}
+
+FBox FStrategyNavFootprints::GetBuildingFootprint(const AStrategyBuilding* Building, FTransform& OutTransform) const
+{
+	FBox Footprint(ForceInit);
+
+	// bounds in building space, so rotated buildings don't block the corners of their world bounds
+	OutTransform = FTransform(Building->GetActorQuat(), Building->GetActorLocation());
+	TInlineComponentArray<UPrimitiveComponent*> Components;
+	Building->GetComponents(Components);
+	for (const UPrimitiveComponent* Component : Components)
+	{
+		if (Component->IsRegistered() && Component->IsCollisionEnabled() && Component->GetCollisionResponseToChannel(ECC_Pawn) == ECR_Block)
+		{
+			Footprint += Component->CalcBounds(Component->GetComponentTransform().GetRelativeTransform(OutTransform)).GetBox();
+		}
+	}
+
+	return Footprint.IsValid ? Footprint.ExpandBy(FVector(Padding, Padding, 0.0f)) : Footprint;
+}
+
+void FStrategyNavFootprints::Flush(UWorld* World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_StrategyNavFootprintsFlush);
+
+	UNavigationSystemV1* const NavSys = World ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(World) : nullptr;
+	if (NavSys == nullptr)
+	{
+		DirtyKeys.Reset();
+		return;
+	}
+	FootprintWorld = World;
+
+	TArray<FBox> ChangedAreas;
+	for (const FIntVector& Key : DirtyKeys)
+	{
+		FFootprint* const Footprint = Footprints.Find(Key);
+		if (Footprint == nullptr)
+		{
+			continue;
+		}
+
+		const AStrategyBuilding* const Building = Footprint->Building.Get();
+		FTransform NewTransform;
+		const FBox NewBounds = Building ? GetBuildingFootprint(Building, NewTransform) : FBox(ForceInit);
+		UStrategyNavFootprint* const Element = Footprint->Element;
+
+		if (Element == nullptr && !NewBounds.IsValid)
+		{
+			// came and went before it got registered
+			Footprints.Remove(Key);
+			continue;
+		}
+
+		if (Element != nullptr && Element->IsSameFootprint(NewBounds, NewTransform))
+		{
+			// same footprint, nothing to rebuild
+			INC_DWORD_STAT(STAT_StrategyNavFootprintsKept);
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_StrategyNavFootprintsChanged);
+		if (Element != nullptr)
+		{
+			ChangedAreas.Add(Element->Bounds);
+			NavSys->UnregisterNavOctreeElement(Element, Element, UNavigationSystemV1::OctreeUpdate_Modifiers);
+		}
+
+		if (!NewBounds.IsValid)
+		{
+			Footprints.Remove(Key);
+			continue;
+		}
+
+		UStrategyNavFootprint* const NewElement = Element ? Element : NewObject<UStrategyNavFootprint>(GetTransientPackage());
+		NewElement->SetFootprint(NewBounds, NewTransform);
+		NavSys->RegisterNavOctreeElement(NewElement, NewElement, UNavigationSystemV1::OctreeUpdate_Modifiers);
+		Footprint->Element = NewElement;
+		ChangedAreas.Add(NewElement->Bounds);
+	}
+	DirtyKeys.Reset();
+
+	if (ChangedAreas.Num() == 0)
+	{
+		return;
+	}
+
+	// navmesh rebuilds just the tiles under changed areas, tell listeners which
+	TArray<FIntPoint> Tiles;
+	const ARecastNavMesh* const NavMesh = Cast<const ARecastNavMesh>(NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate));
+	if (NavMesh != nullptr && NavMesh->TileSizeUU > 0.0f)
+	{
+		const float TileSize = NavMesh->TileSizeUU;
+		for (const FBox& Area : ChangedAreas)
+		{
+			for (float X = Area.Min.X; X < Area.Max.X + TileSize; X += TileSize)
+			{
+				for (float Y = Area.Min.Y; Y < Area.Max.Y + TileSize; Y += TileSize)
+				{
+					int32 TileX = 0;
+					int32 TileY = 0;
+					const FVector Point(FMath::Min(X, Area.Max.X), FMath::Min(Y, Area.Max.Y), Area.GetCenter().Z);
+					if (NavMesh->GetNavMeshTileXY(Point, TileX, TileY))
+					{
+						Tiles.AddUnique(FIntPoint(TileX, TileY));
+					}
+				}
+			}
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_StrategyNavTilesDirtied, Tiles.Num());
+
+	TilesChangedDelegate.Broadcast(Tiles, ChangedAreas);
+}
+
+void FStrategyNavFootprints::Reset()
+{
+	UWorld* const World = FootprintWorld.Get();
+	UNavigationSystemV1* const NavSys = World ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(World) : nullptr;
+	if (NavSys != nullptr)
+	{
+		for (const TPair<FIntVector, FFootprint>& Pair : Footprints)
+		{
+			if (Pair.Value.Element != nullptr)
+			{
+				NavSys->UnregisterNavOctreeElement(Pair.Value.Element, Pair.Value.Element, UNavigationSystemV1::OctreeUpdate_Modifiers);
+			}
+		}
+	}
+
+	Footprints.Reset();
+	DirtyKeys.Reset();
+	FootprintWorld.Reset();
+	TimeToFlush = -1.0f;
+}
+
+void FStrategyNavFootprints::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TPair<FIntVector, FFootprint>& Pair : Footprints)
+	{
+		Collector.AddReferencedObject(Pair.Value.Element);
+	}
+}
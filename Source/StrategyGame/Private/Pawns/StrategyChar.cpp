@@ -3,9 +3,10 @@
 #include "StrategyGame.h"
 #include "StrategyAIController.h"
 #include "StrategyAttachment.h"
+#include "StrategyCharMovement.h"
 
 AStrategyChar::AStrategyChar(const FObjectInitializer& ObjectInitializer) 
-	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCharacterMovementComponent>(ACharacter::CharacterMovementComponentName)) 
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UStrategyCharMovement>(ACharacter::CharacterMovementComponentName)) 
 {
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -23,6 +24,7 @@ AStrategyChar::AStrategyChar(const FObjectInitializer& ObjectInitializer)
 	}
 
 	Health = 100.f;
+	BodyMesh = nullptr;
 }
 
 void AStrategyChar::PostInitializeComponents()
@@ -81,6 +83,7 @@ void AStrategyChar::SetWeaponAttachment(UStrategyAttachment* Weapon)
 			UpdatePawnData();
 			TickHealth();
 		}
+		UpdateMergedMesh();
 	}
 }
 
@@ -102,6 +105,86 @@ void AStrategyChar::SetArmorAttachment(UStrategyAttachment* Armor)
 			UpdatePawnData();
 			TickHealth();
 		}
+		UpdateMergedMesh();
+	}
+}
+
+void AStrategyChar::UpdateMergedMesh()
+{
+	AStrategyGameState* const StrategyGame = GetWorld()->GetGameState<AStrategyGameState>();
+	if (StrategyGame == nullptr || !StrategyGame->bMergeAttachmentMeshes || GetMesh() == nullptr)
+	{
+		return;
+	}
+
+	if (BodyMesh == nullptr)
+	{
+		BodyMesh = GetMesh()->SkeletalMesh;
+	}
+
+	TArray<USkeletalMesh*> Parts;
+	UStrategyAttachment* const Slots[] = { WeaponSlot, ArmorSlot };
+	bool bMergeSlot[UE_ARRAY_COUNT(Slots)];
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Slots); i++)
+	{
+		bMergeSlot[i] = CanMergeAttachment(Slots[i]);
+		if (bMergeSlot[i])
+		{
+			Parts.Add(Slots[i]->SkeletalMesh);
+		}
+	}
+
+	USkeletalMesh* const MergedMesh = Parts.Num() > 0 ? StrategyGame->GetMeshMergeCache().FindOrQueue(BodyMesh, Parts, this) : nullptr;
+	if (MergedMesh == nullptr)
+	{
+		RestoreSeparateMeshes();
+		return;
+	}
+
+	GetMesh()->SetSkeletalMesh(MergedMesh, false);
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Slots); i++)
+	{
+		if (Slots[i] == nullptr)
+		{
+			continue;
+		}
+
+		if (bMergeSlot[i] && Slots[i]->IsRegistered())
+		{
+			// keep the attachments for their effects, just don't tick and draw them
+			Slots[i]->UnregisterComponent();
+		}
+		else if (!bMergeSlot[i] && !Slots[i]->IsRegistered())
+		{
+			Slots[i]->RegisterComponent();
+			Slots[i]->AttachToComponent(GetMesh(), FAttachmentTransformRules::KeepRelativeTransform, Slots[i]->AttachPoint);
+		}
+	}
+}
+
+bool AStrategyChar::CanMergeAttachment(const UStrategyAttachment* Attachment) const
+{
+	// rigid attachments on sockets or with offsets can't be merged into the body
+	const USkeletalMesh* const PartMesh = Attachment ? Attachment->SkeletalMesh : nullptr;
+	return PartMesh != nullptr && BodyMesh != nullptr && PartMesh->Skeleton == BodyMesh->Skeleton
+		&& Attachment->AttachPoint == NAME_None && Attachment->GetRelativeTransform().Equals(FTransform::Identity);
+}
+
+void AStrategyChar::RestoreSeparateMeshes()
+{
+	if (BodyMesh != nullptr && GetMesh()->SkeletalMesh != BodyMesh)
+	{
+		GetMesh()->SetSkeletalMesh(BodyMesh, false);
+	}
+
+	UStrategyAttachment* const Slots[] = { WeaponSlot, ArmorSlot };
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Slots); i++)
+	{
+		if (Slots[i] && !Slots[i]->IsRegistered())
+		{
+			Slots[i]->RegisterComponent();
+			Slots[i]->AttachToComponent(GetMesh(), FAttachmentTransformRules::KeepRelativeTransform, Slots[i]->AttachPoint);
+		}
 	}
 }
 
@@ -169,7 +252,7 @@ void AStrategyChar::TickHealth()
 		if (PawnData.HealthRegen < 0.f)
 		{
 			// negative health regen is a DoT, so do the damage
-			UGameplayStatics::ApplyDamage(this, -PawnData.HealthRegen, Controller, this, UDamageType::StaticClass());
+			FStrategyDamageQueue::ApplyPointDamage(this, -PawnData.HealthRegen, FVector::ZeroVector, FHitResult(), Controller, this, UDamageType::StaticClass());
 		}
 		else
 		{
@@ -0,0 +1,167 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyCharMovement.h"
+#include "StrategyTargetIndex.h"
+#include "NavigationSystem.h"
+
+static TAutoConsoleVariable<int32> CVarNavWalking(TEXT("strategy.NavWalking"), -1,
+	TEXT("Land movement of spawned units.\n")
+	TEXT("-1: per class setting, 0: full walking, 1: nav walking"));
+
+/** below this fraction of max speed unit following path counts as stuck */
+static const float StuckSpeedFraction = 0.1f;
+
+/** most enemies unit is pushed out of in single move */
+static const int32 MaxEnemyContacts = 4;
+
+UStrategyCharMovement::UStrategyCharMovement(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, PreferredVelocity(FVector::ZeroVector)
+	, PreferredVelocityFrame(0)
+	, AvoidanceVelocity(FVector::ZeroVector)
+	, AvoidanceVelocityFrame(0)
+	, MovingTime(0.0f)
+	, StuckTime(0.0f)
+	, CurrentStuckTime(0.0f)
+	, MovedDistance(0.0f)
+{
+	bUseNavWalking = false;
+	bNavWalkingEnemyCollision = true;
+}
+
+void UStrategyCharMovement::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	const int32 NavWalkingOverride = CVarNavWalking.GetValueOnGameThread();
+	const bool bNavWalking = NavWalkingOverride < 0 ? bUseNavWalking : NavWalkingOverride > 0;
+	DefaultLandMovementMode = bNavWalking ? MOVE_NavWalking : MOVE_Walking;
+	if (bNavWalking)
+	{
+		// enemies are handled after the move, everything else is left to the navmesh
+		bSweepWhileNavWalking = false;
+	}
+}
+
+void UStrategyCharMovement::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	const FVector OldLocation = UpdatedComponent ? UpdatedComponent->GetComponentLocation() : FVector::ZeroVector;
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (UpdatedComponent && HasPreferredVelocity())
+	{
+		MovingTime += DeltaTime;
+		MovedDistance += FVector::Dist2D(OldLocation, UpdatedComponent->GetComponentLocation());
+		if (Velocity.Size2D() < GetMaxSpeed() * StuckSpeedFraction)
+		{
+			StuckTime += DeltaTime;
+			CurrentStuckTime += DeltaTime;
+		}
+		else
+		{
+			CurrentStuckTime = 0.0f;
+		}
+	}
+	else
+	{
+		CurrentStuckTime = 0.0f;
+	}
+}
+
+void UStrategyCharMovement::PhysNavWalking(float deltaTime, int32 Iterations)
+{
+	Super::PhysNavWalking(deltaTime, Iterations);
+
+	if (bNavWalkingEnemyCollision && MovementMode == MOVE_NavWalking && !Velocity.IsNearlyZero())
+	{
+		ResolveEnemyOverlaps();
+	}
+}
+
+void UStrategyCharMovement::ResolveEnemyOverlaps()
+{
+	ABaseCharacter* const MyChar = Cast<ABaseCharacter>(CharacterOwner);
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (MyChar == nullptr || MyGameState == nullptr)
+	{
+		return;
+	}
+
+	// enemies are searched as if they were up to twice our size
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const float Radius = MyChar->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	TArray<ABaseCharacter*> Enemies;
+	MyGameState->GetTargetIndex().FindNearestEnemies(GetWorld(), FStrategyEntityHandle(), Location, MyChar->GetTeamNum(), Radius * 3.0f, MaxEnemyContacts, Enemies);
+
+	FVector PushOut = FVector::ZeroVector;
+	for (const ABaseCharacter* const Enemy : Enemies)
+	{
+		const FVector Offset = (Location - Enemy->GetActorLocation()) * FVector(1.0f, 1.0f, 0.0f);
+		const float Distance = Offset.Size();
+		const float Penetration = Radius + Enemy->GetCapsuleComponent()->GetScaledCapsuleRadius() - Distance;
+		if (Penetration > 0.0f && Distance > KINDA_SMALL_NUMBER)
+		{
+			PushOut += Offset / Distance * Penetration;
+		}
+	}
+
+	if (PushOut.IsNearlyZero())
+	{
+		return;
+	}
+
+	// nav walking capsule ignores the world, so keep the push on the navmesh: stop at its edge, skip if off it
+	FVector Target = Location + PushOut;
+	FVector NavHitLocation;
+	if (UNavigationSystemV1::NavigationRaycast(GetWorld(), Location, Target, NavHitLocation, nullptr, MyChar->GetController()))
+	{
+		Target = FVector(NavHitLocation.X, NavHitLocation.Y, Location.Z);
+	}
+	FNavLocation NavFloor;
+	if (!FindNavFloor(Target, NavFloor))
+	{
+		return;
+	}
+
+	// swept, so other units are not pushed into
+	FHitResult Hit;
+	SafeMoveUpdatedComponent(Target - Location, UpdatedComponent->GetComponentQuat(), true, Hit);
+}
+
+void UStrategyCharMovement::RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed)
+{
+	// path following may pass just the direction, avoidance must not aim over max speed
+	const float MaxSpeed = GetMaxSpeed();
+	PreferredVelocity = MoveVelocity.SizeSquared() > 1.0f ? MoveVelocity.GetClampedToMaxSize(MaxSpeed) : MoveVelocity * MaxSpeed;
+	PreferredVelocityFrame = GFrameCounter;
+
+	// avoidance is solved at the end of the frame for the next one
+	if (AvoidanceVelocityFrame + 1 >= GFrameCounter && !MoveVelocity.IsNearlyZero())
+	{
+		Super::RequestDirectMove(AvoidanceVelocity, false);
+		return;
+	}
+
+	Super::RequestDirectMove(MoveVelocity, bForceMaxSpeed);
+}
+
+void UStrategyCharMovement::StopActiveMovement()
+{
+	Super::StopActiveMovement();
+
+	PreferredVelocityFrame = 0;
+	AvoidanceVelocityFrame = 0;
+}
+
+void UStrategyCharMovement::SetAvoidanceVelocity(const FVector& InVelocity)
+{
+	AvoidanceVelocity = InVelocity;
+	AvoidanceVelocityFrame = GFrameCounter;
+}
+
+bool UStrategyCharMovement::HasPreferredVelocity() const
+{
+	return PreferredVelocityFrame != 0 && PreferredVelocityFrame + 1 >= GFrameCounter;
+}
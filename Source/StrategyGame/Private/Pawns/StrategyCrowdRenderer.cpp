@@ -0,0 +1,365 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyCrowdRenderer.h"
+#include "StrategyPlayerController.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd render"), STAT_StrategyCrowdRender, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instanced units"), STAT_StrategyCrowdInstancedUnits, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instance batches"), STAT_StrategyCrowdInstanceBatches, STATGROUP_StrategyGame);
+
+/** instanced units come back this much closer than they leave, so they don't flicker on the border */
+static const float InstanceDistanceHysteresis = 0.1f;
+
+/** units moving slower are idle */
+static const float MinWalkSpeed = 10.0f;
+
+/** units dying within this many seconds share death batch */
+static const float DeathStartStep = 0.25f;
+
+const FStrategyVATClip& FStrategyCrowdRenderData::GetClip(EStrategyCrowdClip::Type Clip) const
+{
+	switch (Clip)
+	{
+		case EStrategyCrowdClip::Walk:		return Walk;
+		case EStrategyCrowdClip::Attack:	return Attack;
+		case EStrategyCrowdClip::Death:		return Death;
+		default:							return Idle;
+	}
+}
+
+FStrategyCrowdRenderer::FStrategyCrowdRenderer()
+	: InstanceDistance(4000.0f)
+	, EventBus(nullptr)
+{
+}
+
+void FStrategyCrowdRenderer::Configure(FStrategyGameplayEventBus& InEventBus, float InInstanceDistance)
+{
+	Reset();
+	InstanceDistance = FMath::Max(InInstanceDistance, 0.0f);
+	EventBus = &InEventBus;
+	EventHandle = EventBus->Subscribe(EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::CharSpawned) | EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::CharDied),
+		EStrategyTeam::AllMask, FOnStrategyGameplayEvent::CreateRaw(this, &FStrategyCrowdRenderer::OnGameplayEvent));
+}
+
+void FStrategyCrowdRenderer::OnGameplayEvent(const FStrategyGameplayEvent& Event)
+{
+	ABaseCharacter* const Char = Cast<ABaseCharacter>(Event.Actor.Get());
+	if (Char == nullptr || !Char->GetCrowdRenderData().IsValid() || Char->GetMesh() == nullptr)
+	{
+		return;
+	}
+
+	if (Event.Type == EStrategyGameplayEvent::CharSpawned)
+	{
+		Registered.Add(Char);
+		return;
+	}
+
+	Registered.RemoveSwap(Char);
+	FUnit* const Unit = Units.Find(Char);
+	if (Unit == nullptr)
+	{
+		// dies as skeletal mesh
+		return;
+	}
+
+	RemoveInstance(Char, Unit->Key);
+	const FStrategyCrowdRenderData& RenderData = Char->GetCrowdRenderData();
+	if (RenderData.Death.NumFrames > 0)
+	{
+		// corpse stays instanced until it's destroyed
+		Unit->Key.Clip = EStrategyCrowdClip::Death;
+		Unit->Key.StartStep = FMath::CeilToInt(Char->GetWorld()->GetTimeSeconds() / DeathStartStep);
+		AddInstance(Char->GetWorld(), Char, Unit->Key, RenderData);
+	}
+	else
+	{
+		SetSkeletalVisible(Char, true, *Unit);
+		Units.Remove(Char);
+	}
+}
+
+EStrategyCrowdClip::Type FStrategyCrowdRenderer::GetClip(const ABaseCharacter* Char)
+{
+	// only attacks are played as montages while alive
+	const UAnimInstance* const AnimInstance = Char->GetMesh() ? Char->GetMesh()->GetAnimInstance() : nullptr;
+	if (AnimInstance != nullptr && AnimInstance->IsAnyMontagePlaying())
+	{
+		return EStrategyCrowdClip::Attack;
+	}
+
+	return Char->GetVelocity().SizeSquared2D() > FMath::Square(MinWalkSpeed) ? EStrategyCrowdClip::Walk : EStrategyCrowdClip::Idle;
+}
+
+void FStrategyCrowdRenderer::Tick(UWorld* World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_StrategyCrowdRender);
+
+	APlayerController* const PlayerController = (World && World->GetNetMode() != NM_DedicatedServer) ? World->GetFirstPlayerController() : nullptr;
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+	{
+		return;
+	}
+
+	const FVector CameraLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	const AStrategyPlayerController* const StrategyController = Cast<AStrategyPlayerController>(PlayerController);
+	const AActor* const SelectedActor = StrategyController ? StrategyController->GetSelectedActor() : nullptr;
+
+	for (int32 Idx = Registered.Num() - 1; Idx >= 0; Idx--)
+	{
+		ABaseCharacter* const TestChar = Registered[Idx].Get();
+		if (TestChar == nullptr)
+		{
+			// destroyed without dying, its instance is removed below
+			Registered.RemoveAtSwap(Idx, 1, false);
+			continue;
+		}
+
+		FUnit* Unit = Units.Find(TestChar);
+		const float SwapDistance = Unit ? InstanceDistance * (1.0f - InstanceDistanceHysteresis) : InstanceDistance;
+		const bool bInstanced = TestChar != SelectedActor &&
+			FVector::DistSquared(TestChar->GetActorLocation(), CameraLocation) > FMath::Square(SwapDistance);
+
+		if (bInstanced)
+		{
+			const FStrategyCrowdRenderData& RenderData = TestChar->GetCrowdRenderData();
+			FBatchKey Key;
+			Key.Mesh = RenderData.Mesh;
+			Key.Material = RenderData.Material;
+			Key.Clip = GetClip(TestChar);
+			Key.StartStep = 0;
+
+			if (Unit == nullptr)
+			{
+				Unit = &Units.Add(TestChar);
+				Unit->Char = TestChar;
+				SetSkeletalVisible(TestChar, false, *Unit);
+				Unit->Key = Key;
+				AddInstance(World, TestChar, Key, RenderData);
+			}
+			else if (!(Unit->Key == Key))
+			{
+				RemoveInstance(TestChar, Unit->Key);
+				Unit->Key = Key;
+				AddInstance(World, TestChar, Key, RenderData);
+			}
+		}
+		else if (Unit != nullptr)
+		{
+			RemoveInstance(TestChar, Unit->Key);
+			SetSkeletalVisible(TestChar, true, *Unit);
+			Units.Remove(TestChar);
+		}
+	}
+
+	// destroyed units, their instances are removed below
+	for (auto It = Units.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().Char.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (auto It = Batches.CreateIterator(); It; ++It)
+	{
+		FBatch& Batch = It.Value();
+		UpdateBatch(Batch);
+
+		// every death moment gets its own batch, they go away with the corpses
+		if (It.Key().StartStep != 0 && Batch.Units.Num() == 0)
+		{
+			if (Batch.Component.IsValid())
+			{
+				Batch.Component->DestroyComponent();
+			}
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FStrategyCrowdRenderer::UpdateBatch(FBatch& Batch)
+{
+	UInstancedStaticMeshComponent* const Component = Batch.Component.Get();
+	if (Component == nullptr)
+	{
+		Batch.Units.Reset();
+		return;
+	}
+
+	for (int32 Idx = Batch.Units.Num() - 1; Idx >= 0; Idx--)
+	{
+		if (!Batch.Units[Idx].IsValid())
+		{
+			RemoveBatchInstance(Batch, Idx);
+		}
+	}
+
+	INC_DWORD_STAT(STAT_StrategyCrowdInstanceBatches);
+	INC_DWORD_STAT_BY(STAT_StrategyCrowdInstancedUnits, Batch.Units.Num());
+	if (Batch.Units.Num() == 0 || Batch.bStatic)
+	{
+		return;
+	}
+
+	// one render state update for the whole batch
+	Batch.Transforms.Reset();
+	for (const TWeakObjectPtr<ABaseCharacter>& BatchUnit : Batch.Units)
+	{
+		Batch.Transforms.Add(BatchUnit->GetMesh()->GetComponentTransform());
+	}
+	Component->BatchUpdateInstancesTransforms(0, Batch.Transforms, true, true, true);
+}
+
+void FStrategyCrowdRenderer::RemoveBatchInstance(FBatch& Batch, int32 Idx)
+{
+	UInstancedStaticMeshComponent* const Component = Batch.Component.Get();
+	const int32 LastIdx = Batch.Units.Num() - 1;
+	if (Idx != LastIdx)
+	{
+		// moving batches are rewritten each frame anyway, corpses need the last one moved into the gap
+		FTransform LastTransform;
+		Component->GetInstanceTransform(LastIdx, LastTransform, true);
+		Component->UpdateInstanceTransform(Idx, LastTransform, true, false, true);
+	}
+	Batch.Units.RemoveAtSwap(Idx, 1, false);
+	Component->RemoveInstance(LastIdx);
+}
+
+FStrategyCrowdRenderer::FBatch* FStrategyCrowdRenderer::FindOrAddBatch(UWorld* World, const FBatchKey& Key, const FStrategyCrowdRenderData& RenderData)
+{
+	FBatch* Batch = Batches.Find(Key);
+	if (Batch != nullptr && Batch->Component.IsValid())
+	{
+		return Batch;
+	}
+
+	AActor* Owner = BatchOwner.Get();
+	if (Owner == nullptr)
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.ObjectFlags |= RF_Transient;
+		Owner = World->SpawnActor<AActor>(SpawnInfo);
+		if (Owner == nullptr)
+		{
+			return nullptr;
+		}
+
+		USceneComponent* const Root = NewObject<USceneComponent>(Owner, TEXT("Root"));
+		Owner->SetRootComponent(Root);
+		Root->RegisterComponent();
+		BatchOwner = Owner;
+	}
+
+	// corpses stay where they fell, only their batches are worth a cluster tree
+	const bool bStatic = Key.StartStep != 0;
+	UInstancedStaticMeshComponent* const Component = bStatic
+		? NewObject<UHierarchicalInstancedStaticMeshComponent>(Owner)
+		: NewObject<UInstancedStaticMeshComponent>(Owner);
+	Component->SetMobility(EComponentMobility::Movable);
+	Component->SetupAttachment(Owner->GetRootComponent());
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Component->SetCanEverAffectNavigation(false);
+	Component->SetStaticMesh(RenderData.Mesh);
+
+	const FStrategyVATClip& Clip = RenderData.GetClip((EStrategyCrowdClip::Type)Key.Clip);
+	UMaterialInstanceDynamic* const Material = UMaterialInstanceDynamic::Create(RenderData.Material, Component);
+	Material->SetScalarParameterValue(TEXT("VATStartFrame"), Clip.StartFrame);
+	Material->SetScalarParameterValue(TEXT("VATNumFrames"), Clip.NumFrames);
+	Material->SetScalarParameterValue(TEXT("VATFrameRate"), RenderData.FrameRate);
+	Material->SetScalarParameterValue(TEXT("VATLoop"), Key.StartStep == 0 ? 1.0f : 0.0f);
+	Material->SetScalarParameterValue(TEXT("VATStartTime"), Key.StartStep * DeathStartStep);
+	for (int32 MaterialIndex = 0; MaterialIndex < Component->GetNumMaterials(); MaterialIndex++)
+	{
+		Component->SetMaterial(MaterialIndex, Material);
+	}
+	Component->RegisterComponent();
+
+	if (Batch == nullptr)
+	{
+		Batch = &Batches.Add(Key);
+	}
+	Batch->Component = Component;
+	Batch->Units.Reset();
+	Batch->bStatic = bStatic;
+	return Batch;
+}
+
+void FStrategyCrowdRenderer::AddInstance(UWorld* World, ABaseCharacter* Char, const FBatchKey& Key, const FStrategyCrowdRenderData& RenderData)
+{
+	FBatch* const Batch = FindOrAddBatch(World, Key, RenderData);
+	if (Batch != nullptr)
+	{
+		Batch->Units.Add(Char);
+		Batch->Component->AddInstanceWorldSpace(Char->GetMesh()->GetComponentTransform());
+	}
+}
+
+void FStrategyCrowdRenderer::RemoveInstance(const ABaseCharacter* Char, const FBatchKey& Key)
+{
+	FBatch* const Batch = Batches.Find(Key);
+	if (Batch == nullptr || !Batch->Component.IsValid())
+	{
+		return;
+	}
+
+	const int32 Idx = Batch->Units.IndexOfByPredicate([Char](const TWeakObjectPtr<ABaseCharacter>& BatchUnit) { return BatchUnit.Get() == Char; });
+	if (Idx != INDEX_NONE)
+	{
+		RemoveBatchInstance(*Batch, Idx);
+	}
+}
+
+void FStrategyCrowdRenderer::SetSkeletalVisible(ABaseCharacter* Char, bool bVisible, FUnit& Unit)
+{
+	USkeletalMeshComponent* const Mesh = Char->GetMesh();
+	if (bVisible)
+	{
+		Mesh->VisibilityBasedAnimTickOption = Unit.SavedTickOption;
+		Mesh->SetVisibility(true, true);
+	}
+	else
+	{
+		// hidden mesh still plays montages, melee damage comes from their notifies
+		Unit.SavedTickOption = Mesh->VisibilityBasedAnimTickOption;
+		Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+		Mesh->SetVisibility(false, true);
+	}
+}
+
+void FStrategyCrowdRenderer::Reset()
+{
+	for (TPair<FBatchKey, FBatch>& Pair : Batches)
+	{
+		for (const TWeakObjectPtr<ABaseCharacter>& BatchUnit : Pair.Value.Units)
+		{
+			ABaseCharacter* const Char = BatchUnit.Get();
+			FUnit* const Unit = Char ? Units.Find(Char) : nullptr;
+			if (Unit != nullptr)
+			{
+				SetSkeletalVisible(Char, true, *Unit);
+			}
+		}
+	}
+
+	AActor* const Owner = BatchOwner.Get();
+	if (Owner != nullptr && !Owner->GetWorld()->bIsTearingDown)
+	{
+		Owner->Destroy();
+	}
+
+	if (EventBus != nullptr)
+	{
+		EventBus->Unsubscribe(EventHandle);
+		EventBus = nullptr;
+	}
+
+	Batches.Reset();
+	Registered.Reset();
+	Units.Reset();
+	BatchOwner.Reset();
+}
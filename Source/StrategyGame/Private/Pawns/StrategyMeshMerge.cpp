@@ -0,0 +1,107 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyMeshMerge.h"
+#include "SkeletalMeshMerge.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mesh merge"), STAT_StrategyMeshMerge, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Merged meshes"), STAT_StrategyMergedMeshes, STATGROUP_StrategyGame);
+
+FStrategyMeshMergeCache::FStrategyMeshMergeCache()
+	: MaxMergesPerFrame(1)
+{
+}
+
+void FStrategyMeshMergeCache::Configure(int32 InMaxMergesPerFrame)
+{
+	MaxMergesPerFrame = FMath::Max(InMaxMergesPerFrame, 1);
+}
+
+USkeletalMesh* FStrategyMeshMergeCache::FindOrQueue(USkeletalMesh* Body, const TArray<USkeletalMesh*>& Parts, AStrategyChar* Requester)
+{
+	FMergeKey Key;
+	Key.Meshes.Add(Body);
+	Key.Meshes.Append(Parts);
+
+	USkeletalMesh** const MergedMesh = MergedMeshes.Find(Key);
+	if (MergedMesh != nullptr)
+	{
+		return *MergedMesh;
+	}
+
+	TPair<FMergeKey, TArray<TWeakObjectPtr<AStrategyChar>>>* QueuedKey = Queue.FindByPredicate([&Key](const TPair<FMergeKey, TArray<TWeakObjectPtr<AStrategyChar>>>& Item) { return Item.Key == Key; });
+	if (QueuedKey == nullptr)
+	{
+		QueuedKey = &Queue[Queue.Emplace(Key, TArray<TWeakObjectPtr<AStrategyChar>>())];
+	}
+	QueuedKey->Value.AddUnique(Requester);
+	return nullptr;
+}
+
+void FStrategyMeshMergeCache::Tick()
+{
+	if (Queue.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategyMeshMerge);
+
+	const int32 NumMerges = FMath::Min(Queue.Num(), MaxMergesPerFrame);
+	TArray<TPair<FMergeKey, TArray<TWeakObjectPtr<AStrategyChar>>>> Merged;
+	for (int32 Idx = 0; Idx < NumMerges; Idx++)
+	{
+		Merged.Add(Queue[Idx]);
+		MergedMeshes.Add(Queue[Idx].Key, Merge(Queue[Idx].Key));
+	}
+	Queue.RemoveAt(0, NumMerges);
+
+	// units may have changed loadout meanwhile, they check themselves
+	for (const TPair<FMergeKey, TArray<TWeakObjectPtr<AStrategyChar>>>& Item : Merged)
+	{
+		for (const TWeakObjectPtr<AStrategyChar>& Requester : Item.Value)
+		{
+			if (Requester.IsValid())
+			{
+				Requester->UpdateMergedMesh();
+			}
+		}
+	}
+}
+
+USkeletalMesh* FStrategyMeshMergeCache::Merge(const FMergeKey& Key)
+{
+	USkeletalMesh* const MergedMesh = NewObject<USkeletalMesh>(GetTransientPackage(), NAME_None, RF_Transient);
+	MergedMesh->Skeleton = Key.Meshes[0]->Skeleton;
+
+	const TArray<FSkelMeshMergeSectionMapping> SectionMappings;
+	FSkeletalMeshMerge Merger(MergedMesh, Key.Meshes, SectionMappings, 0);
+	if (!Merger.DoMerge())
+	{
+		UE_LOG(LogGame, Warning, TEXT("Couldn't merge %s with its attachments, keeping them separate."), *GetNameSafe(Key.Meshes[0]));
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_StrategyMergedMeshes);
+	return MergedMesh;
+}
+
+void FStrategyMeshMergeCache::Reset()
+{
+	MergedMeshes.Reset();
+	Queue.Reset();
+	SET_DWORD_STAT(STAT_StrategyMergedMeshes, 0);
+}
+
+void FStrategyMeshMergeCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TPair<FMergeKey, USkeletalMesh*>& Pair : MergedMeshes)
+	{
+		Collector.AddReferencedObjects(Pair.Key.Meshes);
+		Collector.AddReferencedObject(Pair.Value);
+	}
+	for (TPair<FMergeKey, TArray<TWeakObjectPtr<AStrategyChar>>>& Item : Queue)
+	{
+		Collector.AddReferencedObjects(Item.Key.Meshes);
+	}
+}
@@ -2,6 +2,11 @@
 
 #include "StrategyGame.h"
 #include "StrategyCheatManager.h"
+#include "StrategyMatchSnapshot.h"
+#include "StrategyCharMovement.h"
+#include "StrategyUnitMemory.h"
+#include "StrategyBuilding_Brewery.h"
+#include "StrategyAIDirector.h"
 
 
 UStrategyCheatManager::UStrategyCheatManager(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -15,7 +20,7 @@ void UStrategyCheatManager::AddGold(uint32 NewGold)
 
 	if (TeamData)
 	{
-		TeamData->ResourcesAvailable += NewGold;
+		MyGameState->AddResources(EStrategyTeam::Player, NewGold);
 		TeamData->ResourcesGathered += NewGold;
 
 		AStrategyPlayerController* MyPC = Cast<AStrategyPlayerController>(GetOuter());
@@ -26,3 +31,149 @@ void UStrategyCheatManager::AddGold(uint32 NewGold)
 		}
 	}
 }
+
+void UStrategyCheatManager::ShowTelemetry()
+{
+	AStrategyPlayerController* const MyPC = Cast<AStrategyPlayerController>(GetOuter());
+	AStrategyHUD* const MyHUD = MyPC ? Cast<AStrategyHUD>(MyPC->GetHUD()) : NULL;
+	if (MyHUD)
+	{
+		MyHUD->ToggleTelemetryGraph();
+	}
+}
+
+void UStrategyCheatManager::ShowFogOfWar()
+{
+	AStrategyPlayerController* const MyPC = Cast<AStrategyPlayerController>(GetOuter());
+	AStrategyHUD* const MyHUD = MyPC ? Cast<AStrategyHUD>(MyPC->GetHUD()) : NULL;
+	if (MyHUD)
+	{
+		MyHUD->ToggleFogOfWar();
+	}
+}
+
+void UStrategyCheatManager::SaveSnapshot(const FString& SnapshotName)
+{
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	AStrategyPlayerController* const MyPC = Cast<AStrategyPlayerController>(GetOuter());
+	if (FStrategyMatchSnapshot::Save(MyGameState, SnapshotName) && MyPC)
+	{
+		MyPC->ClientMessage(FString::Printf(TEXT("Snapshot saved: %s"), *FStrategyMatchSnapshot::GetFilename(SnapshotName)));
+	}
+}
+
+void UStrategyCheatManager::LoadSnapshot(const FString& SnapshotName)
+{
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	AStrategyPlayerController* const MyPC = Cast<AStrategyPlayerController>(GetOuter());
+	if (FStrategyMatchSnapshot::Load(MyGameState, SnapshotName) && MyPC)
+	{
+		MyPC->ClientMessage(FString::Printf(TEXT("Snapshot loaded: %s"), *FStrategyMatchSnapshot::GetFilename(SnapshotName)));
+	}
+}
+
+void UStrategyCheatManager::MovementReport(float StuckSeconds)
+{
+	StuckSeconds = StuckSeconds > 0.0f ? StuckSeconds : 2.0f;
+
+	// walking and nav walking
+	int32 NumUnits[2] = { 0, 0 };
+	int32 NumStuckNow[2] = { 0, 0 };
+	float MovingTime[2] = { 0.0f, 0.0f };
+	float StuckTime[2] = { 0.0f, 0.0f };
+	float MovedDistance[2] = { 0.0f, 0.0f };
+	float MaxDistance[2] = { 0.0f, 0.0f };
+	for (const ABaseCharacter* const TestChar : TActorRange<ABaseCharacter>(GetWorld()))
+	{
+		const UStrategyCharMovement* const Movement = Cast<UStrategyCharMovement>(TestChar->GetCharacterMovement());
+		if (Movement == nullptr || TestChar->GetHealth() <= 0)
+		{
+			continue;
+		}
+
+		const int32 Mode = Movement->MovementMode == MOVE_NavWalking ? 1 : 0;
+		NumUnits[Mode]++;
+		NumStuckNow[Mode] += Movement->GetCurrentStuckTime() > StuckSeconds ? 1 : 0;
+		MovingTime[Mode] += Movement->GetMovingTime();
+		StuckTime[Mode] += Movement->GetStuckTime();
+		MovedDistance[Mode] += Movement->GetMovedDistance();
+		MaxDistance[Mode] += Movement->GetMovingTime() * Movement->GetMaxSpeed();
+	}
+
+	AStrategyPlayerController* const MyPC = Cast<AStrategyPlayerController>(GetOuter());
+	for (int32 Mode = 0; Mode < 2; Mode++)
+	{
+		// ground covered against max speed, arrival time grows with its inverse
+		const FString Str = FString::Printf(TEXT("%s: %d units, %.0f%% of max speed on paths, stuck %.1f%% of %.0f s moving, %d stuck now"),
+			Mode == 1 ? TEXT("Nav walking") : TEXT("Walking"), NumUnits[Mode],
+			MaxDistance[Mode] > 0.0f ? MovedDistance[Mode] / MaxDistance[Mode] * 100.0f : 0.0f,
+			MovingTime[Mode] > 0.0f ? StuckTime[Mode] / MovingTime[Mode] * 100.0f : 0.0f, MovingTime[Mode], NumStuckNow[Mode]);
+		UE_LOG(LogGame, Log, TEXT("%s"), *Str);
+		if (MyPC)
+		{
+			MyPC->ClientMessage(Str);
+		}
+	}
+}
+
+void UStrategyCheatManager::UnitMemoryReport(int32 NumUnits)
+{
+	AStrategyGameState* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (MyGameState == nullptr)
+	{
+		return;
+	}
+	NumUnits = NumUnits > 0 ? NumUnits : 100;
+
+	// minions with their director's equipment and zombies, each kind once
+	TArray<FStrategyUnitMemorySetup> Setups;
+	TArray<FVector> Origins;
+	for (int32 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		const FPlayerData* const TeamData = MyGameState->GetPlayerData(TeamNum);
+		const AStrategyBuilding_Brewery* const Brewery = TeamData ? TeamData->Brewery.Get() : nullptr;
+		if (Brewery == nullptr)
+		{
+			continue;
+		}
+
+		FStrategyUnitMemorySetup Setup;
+		Setup.UnitClass = Brewery->DwarfCharClass;
+		Setup.Weapon = Brewery->GetAIDirector()->GetDefaultWeaponClass();
+		Setup.Armor = Brewery->GetAIDirector()->GetDefaultArmorClass();
+		FStrategyUnitMemorySetup ZombieSetup;
+		ZombieSetup.UnitClass = Brewery->ZombieCharClass;
+		for (const FStrategyUnitMemorySetup& NewSetup : { Setup, ZombieSetup })
+		{
+			const bool bKnown = Setups.ContainsByPredicate([&NewSetup](const FStrategyUnitMemorySetup& Test)
+				{ return Test.UnitClass == NewSetup.UnitClass && Test.Weapon == NewSetup.Weapon && Test.Armor == NewSetup.Armor; });
+			if (NewSetup.UnitClass != nullptr && !bKnown)
+			{
+				Setups.Add(NewSetup);
+				Origins.Add(Brewery->GetActorLocation());
+			}
+		}
+	}
+
+	AStrategyPlayerController* const MyPC = Cast<AStrategyPlayerController>(GetOuter());
+	for (int32 Idx = 0; Idx < Setups.Num(); Idx++)
+	{
+		FStrategyUnitMemoryReport Report;
+		if (!Report.Measure(GetWorld(), Setups[Idx], NumUnits, Origins[Idx]))
+		{
+			continue;
+		}
+
+		TArray<FString> Lines;
+		Report.GetLines(MyGameState->UnitMemoryBudgetKB, Lines);
+		for (int32 LineIdx = 0; LineIdx < Lines.Num(); LineIdx++)
+		{
+			UE_LOG(LogGame, Log, TEXT("%s"), *Lines[LineIdx]);
+			// breakdown goes to the log only
+			if (MyPC && LineIdx == 0)
+			{
+				MyPC->ClientMessage(Lines[LineIdx]);
+			}
+		}
+	}
+}
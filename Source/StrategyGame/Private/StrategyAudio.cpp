@@ -0,0 +1,216 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyAudio.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Sound routing"), STAT_StrategyAudioRoute, STATGROUP_StrategyAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sounds played"), STAT_StrategyAudioPlayed, STATGROUP_StrategyAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sounds culled by distance"), STAT_StrategyAudioCulledDistance, STATGROUP_StrategyAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sounds culled by voice limit"), STAT_StrategyAudioCulledLimit, STATGROUP_StrategyAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Voices stolen"), STAT_StrategyAudioStolen, STATGROUP_StrategyAudio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active voices"), STAT_StrategyAudioActiveVoices, STATGROUP_StrategyAudio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled voices"), STAT_StrategyAudioPooledVoices, STATGROUP_StrategyAudio);
+
+/** significance of sounds out of view is scaled by this */
+static const float OutOfViewSignificance = 0.5f;
+
+FStrategyAudioRouter::FStrategyAudioRouter()
+	: VoicesPerCategory(8)
+	, CullDistance(6000.0f)
+	, PoolSize(32)
+{
+}
+
+void FStrategyAudioRouter::Configure(int32 InVoicesPerCategory, float InCullDistance, int32 InPoolSize)
+{
+	Reset();
+	VoicesPerCategory = FMath::Max(InVoicesPerCategory, 1);
+	CullDistance = FMath::Max(InCullDistance, 0.0f);
+	PoolSize = FMath::Max(InPoolSize, 1);
+}
+
+float FStrategyAudioRouter::GetSignificance(UWorld* World, const USoundBase* Sound, const FVector& Location) const
+{
+	// sounds without attenuation play at full volume wherever the camera is
+	APlayerController* const PlayerController = World->GetFirstPlayerController();
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr || !IsAttenuated(Sound))
+	{
+		return 1.0f;
+	}
+
+	// sounds with attenuation are inaudible past their max distance anyway
+	const APlayerCameraManager* const CameraManager = PlayerController->PlayerCameraManager;
+	const FVector ToSound = Location - CameraManager->GetCameraLocation();
+	const float Distance = ToSound.Size();
+	const float MaxDistance = FMath::Min(CullDistance, Sound->GetMaxDistance());
+	if (Distance >= MaxDistance)
+	{
+		return 0.0f;
+	}
+
+	float Significance = 1.0f - Distance / MaxDistance;
+	const float ViewCos = FMath::Cos(FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5f));
+	if (Distance > KINDA_SMALL_NUMBER && FVector::DotProduct(ToSound / Distance, CameraManager->GetCameraRotation().Vector()) < ViewCos)
+	{
+		Significance *= OutOfViewSignificance;
+	}
+	return Significance;
+}
+
+bool FStrategyAudioRouter::IsAttenuated(const USoundBase* Sound)
+{
+	return Sound != nullptr && Sound->GetAttenuationSettingsToApply() != nullptr;
+}
+
+int32 FStrategyAudioRouter::FindVoice(UWorld* World, EStrategySoundCategory::Type Category, float Significance)
+{
+	// components die with the level
+	Voices.RemoveAllSwap([](const FVoice& Voice) { return !Voice.Component.IsValid(); }, false);
+
+	int32 NumPlaying = 0;
+	int32 FreeIndex = INDEX_NONE;
+	int32 WeakestIndex = INDEX_NONE;
+	for (int32 VoiceIndex = 0; VoiceIndex < Voices.Num(); VoiceIndex++)
+	{
+		const UAudioComponent* const Component = Voices[VoiceIndex].Component.Get();
+		if (!Component->IsPlaying())
+		{
+			FreeIndex = VoiceIndex;
+		}
+		else if (Voices[VoiceIndex].Category == Category)
+		{
+			// camera moved since the voice started, its significance is stale
+			Voices[VoiceIndex].Significance = GetSignificance(World, Component->Sound, Component->GetComponentLocation());
+			NumPlaying++;
+			if (WeakestIndex == INDEX_NONE || Voices[VoiceIndex].Significance < Voices[WeakestIndex].Significance)
+			{
+				WeakestIndex = VoiceIndex;
+			}
+		}
+	}
+
+	// over the limit take the least significant voice of the category, if it's less significant
+	if (NumPlaying >= VoicesPerCategory)
+	{
+		if (WeakestIndex != INDEX_NONE && Voices[WeakestIndex].Significance < Significance)
+		{
+			INC_DWORD_STAT(STAT_StrategyAudioStolen);
+			return WeakestIndex;
+		}
+		return INDEX_NONE;
+	}
+
+	if (FreeIndex != INDEX_NONE)
+	{
+		return FreeIndex;
+	}
+
+	if (Voices.Num() >= PoolSize)
+	{
+		// pool is full of other categories' sounds
+		return INDEX_NONE;
+	}
+
+	AActor* Owner = VoiceOwner.Get();
+	if (Owner == nullptr)
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.ObjectFlags |= RF_Transient;
+		Owner = World->SpawnActor<AActor>(SpawnInfo);
+		if (Owner == nullptr)
+		{
+			return INDEX_NONE;
+		}
+		VoiceOwner = Owner;
+	}
+
+	UAudioComponent* const Component = NewObject<UAudioComponent>(Owner);
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->RegisterComponent();
+
+	FVoice& Voice = Voices[Voices.AddUninitialized()];
+	Voice.Component = Component;
+	Voice.Category = Category;
+	Voice.Significance = 0.0f;
+	return Voices.Num() - 1;
+}
+
+bool FStrategyAudioRouter::Play(UWorld* World, USoundBase* Sound, const FVector& Location, EStrategySoundCategory::Type Category, float VolumeMultiplier, float PitchMultiplier)
+{
+	if (Sound == nullptr || World == nullptr || !World->bAllowAudioPlayback || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategyAudioRoute);
+
+	const float Significance = GetSignificance(World, Sound, Location);
+	if (Significance <= 0.0f)
+	{
+		INC_DWORD_STAT(STAT_StrategyAudioCulledDistance);
+		return false;
+	}
+
+	const int32 VoiceIndex = FindVoice(World, Category, Significance);
+	if (VoiceIndex == INDEX_NONE)
+	{
+		INC_DWORD_STAT(STAT_StrategyAudioCulledLimit);
+		return false;
+	}
+
+	FVoice& Voice = Voices[VoiceIndex];
+	Voice.Category = Category;
+	Voice.Significance = Significance;
+
+	UAudioComponent* const Component = Voice.Component.Get();
+	Component->Stop();
+	Component->bAllowSpatialization = IsAttenuated(Sound);
+	Component->SetSound(Sound);
+	Component->SetWorldLocation(Location);
+	Component->SetVolumeMultiplier(VolumeMultiplier);
+	Component->SetPitchMultiplier(PitchMultiplier);
+	Component->Play();
+
+	INC_DWORD_STAT(STAT_StrategyAudioPlayed);
+	return true;
+}
+
+void FStrategyAudioRouter::Tick()
+{
+	int32 NumActive = 0;
+	for (const FVoice& Voice : Voices)
+	{
+		const UAudioComponent* const Component = Voice.Component.Get();
+		NumActive += (Component && Component->IsPlaying()) ? 1 : 0;
+	}
+	SET_DWORD_STAT(STAT_StrategyAudioActiveVoices, NumActive);
+	SET_DWORD_STAT(STAT_StrategyAudioPooledVoices, Voices.Num());
+}
+
+void FStrategyAudioRouter::Reset()
+{
+	AActor* const Owner = VoiceOwner.Get();
+	if (Owner != nullptr && !Owner->GetWorld()->bIsTearingDown)
+	{
+		Owner->Destroy();
+	}
+
+	Voices.Reset();
+	VoiceOwner.Reset();
+}
+
+void FStrategyAudioRouter::PlaySoundAtLocation(const UObject* WorldContextObject, USoundBase* Sound, const FVector& Location, EStrategySoundCategory::Type Category, float VolumeMultiplier, float PitchMultiplier)
+{
+	UWorld* const World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	AStrategyGameState* const MyGameState = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	if (MyGameState == nullptr)
+	{
+		UGameplayStatics::PlaySoundAtLocation(WorldContextObject, Sound, Location, VolumeMultiplier, PitchMultiplier);
+		return;
+	}
+
+	MyGameState->GetAudioRouter().Play(World, Sound, Location, Category, VolumeMultiplier, PitchMultiplier);
+}
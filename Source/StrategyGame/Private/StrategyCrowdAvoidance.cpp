@@ -0,0 +1,423 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyCrowdAvoidance.h"
+#include "StrategyCharMovement.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd avoidance"), STAT_StrategyCrowdAvoidance, STATGROUP_StrategyCrowd);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Steered units"), STAT_StrategyCrowdSteered, STATGROUP_StrategyCrowd);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Avoiding units"), STAT_StrategyCrowdAvoiding, STATGROUP_StrategyCrowd);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Navmesh rejected"), STAT_StrategyCrowdNavRejected, STATGROUP_StrategyCrowd);
+
+/** below this many agents solving on single thread is cheaper */
+static const int32 MinParallelAgents = 32;
+
+/** avoidance turning the unit less than this many degrees off its path is not checked against the navmesh */
+static const float NavProbeMinTurnAngle = 30.0f;
+
+static const float AvoidanceEpsilon = 0.00001f;
+
+/** @return 2D cross product */
+static FORCEINLINE float Det(const FVector2D& A, const FVector2D& B)
+{
+	return A.X * B.Y - A.Y * B.X;
+}
+
+FStrategyCrowdAvoidance::FStrategyCrowdAvoidance()
+	: NeighborDistance(500.0f)
+	, TimeHorizon(1.0f)
+	, MaxNeighbors(8)
+	, NavProbeTime(0.3f)
+{
+}
+
+void FStrategyCrowdAvoidance::Configure(float InNeighborDistance, float InTimeHorizon, int32 InMaxNeighbors, float InNavProbeTime)
+{
+	NeighborDistance = FMath::Max(InNeighborDistance, 10.0f);
+	TimeHorizon = FMath::Max(InTimeHorizon, 0.1f);
+	MaxNeighbors = FMath::Max(InMaxNeighbors, 1);
+	NavProbeTime = FMath::Max(InNavProbeTime, 0.0f);
+	Reset();
+}
+
+void FStrategyCrowdAvoidance::Reset()
+{
+	Agents.Reset();
+	SortedAgents.Reset();
+	Cells.Reset();
+}
+
+void FStrategyCrowdAvoidance::Tick(UWorld* World, float DeltaSeconds)
+{
+	if (World == nullptr || DeltaSeconds <= 0.0f)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategyCrowdAvoidance);
+
+	GatherAgents(World);
+	if (Agents.Num() == 0)
+	{
+		return;
+	}
+
+	// every agent writes only its own result
+	ParallelFor(Agents.Num(), [this, DeltaSeconds](int32 AgentIndex)
+	{
+		SolveAgent(AgentIndex, DeltaSeconds);
+	}, Agents.Num() < MinParallelAgents);
+
+	ApplyVelocities(World);
+}
+
+void FStrategyCrowdAvoidance::GatherAgents(UWorld* World)
+{
+	Agents.Reset();
+	for (ABaseCharacter* TestChar : TActorRange<ABaseCharacter>(World))
+	{
+		UStrategyCharMovement* const Movement = Cast<UStrategyCharMovement>(TestChar->GetCharacterMovement());
+		if (Movement == nullptr || TestChar->bIsDying || TestChar->GetHealth() <= 0 || Movement->MovementMode == MOVE_None)
+		{
+			continue;
+		}
+
+		FAgent& Agent = Agents[Agents.AddUninitialized()];
+		Agent.Movement = Movement;
+		Agent.Location = FVector2D(TestChar->GetActorLocation());
+		Agent.Velocity = FVector2D(Movement->Velocity);
+		Agent.PreferredVelocity = FVector2D(Movement->GetPreferredVelocity());
+		Agent.Radius = TestChar->GetCapsuleComponent()->GetScaledCapsuleRadius();
+		Agent.MaxSpeed = Movement->GetMaxSpeed();
+		Agent.bSteered = Movement->HasPreferredVelocity() && !Agent.PreferredVelocity.IsNearlyZero() && Agent.MaxSpeed > 0.0f;
+		Agent.NewVelocity = Agent.bSteered ? Agent.PreferredVelocity : Agent.Velocity;
+	}
+
+	// sort to grid cells as big as neighbor distance, neighbors are then in the surrounding 3x3 cells
+	SortedAgents.Reset();
+	Cells.Reset();
+	for (int32 AgentIndex = 0; AgentIndex < Agents.Num(); AgentIndex++)
+	{
+		SortedAgents.Add(AgentIndex);
+	}
+	SortedAgents.Sort([this](int32 A, int32 B)
+	{
+		const FIntPoint CellA = GetCell(Agents[A].Location);
+		const FIntPoint CellB = GetCell(Agents[B].Location);
+		return CellA.X != CellB.X ? CellA.X < CellB.X : CellA.Y < CellB.Y;
+	});
+	for (int32 SortedIndex = 0; SortedIndex < SortedAgents.Num(); SortedIndex++)
+	{
+		const FIntPoint Cell = GetCell(Agents[SortedAgents[SortedIndex]].Location);
+		FIntPoint* Range = Cells.Find(Cell);
+		if (Range == nullptr)
+		{
+			Range = &Cells.Add(Cell, FIntPoint(SortedIndex, 0));
+		}
+		Range->Y++;
+	}
+}
+
+FIntPoint FStrategyCrowdAvoidance::GetCell(const FVector2D& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / NeighborDistance), FMath::FloorToInt(Location.Y / NeighborDistance));
+}
+
+void FStrategyCrowdAvoidance::SolveAgent(int32 AgentIndex, float DeltaSeconds)
+{
+	FAgent& Agent = Agents[AgentIndex];
+	if (!Agent.bSteered)
+	{
+		return;
+	}
+
+	// closest neighbors, sorted by distance
+	TArray<TPair<float, int32>, TInlineAllocator<16>> Neighbors;
+	const float NeighborDistanceSq = FMath::Square(NeighborDistance);
+	const FIntPoint AgentCell = GetCell(Agent.Location);
+	for (int32 CellY = AgentCell.Y - 1; CellY <= AgentCell.Y + 1; CellY++)
+	{
+		for (int32 CellX = AgentCell.X - 1; CellX <= AgentCell.X + 1; CellX++)
+		{
+			const FIntPoint* const Range = Cells.Find(FIntPoint(CellX, CellY));
+			if (Range == nullptr)
+			{
+				continue;
+			}
+
+			for (int32 SortedIndex = Range->X; SortedIndex < Range->X + Range->Y; SortedIndex++)
+			{
+				const int32 OtherIndex = SortedAgents[SortedIndex];
+				const float DistSq = (Agents[OtherIndex].Location - Agent.Location).SizeSquared();
+				if (OtherIndex == AgentIndex || DistSq >= NeighborDistanceSq)
+				{
+					continue;
+				}
+				if (Neighbors.Num() == MaxNeighbors && DistSq >= Neighbors.Last().Key)
+				{
+					continue;
+				}
+
+				int32 InsertIndex = Neighbors.Num();
+				while (InsertIndex > 0 && Neighbors[InsertIndex - 1].Key > DistSq)
+				{
+					InsertIndex--;
+				}
+				Neighbors.Insert(TPair<float, int32>(DistSq, OtherIndex), InsertIndex);
+				if (Neighbors.Num() > MaxNeighbors)
+				{
+					Neighbors.Pop(false);
+				}
+			}
+		}
+	}
+
+	if (Neighbors.Num() == 0)
+	{
+		return;
+	}
+
+	// velocity obstacle of every neighbor as a half plane
+	FLineArray Lines;
+	const float InvTimeHorizon = 1.0f / TimeHorizon;
+	const float InvTimeStep = 1.0f / DeltaSeconds;
+	for (const TPair<float, int32>& Neighbor : Neighbors)
+	{
+		const FAgent& Other = Agents[Neighbor.Value];
+		const FVector2D RelativeLocation = Other.Location - Agent.Location;
+		const FVector2D RelativeVelocity = Agent.Velocity - Other.Velocity;
+		const float DistSq = Neighbor.Key;
+		const float CombinedRadius = Agent.Radius + Other.Radius;
+		const float CombinedRadiusSq = FMath::Square(CombinedRadius);
+
+		FLine Line;
+		FVector2D U;
+		if (DistSq > CombinedRadiusSq)
+		{
+			// no collision, vector from cutoff center to relative velocity
+			const FVector2D W = RelativeVelocity - InvTimeHorizon * RelativeLocation;
+			const float WLengthSq = W.SizeSquared();
+			const float DotProduct = W | RelativeLocation;
+
+			if (DotProduct < 0.0f && FMath::Square(DotProduct) > CombinedRadiusSq * WLengthSq)
+			{
+				// project on cutoff circle
+				const float WLength = FMath::Sqrt(WLengthSq);
+				const FVector2D UnitW = W / WLength;
+				Line.Direction = FVector2D(UnitW.Y, -UnitW.X);
+				U = (CombinedRadius * InvTimeHorizon - WLength) * UnitW;
+			}
+			else
+			{
+				// project on legs
+				const float Leg = FMath::Sqrt(DistSq - CombinedRadiusSq);
+				if (Det(RelativeLocation, W) > 0.0f)
+				{
+					Line.Direction = FVector2D(RelativeLocation.X * Leg - RelativeLocation.Y * CombinedRadius, RelativeLocation.X * CombinedRadius + RelativeLocation.Y * Leg) / DistSq;
+				}
+				else
+				{
+					Line.Direction = -FVector2D(RelativeLocation.X * Leg + RelativeLocation.Y * CombinedRadius, -RelativeLocation.X * CombinedRadius + RelativeLocation.Y * Leg) / DistSq;
+				}
+				U = (RelativeVelocity | Line.Direction) * Line.Direction - RelativeVelocity;
+			}
+		}
+		else
+		{
+			// already overlapping, push apart within this frame
+			const FVector2D W = RelativeVelocity - InvTimeStep * RelativeLocation;
+			const float WLength = FMath::Max(W.Size(), AvoidanceEpsilon);
+			const FVector2D UnitW = W / WLength;
+			Line.Direction = FVector2D(UnitW.Y, -UnitW.X);
+			U = (CombinedRadius * InvTimeStep - WLength) * UnitW;
+		}
+
+		// units standing still don't avoid, take the whole responsibility then
+		Line.Point = Agent.Velocity + (Other.bSteered ? 0.5f : 1.0f) * U;
+		Lines.Add(Line);
+	}
+
+	FVector2D NewVelocity = Agent.PreferredVelocity;
+	const int32 LineFail = LinearProgram2(Lines, Agent.MaxSpeed, Agent.PreferredVelocity, false, NewVelocity);
+	if (LineFail < Lines.Num())
+	{
+		LinearProgram3(Lines, LineFail, Agent.MaxSpeed, NewVelocity);
+	}
+	Agent.NewVelocity = NewVelocity;
+}
+
+bool FStrategyCrowdAvoidance::LinearProgram1(const FLineArray& Lines, int32 LineNo, float Radius, const FVector2D& OptVelocity, bool bDirectionOpt, FVector2D& Result)
+{
+	const FLine& Line = Lines[LineNo];
+	const float DotProduct = Line.Point | Line.Direction;
+	const float Discriminant = FMath::Square(DotProduct) + FMath::Square(Radius) - Line.Point.SizeSquared();
+	if (Discriminant < 0.0f)
+	{
+		// max speed circle fully invalidates the line
+		return false;
+	}
+
+	const float SqrtDiscriminant = FMath::Sqrt(Discriminant);
+	float TLeft = -DotProduct - SqrtDiscriminant;
+	float TRight = -DotProduct + SqrtDiscriminant;
+
+	for (int32 Idx = 0; Idx < LineNo; Idx++)
+	{
+		const float Denominator = Det(Line.Direction, Lines[Idx].Direction);
+		const float Numerator = Det(Lines[Idx].Direction, Line.Point - Lines[Idx].Point);
+
+		if (FMath::Abs(Denominator) <= AvoidanceEpsilon)
+		{
+			// parallel lines
+			if (Numerator < 0.0f)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		const float T = Numerator / Denominator;
+		if (Denominator >= 0.0f)
+		{
+			TRight = FMath::Min(TRight, T);
+		}
+		else
+		{
+			TLeft = FMath::Max(TLeft, T);
+		}
+
+		if (TLeft > TRight)
+		{
+			return false;
+		}
+	}
+
+	if (bDirectionOpt)
+	{
+		Result = Line.Point + ((OptVelocity | Line.Direction) > 0.0f ? TRight : TLeft) * Line.Direction;
+	}
+	else
+	{
+		const float T = Line.Direction | (OptVelocity - Line.Point);
+		Result = Line.Point + FMath::Clamp(T, TLeft, TRight) * Line.Direction;
+	}
+	return true;
+}
+
+int32 FStrategyCrowdAvoidance::LinearProgram2(const FLineArray& Lines, float Radius, const FVector2D& OptVelocity, bool bDirectionOpt, FVector2D& Result)
+{
+	if (bDirectionOpt)
+	{
+		// optimize direction, velocity is unit length then
+		Result = OptVelocity * Radius;
+	}
+	else if (OptVelocity.SizeSquared() > FMath::Square(Radius))
+	{
+		Result = OptVelocity.GetSafeNormal() * Radius;
+	}
+	else
+	{
+		Result = OptVelocity;
+	}
+
+	for (int32 Idx = 0; Idx < Lines.Num(); Idx++)
+	{
+		if (Det(Lines[Idx].Direction, Lines[Idx].Point - Result) > 0.0f)
+		{
+			// result doesn't satisfy the constraint
+			const FVector2D TempResult = Result;
+			if (!LinearProgram1(Lines, Idx, Radius, OptVelocity, bDirectionOpt, Result))
+			{
+				Result = TempResult;
+				return Idx;
+			}
+		}
+	}
+	return Lines.Num();
+}
+
+void FStrategyCrowdAvoidance::LinearProgram3(const FLineArray& Lines, int32 BeginLine, float Radius, FVector2D& Result)
+{
+	// infeasible, minimize the penetration of the constraints instead
+	float Distance = 0.0f;
+	for (int32 Idx = BeginLine; Idx < Lines.Num(); Idx++)
+	{
+		if (Det(Lines[Idx].Direction, Lines[Idx].Point - Result) <= Distance)
+		{
+			continue;
+		}
+
+		FLineArray ProjectedLines;
+		for (int32 PrevIdx = 0; PrevIdx < Idx; PrevIdx++)
+		{
+			FLine Line;
+			const float Determinant = Det(Lines[Idx].Direction, Lines[PrevIdx].Direction);
+			if (FMath::Abs(Determinant) <= AvoidanceEpsilon)
+			{
+				if ((Lines[Idx].Direction | Lines[PrevIdx].Direction) > 0.0f)
+				{
+					// same direction
+					continue;
+				}
+				Line.Point = 0.5f * (Lines[Idx].Point + Lines[PrevIdx].Point);
+			}
+			else
+			{
+				Line.Point = Lines[Idx].Point + (Det(Lines[PrevIdx].Direction, Lines[Idx].Point - Lines[PrevIdx].Point) / Determinant) * Lines[Idx].Direction;
+			}
+			Line.Direction = (Lines[PrevIdx].Direction - Lines[Idx].Direction).GetSafeNormal();
+			ProjectedLines.Add(Line);
+		}
+
+		const FVector2D TempResult = Result;
+		if (LinearProgram2(ProjectedLines, Radius, FVector2D(-Lines[Idx].Direction.Y, Lines[Idx].Direction.X), true, Result) < ProjectedLines.Num())
+		{
+			// can only happen because of float rounding, keep the last result
+			Result = TempResult;
+		}
+		Distance = Det(Lines[Idx].Direction, Lines[Idx].Point - Result);
+	}
+}
+
+void FStrategyCrowdAvoidance::ApplyVelocities(UWorld* World)
+{
+	UNavigationSystemV1* const NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	const ANavigationData* const NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+
+	for (const FAgent& Agent : Agents)
+	{
+		if (!Agent.bSteered)
+		{
+			continue;
+		}
+		INC_DWORD_STAT(STAT_StrategyCrowdSteered);
+
+		FVector2D NewVelocity = Agent.NewVelocity;
+		const float PreferredSpeed = Agent.PreferredVelocity.Size();
+		const float NewSpeed = NewVelocity.Size();
+
+		// path is on navmesh, slowing down along it is safe, only velocities turning well away have to be checked
+		const float MinTurnCos = FMath::Cos(FMath::DegreesToRadians(NavProbeMinTurnAngle));
+		const bool bTurns = (NewVelocity | Agent.PreferredVelocity) < NewSpeed * PreferredSpeed * MinTurnCos;
+		if (bTurns && NavData && NavProbeTime > 0.0f && NewSpeed > KINDA_SMALL_NUMBER)
+		{
+			INC_DWORD_STAT(STAT_StrategyCrowdAvoiding);
+
+			const FVector FeetLocation = Agent.Movement->GetActorFeetLocation();
+			const FVector ProbeEnd = FeetLocation + FVector(NewVelocity * NavProbeTime, 0.0f);
+			FVector HitLocation;
+			if (NavData->Raycast(FeetLocation, ProbeEnd, HitLocation, NavData->GetDefaultQueryFilter(), Agent.Movement->GetOwner()))
+			{
+				// going back to the path would walk into the neighbors, only go as far as the navmesh allows
+				INC_DWORD_STAT(STAT_StrategyCrowdNavRejected);
+				const float AllowedDistance = FVector::Dist2D(FeetLocation, HitLocation);
+				NewVelocity = NewVelocity.GetSafeNormal() * FMath::Min(NewSpeed, AllowedDistance / NavProbeTime);
+			}
+		}
+
+		Agent.Movement->SetAvoidanceVelocity(FVector(NewVelocity, 0.0f));
+	}
+}
@@ -0,0 +1,430 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyCrowdBakeCommandlet.h"
+
+#if WITH_EDITOR
+#include "Animation/AnimSequence.h"
+#include "Rendering/SkeletalMeshModel.h"
+#include "Rendering/SkeletalMeshLODModel.h"
+#include "StaticMeshAttributes.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialExpressionAdd.h"
+#include "Materials/MaterialExpressionAppendVector.h"
+#include "Materials/MaterialExpressionClamp.h"
+#include "Materials/MaterialExpressionComponentMask.h"
+#include "Materials/MaterialExpressionConstant.h"
+#include "Materials/MaterialExpressionDivide.h"
+#include "Materials/MaterialExpressionFloor.h"
+#include "Materials/MaterialExpressionFrac.h"
+#include "Materials/MaterialExpressionLinearInterpolate.h"
+#include "Materials/MaterialExpressionMultiply.h"
+#include "Materials/MaterialExpressionPerInstanceRandom.h"
+#include "Materials/MaterialExpressionScalarParameter.h"
+#include "Materials/MaterialExpressionSubtract.h"
+#include "Materials/MaterialExpressionTextureCoordinate.h"
+#include "Materials/MaterialExpressionTextureSampleParameter2D.h"
+#include "Materials/MaterialExpressionTime.h"
+#include "Materials/MaterialExpressionTransform.h"
+
+/** widest vertex animation texture, one column per vertex */
+static const int32 MaxBakedVertices = 8192;
+
+/** adds expression to material graph */
+template<typename ExpressionType>
+static ExpressionType* AddExpression(UMaterial* Material)
+{
+	ExpressionType* const Expression = NewObject<ExpressionType>(Material);
+	Material->Expressions.Add(Expression);
+	return Expression;
+}
+
+/** adds scalar parameter to material graph */
+static UMaterialExpressionScalarParameter* AddScalarParameter(UMaterial* Material, FName Name, float DefaultValue)
+{
+	UMaterialExpressionScalarParameter* const Parameter = AddExpression<UMaterialExpressionScalarParameter>(Material);
+	Parameter->ParameterName = Name;
+	Parameter->DefaultValue = DefaultValue;
+	return Parameter;
+}
+
+/** adds A op B to material graph */
+template<typename ExpressionType>
+static ExpressionType* AddBinary(UMaterial* Material, UMaterialExpression* A, UMaterialExpression* B)
+{
+	ExpressionType* const Expression = AddExpression<ExpressionType>(Material);
+	Expression->A.Connect(0, A);
+	Expression->B.Connect(0, B);
+	return Expression;
+}
+
+/**
+ * Skins vertices of the mesh with current pose.
+ *
+ * @param	LODModel		Source model of the mesh.
+ * @param	RefToLocals		Reference to local matrices of the pose.
+ * @param	OutPositions	Positions in mesh space, by render vertex index.
+ */
+static void SkinVertices(const FSkeletalMeshLODModel& LODModel, const TArray<FMatrix>& RefToLocals, TArray<FVector>& OutPositions)
+{
+	OutPositions.SetNumZeroed(LODModel.NumVertices);
+	for (const FSkelMeshSection& Section : LODModel.Sections)
+	{
+		for (int32 Idx = 0; Idx < Section.SoftVertices.Num(); Idx++)
+		{
+			const FSoftSkinVertex& Vertex = Section.SoftVertices[Idx];
+			FVector Position = FVector::ZeroVector;
+			for (int32 Influence = 0; Influence < MAX_TOTAL_INFLUENCES; Influence++)
+			{
+				const float Weight = Vertex.InfluenceWeights[Influence] / 255.0f;
+				if (Weight > 0.0f)
+				{
+					const int32 BoneIndex = Section.BoneMap[Vertex.InfluenceBones[Influence]];
+					Position += RefToLocals[BoneIndex].TransformPosition(Vertex.Position) * Weight;
+				}
+			}
+			OutPositions[Section.BaseVertexIndex + Idx] = Position;
+		}
+	}
+}
+
+/** @return new asset in its own package */
+template<typename AssetType>
+static AssetType* CreateAsset(const FString& PackagePath, const FString& AssetName)
+{
+	UPackage* const Package = CreatePackage(nullptr, *(PackagePath / AssetName));
+	Package->FullyLoad();
+	return NewObject<AssetType>(Package, *AssetName, RF_Public | RF_Standalone);
+}
+
+/** @return true if the asset's package was written */
+static bool SaveAsset(UObject* Asset)
+{
+	UPackage* const Package = Asset->GetOutermost();
+	Package->MarkPackageDirty();
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+	return UPackage::SavePackage(Package, Asset, RF_Public | RF_Standalone, *Filename);
+}
+
+/** static mesh of the skeletal mesh in reference pose, second UV channel addresses vertex columns of the texture */
+static UStaticMesh* BakeStaticMesh(USkeletalMesh* SkeletalMesh, const FSkeletalMeshLODModel& LODModel, float MaxOffset, const FString& PackagePath, const FString& AssetName)
+{
+	UStaticMesh* const StaticMesh = CreateAsset<UStaticMesh>(PackagePath, AssetName);
+	StaticMesh->SetNumSourceModels(1);
+	FStaticMeshSourceModel& SourceModel = StaticMesh->GetSourceModel(0);
+	SourceModel.BuildSettings.bRecomputeNormals = false;
+	SourceModel.BuildSettings.bRecomputeTangents = false;
+	SourceModel.BuildSettings.bRemoveDegenerates = false;
+	SourceModel.BuildSettings.bUseFullPrecisionUVs = true;
+	SourceModel.BuildSettings.bGenerateLightmapUVs = false;
+
+	FMeshDescription* const MeshDescription = StaticMesh->CreateMeshDescription(0);
+	FStaticMeshAttributes Attributes(*MeshDescription);
+	TVertexAttributesRef<FVector> Positions = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesRef<FVector> Normals = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector> Tangents = Attributes.GetVertexInstanceTangents();
+	TVertexInstanceAttributesRef<float> BinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+	TVertexInstanceAttributesRef<FVector2D> UVs = Attributes.GetVertexInstanceUVs();
+	TPolygonGroupAttributesRef<FName> SlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+	UVs.SetNumIndices(2);
+
+	TArray<FPolygonGroupID> Groups;
+	for (const FSkeletalMaterial& Material : SkeletalMesh->Materials)
+	{
+		const FPolygonGroupID Group = MeshDescription->CreatePolygonGroup();
+		SlotNames[Group] = Material.MaterialSlotName;
+		StaticMesh->StaticMaterials.Add(FStaticMaterial(Material.MaterialInterface, Material.MaterialSlotName, Material.MaterialSlotName));
+		Groups.Add(Group);
+	}
+
+	// one vertex instance per render vertex, so vertex columns stay what the texture was baked with
+	TArray<FVertexInstanceID> Instances;
+	Instances.SetNum(LODModel.NumVertices);
+	for (const FSkelMeshSection& Section : LODModel.Sections)
+	{
+		for (int32 Idx = 0; Idx < Section.SoftVertices.Num(); Idx++)
+		{
+			const FSoftSkinVertex& Vertex = Section.SoftVertices[Idx];
+			const int32 VertexIndex = Section.BaseVertexIndex + Idx;
+			const FVertexID VertexID = MeshDescription->CreateVertex();
+			Positions[VertexID] = Vertex.Position;
+
+			const FVertexInstanceID Instance = MeshDescription->CreateVertexInstance(VertexID);
+			const FVector TangentZ = Vertex.TangentZ;
+			Normals[Instance] = TangentZ;
+			Tangents[Instance] = Vertex.TangentX;
+			BinormalSigns[Instance] = GetBasisDeterminantSign(Vertex.TangentX, Vertex.TangentY, TangentZ);
+			UVs.Set(Instance, 0, Vertex.UVs[0]);
+			UVs.Set(Instance, 1, FVector2D((VertexIndex + 0.5f) / LODModel.NumVertices, 0.0f));
+			Instances[VertexIndex] = Instance;
+		}
+	}
+
+	for (const FSkelMeshSection& Section : LODModel.Sections)
+	{
+		const FPolygonGroupID Group = Groups.IsValidIndex(Section.MaterialIndex) ? Groups[Section.MaterialIndex] : Groups[0];
+		for (uint32 Triangle = 0; Triangle < Section.NumTriangles; Triangle++)
+		{
+			const uint32 FirstIndex = Section.BaseIndex + Triangle * 3;
+			TArray<FVertexInstanceID> Corners;
+			Corners.Add(Instances[LODModel.IndexBuffer[FirstIndex]]);
+			Corners.Add(Instances[LODModel.IndexBuffer[FirstIndex + 1]]);
+			Corners.Add(Instances[LODModel.IndexBuffer[FirstIndex + 2]]);
+			MeshDescription->CreatePolygon(Group, Corners);
+		}
+	}
+
+	// animated vertices leave the reference pose bounds
+	StaticMesh->PositiveBoundsExtension = FVector(MaxOffset);
+	StaticMesh->NegativeBoundsExtension = FVector(MaxOffset);
+
+	StaticMesh->CommitMeshDescription(0);
+	StaticMesh->Build(true);
+	return StaticMesh;
+}
+
+/**
+ * Material moving the vertices by the texture. Row of the frame:
+ *   looped:	StartFrame + floor(frac(Time * FrameRate / NumFrames + PerInstanceRandom) * NumFrames)
+ *   once:		StartFrame + floor(clamp((Time - StartTime) * FrameRate, 0, NumFrames - 1))
+ */
+static UMaterial* BakeMaterial(UTexture2D* PositionTexture, int32 TextureFrames, float FrameRate, UTexture* BaseColorTexture, const FString& PackagePath, const FString& AssetName)
+{
+	UMaterial* const Material = CreateAsset<UMaterial>(PackagePath, AssetName);
+	Material->bUsedWithInstancedStaticMeshes = true;
+
+	UMaterialExpression* const Time = AddExpression<UMaterialExpressionTime>(Material);
+	UMaterialExpression* const Rate = AddScalarParameter(Material, TEXT("VATFrameRate"), FrameRate);
+	UMaterialExpression* const NumFrames = AddScalarParameter(Material, TEXT("VATNumFrames"), 1.0f);
+	UMaterialExpression* const StartFrame = AddScalarParameter(Material, TEXT("VATStartFrame"), 0.0f);
+	UMaterialExpression* const StartTime = AddScalarParameter(Material, TEXT("VATStartTime"), 0.0f);
+	UMaterialExpression* const Loop = AddScalarParameter(Material, TEXT("VATLoop"), 1.0f);
+	UMaterialExpression* const Rows = AddScalarParameter(Material, TEXT("VATTextureFrames"), TextureFrames);
+
+	UMaterialExpression* const Cycles = AddBinary<UMaterialExpressionAdd>(Material,
+		AddBinary<UMaterialExpressionDivide>(Material, AddBinary<UMaterialExpressionMultiply>(Material, Time, Rate), NumFrames),
+		AddExpression<UMaterialExpressionPerInstanceRandom>(Material));
+	UMaterialExpressionFrac* const CyclePhase = AddExpression<UMaterialExpressionFrac>(Material);
+	CyclePhase->Input.Connect(0, Cycles);
+	UMaterialExpression* const LoopFrame = AddBinary<UMaterialExpressionMultiply>(Material, CyclePhase, NumFrames);
+
+	UMaterialExpressionSubtract* const LastFrame = AddExpression<UMaterialExpressionSubtract>(Material);
+	LastFrame->A.Connect(0, NumFrames);
+	LastFrame->ConstB = 1.0f;
+	UMaterialExpressionClamp* const OnceFrame = AddExpression<UMaterialExpressionClamp>(Material);
+	OnceFrame->Input.Connect(0, AddBinary<UMaterialExpressionMultiply>(Material, AddBinary<UMaterialExpressionSubtract>(Material, Time, StartTime), Rate));
+	OnceFrame->MinDefault = 0.0f;
+	OnceFrame->Max.Connect(0, LastFrame);
+
+	UMaterialExpressionLinearInterpolate* const ClipFrame = AddExpression<UMaterialExpressionLinearInterpolate>(Material);
+	ClipFrame->A.Connect(0, OnceFrame);
+	ClipFrame->B.Connect(0, LoopFrame);
+	ClipFrame->Alpha.Connect(0, Loop);
+	UMaterialExpressionFloor* const Frame = AddExpression<UMaterialExpressionFloor>(Material);
+	Frame->Input.Connect(0, ClipFrame);
+
+	// texel centers
+	UMaterialExpressionAdd* const Row = AddBinary<UMaterialExpressionAdd>(Material, StartFrame, Frame);
+	UMaterialExpressionAdd* const RowCenter = AddExpression<UMaterialExpressionAdd>(Material);
+	RowCenter->A.Connect(0, Row);
+	RowCenter->ConstB = 0.5f;
+
+	UMaterialExpressionTextureCoordinate* const VertexUV = AddExpression<UMaterialExpressionTextureCoordinate>(Material);
+	VertexUV->CoordinateIndex = 1;
+	UMaterialExpressionComponentMask* const Column = AddExpression<UMaterialExpressionComponentMask>(Material);
+	Column->Input.Connect(0, VertexUV);
+	Column->R = true;
+
+	UMaterialExpressionTextureSampleParameter2D* const Offset = AddExpression<UMaterialExpressionTextureSampleParameter2D>(Material);
+	Offset->ParameterName = TEXT("VATPositions");
+	Offset->Texture = PositionTexture;
+	Offset->SamplerType = SAMPLERTYPE_LinearColor;
+	Offset->MipValueMode = TMVM_MipLevel;
+	Offset->ConstMipValue = 0;
+	Offset->Coordinates.Connect(0, AddBinary<UMaterialExpressionAppendVector>(Material, Column, AddBinary<UMaterialExpressionDivide>(Material, RowCenter, Rows)));
+
+	UMaterialExpressionTransform* const WorldOffset = AddExpression<UMaterialExpressionTransform>(Material);
+	WorldOffset->Input.Connect(0, Offset);
+	WorldOffset->TransformSourceType = TRANSFORMSOURCE_Local;
+	WorldOffset->TransformType = TRANSFORM_World;
+	Material->WorldPositionOffset.Connect(0, WorldOffset);
+
+	if (BaseColorTexture != nullptr)
+	{
+		UMaterialExpressionTextureSampleParameter2D* const BaseColor = AddExpression<UMaterialExpressionTextureSampleParameter2D>(Material);
+		BaseColor->ParameterName = TEXT("BaseColor");
+		BaseColor->Texture = BaseColorTexture;
+		Material->BaseColor.Connect(0, BaseColor);
+	}
+	else
+	{
+		UMaterialExpressionConstant* const BaseColor = AddExpression<UMaterialExpressionConstant>(Material);
+		BaseColor->R = 0.5f;
+		Material->BaseColor.Connect(0, BaseColor);
+	}
+
+	Material->PostEditChange();
+	return Material;
+}
+#endif // WITH_EDITOR
+
+UStrategyCrowdBakeCommandlet::UStrategyCrowdBakeCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UStrategyCrowdBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	static const TCHAR* const ClipParams[EStrategyCrowdClip::MAX] = { TEXT("Idle="), TEXT("Walk="), TEXT("Attack="), TEXT("Death=") };
+
+	FString UnitPath;
+	FString OutputPath;
+	if (!FParse::Value(*Params, TEXT("Unit="), UnitPath) || !FParse::Value(*Params, TEXT("Output="), OutputPath))
+	{
+		UE_LOG(LogGame, Error, TEXT("Usage: -run=StrategyCrowdBake -Unit=<class path> -Output=<package path> -Idle=<anim> -Walk=<anim> -Attack=<anim> [-Death=<anim>] [-BaseColor=<texture>]"));
+		return 1;
+	}
+
+	UClass* const UnitClass = LoadClass<ABaseCharacter>(nullptr, *UnitPath);
+	const ABaseCharacter* const UnitCDO = UnitClass ? UnitClass->GetDefaultObject<ABaseCharacter>() : nullptr;
+	USkeletalMesh* const SkeletalMesh = (UnitCDO && UnitCDO->GetMesh()) ? UnitCDO->GetMesh()->SkeletalMesh : nullptr;
+	if (SkeletalMesh == nullptr || SkeletalMesh->GetImportedModel() == nullptr || SkeletalMesh->GetImportedModel()->LODModels.Num() == 0)
+	{
+		UE_LOG(LogGame, Error, TEXT("No skeletal mesh with source model in %s"), *UnitPath);
+		return 1;
+	}
+
+	// layout comes from the config of the native class, which is where the result goes too
+	UClass* ConfigClass = UnitClass;
+	while (!ConfigClass->HasAnyClassFlags(CLASS_Native))
+	{
+		ConfigClass = ConfigClass->GetSuperClass();
+	}
+	ABaseCharacter* const ConfigCDO = ConfigClass->GetDefaultObject<ABaseCharacter>();
+	FStrategyCrowdRenderData RenderData = ConfigCDO->GetCrowdRenderData();
+
+	UAnimSequence* Sequences[EStrategyCrowdClip::MAX] = {};
+	int32 TextureFrames = 0;
+	for (int32 Clip = 0; Clip < EStrategyCrowdClip::MAX; Clip++)
+	{
+		const FStrategyVATClip& Frames = RenderData.GetClip((EStrategyCrowdClip::Type)Clip);
+		FString AnimPath;
+		if (FParse::Value(*Params, ClipParams[Clip], AnimPath))
+		{
+			Sequences[Clip] = LoadObject<UAnimSequence>(nullptr, *AnimPath);
+			if (Sequences[Clip] == nullptr || Frames.NumFrames < 1)
+			{
+				UE_LOG(LogGame, Error, TEXT("Can't bake %s%s: animation missing or clip has no frames in CrowdRender of %s"), ClipParams[Clip], *AnimPath, *ConfigClass->GetName());
+				return 1;
+			}
+		}
+		else if (Clip != EStrategyCrowdClip::Death)
+		{
+			UE_LOG(LogGame, Error, TEXT("Missing -%s<anim>"), ClipParams[Clip]);
+			return 1;
+		}
+		TextureFrames = FMath::Max(TextureFrames, Frames.StartFrame + Frames.NumFrames);
+	}
+
+	const FSkeletalMeshLODModel& LODModel = SkeletalMesh->GetImportedModel()->LODModels[0];
+	const int32 NumVertices = LODModel.NumVertices;
+	if (NumVertices > MaxBakedVertices || RenderData.FrameRate <= 0.0f)
+	{
+		UE_LOG(LogGame, Error, TEXT("Can't bake %s: %d vertices (at most %d), frame rate %.1f"), *SkeletalMesh->GetName(), NumVertices, MaxBakedVertices, RenderData.FrameRate);
+		return 1;
+	}
+
+	// pose the mesh in a world of its own, without ticking
+	UWorld* const World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	USkeletalMeshComponent* const Component = NewObject<USkeletalMeshComponent>(World);
+	Component->SetSkeletalMesh(SkeletalMesh);
+	Component->RegisterComponentWithWorld(World);
+	Component->SetAnimationMode(EAnimationMode::AnimationSingleNode);
+
+	TArray<FVector> RefPositions;
+	TArray<FVector> Positions;
+	TArray<FMatrix> RefToLocals;
+	Component->RefreshBoneTransforms();
+	Component->CacheRefToLocalMatrices(RefToLocals);
+	SkinVertices(LODModel, RefToLocals, RefPositions);
+
+	// offsets from reference pose, one row per frame
+	TArray<FFloat16Color> Pixels;
+	Pixels.AddZeroed(NumVertices * TextureFrames);
+	float MaxOffset = 0.0f;
+	for (int32 Clip = 0; Clip < EStrategyCrowdClip::MAX; Clip++)
+	{
+		UAnimSequence* const Sequence = Sequences[Clip];
+		if (Sequence == nullptr)
+		{
+			continue;
+		}
+
+		// looped clips wrap around, death ends on its last pose
+		const FStrategyVATClip& Frames = RenderData.GetClip((EStrategyCrowdClip::Type)Clip);
+		const int32 TimeSteps = Clip == EStrategyCrowdClip::Death ? FMath::Max(Frames.NumFrames - 1, 1) : Frames.NumFrames;
+		Component->SetAnimation(Sequence);
+		for (int32 Frame = 0; Frame < Frames.NumFrames; Frame++)
+		{
+			Component->SetPosition(Sequence->SequenceLength * Frame / TimeSteps, false);
+			Component->TickAnimation(0.0f, false);
+			Component->RefreshBoneTransforms();
+			Component->CacheRefToLocalMatrices(RefToLocals);
+			SkinVertices(LODModel, RefToLocals, Positions);
+
+			FFloat16Color* const Row = &Pixels[(Frames.StartFrame + Frame) * NumVertices];
+			for (int32 VertexIndex = 0; VertexIndex < NumVertices; VertexIndex++)
+			{
+				const FVector Offset = Positions[VertexIndex] - RefPositions[VertexIndex];
+				Row[VertexIndex] = FFloat16Color(FLinearColor(Offset.X, Offset.Y, Offset.Z, 0.0f));
+				MaxOffset = FMath::Max(MaxOffset, Offset.GetAbsMax());
+			}
+		}
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	const FString BaseName = SkeletalMesh->GetName();
+	UTexture2D* const Texture = CreateAsset<UTexture2D>(OutputPath, FString::Printf(TEXT("T_%s_VAT"), *BaseName));
+	Texture->Source.Init(NumVertices, TextureFrames, 1, 1, TSF_RGBA16F, (const uint8*)Pixels.GetData());
+	Texture->SRGB = false;
+	Texture->CompressionSettings = TC_HDR;
+	Texture->MipGenSettings = TMGS_NoMipmaps;
+	Texture->Filter = TF_Nearest;
+	Texture->AddressX = TA_Clamp;
+	Texture->AddressY = TA_Clamp;
+	Texture->NeverStream = true;
+	Texture->PostEditChange();
+
+	FString BaseColorPath;
+	UTexture* const BaseColor = FParse::Value(*Params, TEXT("BaseColor="), BaseColorPath) ? LoadObject<UTexture>(nullptr, *BaseColorPath) : nullptr;
+
+	RenderData.Mesh = BakeStaticMesh(SkeletalMesh, LODModel, MaxOffset, OutputPath, FString::Printf(TEXT("SM_%s_Crowd"), *BaseName));
+	RenderData.Material = BakeMaterial(Texture, TextureFrames, RenderData.FrameRate, BaseColor, OutputPath, FString::Printf(TEXT("M_%s_Crowd"), *BaseName));
+
+	if (!SaveAsset(Texture) || !SaveAsset(RenderData.Mesh) || !SaveAsset(RenderData.Material))
+	{
+		UE_LOG(LogGame, Error, TEXT("Failed to save baked assets to %s"), *OutputPath);
+		return 1;
+	}
+
+	ConfigCDO->SetCrowdRenderData(RenderData);
+	ConfigCDO->UpdateDefaultConfigFile();
+
+	UE_LOG(LogGame, Display, TEXT("Baked %s: %d vertices, %d frames, offsets up to %.1f, written to CrowdRender of %s"),
+		*BaseName, NumVertices, TextureFrames, MaxOffset, *ConfigClass->GetName());
+	return 0;
+#else
+	UE_LOG(LogGame, Error, TEXT("Crowd baking needs the editor"));
+	return 1;
+#endif // WITH_EDITOR
+}
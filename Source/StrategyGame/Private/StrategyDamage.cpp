@@ -0,0 +1,173 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyDamage.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage pass"), STAT_StrategyDamagePass, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage records"), STAT_StrategyDamageRecords, STATGROUP_StrategyGame);
+
+/** initial size of the damage queue, enough for a busy fight without growing */
+static const int32 InitialDamageQueueSize = 256;
+
+FStrategyDamageQueue::FStrategyDamageQueue()
+{
+	Records.Reserve(InitialDamageQueueSize);
+}
+
+float FStrategyDamageQueue::Queue(const FStrategyEntityTable& Entities, ABaseCharacter* Victim, float Damage, AController* Instigator, AActor* Causer)
+{
+	check(Victim);
+	const FStrategyEntityHandle VictimHandle = Victim->GetEntityHandle();
+	if (Damage <= 0.0f || Victim->Health <= 0.0f || Victim->bIsDying || !Entities.IsValid(VictimHandle))
+	{
+		return 0.0f;
+	}
+
+	// instigator team, cached team of the causer is enough for units and projectiles
+	const FStrategyEntityHandle CauserHandle = FStrategyEntityTable::GetHandle(Causer);
+	uint8 InstigatorTeamNum = EStrategyTeam::Unknown;
+	if (Entities.IsValid(CauserHandle))
+	{
+		InstigatorTeamNum = Entities.GetTeamNum(CauserHandle);
+	}
+	else
+	{
+		const IStrategyTeamInterface* InstigatorTeam = Cast<const IStrategyTeamInterface>(Instigator);
+		if (InstigatorTeam == nullptr)
+		{
+			InstigatorTeam = Cast<const IStrategyTeamInterface>(Causer);
+		}
+		InstigatorTeamNum = InstigatorTeam ? InstigatorTeam->GetTeamNum() : (uint8)EStrategyTeam::Unknown;
+	}
+
+	// skip friendly fire
+	if (IsFriendlyFire(Entities.GetTeamRelations(), InstigatorTeamNum, Entities.GetTeamNum(VictimHandle)))
+	{
+		return 0.0f;
+	}
+
+	// pawn's damage reduction
+	const AStrategyChar* const VictimChar = Cast<AStrategyChar>(Victim);
+	if (VictimChar)
+	{
+		Damage -= VictimChar->GetDefaultPawnData()->DamageReduction;
+	}
+	if (Damage <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	FStrategyDamageRecord Record;
+	Record.Victim = VictimHandle;
+	Record.Causer = CauserHandle;
+	Record.Instigator = Instigator;
+	Record.InstigatorTeamNum = InstigatorTeamNum;
+	Record.Damage = Damage;
+	Records.Add(Record);
+	return Damage;
+}
+
+bool FStrategyDamageQueue::IsFriendlyFire(const FStrategyTeamRelations& Relations, uint8 InstigatorTeamNum, uint8 VictimTeamNum)
+{
+	// environment and neutral instigators hurt everybody, teamless victims included
+	return InstigatorTeamNum != EStrategyTeam::Unknown && VictimTeamNum != EStrategyTeam::Unknown
+		&& (InstigatorTeamNum == VictimTeamNum || Relations.IsFriendly(InstigatorTeamNum, VictimTeamNum));
+}
+
+void FStrategyDamageQueue::Tick(UWorld* World)
+{
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(World);
+	if (Records.Num() == 0 || Entities == nullptr)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategyDamagePass);
+	INC_DWORD_STAT_BY(STAT_StrategyDamageRecords, Records.Num());
+
+	// damage queued before the game finished doesn't land either
+	AStrategyGameState* const MyGameState = World->GetGameState<AStrategyGameState>();
+	if (MyGameState && MyGameState->GameplayState == EGameplayState::Finished)
+	{
+		Reset();
+		return;
+	}
+
+	FStrategyGameplayEventBus* const EventBus = MyGameState ? &MyGameState->GetEventBus() : nullptr;
+	for (int32 Idx = 0; Idx < Records.Num(); Idx++)
+	{
+		const FStrategyDamageRecord& Record = Records[Idx];
+		ABaseCharacter* const Victim = Entities->Get<ABaseCharacter>(Record.Victim);
+		if (Victim == nullptr || Victim->Health <= 0.0f || Victim->bIsDying)
+		{
+			// no further damage if already dead
+			continue;
+		}
+
+		Victim->Health -= Record.Damage;
+		if (Victim->Health <= 0.0f)
+		{
+			KillingRecords.Add(Idx);
+		}
+
+		if (EventBus)
+		{
+			// let the listeners know when damage happens
+			FStrategyGameplayEvent DamagedEvent;
+			DamagedEvent.Type = EStrategyGameplayEvent::ActorDamaged;
+			DamagedEvent.TeamNum = Entities->GetTeamNum(Record.Victim);
+			DamagedEvent.InstigatorTeamNum = Record.InstigatorTeamNum;
+			DamagedEvent.Value = Record.Damage;
+			DamagedEvent.Actor = Victim;
+			DamagedEvent.Instigator = Record.Instigator;
+			EventBus->Post(DamagedEvent);
+		}
+	}
+
+	// deaths after all health changes, dying units leave the entity table
+	const FDamageEvent DamageEvent(UDamageType::StaticClass());
+	for (const int32 Idx : KillingRecords)
+	{
+		// earlier death may have finished the game
+		if (MyGameState && MyGameState->GameplayState == EGameplayState::Finished)
+		{
+			break;
+		}
+
+		// one killing record per victim, unless something else killed or healed it meanwhile
+		const FStrategyDamageRecord& Record = Records[Idx];
+		ABaseCharacter* const Victim = Entities->Get<ABaseCharacter>(Record.Victim);
+		if (Victim && Victim->Health <= 0.0f && !Victim->bIsDying)
+		{
+			Victim->Die(Record.Damage, DamageEvent, Record.Instigator.Get(), Entities->Get(Record.Causer));
+		}
+	}
+
+	KillingRecords.Reset();
+	Records.Reset();
+}
+
+void FStrategyDamageQueue::Reset()
+{
+	Records.Reset();
+	KillingRecords.Reset();
+}
+
+float FStrategyDamageQueue::ApplyPointDamage(AActor* DamagedActor, float Damage, const FVector& HitFromDirection, const FHitResult& HitInfo, AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageTypeClass)
+{
+	UWorld* const World = DamagedActor ? DamagedActor->GetWorld() : nullptr;
+	AStrategyGameState* const MyGameState = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	ABaseCharacter* const DamagedChar = Cast<ABaseCharacter>(DamagedActor);
+	if (MyGameState == nullptr || !MyGameState->bDirectDamage || DamagedChar == nullptr || DamagedChar->bDamageThroughTakeDamage)
+	{
+		return UGameplayStatics::ApplyPointDamage(DamagedActor, Damage, HitFromDirection, HitInfo, EventInstigator, DamageCauser, DamageTypeClass);
+	}
+
+	// no health changes after game is finished
+	if (MyGameState->GameplayState == EGameplayState::Finished)
+	{
+		return 0.0f;
+	}
+
+	return MyGameState->GetDamageQueue().Queue(MyGameState->GetEntities(), DamagedChar, Damage, EventInstigator, DamageCauser);
+}
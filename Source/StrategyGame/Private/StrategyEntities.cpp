@@ -0,0 +1,138 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyEntities.h"
+
+/** generations fit in the bits left by the index, zero is never given out and marks retired slots */
+static const uint32 MaxGeneration = (1u << (32 - FStrategyEntityHandle::IndexBits)) - 1;
+
+/** freed slots wait until this many more are free, so a slot is reused at most once per this many removals */
+static const int32 MinFreeIndices = 1024;
+
+TArray<FStrategyEntityTable*, TInlineAllocator<4>> FStrategyEntityTable::ActiveTables;
+
+FStrategyEntityTable::FStrategyEntityTable()
+	: FreeHead(0)
+	, NumRetired(0)
+	, World(nullptr)
+{
+}
+
+FStrategyEntityTable::~FStrategyEntityTable()
+{
+	Unregister();
+}
+
+FStrategyEntityHandle FStrategyEntityTable::Add(AActor* Actor, EStrategyEntity::Type Type, uint8 TeamNum)
+{
+	check(Actor);
+
+	uint32 Index = 0;
+	if (FreeIndices.Num() - FreeHead > MinFreeIndices)
+	{
+		Index = FreeIndices[FreeHead++];
+		if (FreeHead * 2 >= FreeIndices.Num())
+		{
+			FreeIndices.RemoveAt(0, FreeHead, false);
+			FreeHead = 0;
+		}
+	}
+	else
+	{
+		Index = Actors.Num();
+		check(Index <= FStrategyEntityHandle::IndexMask);
+		Generations.Add(1);
+		Actors.Add(nullptr);
+		Teams.Add(EStrategyTeam::Unknown);
+		Types.Add(EStrategyEntity::None);
+	}
+
+	Actors[Index] = Actor;
+	Teams[Index] = TeamNum;
+	Types[Index] = (uint8)Type;
+	return FStrategyEntityHandle(Index, Generations[Index]);
+}
+
+void FStrategyEntityTable::Remove(FStrategyEntityHandle Handle)
+{
+	if (!IsValid(Handle))
+	{
+		return;
+	}
+
+	const uint32 Index = Handle.GetIndex();
+	Actors[Index] = nullptr;
+	Teams[Index] = EStrategyTeam::Unknown;
+	Types[Index] = EStrategyEntity::None;
+	if (Generations[Index] < MaxGeneration)
+	{
+		Generations[Index]++;
+		FreeIndices.Add(Index);
+	}
+	else
+	{
+		// wrapping around would let old handles match again
+		Generations[Index] = 0;
+		NumRetired++;
+	}
+}
+
+void FStrategyEntityTable::SetTeamNum(FStrategyEntityHandle Handle, uint8 TeamNum)
+{
+	if (IsValid(Handle))
+	{
+		Teams[Handle.GetIndex()] = TeamNum;
+	}
+}
+
+void FStrategyEntityTable::Reset()
+{
+	// handles given out before stay stale, generations keep going
+	for (int32 Index = 0; Index < Actors.Num(); Index++)
+	{
+		if (Actors[Index] != nullptr)
+		{
+			Remove(FStrategyEntityHandle(Index, Generations[Index]));
+		}
+	}
+	TeamRelations.Reset();
+}
+
+FStrategyEntityHandle FStrategyEntityTable::GetHandle(const AActor* Actor)
+{
+	const IStrategyTeamInterface* const TeamActor = Cast<const IStrategyTeamInterface>(Actor);
+	return TeamActor ? TeamActor->GetEntityHandle() : FStrategyEntityHandle();
+}
+
+void FStrategyEntityTable::Register(const UWorld* InWorld)
+{
+	Unregister();
+	World = InWorld;
+	ActiveTables.Add(this);
+}
+
+void FStrategyEntityTable::Unregister()
+{
+	ActiveTables.RemoveSingleSwap(this, false);
+	World = nullptr;
+}
+
+FStrategyEntityTable* FStrategyEntityTable::Get(const UWorld* InWorld)
+{
+	// team checks ask for this all the time, registered tables spare them the game state cast
+	for (FStrategyEntityTable* const Table : ActiveTables)
+	{
+		if (Table->World == InWorld)
+		{
+			return Table;
+		}
+	}
+
+	AStrategyGameState* const MyGameState = (InWorld && InWorld->IsGameWorld()) ? InWorld->GetGameState<AStrategyGameState>() : nullptr;
+	if (MyGameState == nullptr)
+	{
+		return nullptr;
+	}
+	MyGameState->GetEntities().Register(InWorld);
+	return &MyGameState->GetEntities();
+}
@@ -71,6 +71,38 @@ AStrategyProjectile* UStrategyGameBlueprintLibrary::SpawnProjectile(UObject* Wor
 		SpawnLocation, ShootDirection, OwnerTeam, ImpactDamage, LifeSpan, InOwner);
 }
 
+TArray<ABaseCharacter*> UStrategyGameBlueprintLibrary::FindNearestEnemies(UObject* WorldContextObject, const FVector& Origin, TEnumAsByte<EStrategyTeam::Type> Team, float Radius, int32 MaxCount)
+{
+	TArray<ABaseCharacter*> Enemies;
+	AStrategyGameState* const MyGameState = GetGameStateFromContextObject(WorldContextObject);
+	if (MyGameState)
+	{
+		MyGameState->GetTargetIndex().FindNearestEnemies(MyGameState->GetWorld(), FStrategyEntityHandle(), Origin, Team, Radius, MaxCount, Enemies);
+	}
+	return Enemies;
+}
+
+ABaseCharacter* UStrategyGameBlueprintLibrary::FindWeakestEnemy(UObject* WorldContextObject, const FVector& Origin, TEnumAsByte<EStrategyTeam::Type> Team, float Radius)
+{
+	AStrategyGameState* const MyGameState = GetGameStateFromContextObject(WorldContextObject);
+	return MyGameState ? MyGameState->GetTargetIndex().FindWeakestEnemy(MyGameState->GetWorld(), FStrategyEntityHandle(), Origin, Team, Radius) : nullptr;
+}
+
+bool UStrategyGameBlueprintLibrary::PredictInterceptPoint(const FVector& ShotOrigin, float ProjectileSpeed, AActor* Target, FVector& InterceptPoint)
+{
+	if (Target == nullptr)
+	{
+		InterceptPoint = ShotOrigin;
+		return false;
+	}
+	return FStrategyTargetIndex::PredictIntercept(ShotOrigin, ProjectileSpeed, Target->GetActorLocation(), Target->GetVelocity(), InterceptPoint);
+}
+
+void UStrategyGameBlueprintLibrary::PlayGameplaySound(UObject* WorldContextObject, USoundBase* Sound, const FVector& Location, TEnumAsByte<EStrategySoundCategory::Type> Category, float VolumeMultiplier, float PitchMultiplier)
+{
+	FStrategyAudioRouter::PlaySoundAtLocation(WorldContextObject, Sound, Location, Category, VolumeMultiplier, PitchMultiplier);
+}
+
 void UStrategyGameBlueprintLibrary::GiveBuff(AStrategyChar* InChar,
 	int32 AttackMin, int32 AttackMax, int32 DamageReduction, int32 MaxHealthBonus, int32 HealthRegen, float Speed, float Duration, bool bInfiniteDuration, int32 AttackDistance)
 {
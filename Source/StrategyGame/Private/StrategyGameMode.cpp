@@ -4,6 +4,7 @@
 #include "StrategyBuilding.h"
 #include "StrategySpectatorPawn.h"
 #include "StrategyTeamInterface.h"
+#include "StrategyMapWarmup.h"
 
 
 AStrategyGameMode::AStrategyGameMode(const FObjectInitializer& ObjectInitializer)
@@ -15,8 +16,7 @@ AStrategyGameMode::AStrategyGameMode(const FObjectInitializer& ObjectInitializer
 	GameStateClass = AStrategyGameState::StaticClass();
 	HUDClass = AStrategyHUD::StaticClass();
 
-	static ConstructorHelpers::FClassFinder<AStrategyBuilding> EmptyWallSlotHelper(TEXT("/Game/Buildings/Wall/Wall_EmptySlot"));
-	EmptyWallSlotClass = EmptyWallSlotHelper.Class;
+	EmptyWallSlotClass = TSoftClassPtr<AStrategyBuilding>(FSoftObjectPath(TEXT("/Game/Buildings/Wall/Wall_EmptySlot.Wall_EmptySlot_C")));
 	if ((GEngine != nullptr) && (GEngine->GameViewport != nullptr))
 	{
 		GEngine->GameViewport->SetSuppressTransitionMessage(true);
@@ -42,9 +42,44 @@ void AStrategyGameMode::InitGameState()
 		EGameDifficulty::Type const NewDifficulty = (EGameDifficulty::Type) UGameplayStatics::GetIntOption(OptionsString, DifficultyOptionName, 0);
 		StrategyGameState->SetGameDifficulty(NewDifficulty);
 
+		// start the game once the map is warmed up
+		FStrategyMapWarmup::Get().StartWarmup(this, FSimpleDelegate::CreateUObject(this, &AStrategyGameMode::OnWarmupComplete));
+	}
+}
+
+void AStrategyGameMode::OnWarmupComplete()
+{
+	AStrategyGameState* const StrategyGameState = GetGameState<AStrategyGameState>();
+	if (StrategyGameState)
+	{
 		// start the game!
 		StrategyGameState->StartGameplayStateMachine();
 	}
+
+	FStrategyMapWarmup::Get().NotifyInteractive(GetWorld());
+}
+
+void AStrategyGameMode::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	if (!EmptyWallSlotClass.IsNull())
+	{
+		OutAssets.AddUnique(EmptyWallSlotClass.ToSoftObjectPath());
+	}
+
+	const AStrategyHUD* const DefaultHUD = HUDClass ? Cast<AStrategyHUD>(HUDClass->GetDefaultObject()) : nullptr;
+	if (DefaultHUD)
+	{
+		DefaultHUD->GetPreloadAssets(OutAssets);
+	}
+
+	// building classes placed in the map (and their upgrades) are loaded with it already, their soft references are not
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		if (It->IsChildOf(AStrategyBuilding::StaticClass()) && !It->HasAnyClassFlags(CLASS_Abstract | CLASS_NewerVersionExists))
+		{
+			It->GetDefaultObject<AStrategyBuilding>()->GetPreloadAssets(OutAssets);
+		}
+	}
 }
 
 void AStrategyGameMode::RestartPlayer(AController* NewPlayer)
@@ -124,26 +159,50 @@ void AStrategyGameMode::ReturnToMenu()
 	GetWorld()->ServerTravel(FString("/Game/Maps/StrategyMenu"));
 }
 
+/** relations used without entity table, no alliances */
+static const FStrategyTeamRelations DefaultTeamRelations;
+
+/** @return team cached in entity table for entities in play, team interface result for others, INDEX_NONE without team */
+static int32 GetActorTeamNum(const FStrategyEntityTable* Entities, const AActor* Actor)
+{
+	const IStrategyTeamInterface* const Team = Cast<const IStrategyTeamInterface>(Actor);
+	if (Team == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	const FStrategyEntityHandle Handle = Team->GetEntityHandle();
+	return (Entities && Entities->IsValid(Handle)) ? Entities->GetTeamNum(Handle) : Team->GetTeamNum();
+}
+
+/** @return entity table of the actors world */
+static const FStrategyEntityTable* GetEntities(const AActor* ActorA, const AActor* ActorB)
+{
+	const AActor* const Actor = ActorA ? ActorA : ActorB;
+	return Actor ? FStrategyEntityTable::Get(Actor->GetWorld()) : nullptr;
+}
+
 bool AStrategyGameMode::OnFriendlyTeam(const AActor* ActorA, const AActor* ActorB)
 {
-	const IStrategyTeamInterface* TeamA = Cast<const IStrategyTeamInterface>(ActorA);
-	const IStrategyTeamInterface* TeamB = Cast<const IStrategyTeamInterface>(ActorB);
+	const FStrategyEntityTable* const Entities = GetEntities(ActorA, ActorB);
+	const int32 TeamA = GetActorTeamNum(Entities, ActorA);
+	const int32 TeamB = GetActorTeamNum(Entities, ActorB);
 
-	if( (TeamA != nullptr && TeamA->GetTeamNum() == EStrategyTeam::Unknown) || (TeamB != nullptr && TeamB->GetTeamNum() == EStrategyTeam::Unknown))
+	if (TeamA == EStrategyTeam::Unknown || TeamB == EStrategyTeam::Unknown)
 		return true;
 
-	return (TeamA != nullptr) && (TeamB != nullptr) && (TeamA->GetTeamNum() == TeamB->GetTeamNum());
+	const FStrategyTeamRelations& Relations = Entities ? Entities->GetTeamRelations() : DefaultTeamRelations;
+	return (TeamA != INDEX_NONE) && (TeamB != INDEX_NONE) && Relations.IsFriendly(TeamA, TeamB);
 }
 
 bool AStrategyGameMode::OnEnemyTeam(const AActor* ActorA, const AActor* ActorB)
 {
-	const IStrategyTeamInterface* TeamA = Cast<const IStrategyTeamInterface>(ActorA);
-	const IStrategyTeamInterface* TeamB = Cast<const IStrategyTeamInterface>(ActorB);
-
-	if( (TeamA != nullptr && TeamA->GetTeamNum() == EStrategyTeam::Unknown) || (TeamB != nullptr && TeamB->GetTeamNum() == EStrategyTeam::Unknown))
-		return false;
+	const FStrategyEntityTable* const Entities = GetEntities(ActorA, ActorB);
+	const int32 TeamA = GetActorTeamNum(Entities, ActorA);
+	const int32 TeamB = GetActorTeamNum(Entities, ActorB);
 
-	return (TeamA != nullptr) && (TeamB != nullptr) && (TeamA->GetTeamNum() != TeamB->GetTeamNum());
+	const FStrategyTeamRelations& Relations = Entities ? Entities->GetTeamRelations() : DefaultTeamRelations;
+	return (TeamA != INDEX_NONE) && (TeamB != INDEX_NONE) && Relations.IsEnemy(TeamA, TeamB);
 }
 
 
@@ -5,6 +5,7 @@
 #include "StrategyHUDSoundsWidgetStyle.h"
 #include "StrategyHUDWidgetStyle.h"
 #include "StrategyMenuWidgetStyle.h"
+#include "StrategyMapWarmup.h"
 
 
 
@@ -15,10 +16,12 @@ class FStrategyGameModule : public FDefaultGameModuleImpl
 		//Hot reload hack
 		FSlateStyleRegistry::UnRegisterSlateStyle(FStrategyStyle::GetStyleSetName());
 		FStrategyStyle::Initialize();
+		FStrategyMapWarmup::Initialize();
 	}
 
 	virtual void ShutdownModule() override
 	{
+		FStrategyMapWarmup::Shutdown();
 		FStrategyStyle::Shutdown();
 	}
 };
@@ -3,15 +3,52 @@
 #include "StrategyGame.h"
 #include "StrategyBuilding_Brewery.h"
 #include "StrategyTypes.h"
+#include "StrategyTelemetry.h"
+#include "StrategyStressRun.h"
+#include "StrategyAISensingComponent.h"
 
 AStrategyGameState::AStrategyGameState(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	// team data for: unknown, player, enemy
-	PlayersData.AddZeroed(EStrategyTeam::MAX);
+	PlayersData.AddDefaulted(EStrategyTeam::MAX);
+	FMemory::Memzero(LivePawnCounter);
 	MiniMapCamera = nullptr;
 	WinningTeam = EStrategyTeam::Unknown;
 	GameFinishedTime = 0;
+	bRecordTelemetry = false;
+	TelemetrySampleInterval = 1.0f;
+	VisibilityCellSize = 200.0f;
+	VisibilityUpdateInterval = 0.2f;
+	VisibilityBlockerHeight = 150.0f;
+	PathQueriesPerFrame = 8;
+	PathMergeDistance = 150.0f;
+	PathCacheSize = 64;
+	PathCacheLifetime = 20.0f;
+	NavFootprintRebuildDelay = 0.2f;
+	NavFootprintPadding = 0.0f;
+	bCrowdAvoidance = true;
+	CrowdNeighborDistance = 500.0f;
+	CrowdTimeHorizon = 1.0f;
+	CrowdMaxNeighbors = 8;
+	CrowdNavProbeTime = 0.3f;
+	bCrowdInstancing = true;
+	CrowdInstanceDistance = 4000.0f;
+	bMergeAttachmentMeshes = true;
+	MeshMergesPerFrame = 1;
+	bDirectDamage = true;
+	SoundVoicesPerCategory = 8;
+	SoundCullDistance = 6000.0f;
+	SoundPoolSize = 32;
+	bAsyncSceneQueries = true;
+	StressFrameTimeBudget = 33.3f;
+	UnitMemoryBudgetKB = 128.0f;
+	UnitSpawnsPerFrame = 2;
+	UnitSpawnsThisFrame = 0;
+
+	// dispatch gameplay events after everything posted them this frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
 }
 
 int32 AStrategyGameState::GetNumberOfLivePawns(TEnumAsByte<EStrategyTeam::Type> InTeam) const
@@ -19,52 +56,199 @@ int32 AStrategyGameState::GetNumberOfLivePawns(TEnumAsByte<EStrategyTeam::Type>
 	return LivePawnCounter[InTeam];
 }
 
-void AStrategyGameState::AddChar(ABaseCharacter* InChar)
+void AStrategyGameState::BeginPlay()
 {
-	if (InChar != nullptr)
+	Super::BeginPlay();
+
+	EventBus.Subscribe(EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::CharSpawned), EStrategyTeam::AllMask,
+		FOnStrategyGameplayEvent::CreateUObject(this, &AStrategyGameState::OnCharSpawned));
+	// only enemies are worth resources
+	EventBus.Subscribe(EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::CharDied), EStrategyTeam::Mask(EStrategyTeam::Enemy),
+		FOnStrategyGameplayEvent::CreateUObject(this, &AStrategyGameState::OnCharDied));
+	EventBus.Subscribe(EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::ActorDamaged), EStrategyTeam::AllMask,
+		FOnStrategyGameplayEvent::CreateUObject(this, &AStrategyGameState::OnActorDamaged));
+
+	const UStrategyAISensingComponent* const DefaultSensing = GetDefault<UStrategyAISensingComponent>();
+	VisibilityGrid.Configure(VisibilityCellSize, VisibilityUpdateInterval, VisibilityBlockerHeight, DefaultSensing->GetSightDistance());
+	PathService.Configure(PathQueriesPerFrame, PathMergeDistance, PathCacheSize, PathCacheLifetime);
+	NavFootprints.Configure(NavFootprintRebuildDelay, NavFootprintPadding);
+	NavFootprints.OnTilesChanged().AddRaw(&PathService, &FStrategyPathService::OnNavTilesChanged);
+	CrowdAvoidance.Configure(CrowdNeighborDistance, CrowdTimeHorizon, CrowdMaxNeighbors, CrowdNavProbeTime);
+	CrowdRenderer.Configure(EventBus, CrowdInstanceDistance);
+	MeshMergeCache.Configure(MeshMergesPerFrame);
+	AudioRouter.Configure(SoundVoicesPerCategory, SoundCullDistance, SoundPoolSize);
+	SceneQueries.Configure(bAsyncSceneQueries);
+
+	if (bRecordTelemetry)
 	{
-		LivePawnCounter[InChar->GetTeamNum()]++;
+		TelemetryRecorder = MakeShareable(new FStrategyTelemetryRecorder(this, TelemetrySampleInterval));
 	}
+
+	StressRun = FStrategyStressRun::CreateFromCommandLine(this, StressFrameTimeBudget);
+}
+
+void AStrategyGameState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StressRun.Reset();
+	TelemetryRecorder.Reset();
+	SceneQueries.Reset();
+	DamageQueue.Reset();
+	TargetIndex.Reset();
+	AudioRouter.Reset();
+	NavFootprints.OnTilesChanged().RemoveAll(&PathService);
+	NavFootprints.Reset();
+	PathService.Reset();
+	AttackSlots.Reset();
+	CrowdAvoidance.Reset();
+	CrowdRenderer.Reset();
+	MeshMergeCache.Reset();
+	VisibilityGrid.Reset();
+	EventBus.Reset();
+	Entities.Reset();
+	Entities.Unregister();
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AStrategyGameState::RemoveChar(ABaseCharacter* InChar)
+void AStrategyGameState::Tick(float DeltaSeconds)
 {
-	if (InChar != nullptr)
+	Super::Tick(DeltaSeconds);
+
+	// last frame's traces first, so melee hits make this frame's damage pass
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(SceneQueries);
+		SceneQueries.Tick(GetWorld());
+	}
+	// damage next, so its events go out with this frame's batch
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(Damage);
+		DamageQueue.Tick(GetWorld());
+	}
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(Events);
+		EventBus.Dispatch();
+	}
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(Visibility);
+		VisibilityGrid.Tick(GetWorld(), WorldBounds, DeltaSeconds);
+	}
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(AttackSlots);
+		AttackSlots.Tick();
+	}
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(NavFootprints);
+		NavFootprints.Tick(GetWorld(), DeltaSeconds);
+	}
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(Paths);
+		PathService.Tick(GetWorld());
+	}
+
+	if (bCrowdAvoidance)
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(Crowd);
+		CrowdAvoidance.Tick(GetWorld(), DeltaSeconds);
+	}
+
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(MeshMerge);
+		MeshMergeCache.Tick();
+	}
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(Audio);
+		AudioRouter.Tick();
+	}
+
+	if (bCrowdInstancing)
+	{
+		STRATEGY_SUBSYSTEM_SCOPE(CrowdRender);
+		CrowdRenderer.Tick(GetWorld());
+	}
+
+	if (TelemetryRecorder.IsValid())
 	{
-		LivePawnCounter[InChar->GetTeamNum()]--;
+		STRATEGY_SUBSYSTEM_SCOPE(Telemetry);
+		TelemetryRecorder->Tick(DeltaSeconds);
+	}
+
+	// directors ticked already, the budget is for the next frame
+	UnitSpawnsThisFrame = 0;
+
+	// last, so the frame it records has all the work above
+	if (StressRun.IsValid())
+	{
+		StressRun->Tick(DeltaSeconds);
 	}
 }
 
-void AStrategyGameState::OnCharDied(ABaseCharacter* InChar)
+bool AStrategyGameState::ConsumeUnitSpawn()
 {
-	if ( InChar && (InChar->GetTeamNum() == EStrategyTeam::Enemy) )
+	if (UnitSpawnsThisFrame >= FMath::Max(UnitSpawnsPerFrame, 1))
 	{
-		PlayersData[EStrategyTeam::Player].ResourcesAvailable += InChar->ResourcesToGather;		
-		RemoveChar(InChar);
+		return false;
 	}
+	UnitSpawnsThisFrame++;
+	return true;
 }
 
-void AStrategyGameState::OnActorDamaged(AActor* InActor, float Damage, AController* EventInstigator)
+void AStrategyGameState::OnCharSpawned(const FStrategyGameplayEvent& Event)
 {
-	IStrategyTeamInterface* const InstigatorTeam = Cast<IStrategyTeamInterface>(EventInstigator);
+	LivePawnCounter[Event.TeamNum]++;
+}
 
+void AStrategyGameState::OnCharDied(const FStrategyGameplayEvent& Event)
+{
+	AddResources(EStrategyTeam::Player, FMath::TruncToInt(Event.Value));
+	LivePawnCounter[Event.TeamNum]--;
+}
+
+void AStrategyGameState::OnActorDamaged(const FStrategyGameplayEvent& Event)
+{
 	// track damage done
-	// @todo, this is def not the place for this
-	if (InstigatorTeam)
+	if (Event.InstigatorTeamNum != EStrategyTeam::Unknown)
 	{
-		FPlayerData& TeamData = PlayersData[InstigatorTeam->GetTeamNum()];
-		TeamData.DamageDone += FMath::TruncToInt(Damage);
+		FPlayerData& TeamData = PlayersData[Event.InstigatorTeamNum];
+		TeamData.DamageDone += FMath::TruncToInt(Event.Value);
 	}
 }
 
-void AStrategyGameState::OnCharSpawned(ABaseCharacter* InChar)
+void FPlayerData::AddBuilding(AStrategyBuilding* Building)
 {
-	if ( InChar && !InChar->IsPendingKill() )
+	check(Building && Building->TeamBuildingIndex == INDEX_NONE && Building->GetEntityHandle().IsSet());
+	Building->TeamBuildingIndex = BuildingsList.Add(Building->GetEntityHandle());
+	BuildingCounts.FindOrAdd(Building->GetClass())++;
+}
+
+void FPlayerData::RemoveBuilding(AStrategyBuilding* Building)
+{
+	check(Building);
+	const int32 Index = Building->TeamBuildingIndex;
+	if (BuildingsList.IsValidIndex(Index) && BuildingsList[Index] == Building->GetEntityHandle())
 	{
-		AddChar(InChar);
+		BuildingsList.RemoveAtSwap(Index, 1, false);
+		const FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(Building->GetWorld());
+		AStrategyBuilding* const MovedBuilding = (Entities && BuildingsList.IsValidIndex(Index)) ? Entities->Get<AStrategyBuilding>(BuildingsList[Index]) : nullptr;
+		if (MovedBuilding)
+		{
+			MovedBuilding->TeamBuildingIndex = Index;
+		}
+		Building->TeamBuildingIndex = INDEX_NONE;
+
+		int32* const Count = BuildingCounts.Find(Building->GetClass());
+		if (Count && --(*Count) <= 0)
+		{
+			BuildingCounts.Remove(Building->GetClass());
+		}
 	}
 }
 
+int32 FPlayerData::GetBuildingCount(const UClass* BuildingClass) const
+{
+	const int32* const Count = BuildingCounts.Find(BuildingClass);
+	return Count ? *Count : 0;
+}
+
 FPlayerData* AStrategyGameState::GetPlayerData(uint8 TeamNum) const
 {
 	if (TeamNum != EStrategyTeam::Unknown)
@@ -75,18 +259,41 @@ FPlayerData* AStrategyGameState::GetPlayerData(uint8 TeamNum) const
 	return nullptr;
 }
 
-void AStrategyGameState::SetGameplayState(EGameplayState::Type NewState)
+void AStrategyGameState::AddResources(uint8 TeamNum, int32 Amount)
 {
-	GameplayState = NewState;
+	FPlayerData* const TeamData = GetPlayerData(TeamNum);
+	if (TeamData)
+	{
+		SetResources(TeamNum, FMath::Max(0, int32(TeamData->ResourcesAvailable) + Amount));
+	}
+}
 
-	// notify the breweries of the state change
-	for (int32 i = 0; i < PlayersData.Num(); i++)
+void AStrategyGameState::SetResources(uint8 TeamNum, uint32 NewAmount)
+{
+	FPlayerData* const TeamData = GetPlayerData(TeamNum);
+	if (TeamData == nullptr || TeamData->ResourcesAvailable == NewAmount)
 	{
-		if (PlayersData[i].Brewery.IsValid())
-		{
-			PlayersData[i].Brewery->OnGameplayStateChange(NewState);
-		}
+		return;
 	}
+
+	TeamData->ResourcesAvailable = NewAmount;
+
+	FStrategyGameplayEvent ResourcesEvent;
+	ResourcesEvent.Type = EStrategyGameplayEvent::ResourcesChanged;
+	ResourcesEvent.TeamNum = TeamNum;
+	ResourcesEvent.Value = NewAmount;
+	EventBus.Post(ResourcesEvent);
+}
+
+void AStrategyGameState::SetGameplayState(EGameplayState::Type NewState)
+{
+	GameplayState = NewState;
+
+	// breweries and the HUD pick it up from the event
+	FStrategyGameplayEvent StateEvent;
+	StateEvent.Type = EStrategyGameplayEvent::GameplayStateChanged;
+	StateEvent.Value = NewState;
+	EventBus.Post(StateEvent);
 }
 
 bool AStrategyGameState::IsGameActive() const
@@ -0,0 +1,93 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyGameplayEvents.h"
+
+/** initial size of the event queues, enough for a busy fight without growing */
+static const int32 InitialEventQueueSize = 256;
+
+FStrategyGameplayEventBus::FStrategyGameplayEventBus()
+	: bIsDispatching(false)
+{
+	PendingEvents.Reserve(InitialEventQueueSize);
+	DispatchedEvents.Reserve(InitialEventQueueSize);
+}
+
+FDelegateHandle FStrategyGameplayEventBus::Subscribe(uint32 EventTypeMask, uint32 TeamMask, const FOnStrategyGameplayEvent& Delegate)
+{
+	FSubscriber& Subscriber = Subscribers[Subscribers.AddDefaulted()];
+	Subscriber.EventTypeMask = EventTypeMask;
+	Subscriber.TeamMask = TeamMask;
+	Subscriber.Delegate = Delegate;
+	Subscriber.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	return Subscriber.Handle;
+}
+
+void FStrategyGameplayEventBus::Unsubscribe(FDelegateHandle Handle)
+{
+	for (int32 Idx = 0; Idx < Subscribers.Num(); Idx++)
+	{
+		if (Subscribers[Idx].Handle == Handle)
+		{
+			// keep the order while dispatching, listeners are walked by index
+			Subscribers[Idx].Delegate.Unbind();
+			if (!bIsDispatching)
+			{
+				Subscribers.RemoveAt(Idx);
+			}
+			break;
+		}
+	}
+}
+
+void FStrategyGameplayEventBus::Post(const FStrategyGameplayEvent& Event)
+{
+	check(Event.Type < EStrategyGameplayEvent::MAX);
+	PendingEvents.Add(Event);
+}
+
+void FStrategyGameplayEventBus::Dispatch()
+{
+	if (bIsDispatching || PendingEvents.Num() == 0)
+	{
+		return;
+	}
+
+	bIsDispatching = true;
+	Swap(PendingEvents, DispatchedEvents);
+
+	for (const FStrategyGameplayEvent& Event : DispatchedEvents)
+	{
+		const uint32 EventTypeBit = EStrategyGameplayEvent::Mask(Event.Type);
+		const uint32 TeamBit = EStrategyTeam::Mask(Event.TeamNum);
+		for (int32 Idx = 0; Idx < Subscribers.Num(); Idx++)
+		{
+			const FSubscriber& Subscriber = Subscribers[Idx];
+			if ((Subscriber.EventTypeMask & EventTypeBit) && (Subscriber.TeamMask & TeamBit))
+			{
+				Subscriber.Delegate.ExecuteIfBound(Event);
+			}
+		}
+	}
+
+	DispatchedEvents.Reset();
+	bIsDispatching = false;
+
+	// drop listeners unsubscribed during dispatch
+	Subscribers.RemoveAll([](const FSubscriber& Subscriber) { return !Subscriber.Delegate.IsBound(); });
+}
+
+void FStrategyGameplayEventBus::Reset()
+{
+	PendingEvents.Reset();
+	Subscribers.Reset();
+}
+
+void FStrategyGameplayEventBus::Post(const UWorld* World, const FStrategyGameplayEvent& Event)
+{
+	AStrategyGameState* const GameState = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	if (GameState)
+	{
+		GameState->GetEventBus().Post(Event);
+	}
+}
@@ -0,0 +1,479 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyMapWarmup.h"
+#include "StrategyGameLoadingScreen.h"
+#include "StrategyBuilding_Brewery.h"
+#include "StrategyAttachment.h"
+#include "StrategyProjectile.h"
+#include "ZombieCharacter.h"
+#include "NavigationSystem.h"
+#include "ShaderPipelineCache.h"
+#if WITH_EDITOR
+#include "ShaderCompiler.h"
+#endif
+
+/** how many unit meshes are added each frame */
+static const int32 WarmupMeshesPerFrame = 2;
+
+/** frames each mesh is drawn for */
+static const int32 WarmupMeshFrames = 2;
+
+/** distance in front of the camera meshes are drawn at */
+static const float WarmupMeshDistance = 500.0f;
+
+/** seconds textures of unit meshes are kept fully streamed in */
+static const float WarmupTextureSeconds = 10.0f;
+
+/** stage names used by the loading screen and in the timing log */
+static const TCHAR* const WarmupStageNames[] = { TEXT("Assets"), TEXT("Navigation"), TEXT("Shaders"), TEXT("Units") };
+
+TSharedPtr<FStrategyMapWarmup> FStrategyMapWarmup::Instance = nullptr;
+
+FStrategyMapWarmup::FStrategyMapWarmup()
+	: NumWarmupMeshes(0)
+	, NumUnitClasses(0)
+	, WarmupFramesLeft(0)
+	, InitialNavigationTasks(0)
+	, InitialShaderPrecompiles(0)
+	, MapLoadStartTime(0.0)
+	, WarmupStartTime(0.0)
+	, WarmupEndTime(0.0)
+	, bIsWarmupComplete(false)
+	, NumManifestAssets(0)
+{
+	FMemory::Memzero(bStageRunning);
+	FMemory::Memzero(bStageDone);
+}
+
+void FStrategyMapWarmup::Initialize()
+{
+	if (!Instance.IsValid())
+	{
+		Instance = MakeShareable(new FStrategyMapWarmup());
+		Instance->PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddRaw(Instance.Get(), &FStrategyMapWarmup::OnPreLoadMap);
+	}
+}
+
+void FStrategyMapWarmup::Shutdown()
+{
+	if (Instance.IsValid())
+	{
+		FCoreUObjectDelegates::PreLoadMap.Remove(Instance->PreLoadMapHandle);
+		if (Instance->TickerHandle.IsValid())
+		{
+			FTicker::GetCoreTicker().RemoveTicker(Instance->TickerHandle);
+		}
+		if (Instance->PreloadHandle.IsValid())
+		{
+			Instance->PreloadHandle->CancelHandle();
+		}
+		Instance.Reset();
+	}
+}
+
+FStrategyMapWarmup& FStrategyMapWarmup::Get()
+{
+	check(Instance.IsValid());
+	return *Instance;
+}
+
+void FStrategyMapWarmup::OnPreLoadMap(const FString& MapName)
+{
+	MapLoadStartTime = FPlatformTime::Seconds();
+}
+
+void FStrategyMapWarmup::StartWarmup(const AStrategyGameMode* GameMode, FSimpleDelegate OnComplete)
+{
+	check(GameMode);
+
+	// release assets of the previous map
+	if (PreloadHandle.IsValid())
+	{
+		PreloadHandle->CancelHandle();
+		PreloadHandle.Reset();
+	}
+
+	OnCompleteDelegate = OnComplete;
+	WarmupWorld = GameMode->GetWorld();
+	bIsWarmupComplete = false;
+	WarmupStartTime = FPlatformTime::Seconds();
+	WarmupEndTime = 0.0;
+	FMemory::Memzero(bStageRunning);
+	FMemory::Memzero(bStageDone);
+	PendingMeshes.Reset();
+	NumWarmupMeshes = 0;
+	NumUnitClasses = 0;
+	WarmupFramesLeft = 0;
+
+	// stages which don't depend on each other run in parallel
+	BeginStage(EStage::Navigation);
+	UNavigationSystemV1* const NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GameMode->GetWorld());
+	InitialNavigationTasks = NavSys ? NavSys->GetNumRemainingBuildTasks() : 0;
+
+	// precompile is paused while the map loads, run it at full speed behind the loading screen
+	BeginStage(EStage::Shaders);
+	FShaderPipelineCache::SetBatchMode(FShaderPipelineCache::BatchMode::Fast);
+	FShaderPipelineCache::ResumeBatching();
+	InitialShaderPrecompiles = FShaderPipelineCache::NumPrecompilesRemaining();
+
+	TArray<FSoftObjectPath> Manifest;
+	GameMode->GetPreloadAssets(Manifest);
+	NumManifestAssets = Manifest.Num();
+	BeginStage(EStage::Assets);
+	if (NumManifestAssets > 0)
+	{
+		PreloadHandle = StreamableManager.RequestAsyncLoad(Manifest, FStreamableDelegate::CreateRaw(this, &FStrategyMapWarmup::OnAssetsLoaded), FStreamableManager::AsyncLoadHighPriority);
+		if (PreloadHandle.IsValid())
+		{
+			PreloadHandle->BindUpdateDelegate(FStreamableUpdateDelegate::CreateRaw(this, &FStrategyMapWarmup::OnAssetsUpdate));
+		}
+	}
+
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FStrategyMapWarmup::Tick));
+	}
+
+	// nothing to stream
+	if (!PreloadHandle.IsValid())
+	{
+		OnAssetsLoaded();
+	}
+}
+
+bool FStrategyMapWarmup::IsWarmupComplete() const
+{
+	return bIsWarmupComplete;
+}
+
+bool FStrategyMapWarmup::Tick(float DeltaTime)
+{
+	if (bStageRunning[(uint8)EStage::Navigation])
+	{
+		const float Progress = GetNavigationProgress();
+		UpdateStage(EStage::Navigation, Progress);
+		if (Progress >= 1.0f)
+		{
+			EndStage(EStage::Navigation);
+		}
+	}
+
+	if (bStageRunning[(uint8)EStage::Shaders])
+	{
+		const float Progress = GetShadersProgress();
+		UpdateStage(EStage::Shaders, Progress);
+		if (Progress >= 1.0f)
+		{
+			FShaderPipelineCache::SetBatchMode(FShaderPipelineCache::BatchMode::Background);
+			EndStage(EStage::Shaders);
+		}
+	}
+
+	if (bStageRunning[(uint8)EStage::Units])
+	{
+		const float Progress = WarmupUnitAssets();
+		UpdateStage(EStage::Units, Progress);
+		if (Progress >= 1.0f)
+		{
+			EndStage(EStage::Units);
+		}
+	}
+
+	CheckWarmupComplete();
+
+	// keep ticking until everything is done
+	if (bIsWarmupComplete)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FStrategyMapWarmup::OnAssetsUpdate(TSharedRef<FStreamableHandle> Handle)
+{
+	UpdateStage(EStage::Assets, Handle->GetProgress());
+}
+
+void FStrategyMapWarmup::OnAssetsLoaded()
+{
+	EndStage(EStage::Assets);
+
+	// unit warmup draws the units the assets were streamed for
+	BeginStage(EStage::Units);
+	GatherUnitAssets();
+}
+
+float FStrategyMapWarmup::GetNavigationProgress()
+{
+	UNavigationSystemV1* const NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(WarmupWorld.Get());
+	if (NavSys == nullptr || !NavSys->IsNavigationBuildInProgress())
+	{
+		return 1.0f;
+	}
+
+	// tasks may be added after the stage started
+	const int32 RemainingTasks = NavSys->GetNumRemainingBuildTasks();
+	InitialNavigationTasks = FMath::Max(InitialNavigationTasks, RemainingTasks);
+	return InitialNavigationTasks > 0 ? FMath::Min(1.0f - (float)RemainingTasks / InitialNavigationTasks, 0.99f) : 0.0f;
+}
+
+float FStrategyMapWarmup::GetShadersProgress()
+{
+	uint32 RemainingJobs = FShaderPipelineCache::NumPrecompilesRemaining();
+#if WITH_EDITOR
+	if (GShaderCompilingManager)
+	{
+		RemainingJobs += GShaderCompilingManager->GetNumRemainingJobs();
+	}
+#endif
+	if (RemainingJobs == 0)
+	{
+		return 1.0f;
+	}
+
+	InitialShaderPrecompiles = FMath::Max(InitialShaderPrecompiles, RemainingJobs);
+	return FMath::Min(1.0f - (float)RemainingJobs / InitialShaderPrecompiles, 0.99f);
+}
+
+void FStrategyMapWarmup::GatherUnitAssets()
+{
+	TArray<UClass*> UnitClasses;
+	UWorld* const World = WarmupWorld.Get();
+	if (World)
+	{
+		for (TActorIterator<AStrategyBuilding_Brewery> It(World); It; ++It)
+		{
+			if (It->DwarfCharClass)
+			{
+				UnitClasses.AddUnique(*It->DwarfCharClass);
+			}
+			if (It->ZombieCharClass)
+			{
+				UnitClasses.AddUnique(*It->ZombieCharClass);
+			}
+		}
+	}
+
+	// projectiles and attachments are only referenced by blueprints, take what was loaded with the map
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		if ((It->IsChildOf(AStrategyProjectile::StaticClass()) || It->IsChildOf(UStrategyAttachment::StaticClass()))
+			&& !It->HasAnyClassFlags(CLASS_Abstract | CLASS_NewerVersionExists))
+		{
+			UnitClasses.AddUnique(*It);
+		}
+	}
+	NumUnitClasses = UnitClasses.Num();
+
+	for (UClass* const UnitClass : UnitClasses)
+	{
+		FWarmupMesh WarmupMesh;
+		if (const ACharacter* const DefaultChar = Cast<ACharacter>(UnitClass->GetDefaultObject()))
+		{
+			if (DefaultChar->GetMesh())
+			{
+				WarmupMesh.Mesh = DefaultChar->GetMesh()->SkeletalMesh;
+				WarmupMesh.AnimClass = DefaultChar->GetMesh()->AnimClass;
+			}
+
+			TArray<UAnimMontage*> Montages;
+			if (const ABaseCharacter* const DefaultPawn = Cast<ABaseCharacter>(DefaultChar))
+			{
+				DefaultPawn->GetMontages(Montages);
+			}
+			for (UAnimMontage* const Montage : Montages)
+			{
+				WarmupMesh.Montages.Add(Montage);
+			}
+		}
+		else if (const UStrategyAttachment* const DefaultAttachment = Cast<UStrategyAttachment>(UnitClass->GetDefaultObject()))
+		{
+			WarmupMesh.Mesh = DefaultAttachment->SkeletalMesh;
+		}
+		else
+		{
+			// projectile meshes come from their blueprints, creating the default object is all we can do ahead
+			UnitClass->GetDefaultObject();
+		}
+
+		if (WarmupMesh.Mesh.IsValid())
+		{
+			PendingMeshes.Add(WarmupMesh);
+		}
+	}
+	NumWarmupMeshes = PendingMeshes.Num();
+}
+
+float FStrategyMapWarmup::WarmupUnitAssets()
+{
+	UWorld* const World = WarmupWorld.Get();
+	if (World == nullptr)
+	{
+		PendingMeshes.Reset();
+		return 1.0f;
+	}
+
+	if (PendingMeshes.Num() > 0)
+	{
+		AActor* Owner = WarmupActor.Get();
+		if (Owner == nullptr)
+		{
+			FActorSpawnParameters SpawnInfo;
+			SpawnInfo.ObjectFlags |= RF_Transient;
+			Owner = World->SpawnActor<AActor>(SpawnInfo);
+			WarmupActor = Owner;
+		}
+
+		// in front of the camera, hidden by the loading screen
+		FVector Location = FVector::ZeroVector;
+		const APlayerController* const PlayerController = World->GetFirstPlayerController();
+		if (PlayerController && PlayerController->PlayerCameraManager)
+		{
+			Location = PlayerController->PlayerCameraManager->GetCameraLocation() + PlayerController->PlayerCameraManager->GetCameraRotation().Vector() * WarmupMeshDistance;
+		}
+
+		for (int32 Idx = 0; Idx < WarmupMeshesPerFrame && PendingMeshes.Num() > 0 && Owner; Idx++)
+		{
+			const FWarmupMesh WarmupMesh = PendingMeshes.Pop(false);
+			if (!WarmupMesh.Mesh.IsValid())
+			{
+				continue;
+			}
+
+			USkeletalMeshComponent* const MeshComp = NewObject<USkeletalMeshComponent>(Owner);
+			MeshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			MeshComp->SetSkeletalMesh(WarmupMesh.Mesh.Get());
+			if (WarmupMesh.AnimClass.IsValid())
+			{
+				MeshComp->SetAnimInstanceClass(WarmupMesh.AnimClass.Get());
+			}
+			MeshComp->SetWorldLocation(Location);
+			MeshComp->RegisterComponent();
+			MeshComp->PrestreamTextures(WarmupTextureSeconds, true);
+
+			UAnimInstance* const AnimInstance = MeshComp->GetAnimInstance();
+			for (const TWeakObjectPtr<UAnimMontage>& Montage : WarmupMesh.Montages)
+			{
+				if (AnimInstance && Montage.IsValid())
+				{
+					AnimInstance->Montage_Play(Montage.Get());
+				}
+			}
+		}
+		WarmupFramesLeft = WarmupMeshFrames;
+	}
+	else if (WarmupFramesLeft > 0)
+	{
+		WarmupFramesLeft--;
+	}
+
+	if (PendingMeshes.Num() == 0 && WarmupFramesLeft == 0)
+	{
+		if (WarmupActor.IsValid())
+		{
+			WarmupActor->Destroy();
+		}
+		WarmupActor.Reset();
+		return 1.0f;
+	}
+
+	// last frames of drawing count as the last step
+	return NumWarmupMeshes > 0 ? FMath::Min(1.0f - (float)PendingMeshes.Num() / NumWarmupMeshes, 0.99f) : 0.99f;
+}
+
+void FStrategyMapWarmup::BeginStage(EStage Stage)
+{
+	static_assert(UE_ARRAY_COUNT(WarmupStageNames) == (uint8)EStage::MAX, "Missing warmup stage name");
+	bStageRunning[(uint8)Stage] = true;
+
+	IStrategyGameLoadingScreenModule* const LoadingScreenModule = FModuleManager::GetModulePtr<IStrategyGameLoadingScreenModule>("StrategyGameLoadingScreen");
+	if (LoadingScreenModule != nullptr)
+	{
+		FText DisplayName;
+		switch (Stage)
+		{
+			case EStage::Assets:
+				DisplayName = FText::Format(NSLOCTEXT("LoadingScreen", "WarmupAssets", "Loading assets ({0})"), FText::AsNumber(NumManifestAssets));
+				break;
+			case EStage::Navigation:
+				DisplayName = NSLOCTEXT("LoadingScreen", "WarmupNavigation", "Building navigation");
+				break;
+			case EStage::Shaders:
+				DisplayName = NSLOCTEXT("LoadingScreen", "WarmupShaders", "Compiling shaders");
+				break;
+			default:
+				DisplayName = NSLOCTEXT("LoadingScreen", "WarmupUnits", "Preparing units");
+				break;
+		}
+		LoadingScreenModule->BeginWarmupStage(FName(WarmupStageNames[(uint8)Stage]), DisplayName);
+	}
+}
+
+void FStrategyMapWarmup::UpdateStage(EStage Stage, float Progress)
+{
+	IStrategyGameLoadingScreenModule* const LoadingScreenModule = FModuleManager::GetModulePtr<IStrategyGameLoadingScreenModule>("StrategyGameLoadingScreen");
+	if (LoadingScreenModule != nullptr)
+	{
+		LoadingScreenModule->UpdateWarmupStage(FName(WarmupStageNames[(uint8)Stage]), Progress);
+	}
+}
+
+void FStrategyMapWarmup::EndStage(EStage Stage)
+{
+	bStageRunning[(uint8)Stage] = false;
+	bStageDone[(uint8)Stage] = true;
+
+	IStrategyGameLoadingScreenModule* const LoadingScreenModule = FModuleManager::GetModulePtr<IStrategyGameLoadingScreenModule>("StrategyGameLoadingScreen");
+	if (LoadingScreenModule != nullptr)
+	{
+		LoadingScreenModule->EndWarmupStage(FName(WarmupStageNames[(uint8)Stage]));
+	}
+}
+
+void FStrategyMapWarmup::CheckWarmupComplete()
+{
+	if (bIsWarmupComplete)
+	{
+		return;
+	}
+
+	for (uint8 Idx = 0; Idx < (uint8)EStage::MAX; Idx++)
+	{
+		if (!bStageDone[Idx])
+		{
+			return;
+		}
+	}
+
+	bIsWarmupComplete = true;
+	WarmupEndTime = FPlatformTime::Seconds();
+	UE_LOG(LogGame, Log, TEXT("Map warmup finished in %.3f s (%d assets, %d unit classes, %d meshes)"), WarmupEndTime - WarmupStartTime, NumManifestAssets, NumUnitClasses, NumWarmupMeshes);
+
+	IStrategyGameLoadingScreenModule* const LoadingScreenModule = FModuleManager::GetModulePtr<IStrategyGameLoadingScreenModule>("StrategyGameLoadingScreen");
+	if (LoadingScreenModule != nullptr)
+	{
+		LoadingScreenModule->StopInGameLoadingScreen();
+	}
+
+	// delegate may start another warmup, so unbind before executing it
+	FSimpleDelegate CompleteDelegate = OnCompleteDelegate;
+	OnCompleteDelegate.Unbind();
+	CompleteDelegate.ExecuteIfBound();
+}
+
+void FStrategyMapWarmup::NotifyInteractive(const UWorld* World)
+{
+	const double Now = FPlatformTime::Seconds();
+	// without PreLoadMap (e.g. PIE) measure from the start of the warmup
+	const double StartTime = (MapLoadStartTime > 0.0 && MapLoadStartTime <= WarmupStartTime) ? MapLoadStartTime : WarmupStartTime;
+
+	UE_LOG(LogGame, Log, TEXT("Map %s interactive after %.3f s (map load %.3f s, warmup %.3f s)"),
+		World ? *World->GetMapName() : TEXT("None"),
+		Now - StartTime,
+		WarmupStartTime - StartTime,
+		WarmupEndTime - WarmupStartTime);
+
+	MapLoadStartTime = 0.0;
+}
@@ -0,0 +1,472 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyMatchSnapshot.h"
+#include "StrategyBuilding_Brewery.h"
+#include "StrategyAIDirector.h"
+#include "StrategyAIController.h"
+#include "StrategyAIAction.h"
+#include "StrategyAttachment.h"
+#include "StrategyGameBlueprintLibrary.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/LargeMemoryReader.h"
+
+/** rough size of a unit record, used to size the write buffer up front */
+static const int32 UnitRecordSizeEstimate = 160;
+
+TFuture<bool> FStrategyMatchSnapshot::PendingWrite;
+
+int32 FStrategyMatchSnapshot::FData::GetClassIndex(const UClass* Class)
+{
+	if (Class == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32* const Found = ClassIndices.Find(Class);
+	if (Found)
+	{
+		return *Found;
+	}
+
+	const int32 Index = Header.ClassPaths.Add(Class->GetPathName());
+	ClassIndices.Add(Class, Index);
+	return Index;
+}
+
+FString FStrategyMatchSnapshot::GetFilename(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Snapshots") / (Name.IsEmpty() ? FString(TEXT("Quick")) : Name) + TEXT(".ssnp");
+}
+
+bool FStrategyMatchSnapshot::Save(AStrategyGameState* GameState, const FString& Name)
+{
+	if (GameState == nullptr || !GameState->IsGameActive())
+	{
+		UE_LOG(LogGame, Warning, TEXT("Match snapshot can only be taken while the match is playing"));
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	UWorld* const World = GameState->GetWorld();
+	const float GameTime = World->GetTimeSeconds();
+
+	FData Data;
+	Data.Header.MapName = World->GetMapName();
+	Data.Header.GameTime = GameTime;
+
+	for (int32 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		const FPlayerData& TeamData = GameState->PlayersData[TeamNum];
+		Data.Teams[TeamNum].ResourcesAvailable = TeamData.ResourcesAvailable;
+		Data.Teams[TeamNum].ResourcesGathered = TeamData.ResourcesGathered;
+		Data.Teams[TeamNum].DamageDone = TeamData.DamageDone;
+
+		AStrategyBuilding_Brewery* const Brewery = TeamData.Brewery.Get();
+		if (Brewery)
+		{
+			FStrategySnapshotBrewery& Record = Data.Breweries[Data.Breweries.AddDefaulted()];
+			Record.TeamNum = TeamNum;
+			Record.NumberOfLives = Brewery->GetNumberOfLives();
+			for (const TSubclassOf<AStrategyBuilding>& Upgrade : Brewery->Upgrades)
+			{
+				Record.Upgrades.Add(Data.GetClassIndex(*Upgrade));
+			}
+
+			const UStrategyAIDirector* const Director = Brewery->GetAIDirector();
+			if (Director)
+			{
+				Record.WaveSize = Director->WaveSize;
+				Record.ZombieWaveSize = Director->ZombieWaveSize;
+				Record.DwarfSpawnDelay = FMath::Max(Director->NextDwarfSpawnTime - GameTime, 0.0f);
+				Record.ZombieSpawnDelay = FMath::Max(Director->NextZombieSpawnTime - GameTime, 0.0f);
+			}
+		}
+	}
+
+	for (AStrategyBuilding* Building : TActorRange<AStrategyBuilding>(World))
+	{
+		CaptureBuilding(Data, GameState, Building);
+	}
+
+	Data.Units.Reserve(GameState->GetNumberOfLivePawns(EStrategyTeam::Player) + GameState->GetNumberOfLivePawns(EStrategyTeam::Enemy));
+	for (ABaseCharacter* Unit : TActorRange<ABaseCharacter>(World))
+	{
+		CaptureUnit(Data, Unit, GameTime);
+	}
+
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Blob = MakeShareable(new TArray<uint8>());
+	Blob->Reserve(Data.Units.Num() * UnitRecordSizeEstimate + 4096);
+	FMemoryWriter Writer(*Blob);
+	Writer << Data;
+
+	// only one write at a time, so a quick save over the same name can't be overtaken by older one
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+	}
+
+	const FString Filename = GetFilename(Name);
+	PendingWrite = Async(EAsyncExecution::ThreadPool, [Blob, Filename]()
+	{
+		const bool bSaved = FFileHelper::SaveArrayToFile(*Blob, *Filename);
+		if (!bSaved)
+		{
+			UE_LOG(LogGame, Warning, TEXT("Failed to write match snapshot %s"), *Filename);
+		}
+		return bSaved;
+	});
+
+	UE_LOG(LogGame, Log, TEXT("Match snapshot %s: %d buildings, %d units, %d bytes captured in %.3f s"),
+		*Filename, Data.Buildings.Num(), Data.Units.Num(), Blob->Num(), FPlatformTime::Seconds() - StartTime);
+	return true;
+}
+
+void FStrategyMatchSnapshot::CaptureBuilding(FData& Data, const AStrategyGameState* GameState, AStrategyBuilding* Building)
+{
+	// breweries are kept, replaced buildings are about to go away
+	if (Building->IsA(AStrategyBuilding_Brewery::StaticClass()) || Building->IsPendingKill() || Building->GetLifeSpan() > 0.0f)
+	{
+		return;
+	}
+
+	FStrategySnapshotBuilding& Record = Data.Buildings[Data.Buildings.AddDefaulted()];
+	Record.Name = Building->GetName();
+	Record.ClassIndex = Data.GetClassIndex(Building->GetClass());
+	Record.Transform = Building->GetActorTransform();
+	Record.TeamNum = Building->GetTeamNum();
+	Record.Health = Building->Health;
+	Record.bIsBeingBuild = Building->bIsBeingBuild;
+	Record.bIsContructionFinished = Building->bIsContructionFinished;
+	Record.InitialBuildTime = Building->InitialBuildTime;
+	Record.RemainingBuildTime = Building->RemainingBuildTime;
+
+	const FPlayerData* const TeamData = GameState->GetPlayerData(Record.TeamNum);
+	const AStrategyBuilding_Brewery* const Brewery = TeamData ? TeamData->Brewery.Get() : nullptr;
+	if (Brewery)
+	{
+		Record.BrewerySlot = Brewery->LeftSlot == Building ? 1 : (Brewery->RightSlot == Building ? 2 : 0);
+	}
+}
+
+void FStrategyMatchSnapshot::CaptureUnit(FData& Data, ABaseCharacter* Unit, float GameTime)
+{
+	if (Unit->bIsDying || Unit->GetHealth() <= 0 || Unit->IsPendingKill())
+	{
+		return;
+	}
+
+	FStrategySnapshotUnit& Record = Data.Units[Data.Units.AddDefaulted()];
+	Record.ClassIndex = Data.GetClassIndex(Unit->GetClass());
+	Record.Transform = Unit->GetActorTransform();
+	Record.AnimRateScale = Unit->GetMesh() ? Unit->GetMesh()->GlobalAnimRateScale : 1.0f;
+	Record.TeamNum = Unit->GetTeamNum();
+	Record.Health = Unit->Health;
+
+	const AStrategyChar* const Char = Cast<AStrategyChar>(Unit);
+	if (Char)
+	{
+		Record.WeaponClassIndex = Data.GetClassIndex(Char->WeaponSlot ? Char->WeaponSlot->GetClass() : nullptr);
+		Record.ArmorClassIndex = Data.GetClassIndex(Char->ArmorSlot ? Char->ArmorSlot->GetClass() : nullptr);
+	}
+
+	const AStrategyAIController* const AIController = Cast<AStrategyAIController>(Unit->Controller);
+	if (AIController && AIController->CurrentAction)
+	{
+		Record.ActionClassIndex = Data.GetClassIndex(AIController->CurrentAction->GetClass());
+	}
+
+	Record.Buffs.Reserve(Unit->ActiveBuffs.Num());
+	for (const FBuffData& Buff : Unit->ActiveBuffs)
+	{
+		FStrategySnapshotBuff& BuffRecord = Record.Buffs[Record.Buffs.AddDefaulted()];
+		BuffRecord.BuffData = Buff.BuffData;
+		BuffRecord.bInfiniteDuration = Buff.bInfiniteDuration;
+		BuffRecord.Duration = Buff.Duration;
+		BuffRecord.TimeLeft = Buff.bInfiniteDuration ? 0.0f : FMath::Max(Buff.EndTime - GameTime, 0.0f);
+	}
+}
+
+bool FStrategyMatchSnapshot::Load(AStrategyGameState* GameState, const FString& Name)
+{
+	if (GameState == nullptr || !GameState->IsGameActive())
+	{
+		UE_LOG(LogGame, Warning, TEXT("Match snapshot can only be loaded while the match is playing"));
+		return false;
+	}
+
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FString Filename = GetFilename(Name);
+	FData Data;
+	bool bRead = false;
+
+	// map the file when the platform can, otherwise read it in one go
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Filename));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile.IsValid() ? MappedFile->MapRegion() : nullptr);
+	if (MappedRegion.IsValid())
+	{
+		FLargeMemoryReader Reader(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+		Reader << Data;
+		bRead = !Reader.IsError();
+	}
+	else
+	{
+		TArray<uint8> FileData;
+		if (FFileHelper::LoadFileToArray(FileData, *Filename))
+		{
+			FMemoryReader Reader(FileData);
+			Reader << Data;
+			bRead = !Reader.IsError();
+		}
+	}
+
+	UWorld* const World = GameState->GetWorld();
+	if (!bRead)
+	{
+		UE_LOG(LogGame, Warning, TEXT("Failed to read match snapshot %s"), *Filename);
+		return false;
+	}
+	if (Data.Header.MapName != World->GetMapName())
+	{
+		UE_LOG(LogGame, Warning, TEXT("Match snapshot %s was taken on %s, can't load it on %s"), *Filename, *Data.Header.MapName, *World->GetMapName());
+		return false;
+	}
+
+	TArray<UClass*> Classes;
+	Classes.Reserve(Data.Header.ClassPaths.Num());
+	for (const FString& ClassPath : Data.Header.ClassPaths)
+	{
+		UClass* const Class = LoadObject<UClass>(nullptr, *ClassPath);
+		if (Class == nullptr)
+		{
+			UE_LOG(LogGame, Warning, TEXT("Match snapshot %s references missing class %s"), *Filename, *ClassPath);
+		}
+		Classes.Add(Class);
+	}
+
+	// deliver what happened before the load, so it doesn't leak into the restored match
+	GameState->EventBus.Dispatch();
+
+	const float GameTime = World->GetTimeSeconds();
+	for (int32 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		FPlayerData& TeamData = GameState->PlayersData[TeamNum];
+		GameState->SetResources(TeamNum, Data.Teams[TeamNum].ResourcesAvailable);
+		TeamData.ResourcesGathered = Data.Teams[TeamNum].ResourcesGathered;
+		TeamData.DamageDone = Data.Teams[TeamNum].DamageDone;
+	}
+
+	for (const FStrategySnapshotBrewery& Record : Data.Breweries)
+	{
+		const FPlayerData* const TeamData = GameState->GetPlayerData(Record.TeamNum);
+		AStrategyBuilding_Brewery* const Brewery = TeamData ? TeamData->Brewery.Get() : nullptr;
+		if (Brewery == nullptr)
+		{
+			continue;
+		}
+
+		Brewery->SetNumberOfLives(Record.NumberOfLives);
+		Brewery->Upgrades.Reset(Record.Upgrades.Num());
+		for (const int32 ClassIndex : Record.Upgrades)
+		{
+			if (Classes.IsValidIndex(ClassIndex) && Classes[ClassIndex])
+			{
+				Brewery->Upgrades.Add(Classes[ClassIndex]);
+			}
+		}
+
+		UStrategyAIDirector* const Director = Brewery->GetAIDirector();
+		if (Director)
+		{
+			Director->WaveSize = Record.WaveSize;
+			Director->ZombieWaveSize = Record.ZombieWaveSize;
+			Director->NextDwarfSpawnTime = GameTime + Record.DwarfSpawnDelay;
+			Director->NextZombieSpawnTime = GameTime + Record.ZombieSpawnDelay;
+		}
+	}
+
+	RestoreBuildings(GameState, Data, Classes);
+	RestoreUnits(GameState, Data, Classes);
+
+	UE_LOG(LogGame, Log, TEXT("Match snapshot %s: %d buildings, %d units restored in %.3f s (%s)"),
+		*Filename, Data.Buildings.Num(), Data.Units.Num(), FPlatformTime::Seconds() - StartTime, MappedRegion.IsValid() ? TEXT("mapped") : TEXT("read"));
+	return true;
+}
+
+void FStrategyMatchSnapshot::RestoreBuildings(AStrategyGameState* GameState, const FData& Data, const TArray<UClass*>& Classes)
+{
+	UWorld* const World = GameState->GetWorld();
+
+	// level placed buildings keep their names, they are updated in place
+	TMap<FString, AStrategyBuilding*> ExistingBuildings;
+	for (AStrategyBuilding* Building : TActorRange<AStrategyBuilding>(World))
+	{
+		if (!Building->IsA(AStrategyBuilding_Brewery::StaticClass()) && !Building->IsPendingKill())
+		{
+			ExistingBuildings.Add(Building->GetName(), Building);
+		}
+	}
+
+	for (const FStrategySnapshotBuilding& Record : Data.Buildings)
+	{
+		UClass* const Class = Classes.IsValidIndex(Record.ClassIndex) ? Classes[Record.ClassIndex] : nullptr;
+		if (Class == nullptr)
+		{
+			continue;
+		}
+
+		AStrategyBuilding* Building = nullptr;
+		if (ExistingBuildings.RemoveAndCopyValue(Record.Name, Building) && Building->GetClass() != Class)
+		{
+			Building->Destroy();
+			Building = nullptr;
+		}
+
+		if (Building)
+		{
+			// building may have been replaced meanwhile, keep it
+			Building->SetLifeSpan(0.0f);
+			Building->SetActorTransform(Record.Transform);
+			Building->SetTeamNum(Record.TeamNum);
+		}
+		else
+		{
+			Building = World->SpawnActorDeferred<AStrategyBuilding>(Class, Record.Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			if (Building == nullptr)
+			{
+				continue;
+			}
+			// joins the team once it's in the entity table
+			Building->SpawnTeamNum = (EStrategyTeam::Type)Record.TeamNum;
+			UGameplayStatics::FinishSpawningActor(Building, Record.Transform);
+		}
+
+		Building->Health = Record.Health;
+		Building->bIsBeingBuild = Record.bIsBeingBuild;
+		Building->bIsContructionFinished = Record.bIsContructionFinished;
+		Building->InitialBuildTime = Record.InitialBuildTime;
+		Building->RemainingBuildTime = Record.RemainingBuildTime;
+		if (Building->bIsBeingBuild)
+		{
+			Building->SetActorTickEnabled(true);
+		}
+
+		const FPlayerData* const TeamData = GameState->GetPlayerData(Record.TeamNum);
+		AStrategyBuilding_Brewery* const Brewery = TeamData ? TeamData->Brewery.Get() : nullptr;
+		if (Brewery && Record.BrewerySlot != 0)
+		{
+			if (Record.BrewerySlot == 1)
+			{
+				Brewery->LeftSlot = Building;
+			}
+			else
+			{
+				Brewery->RightSlot = Building;
+			}
+
+			if (Building->bIsBeingBuild && !Building->BuildFinishedDelegate.IsBound())
+			{
+				Building->BuildFinishedDelegate.BindUObject(Brewery, &AStrategyBuilding_Brewery::OnConstructedBuilding);
+			}
+		}
+	}
+
+	// buildings which didn't exist when the snapshot was taken
+	for (const TPair<FString, AStrategyBuilding*>& Pair : ExistingBuildings)
+	{
+		Pair.Value->Destroy();
+	}
+}
+
+void FStrategyMatchSnapshot::RestoreUnits(AStrategyGameState* GameState, const FData& Data, const TArray<UClass*>& Classes)
+{
+	UWorld* const World = GameState->GetWorld();
+	const float GameTime = World->GetTimeSeconds();
+
+	// there are no unit pools, current units are dropped and the snapshot ones spawned in one batch
+	TArray<ABaseCharacter*> OldUnits;
+	for (ABaseCharacter* Unit : TActorRange<ABaseCharacter>(World))
+	{
+		OldUnits.Add(Unit);
+	}
+	for (ABaseCharacter* Unit : OldUnits)
+	{
+		Unit->Destroy();
+	}
+
+	// spawn events below count the units again
+	FMemory::Memzero(GameState->LivePawnCounter);
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (const FStrategySnapshotUnit& Record : Data.Units)
+	{
+		UClass* const Class = Classes.IsValidIndex(Record.ClassIndex) ? Classes[Record.ClassIndex] : nullptr;
+		ABaseCharacter* const Unit = Class ? World->SpawnActor<ABaseCharacter>(Class, Record.Transform, SpawnInfo) : nullptr;
+		if (Unit == nullptr)
+		{
+			continue;
+		}
+
+		Unit->SetTeamNum(Record.TeamNum);
+		Unit->SpawnDefaultController();
+		if (Unit->GetMesh())
+		{
+			Unit->GetMesh()->GlobalAnimRateScale = Record.AnimRateScale;
+		}
+
+		FStrategyGameplayEvent SpawnEvent;
+		SpawnEvent.Type = EStrategyGameplayEvent::CharSpawned;
+		SpawnEvent.TeamNum = Unit->GetTeamNum();
+		SpawnEvent.Actor = Unit;
+		GameState->EventBus.Post(SpawnEvent);
+
+		Unit->ActiveBuffs.Reset(Record.Buffs.Num());
+		for (const FStrategySnapshotBuff& BuffRecord : Record.Buffs)
+		{
+			FBuffData Buff;
+			Buff.BuffData = BuffRecord.BuffData;
+			Buff.bInfiniteDuration = BuffRecord.bInfiniteDuration;
+			Buff.Duration = BuffRecord.Duration;
+			Buff.EndTime = GameTime + BuffRecord.TimeLeft;
+			Unit->ActiveBuffs.Add(Buff);
+		}
+
+		AStrategyChar* const Char = Cast<AStrategyChar>(Unit);
+		if (Char)
+		{
+			if (Classes.IsValidIndex(Record.WeaponClassIndex))
+			{
+				UStrategyGameBlueprintLibrary::GiveWeaponFromClass(Char, Classes[Record.WeaponClassIndex]);
+			}
+			if (Classes.IsValidIndex(Record.ArmorClassIndex))
+			{
+				UStrategyGameBlueprintLibrary::GiveArmorFromClass(Char, Classes[Record.ArmorClassIndex]);
+			}
+		}
+
+		// health last, pawn data update clamps it to the new maximum
+		Unit->UpdatePawnData();
+		Unit->Health = Record.Health;
+
+		// resume the action if it still makes sense, the controller picks a new one otherwise
+		AStrategyAIController* const AIController = Cast<AStrategyAIController>(Unit->Controller);
+		UClass* const ActionClass = Classes.IsValidIndex(Record.ActionClassIndex) ? Classes[Record.ActionClassIndex] : nullptr;
+		const UStrategyAIAction* const Action = (AIController && ActionClass) ? AIController->GetInstanceOfAction(ActionClass) : nullptr;
+		if (Action && Action->ShouldActivate(AIController))
+		{
+			AIController->ActivateAction(Action);
+		}
+	}
+}
@@ -40,11 +40,40 @@ void AStrategyProjectile::InitProjectile(const FVector& Direction, uint8 InTeamN
 	
 	MyTeamNum = InTeamNum;
 	RemainingDamage = ImpactDamage;
+
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities)
+	{
+		Entities->SetTeamNum(EntityHandle, InTeamNum);
+	}
 	SetLifeSpan( InLifeSpan );
 
 	bInitialized = true;
 }
 
+void AStrategyProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities)
+	{
+		EntityHandle = Entities->Add(this, EStrategyEntity::Projectile, MyTeamNum);
+	}
+}
+
+void AStrategyProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(GetWorld());
+	if (Entities)
+	{
+		Entities->Remove(EntityHandle);
+		EntityHandle = FStrategyEntityHandle();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AStrategyProjectile::NotifyActorBeginOverlap(class AActor* OtherActor)
 {
 	Super::NotifyActorBeginOverlap(OtherActor);
@@ -89,13 +118,13 @@ void AStrategyProjectile::OnHit(FHitResult const& HitResult)
 void AStrategyProjectile::DealDamage(FHitResult const& HitResult)
 {
 	const ABaseCharacter* HitChar = Cast<ABaseCharacter>(HitResult.Actor.Get());
-	const float PrevHealth = HitChar ? HitChar->Health : 0.0f;
 
-	UGameplayStatics::ApplyPointDamage(HitResult.Actor.Get(), RemainingDamage, -HitResult.ImpactNormal, HitResult, NULL, this, UDamageType::StaticClass());
+	// queued damage is taken from health later this frame, piercing uses what will be taken
+	const float ActualDamage = FStrategyDamageQueue::ApplyPointDamage(HitResult.Actor.Get(), RemainingDamage, -HitResult.ImpactNormal, HitResult, NULL, this, UDamageType::StaticClass());
 
 	if (HitChar && !ConstantDamage)
 	{
-		RemainingDamage -= FMath::TruncToInt(PrevHealth - HitChar->Health);
+		RemainingDamage -= FMath::TruncToInt(ActualDamage);
 	}
 }
 
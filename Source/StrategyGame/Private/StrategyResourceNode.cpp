@@ -21,7 +21,7 @@ void AStrategyResourceNode::OnInputTap_Implementation()
 
 		if (TeamData)
 		{
-			TeamData->ResourcesAvailable += NumResources;
+			MyGameState->AddResources(EStrategyTeam::Player, NumResources);
 			TeamData->ResourcesGathered += NumResources;
 		}
 
@@ -0,0 +1,126 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategySceneQueries.h"
+
+DECLARE_CYCLE_STAT(TEXT("Scene query results"), STAT_StrategySceneQueryResults, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async scene queries"), STAT_StrategyAsyncSceneQueries, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Blocking scene queries"), STAT_StrategyBlockingSceneQueries, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lost scene queries"), STAT_StrategyLostSceneQueries, STATGROUP_StrategyGame);
+
+FStrategySceneQueries::FStrategySceneQueries()
+	: bAsync(true)
+{
+}
+
+void FStrategySceneQueries::Configure(bool bInAsync)
+{
+	Reset();
+	bAsync = bInAsync;
+}
+
+void FStrategySceneQueries::Reset()
+{
+	Pending.Reset();
+	Finished.Reset();
+}
+
+void FStrategySceneQueries::Cancel(const void* UserObject)
+{
+	Pending.RemoveAll([UserObject](const FPendingQuery& Query) { return Query.OnDone.IsBoundToObject(UserObject); });
+}
+
+FStrategySceneQueries* FStrategySceneQueries::Get(UWorld* World)
+{
+	AStrategyGameState* const MyGameState = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	FStrategySceneQueries* const Queries = MyGameState ? &MyGameState->GetSceneQueries() : nullptr;
+	return (Queries && Queries->bAsync) ? Queries : nullptr;
+}
+
+void FStrategySceneQueries::AddPending(const FTraceHandle& Handle, const FOnStrategySceneQueryDone& OnDone)
+{
+	FPendingQuery& Query = Pending[Pending.AddDefaulted()];
+	Query.Handle = Handle;
+	Query.Frame = GFrameCounter;
+	Query.OnDone = OnDone;
+	INC_DWORD_STAT(STAT_StrategyAsyncSceneQueries);
+}
+
+void FStrategySceneQueries::Tick(UWorld* World)
+{
+	if (Pending.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategySceneQueryResults);
+
+	// queries of this frame run at its end, callbacks may issue new ones
+	Finished.Reset();
+	int32 NumKept = 0;
+	for (int32 Idx = 0; Idx < Pending.Num(); Idx++)
+	{
+		if (Pending[Idx].Frame < GFrameCounter)
+		{
+			Finished.Add(MoveTemp(Pending[Idx]));
+		}
+		else if (NumKept++ != Idx)
+		{
+			Pending[NumKept - 1] = MoveTemp(Pending[Idx]);
+		}
+	}
+	Pending.SetNum(NumKept, false);
+
+	FTraceDatum Datum;
+	const TArray<FHitResult> NoHits;
+	for (const FPendingQuery& Query : Finished)
+	{
+		if (World->QueryTraceData(Query.Handle, Datum))
+		{
+			Query.OnDone.ExecuteIfBound(Datum.OutHits);
+		}
+		else
+		{
+			// results are kept for one frame only
+			INC_DWORD_STAT(STAT_StrategyLostSceneQueries);
+			Query.OnDone.ExecuteIfBound(NoHits);
+		}
+	}
+	Finished.Reset();
+}
+
+void FStrategySceneQueries::LineTraceSingleByObjectType(UWorld* World, const FVector& Start, const FVector& End, const FCollisionObjectQueryParams& ObjectParams, const FCollisionQueryParams& Params, const FOnStrategySceneQueryDone& OnDone)
+{
+	check(World);
+	FStrategySceneQueries* const Queries = Get(World);
+	if (Queries)
+	{
+		Queries->AddPending(World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Start, End, ObjectParams, Params), OnDone);
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_StrategyBlockingSceneQueries);
+	TArray<FHitResult> Hits;
+	FHitResult Hit;
+	if (World->LineTraceSingleByObjectType(Hit, Start, End, ObjectParams, Params))
+	{
+		Hits.Add(Hit);
+	}
+	OnDone.ExecuteIfBound(Hits);
+}
+
+void FStrategySceneQueries::SweepMultiByChannel(UWorld* World, const FVector& Start, const FVector& End, ECollisionChannel Channel, const FCollisionShape& Shape, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParams, const FOnStrategySceneQueryDone& OnDone)
+{
+	check(World);
+	FStrategySceneQueries* const Queries = Get(World);
+	if (Queries)
+	{
+		Queries->AddPending(World->AsyncSweepByChannel(EAsyncTraceType::Multi, Start, End, FQuat::Identity, Channel, Shape, Params, ResponseParams), OnDone);
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_StrategyBlockingSceneQueries);
+	TArray<FHitResult> Hits;
+	World->SweepMultiByChannel(Hits, Start, End, FQuat::Identity, Channel, Shape, Params, ResponseParams);
+	OnDone.ExecuteIfBound(Hits);
+}
@@ -0,0 +1,440 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyStressRun.h"
+#include "StrategyBuilding_Brewery.h"
+#include "StrategyAIDirector.h"
+#include "StrategyAIAction.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformFilemanager.h"
+
+CSV_DEFINE_CATEGORY(Strategy, true);
+
+FStrategyStressRun* FStrategyStressRun::ActiveRun = nullptr;
+TArray<int32> FStrategyStressRun::Scenarios;
+int32 FStrategyStressRun::ScenarioIndex = 0;
+bool FStrategyStressRun::bAnyFailed = false;
+bool FStrategyStressRun::bExitWhenDone = true;
+FStrategyStressResult FStrategyStressRun::LastResult;
+
+/** simulated frame rate of stress runs */
+static const double StressFrameRate = 30.0;
+
+/** real seconds the match has to start in */
+static const double StressStartTimeout = 300.0;
+
+const TCHAR* EStrategySubsystem::GetName(Type Subsystem)
+{
+	static const TCHAR* const Names[] =
+	{
+		TEXT("SceneQueries"),
+		TEXT("Damage"),
+		TEXT("Events"),
+		TEXT("Visibility"),
+		TEXT("AttackSlots"),
+		TEXT("NavFootprints"),
+		TEXT("Paths"),
+		TEXT("Crowd"),
+		TEXT("MeshMerge"),
+		TEXT("Audio"),
+		TEXT("CrowdRender"),
+		TEXT("Telemetry"),
+		TEXT("Spawning"),
+	};
+	static_assert(UE_ARRAY_COUNT(Names) == MAX, "Subsystem names out of date");
+	return Subsystem < MAX ? Names[Subsystem] : TEXT("Unknown");
+}
+
+/** @return value at percentile of sorted values */
+static float GetPercentile(const TArray<float>& SortedValues, float Percentile)
+{
+	if (SortedValues.Num() == 0)
+	{
+		return 0.0f;
+	}
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
+
+FStrategyStressRun::FStrategyStressRun(AStrategyGameState* InGameState, int32 InNumUnits, float DefaultBudgetMs)
+	: GameState(InGameState)
+	, NumUnits(FMath::Max(InNumUnits, 1))
+	, Duration(60.0f)
+	, SpawnDuration(10.0f)
+	, BudgetMs(DefaultBudgetMs)
+	, State(EState::WaitingForMatch)
+	, StartTime(0.0f)
+	, LastFrameTime(0.0)
+	, CreateTime(FPlatformTime::Seconds())
+	, bPrevUseFixedTimeStep(false)
+	, PrevFixedDeltaTime(0.0)
+	, bPassed(true)
+	, FrameTimeP95(0.0f)
+	, GCStartTime(0.0)
+	, bForcedGC(false)
+	, NumAIActionObjects(0)
+{
+	check(InGameState);
+	FParse::Value(FCommandLine::Get(), TEXT("StressSeconds="), Duration);
+	FParse::Value(FCommandLine::Get(), TEXT("StressSpawnSeconds="), SpawnDuration);
+	FParse::Value(FCommandLine::Get(), TEXT("StressBudgetMs="), BudgetMs);
+	Duration = FMath::Max(Duration, 1.0f);
+	SpawnDuration = FMath::Clamp(SpawnDuration, 0.0f, Duration);
+
+	FMemory::Memzero(FrameSubsystemCycles);
+	FMemory::Memzero(MaxLivePawns);
+	FrameTimes.Reserve(FMath::CeilToInt(Duration * StressFrameRate) + 1);
+
+	UE_LOG(LogGame, Log, TEXT("Stress run %d/%d: %d units per side, %.0f seconds, %.2f ms budget"),
+		ScenarioIndex + 1, Scenarios.Num(), NumUnits, Duration, BudgetMs);
+}
+
+FStrategyStressRun::~FStrategyStressRun()
+{
+	// the map went away under the scenario, there is nothing left to run it on
+	switch (State)
+	{
+		case EState::WaitingForMatch:
+			UE_LOG(LogGame, Error, TEXT("Stress run: map closed before the match started"));
+			bAnyFailed = true;
+			ExitProcess();
+			break;
+
+		case EState::Running:
+			StopReason = TEXT("map closed during the scenario");
+			Finish();
+			ExitProcess();
+			break;
+
+		case EState::Finishing:
+			ExitProcess();
+			break;
+
+		default:
+			break;
+	}
+}
+
+TSharedPtr<FStrategyStressRun> FStrategyStressRun::CreateFromCommandLine(AStrategyGameState* InGameState, float DefaultBudgetMs)
+{
+	if (Scenarios.Num() == 0)
+	{
+		FString UnitCounts;
+		if (!FParse::Value(FCommandLine::Get(), TEXT("StressUnits="), UnitCounts, false))
+		{
+			return nullptr;
+		}
+
+		TArray<FString> Counts;
+		UnitCounts.ParseIntoArray(Counts, TEXT(","));
+		for (const FString& Count : Counts)
+		{
+			const int32 NumUnits = FCString::Atoi(*Count);
+			if (NumUnits > 0)
+			{
+				Scenarios.Add(NumUnits);
+			}
+		}
+	}
+
+	// past the last scenario the exit is already requested
+	if (!Scenarios.IsValidIndex(ScenarioIndex))
+	{
+		return nullptr;
+	}
+	return MakeShareable(new FStrategyStressRun(InGameState, Scenarios[ScenarioIndex], DefaultBudgetMs));
+}
+
+void FStrategyStressRun::RequestScenario(int32 InNumUnits)
+{
+	Scenarios.Reset();
+	Scenarios.Add(InNumUnits);
+	ScenarioIndex = 0;
+	bAnyFailed = false;
+	bExitWhenDone = false;
+	LastResult = FStrategyStressResult();
+}
+
+void FStrategyStressRun::AddSubsystemTime(EStrategySubsystem::Type Subsystem, uint64 Cycles)
+{
+	if (ActiveRun)
+	{
+		ActiveRun->FrameSubsystemCycles[Subsystem] += Cycles;
+	}
+}
+
+void FStrategyStressRun::Tick(float DeltaSeconds)
+{
+	AStrategyGameState* const MyGameState = GameState.Get();
+	if (MyGameState == nullptr)
+	{
+		return;
+	}
+
+	switch (State)
+	{
+		case EState::WaitingForMatch:
+			if (MyGameState->IsGameActive())
+			{
+				Start();
+			}
+			else if (FPlatformTime::Seconds() - CreateTime > StressStartTimeout)
+			{
+				UE_LOG(LogGame, Error, TEXT("Stress run: match didn't start in %.0f seconds"), StressStartTimeout);
+				bAnyFailed = true;
+				State = EState::Done;
+				ExitProcess();
+			}
+			break;
+
+		case EState::Running:
+		{
+			if (MyGameState->GameplayState == EGameplayState::Finished)
+			{
+				Stop(TEXT("match ended during the scenario"));
+				break;
+			}
+
+			// game state ticks late in the frame, so this covers all of the frame but rendering
+			const double CurrentTime = FPlatformTime::Seconds();
+			FrameTimes.Add((CurrentTime - LastFrameTime) * 1000.0);
+			LastFrameTime = CurrentTime;
+
+			for (int32 Idx = 0; Idx < EStrategySubsystem::MAX; Idx++)
+			{
+				SubsystemTimes[Idx].Add(FPlatformTime::ToMilliseconds64(FrameSubsystemCycles[Idx]));
+			}
+			FMemory::Memzero(FrameSubsystemCycles);
+
+			for (int32 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+			{
+				MaxLivePawns[TeamNum] = FMath::Max(MaxLivePawns[TeamNum], MyGameState->GetNumberOfLivePawns((EStrategyTeam::Type)TeamNum));
+			}
+
+			// one full collection with every unit out, the engine runs it at the end of the frame
+			const float RunTime = MyGameState->GetWorld()->GetTimeSeconds() - StartTime;
+			if (!bForcedGC && RunTime >= SpawnDuration + 1.0f)
+			{
+				bForcedGC = true;
+				GEngine->ForceGarbageCollection(true);
+			}
+
+			if (RunTime >= Duration)
+			{
+				Stop(FString());
+			}
+			break;
+		}
+
+		case EState::Finishing:
+#if CSV_PROFILER
+			// the capture is written when its last frame ends
+			if (FCsvProfiler::Get()->IsCapturing())
+			{
+				break;
+			}
+#endif
+			Advance();
+			break;
+
+		default:
+			break;
+	}
+}
+
+void FStrategyStressRun::Stop(const FString& Reason)
+{
+	StopReason = Reason;
+	Finish();
+}
+
+void FStrategyStressRun::Advance()
+{
+	// a scenario cut short fails the whole run, the next ones would only add time
+	State = EState::Done;
+	AStrategyGameState* const MyGameState = GameState.Get();
+	if (!StopReason.IsEmpty() || MyGameState == nullptr || !Scenarios.IsValidIndex(ScenarioIndex + 1))
+	{
+		ExitProcess();
+		return;
+	}
+
+	ScenarioIndex++;
+	UWorld* const World = MyGameState->GetWorld();
+	UGameplayStatics::OpenLevel(World, FName(*UWorld::RemovePIEPrefix(World->GetOutermost()->GetName())));
+}
+
+void FStrategyStressRun::ExitProcess()
+{
+	UE_LOG(LogGame, Display, TEXT("Stress runs %s"), bAnyFailed ? TEXT("FAILED") : TEXT("PASSED"));
+	ScenarioIndex = Scenarios.Num();
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bAnyFailed ? 1 : 0);
+	}
+}
+
+void FStrategyStressRun::Start()
+{
+	AStrategyGameState* const MyGameState = GameState.Get();
+	UWorld* const World = MyGameState->GetWorld();
+
+	// same simulated time for every scenario, frames run as fast as they can
+	bPrevUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PrevFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / StressFrameRate);
+
+	const FString CaptureName = FString::Printf(TEXT("Stress_%s_%d_%s"), *World->GetMapName(), NumUnits, *FDateTime::Now().ToString());
+#if CSV_PROFILER
+	FCsvProfiler::Get()->BeginCapture(-1, FString(), CaptureName + TEXT(".csv"));
+#endif
+#if STATS
+	GEngine->Exec(World, *FString::Printf(TEXT("stat startfile %s.ue4stats"), *CaptureName));
+#endif
+
+	StartWaves();
+
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddRaw(this, &FStrategyStressRun::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FStrategyStressRun::OnPostGarbageCollect);
+
+	ActiveRun = this;
+	State = EState::Running;
+	StartTime = World->GetTimeSeconds();
+	LastFrameTime = FPlatformTime::Seconds();
+	FMemory::Memzero(FrameSubsystemCycles);
+}
+
+void FStrategyStressRun::StartWaves()
+{
+	AStrategyGameState* const MyGameState = GameState.Get();
+	const EStrategyTeam::Type Teams[] = { EStrategyTeam::Player, EStrategyTeam::Enemy };
+
+	// the plan spreads the spawns over the wave, the budget only keeps up with it
+	MyGameState->UnitSpawnsPerFrame = NumUnits * ARRAY_COUNT(Teams);
+	for (EStrategyTeam::Type TeamNum : Teams)
+	{
+		const FPlayerData* const TeamData = MyGameState->GetPlayerData(TeamNum);
+		AStrategyBuilding_Brewery* const Brewery = TeamData ? TeamData->Brewery.Get() : nullptr;
+		UStrategyAIDirector* const Director = Brewery ? Brewery->GetAIDirector() : nullptr;
+		if (Director == nullptr || Brewery->DwarfCharClass == nullptr)
+		{
+			UE_LOG(LogGame, Warning, TEXT("Stress run: no brewery with units for team %d"), (int32)TeamNum);
+			bPassed = false;
+			continue;
+		}
+
+		UStrategyWaveSchedule* const Schedule = NewObject<UStrategyWaveSchedule>(Director, NAME_None, RF_Transient);
+		FStrategyWave& Wave = Schedule->Waves[Schedule->Waves.AddDefaulted()];
+		Wave.StartDelay = 0.0f;
+		Wave.Duration = SpawnDuration;
+		FStrategyWaveUnit& Unit = Wave.Units[Wave.Units.AddDefaulted()];
+		Unit.UnitClass = Brewery->DwarfCharClass;
+		Unit.Count = NumUnits;
+		Director->StartWaveSchedule(Schedule);
+	}
+}
+
+void FStrategyStressRun::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void FStrategyStressRun::OnPostGarbageCollect()
+{
+	if (GCStartTime > 0.0)
+	{
+		GCTimes.Add((FPlatformTime::Seconds() - GCStartTime) * 1000.0);
+		GCStartTime = 0.0;
+	}
+}
+
+void FStrategyStressRun::Finish()
+{
+	ActiveRun = nullptr;
+	State = EState::Finishing;
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	NumAIActionObjects = 0;
+	for (TObjectIterator<UStrategyAIAction> It; It; ++It)
+	{
+		NumAIActionObjects++;
+	}
+
+	if (!StopReason.IsEmpty())
+	{
+		UE_LOG(LogGame, Error, TEXT("Stress run: %s, after %d frames"), *StopReason, FrameTimes.Num());
+		bPassed = false;
+	}
+
+#if CSV_PROFILER
+	FCsvProfiler::Get()->EndCapture();
+#endif
+	AStrategyGameState* const MyGameState = GameState.Get();
+#if STATS
+	GEngine->Exec(MyGameState ? MyGameState->GetWorld() : nullptr, TEXT("stat stopfile"));
+#endif
+
+	FApp::SetUseFixedTimeStep(bPrevUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PrevFixedDeltaTime);
+
+	const FString Summary = BuildSummary();
+	bAnyFailed = bAnyFailed || !bPassed;
+	LastResult.NumUnits = NumUnits;
+	LastResult.FrameTimeP95 = FrameTimeP95;
+	LastResult.StopReason = StopReason;
+	LastResult.bFinished = true;
+	UE_LOG(LogGame, Display, TEXT("%s"), *Summary);
+
+	const FString ProfilingDir = FPaths::ProfilingDir();
+	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*ProfilingDir);
+	const FString Filename = ProfilingDir / FString::Printf(TEXT("StressSummary_%d_%s.txt"), NumUnits, *FDateTime::Now().ToString());
+	if (!FFileHelper::SaveStringToFile(Summary, *Filename))
+	{
+		UE_LOG(LogGame, Warning, TEXT("Failed to write stress run summary %s"), *Filename);
+	}
+}
+
+FString FStrategyStressRun::BuildSummary()
+{
+	TArray<float> Sorted = FrameTimes;
+	Sorted.Sort();
+
+	FrameTimeP95 = GetPercentile(Sorted, 0.95f);
+	bPassed = bPassed && Sorted.Num() > 0 && FrameTimeP95 <= BudgetMs;
+
+	FString Summary = FString::Printf(TEXT("Stress run %s: %d units per side, %d frames over %.0f seconds\n"),
+		bPassed ? TEXT("PASSED") : TEXT("FAILED"), NumUnits, Sorted.Num(), Duration);
+	if (!StopReason.IsEmpty())
+	{
+		Summary += FString::Printf(TEXT("Cut short: %s\n"), *StopReason);
+	}
+	Summary += FString::Printf(TEXT("Most living units: player %d, enemy %d\n"), MaxLivePawns[EStrategyTeam::Player], MaxLivePawns[EStrategyTeam::Enemy]);
+	Summary += FString::Printf(TEXT("Frame ms: p50 %.2f, p95 %.2f (budget %.2f), p99 %.2f, max %.2f\n"),
+		GetPercentile(Sorted, 0.5f), FrameTimeP95, BudgetMs, GetPercentile(Sorted, 0.99f), Sorted.Num() > 0 ? Sorted.Last() : 0.0f);
+
+	float MaxGCTime = 0.0f;
+	for (float Value : GCTimes)
+	{
+		MaxGCTime = FMath::Max(MaxGCTime, Value);
+	}
+	Summary += FString::Printf(TEXT("Garbage collections: %d, max %.2f ms; AI action objects: %d\n"), GCTimes.Num(), MaxGCTime, NumAIActionObjects);
+
+	Summary += TEXT("Subsystem ms: avg, p95, max\n");
+	for (int32 Idx = 0; Idx < EStrategySubsystem::MAX; Idx++)
+	{
+		Sorted = SubsystemTimes[Idx];
+		Sorted.Sort();
+
+		float Total = 0.0f;
+		for (float Value : Sorted)
+		{
+			Total += Value;
+		}
+		Summary += FString::Printf(TEXT("  %-14s %.3f, %.3f, %.3f\n"), EStrategySubsystem::GetName((EStrategySubsystem::Type)Idx),
+			Sorted.Num() > 0 ? Total / Sorted.Num() : 0.0f, GetPercentile(Sorted, 0.95f), Sorted.Num() > 0 ? Sorted.Last() : 0.0f);
+	}
+	return Summary;
+}
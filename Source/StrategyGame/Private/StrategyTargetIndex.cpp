@@ -0,0 +1,293 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyTargetIndex.h"
+
+DECLARE_CYCLE_STAT(TEXT("Target index build"), STAT_StrategyTargetIndexBuild, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Target queries"), STAT_StrategyTargetQueries, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cached target queries"), STAT_StrategyCachedTargetQueries, STATGROUP_StrategyGame);
+
+/** size of the grid cell, about a tower range */
+static const float TargetCellSize = 1000.0f;
+
+FStrategyTargetIndex::FStrategyTargetIndex()
+	: BuiltFrame(0)
+{
+}
+
+void FStrategyTargetIndex::Reset()
+{
+	Targets.Reset();
+	SortedTargets.Reset();
+	Cells.Reset();
+	CachedResults.Reset();
+	BuiltFrame = 0;
+}
+
+const FStrategyEntityTable* FStrategyTargetIndex::Update(UWorld* World)
+{
+	const FStrategyEntityTable* const Entities = FStrategyEntityTable::Get(World);
+	if (Entities == nullptr || BuiltFrame == GFrameCounter)
+	{
+		return Entities;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategyTargetIndexBuild);
+
+	BuiltFrame = GFrameCounter;
+	CachedResults.Reset();
+	Targets.Reset();
+	Entities->ForEach(EStrategyEntity::Unit, [this, Entities](FStrategyEntityHandle Handle, AActor* Actor)
+	{
+		const ABaseCharacter* const TestChar = static_cast<const ABaseCharacter*>(Actor);
+		if (TestChar->GetHealth() > 0 && !TestChar->IsHidden())
+		{
+			FTarget& Target = Targets[Targets.AddUninitialized()];
+			Target.Handle = Handle;
+			Target.Location = TestChar->GetActorLocation();
+			Target.Health = TestChar->Health;
+			Target.TeamNum = Entities->GetTeamNum(Handle);
+		}
+	});
+
+	// same cell sorting as crowd avoidance
+	SortedTargets.Reset();
+	Cells.Reset();
+	for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); TargetIndex++)
+	{
+		SortedTargets.Add(TargetIndex);
+	}
+	SortedTargets.Sort([this](int32 A, int32 B)
+	{
+		const FIntPoint CellA = GetCell(Targets[A].Location);
+		const FIntPoint CellB = GetCell(Targets[B].Location);
+		return CellA.X != CellB.X ? CellA.X < CellB.X : CellA.Y < CellB.Y;
+	});
+	for (int32 SortedIndex = 0; SortedIndex < SortedTargets.Num(); SortedIndex++)
+	{
+		const FIntPoint Cell = GetCell(Targets[SortedTargets[SortedIndex]].Location);
+		FIntPoint* Range = Cells.Find(Cell);
+		if (Range == nullptr)
+		{
+			Range = &Cells.Add(Cell, FIntPoint(SortedIndex, 0));
+		}
+		Range->Y++;
+	}
+
+	return Entities;
+}
+
+FIntPoint FStrategyTargetIndex::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / TargetCellSize), FMath::FloorToInt(Location.Y / TargetCellSize));
+}
+
+void FStrategyTargetIndex::GatherEnemies(const FStrategyEntityTable& Entities, const FVector& Origin, uint8 TeamNum, float Radius, TArray<TPair<float, int32>>& OutEnemies) const
+{
+	const FStrategyTeamRelations& Relations = Entities.GetTeamRelations();
+	const float RadiusSq = FMath::Square(Radius);
+	const FIntPoint MinCell = GetCell(Origin - FVector(Radius));
+	const FIntPoint MaxCell = GetCell(Origin + FVector(Radius));
+
+	// range covering more cells than are occupied, checking every unit is cheaper
+	const int64 NumCoveredCells = (int64)(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1);
+	if (NumCoveredCells > Cells.Num())
+	{
+		for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); TargetIndex++)
+		{
+			const FTarget& Target = Targets[TargetIndex];
+			const float DistSq = FVector::DistSquared2D(Target.Location, Origin);
+			if (DistSq <= RadiusSq && Relations.IsEnemy(TeamNum, Target.TeamNum))
+			{
+				OutEnemies.Emplace(DistSq, TargetIndex);
+			}
+		}
+		return;
+	}
+
+	for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+	{
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+		{
+			const FIntPoint* const Range = Cells.Find(FIntPoint(CellX, CellY));
+			if (Range == nullptr)
+			{
+				continue;
+			}
+
+			for (int32 SortedIndex = Range->X; SortedIndex < Range->X + Range->Y; SortedIndex++)
+			{
+				const int32 TargetIndex = SortedTargets[SortedIndex];
+				const FTarget& Target = Targets[TargetIndex];
+				const float DistSq = FVector::DistSquared2D(Target.Location, Origin);
+				if (DistSq <= RadiusSq && Relations.IsEnemy(TeamNum, Target.TeamNum))
+				{
+					OutEnemies.Emplace(DistSq, TargetIndex);
+				}
+			}
+		}
+	}
+}
+
+void FStrategyTargetIndex::FindNearestEnemies(UWorld* World, FStrategyEntityHandle Querier, const FVector& Origin, uint8 TeamNum, float Radius, int32 MaxCount, TArray<ABaseCharacter*>& OutEnemies)
+{
+	OutEnemies.Reset();
+	const FStrategyEntityTable* const Entities = Update(World);
+	if (Entities == nullptr || MaxCount <= 0 || Radius <= 0.0f)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategyTargetQueries);
+
+	FQueryKey Key;
+	Key.Querier = Querier;
+	Key.Radius = Radius;
+	Key.MaxCount = MaxCount;
+
+	TArray<FStrategyEntityHandle> Handles;
+	const TArray<FStrategyEntityHandle>* Result = Querier.IsSet() ? CachedResults.Find(Key) : nullptr;
+	if (Result != nullptr)
+	{
+		// cached enemy died this frame, the next closest one may be in range, look again
+		for (const FStrategyEntityHandle& Handle : *Result)
+		{
+			const ABaseCharacter* const Enemy = Entities->Get<ABaseCharacter>(Handle);
+			if (Enemy == nullptr || Enemy->GetHealth() <= 0)
+			{
+				CachedResults.Remove(Key);
+				Result = nullptr;
+				break;
+			}
+		}
+	}
+
+	if (Result != nullptr)
+	{
+		INC_DWORD_STAT(STAT_StrategyCachedTargetQueries);
+	}
+	else
+	{
+		TArray<TPair<float, int32>> Enemies;
+		GatherEnemies(*Entities, Origin, TeamNum, Radius, Enemies);
+		Enemies.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+		for (int32 Idx = 0; Idx < Enemies.Num() && Handles.Num() < MaxCount; Idx++)
+		{
+			// skip units died since the grid was built, or the result is dropped right away on the next query
+			const FStrategyEntityHandle Handle = Targets[Enemies[Idx].Value].Handle;
+			const ABaseCharacter* const Enemy = Entities->Get<ABaseCharacter>(Handle);
+			if (Enemy && Enemy->GetHealth() > 0)
+			{
+				Handles.Add(Handle);
+			}
+		}
+		Result = Querier.IsSet() ? &CachedResults.Add(Key, Handles) : &Handles;
+	}
+
+	for (const FStrategyEntityHandle& Handle : *Result)
+	{
+		OutEnemies.Add(Entities->Get<ABaseCharacter>(Handle));
+	}
+}
+
+ABaseCharacter* FStrategyTargetIndex::FindWeakestEnemy(UWorld* World, FStrategyEntityHandle Querier, const FVector& Origin, uint8 TeamNum, float Radius)
+{
+	const FStrategyEntityTable* const Entities = Update(World);
+	if (Entities == nullptr || Radius <= 0.0f)
+	{
+		return nullptr;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StrategyTargetQueries);
+
+	FQueryKey Key;
+	Key.Querier = Querier;
+	Key.Radius = Radius;
+	Key.MaxCount = INDEX_NONE;
+
+	const TArray<FStrategyEntityHandle>* const CachedResult = Querier.IsSet() ? CachedResults.Find(Key) : nullptr;
+	if (CachedResult != nullptr)
+	{
+		INC_DWORD_STAT(STAT_StrategyCachedTargetQueries);
+		ABaseCharacter* const Enemy = CachedResult->Num() > 0 ? Entities->Get<ABaseCharacter>((*CachedResult)[0]) : nullptr;
+		if (Enemy == nullptr || Enemy->GetHealth() > 0)
+		{
+			return Enemy;
+		}
+		// cached enemy died this frame, look again
+	}
+
+	TArray<TPair<float, int32>> Enemies;
+	GatherEnemies(*Entities, Origin, TeamNum, Radius, Enemies);
+
+	int32 BestIndex = INDEX_NONE;
+	float BestDistSq = 0.0f;
+	for (const TPair<float, int32>& Enemy : Enemies)
+	{
+		const FTarget& Target = Targets[Enemy.Value];
+		ABaseCharacter* const EnemyChar = Entities->Get<ABaseCharacter>(Target.Handle);
+		if (EnemyChar == nullptr || EnemyChar->GetHealth() <= 0)
+		{
+			continue;
+		}
+		if (BestIndex == INDEX_NONE || Target.Health < Targets[BestIndex].Health || (Target.Health == Targets[BestIndex].Health && Enemy.Key < BestDistSq))
+		{
+			BestIndex = Enemy.Value;
+			BestDistSq = Enemy.Key;
+		}
+	}
+
+	TArray<FStrategyEntityHandle> Handles;
+	if (BestIndex != INDEX_NONE)
+	{
+		Handles.Add(Targets[BestIndex].Handle);
+	}
+	if (Querier.IsSet())
+	{
+		CachedResults.Add(Key, Handles);
+	}
+	return BestIndex != INDEX_NONE ? Entities->Get<ABaseCharacter>(Targets[BestIndex].Handle) : nullptr;
+}
+
+bool FStrategyTargetIndex::PredictIntercept(const FVector& ShotOrigin, float ProjectileSpeed, const FVector& TargetLocation, const FVector& TargetVelocity, FVector& OutIntercept)
+{
+	OutIntercept = TargetLocation;
+	if (ProjectileSpeed <= 0.0f)
+	{
+		return false;
+	}
+
+	// |Offset + Velocity * t| = Speed * t, solved for smallest positive t
+	const FVector Offset = TargetLocation - ShotOrigin;
+	const float A = TargetVelocity.SizeSquared() - FMath::Square(ProjectileSpeed);
+	const float B = 2.0f * FVector::DotProduct(Offset, TargetVelocity);
+	const float C = Offset.SizeSquared();
+
+	float Time = -1.0f;
+	if (FMath::Abs(A) < KINDA_SMALL_NUMBER)
+	{
+		// target as fast as projectile
+		Time = FMath::Abs(B) > KINDA_SMALL_NUMBER ? -C / B : -1.0f;
+	}
+	else
+	{
+		const float Discriminant = B * B - 4.0f * A * C;
+		if (Discriminant < 0.0f)
+		{
+			return false;
+		}
+		const float Root = FMath::Sqrt(Discriminant);
+		const float T1 = (-B - Root) / (2.0f * A);
+		const float T2 = (-B + Root) / (2.0f * A);
+		Time = (T1 > 0.0f && T2 > 0.0f) ? FMath::Min(T1, T2) : FMath::Max(T1, T2);
+	}
+
+	if (Time <= 0.0f)
+	{
+		return false;
+	}
+
+	OutIntercept = TargetLocation + TargetVelocity * Time;
+	return true;
+}
@@ -0,0 +1,208 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyTelemetry.h"
+#include "Async/Async.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+/** how many samples are kept in memory for the graph */
+static const int32 MaxRecentSamples = 120;
+
+/** buffered bytes which trigger a write */
+static const int32 WriteBufferFlushSize = 4 * 1024;
+
+FStrategyTelemetryRecorder::FStrategyTelemetryRecorder(AStrategyGameState* InGameState, float InSampleInterval)
+	: GameState(InGameState)
+	, SampleInterval(FMath::Max(InSampleInterval, 0.1f))
+	, IntervalTime(0.0f)
+	, IntervalFrames(0)
+	, AccumulatedAITime(0.0)
+{
+	check(InGameState);
+	RecentSamples.Reserve(MaxRecentSamples);
+	WriteBuffer.Reserve(WriteBufferFlushSize * 2);
+
+	FStrategyTelemetryHeader Header;
+	Header.MapName = InGameState->GetWorld()->GetMapName();
+	Header.StartTime = FDateTime::UtcNow();
+	Header.SampleInterval = SampleInterval;
+
+	const FString TelemetryDir = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*TelemetryDir);
+	Filename = TelemetryDir / FString::Printf(TEXT("%s_%s.stlm"), *Header.MapName, *Header.StartTime.ToString());
+	FileHandle = MakeShareable(PlatformFile.OpenWrite(*Filename));
+	if (FileHandle.IsValid())
+	{
+		FMemoryWriter Writer(WriteBuffer);
+		Writer << Header;
+		UE_LOG(LogGame, Log, TEXT("Recording match telemetry to %s"), *Filename);
+	}
+	else
+	{
+		UE_LOG(LogGame, Warning, TEXT("Failed to open telemetry file %s, keeping samples in memory only"), *Filename);
+	}
+
+	EventBusHandle = InGameState->GetEventBus().Subscribe(EStrategyGameplayEvent::AllMask, EStrategyTeam::AllMask,
+		FOnStrategyGameplayEvent::CreateRaw(this, &FStrategyTelemetryRecorder::OnGameplayEvent));
+}
+
+FStrategyTelemetryRecorder::~FStrategyTelemetryRecorder()
+{
+	AStrategyGameState* const MyGameState = GameState.Get();
+	if (MyGameState)
+	{
+		MyGameState->GetEventBus().Unsubscribe(EventBusHandle);
+	}
+
+	FlushBuffer();
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+	}
+	FileHandle.Reset();
+}
+
+void FStrategyTelemetryRecorder::Tick(float DeltaSeconds)
+{
+	const float FrameTimeMs = DeltaSeconds * 1000.0f;
+	CurrentSample.FrameTimeMs += FrameTimeMs;
+	CurrentSample.MaxFrameTimeMs = FMath::Max(CurrentSample.MaxFrameTimeMs, FrameTimeMs);
+	IntervalFrames++;
+
+	IntervalTime += DeltaSeconds;
+	if (IntervalTime >= SampleInterval)
+	{
+		RecordSample();
+		IntervalTime -= SampleInterval * FMath::FloorToFloat(IntervalTime / SampleInterval);
+	}
+}
+
+void FStrategyTelemetryRecorder::OnGameplayEvent(const FStrategyGameplayEvent& Event)
+{
+	if (Event.TeamNum == EStrategyTeam::Unknown || Event.TeamNum >= EStrategyTeam::MAX)
+	{
+		return;
+	}
+
+	FStrategyTelemetryTeamSample& TeamSample = CurrentSample.GetTeam(Event.TeamNum);
+	switch (Event.Type)
+	{
+		case EStrategyGameplayEvent::CharSpawned:
+			TeamSample.Spawns++;
+			break;
+		case EStrategyGameplayEvent::CharDied:
+			TeamSample.Deaths++;
+			break;
+		case EStrategyGameplayEvent::WaveSpawned:
+			TeamSample.WavesSpawned++;
+			break;
+		case EStrategyGameplayEvent::BuildingFinished:
+			TeamSample.BuildingsFinished++;
+			break;
+		default:
+			break;
+	}
+}
+
+void FStrategyTelemetryRecorder::RecordSample()
+{
+	AStrategyGameState* const MyGameState = GameState.Get();
+	if (MyGameState == nullptr)
+	{
+		return;
+	}
+
+	CurrentSample.Time = MyGameState->GetWorld()->GetTimeSeconds();
+	if (IntervalFrames > 0)
+	{
+		CurrentSample.FrameTimeMs /= IntervalFrames;
+		CurrentSample.AITimeMs = AccumulatedAITime * 1000.0 / IntervalFrames;
+	}
+
+	for (uint8 TeamNum = EStrategyTeam::Player; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		const FPlayerData* const TeamData = MyGameState->GetPlayerData(TeamNum);
+		FStrategyTelemetryTeamSample& TeamSample = CurrentSample.GetTeam(TeamNum);
+		TeamSample.ResourcesAvailable = TeamData->ResourcesAvailable;
+		TeamSample.ResourcesGathered = TeamData->ResourcesGathered;
+		TeamSample.DamageDone = TeamData->DamageDone;
+		TeamSample.LivePawns = MyGameState->GetNumberOfLivePawns((EStrategyTeam::Type)TeamNum);
+	}
+
+	if (RecentSamples.Num() >= MaxRecentSamples)
+	{
+		RecentSamples.RemoveAt(0, 1, false);
+	}
+	RecentSamples.Add(CurrentSample);
+
+	if (FileHandle.IsValid())
+	{
+		FMemoryWriter Writer(WriteBuffer);
+		Writer.Seek(WriteBuffer.Num());
+		Writer << CurrentSample;
+		if (WriteBuffer.Num() >= WriteBufferFlushSize)
+		{
+			FlushBuffer();
+		}
+	}
+
+	CurrentSample = FStrategyTelemetrySample();
+	IntervalFrames = 0;
+	AccumulatedAITime = 0.0;
+}
+
+void FStrategyTelemetryRecorder::FlushBuffer()
+{
+	if (!FileHandle.IsValid() || WriteBuffer.Num() == 0)
+	{
+		return;
+	}
+
+	// previous write is long done at this point, waiting only keeps the order of the chunks
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+	}
+
+	TArray<uint8> Data = MoveTemp(WriteBuffer);
+	WriteBuffer.Reserve(WriteBufferFlushSize * 2);
+
+	TSharedPtr<IFileHandle> File = FileHandle;
+	PendingWrite = Async(EAsyncExecution::ThreadPool, [File, Data]()
+	{
+		File->Write(Data.GetData(), Data.Num());
+		File->Flush();
+	});
+}
+
+bool FStrategyTelemetryRecorder::LoadTimeline(const FString& InFilename, FStrategyTelemetryHeader& OutHeader, TArray<FStrategyTelemetrySample>& OutSamples)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *InFilename))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	Reader << OutHeader;
+	if (Reader.IsError() || OutHeader.Magic != FStrategyTelemetryHeader::FileMagic || OutHeader.Version != FStrategyTelemetryHeader::FileVersion)
+	{
+		return false;
+	}
+
+	// recording may have been cut in the middle of a sample, ignore the incomplete one
+	while (!Reader.AtEnd())
+	{
+		FStrategyTelemetrySample Sample;
+		Reader << Sample;
+		if (Reader.IsError())
+		{
+			break;
+		}
+		OutSamples.Add(Sample);
+	}
+	return true;
+}
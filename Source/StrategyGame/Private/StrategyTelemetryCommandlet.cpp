@@ -0,0 +1,96 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyTelemetryCommandlet.h"
+#include "StrategyTelemetry.h"
+
+UStrategyTelemetryCommandlet::UStrategyTelemetryCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UStrategyTelemetryCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if (!FParse::Value(*Params, TEXT("File="), Filename))
+	{
+		UE_LOG(LogGame, Error, TEXT("Usage: -run=StrategyTelemetry -File=<timeline.stlm> [-Format=csv|json|all]"));
+		return 1;
+	}
+
+	FString Format = TEXT("all");
+	FParse::Value(*Params, TEXT("Format="), Format);
+
+	FStrategyTelemetryHeader Header;
+	TArray<FStrategyTelemetrySample> Samples;
+	if (!FStrategyTelemetryRecorder::LoadTimeline(Filename, Header, Samples))
+	{
+		UE_LOG(LogGame, Error, TEXT("Failed to read telemetry timeline %s"), *Filename);
+		return 1;
+	}
+
+	const FString BaseFilename = FPaths::GetPath(Filename) / FPaths::GetBaseFilename(Filename);
+	if (Format == TEXT("csv") || Format == TEXT("all"))
+	{
+		FFileHelper::SaveStringToFile(ToCSV(Header, Samples), *(BaseFilename + TEXT(".csv")));
+	}
+	if (Format == TEXT("json") || Format == TEXT("all"))
+	{
+		FFileHelper::SaveStringToFile(ToJSON(Header, Samples), *(BaseFilename + TEXT(".json")));
+	}
+
+	UE_LOG(LogGame, Display, TEXT("Converted %d telemetry samples of %s from %s"), Samples.Num(), *Header.MapName, *Filename);
+	return 0;
+}
+
+FString UStrategyTelemetryCommandlet::ToCSV(const FStrategyTelemetryHeader& Header, const TArray<FStrategyTelemetrySample>& Samples)
+{
+	FString Result = TEXT("Time,FrameTimeMs,MaxFrameTimeMs,AITimeMs");
+	for (uint8 TeamNum = EStrategyTeam::Player; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		const TCHAR* const Team = TeamNum == EStrategyTeam::Player ? TEXT("Player") : TEXT("Enemy");
+		Result += FString::Printf(TEXT(",%sResources,%sGathered,%sDamageDone,%sLivePawns,%sSpawns,%sDeaths,%sWaves,%sBuildings"),
+			Team, Team, Team, Team, Team, Team, Team, Team);
+	}
+	Result += LINE_TERMINATOR;
+
+	for (const FStrategyTelemetrySample& Sample : Samples)
+	{
+		Result += FString::Printf(TEXT("%.2f,%.3f,%.3f,%.3f"), Sample.Time, Sample.FrameTimeMs, Sample.MaxFrameTimeMs, Sample.AITimeMs);
+		for (uint8 TeamNum = EStrategyTeam::Player; TeamNum < EStrategyTeam::MAX; TeamNum++)
+		{
+			const FStrategyTelemetryTeamSample& TeamSample = Sample.GetTeam(TeamNum);
+			Result += FString::Printf(TEXT(",%u,%u,%u,%u,%u,%u,%u,%u"), TeamSample.ResourcesAvailable, TeamSample.ResourcesGathered,
+				TeamSample.DamageDone, TeamSample.LivePawns, TeamSample.Spawns, TeamSample.Deaths, TeamSample.WavesSpawned, TeamSample.BuildingsFinished);
+		}
+		Result += LINE_TERMINATOR;
+	}
+	return Result;
+}
+
+FString UStrategyTelemetryCommandlet::ToJSON(const FStrategyTelemetryHeader& Header, const TArray<FStrategyTelemetrySample>& Samples)
+{
+	FString Result = FString::Printf(TEXT("{\n\t\"map\": \"%s\",\n\t\"startTime\": \"%s\",\n\t\"sampleInterval\": %.2f,\n\t\"samples\": ["),
+		*Header.MapName.ReplaceCharWithEscapedChar(), *Header.StartTime.ToIso8601(), Header.SampleInterval);
+
+	for (int32 Idx = 0; Idx < Samples.Num(); Idx++)
+	{
+		const FStrategyTelemetrySample& Sample = Samples[Idx];
+		Result += FString::Printf(TEXT("%s\n\t\t{ \"time\": %.2f, \"frameTimeMs\": %.3f, \"maxFrameTimeMs\": %.3f, \"aiTimeMs\": %.3f, \"teams\": ["),
+			Idx > 0 ? TEXT(",") : TEXT(""), Sample.Time, Sample.FrameTimeMs, Sample.MaxFrameTimeMs, Sample.AITimeMs);
+		for (uint8 TeamNum = EStrategyTeam::Player; TeamNum < EStrategyTeam::MAX; TeamNum++)
+		{
+			const FStrategyTelemetryTeamSample& TeamSample = Sample.GetTeam(TeamNum);
+			Result += FString::Printf(TEXT("%s{ \"team\": %d, \"resources\": %u, \"gathered\": %u, \"damageDone\": %u, \"livePawns\": %u, \"spawns\": %u, \"deaths\": %u, \"waves\": %u, \"buildings\": %u }"),
+				TeamNum > EStrategyTeam::Player ? TEXT(", ") : TEXT(""), TeamNum, TeamSample.ResourcesAvailable, TeamSample.ResourcesGathered,
+				TeamSample.DamageDone, TeamSample.LivePawns, TeamSample.Spawns, TeamSample.Deaths, TeamSample.WavesSpawned, TeamSample.BuildingsFinished);
+		}
+		Result += TEXT("] }");
+	}
+
+	Result += TEXT("\n\t]\n}\n");
+	return Result;
+}
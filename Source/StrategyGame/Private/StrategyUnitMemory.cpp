@@ -0,0 +1,158 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyUnitMemory.h"
+#include "StrategyGameBlueprintLibrary.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectHash.h"
+
+/** distance between measured units */
+static const float UnitSpacing = 200.0f;
+
+FStrategyUnitMemoryReport::FStrategyUnitMemoryReport()
+	: NumUnits(0)
+	, ProcessBytesPerUnit(0)
+{
+}
+
+void FStrategyUnitMemoryReport::CountObject(UObject* Object)
+{
+	const FName ClassName = Object->GetClass()->GetFName();
+	FStrategyUnitMemoryItem* Item = Items.FindByPredicate([ClassName](const FStrategyUnitMemoryItem& Test) { return Test.ClassName == ClassName; });
+	if (Item == nullptr)
+	{
+		Item = &Items[Items.AddZeroed()];
+		Item->ClassName = ClassName;
+	}
+
+	// counting archive includes size of the object itself
+	FArchiveCountMem Count(Object);
+	Item->NumObjects++;
+	Item->ObjectBytes += Count.GetMax();
+	Item->NativeBytes += Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+}
+
+bool FStrategyUnitMemoryReport::Measure(UWorld* World, const FStrategyUnitMemorySetup& InSetup, int32 InNumUnits, const FVector& Origin)
+{
+	check(World);
+	Setup = InSetup;
+	NumUnits = 0;
+	ProcessBytesPerUnit = 0;
+	Items.Reset();
+	if (Setup.UnitClass == nullptr || InNumUnits < 1)
+	{
+		return false;
+	}
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// square grid around the origin
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt((float)InNumUnits));
+	const FVector GridOrigin = Origin - FVector(GridSize * UnitSpacing * 0.5f, GridSize * UnitSpacing * 0.5f, 0.0f);
+
+	TArray<ABaseCharacter*> Units;
+	Units.Reserve(InNumUnits);
+	const uint64 UsedBefore = FPlatformMemory::GetStats().UsedPhysical;
+	for (int32 Idx = 0; Idx < InNumUnits; Idx++)
+	{
+		const FVector Loc = GridOrigin + FVector((Idx % GridSize) * UnitSpacing, (Idx / GridSize) * UnitSpacing, 0.0f);
+		ABaseCharacter* const Unit = World->SpawnActor<ABaseCharacter>(Setup.UnitClass, Loc, FRotator::ZeroRotator, SpawnInfo);
+		if (Unit == nullptr)
+		{
+			continue;
+		}
+
+		Unit->SpawnDefaultController();
+		AStrategyChar* const MinionChar = Cast<AStrategyChar>(Unit);
+		if (MinionChar)
+		{
+			if (Setup.Weapon != nullptr)
+			{
+				UStrategyGameBlueprintLibrary::GiveWeaponFromClass(MinionChar, Setup.Weapon);
+			}
+			if (Setup.Armor != nullptr)
+			{
+				UStrategyGameBlueprintLibrary::GiveArmorFromClass(MinionChar, Setup.Armor);
+			}
+		}
+		Units.Add(Unit);
+	}
+	const uint64 UsedAfter = FPlatformMemory::GetStats().UsedPhysical;
+
+	NumUnits = Units.Num();
+	if (NumUnits == 0)
+	{
+		return false;
+	}
+	ProcessBytesPerUnit = UsedAfter > UsedBefore ? (int64)(UsedAfter - UsedBefore) / NumUnits : 0;
+
+	for (ABaseCharacter* Unit : Units)
+	{
+		TArray<UObject*> Objects;
+		Objects.Add(Unit);
+		GetObjectsWithOuter(Unit, Objects, true);
+		if (Unit->Controller)
+		{
+			Objects.Add(Unit->Controller);
+			GetObjectsWithOuter(Unit->Controller, Objects, true);
+		}
+		for (UObject* Object : Objects)
+		{
+			CountObject(Object);
+		}
+	}
+
+	for (ABaseCharacter* Unit : Units)
+	{
+		if (Unit->Controller)
+		{
+			Unit->Controller->Destroy();
+		}
+		Unit->Destroy();
+	}
+
+	for (FStrategyUnitMemoryItem& Item : Items)
+	{
+		Item.NumObjects = FMath::DivideAndRoundUp(Item.NumObjects, NumUnits);
+		Item.ObjectBytes /= NumUnits;
+		Item.NativeBytes /= NumUnits;
+	}
+	Items.Sort([](const FStrategyUnitMemoryItem& A, const FStrategyUnitMemoryItem& B) { return A.ObjectBytes + A.NativeBytes > B.ObjectBytes + B.NativeBytes; });
+	return true;
+}
+
+int64 FStrategyUnitMemoryReport::GetBytesPerUnit() const
+{
+	int64 Total = 0;
+	for (const FStrategyUnitMemoryItem& Item : Items)
+	{
+		Total += Item.ObjectBytes + Item.NativeBytes;
+	}
+	return Total;
+}
+
+bool FStrategyUnitMemoryReport::IsInBudget(float BudgetKB) const
+{
+	// deterministic object count, not the process growth
+	return BudgetKB <= 0.0f || GetBytesPerUnit() / 1024.0f <= BudgetKB;
+}
+
+bool FStrategyUnitMemoryReport::GetLines(float BudgetKB, TArray<FString>& OutLines) const
+{
+	const float UnitKB = GetBytesPerUnit() / 1024.0f;
+	const bool bInBudget = IsInBudget(BudgetKB);
+
+	OutLines.Reset();
+	OutLines.Add(FString::Printf(TEXT("%s%s%s: %.1f KB per unit counted (budget %.1f KB%s), process memory grew %.1f KB per unit, %d units"),
+		*GetNameSafe(Setup.UnitClass),
+		Setup.Weapon != nullptr ? *FString::Printf(TEXT(" + %s"), *Setup.Weapon->GetName()) : TEXT(""),
+		Setup.Armor != nullptr ? *FString::Printf(TEXT(" + %s"), *Setup.Armor->GetName()) : TEXT(""),
+		UnitKB, BudgetKB, bInBudget ? TEXT("") : TEXT(", OVER"), ProcessBytesPerUnit / 1024.0f, NumUnits));
+	for (const FStrategyUnitMemoryItem& Item : Items)
+	{
+		OutLines.Add(FString::Printf(TEXT("  %-40s x%d: %8.2f KB objects, %8.2f KB native"),
+			*Item.ClassName.ToString(), Item.NumObjects, Item.ObjectBytes / 1024.0f, Item.NativeBytes / 1024.0f));
+	}
+	return bInBudget;
+}
@@ -0,0 +1,87 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyUnitMemoryCommandlet.h"
+#include "StrategyUnitMemory.h"
+#include "StrategyAttachment.h"
+
+UStrategyUnitMemoryCommandlet::UStrategyUnitMemoryCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UStrategyUnitMemoryCommandlet::Main(const FString& Params)
+{
+	FString UnitPaths;
+	if (!FParse::Value(*Params, TEXT("Units="), UnitPaths, false))
+	{
+		UE_LOG(LogGame, Error, TEXT("Usage: -run=StrategyUnitMemory -Units=<class path>[,<class path>...] [-Weapon=<class path>] [-Armor=<class path>] [-Count=100] [-BudgetKB=<KB>]"));
+		return 1;
+	}
+
+	int32 NumUnits = 100;
+	FParse::Value(*Params, TEXT("Count="), NumUnits);
+	float BudgetKB = GetDefault<AStrategyGameState>()->UnitMemoryBudgetKB;
+	FParse::Value(*Params, TEXT("BudgetKB="), BudgetKB);
+
+	FStrategyUnitMemorySetup Setup;
+	FString AttachmentPath;
+	if (FParse::Value(*Params, TEXT("Weapon="), AttachmentPath))
+	{
+		Setup.Weapon = LoadClass<UStrategyAttachment>(nullptr, *AttachmentPath);
+		if (Setup.Weapon == nullptr)
+		{
+			UE_LOG(LogGame, Error, TEXT("Failed to load weapon class %s"), *AttachmentPath);
+			return 1;
+		}
+	}
+	if (FParse::Value(*Params, TEXT("Armor="), AttachmentPath))
+	{
+		Setup.Armor = LoadClass<UStrategyAttachment>(nullptr, *AttachmentPath);
+		if (Setup.Armor == nullptr)
+		{
+			UE_LOG(LogGame, Error, TEXT("Failed to load armor class %s"), *AttachmentPath);
+			return 1;
+		}
+	}
+
+	// units are spawned without a match, begin play and AI don't run
+	UWorld* const World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	TArray<FString> Paths;
+	UnitPaths.ParseIntoArray(Paths, TEXT(","));
+	int32 NumFailed = 0;
+	for (const FString& Path : Paths)
+	{
+		Setup.UnitClass = LoadClass<ABaseCharacter>(nullptr, *Path);
+		FStrategyUnitMemoryReport Report;
+		if (Setup.UnitClass == nullptr || !Report.Measure(World, Setup, NumUnits, FVector::ZeroVector))
+		{
+			UE_LOG(LogGame, Error, TEXT("Failed to spawn units of %s"), *Path);
+			NumFailed++;
+			continue;
+		}
+
+		TArray<FString> Lines;
+		Report.GetLines(BudgetKB, Lines);
+		for (const FString& Line : Lines)
+		{
+			UE_LOG(LogGame, Display, TEXT("%s"), *Line);
+		}
+		if (!Report.IsInBudget(BudgetKB))
+		{
+			UE_LOG(LogGame, Error, TEXT("%s is over the memory budget of %.1f counted KB per unit"), *Path, BudgetKB);
+			NumFailed++;
+		}
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,332 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyVisibilityGrid.h"
+#include "StrategyAIController.h"
+#include "StrategyAISensingComponent.h"
+
+/** trace range above and below the world bounds when sampling heights */
+static const float HeightTraceRange = 10000.0f;
+
+/** octant transforms for shadowcasting */
+static const int32 OctantTransforms[8][4] =
+{
+	{ 1,  0,  0,  1 },
+	{ 0,  1,  1,  0 },
+	{ 0, -1,  1,  0 },
+	{-1,  0,  0,  1 },
+	{-1,  0,  0, -1 },
+	{ 0, -1, -1,  0 },
+	{ 0,  1, -1,  0 },
+	{ 1,  0,  0, -1 },
+};
+
+FStrategyVisibilityGrid::FStrategyVisibilityGrid()
+	: CellSize(200.0f)
+	, UpdateInterval(0.2f)
+	, BlockerHeight(150.0f)
+	, DefaultSightRadius(1000.0f)
+	, TimeToUpdate(0.0f)
+	, Bounds(ForceInit)
+	, SizeX(0)
+	, SizeY(0)
+	, Stamp(0)
+	, Version(0)
+	, NumPendingHeights(0)
+	, HeightMapBuild(0)
+	, HeightMapStartTime(0.0)
+{
+}
+
+void FStrategyVisibilityGrid::Configure(float InCellSize, float InUpdateInterval, float InBlockerHeight, float InDefaultSightRadius)
+{
+	CellSize = FMath::Max(InCellSize, 10.0f);
+	UpdateInterval = FMath::Max(InUpdateInterval, 0.0f);
+	BlockerHeight = InBlockerHeight;
+	DefaultSightRadius = InDefaultSightRadius;
+	Reset();
+}
+
+void FStrategyVisibilityGrid::Reset()
+{
+	SizeX = 0;
+	SizeY = 0;
+	Bounds = FBox2D(ForceInit);
+	Heights.Reset();
+	CellStamps.Reset();
+	for (int32 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		TeamVisibility[TeamNum].Reset();
+	}
+	Viewers.Reset();
+	TimeToUpdate = 0.0f;
+	Version++;
+	NumPendingHeights = 0;
+	HeightMapBuild++;
+}
+
+void FStrategyVisibilityGrid::Tick(UWorld* World, const FBox& WorldBounds, float DeltaSeconds)
+{
+	TimeToUpdate -= DeltaSeconds;
+	if (TimeToUpdate > 0.0f || World == nullptr || !WorldBounds.IsValid)
+	{
+		return;
+	}
+	TimeToUpdate = UpdateInterval;
+
+	// mini map capture may move the bounds, start over then
+	const FBox2D NewBounds(FVector2D(WorldBounds.Min), FVector2D(WorldBounds.Max));
+	if (!IsValid() || !NewBounds.Min.Equals(Bounds.Min) || !NewBounds.Max.Equals(Bounds.Max))
+	{
+		// traces of the old height map are bound to us raw, drop them
+		AStrategyGameState* const MyGameState = World->GetGameState<AStrategyGameState>();
+		if (MyGameState)
+		{
+			MyGameState->GetSceneQueries().Cancel(this);
+		}
+		Reset();
+		TimeToUpdate = UpdateInterval;
+		BuildHeightMap(World, WorldBounds);
+	}
+
+	if (NumPendingHeights == 0)
+	{
+		UpdateViewers(World);
+	}
+}
+
+void FStrategyVisibilityGrid::BuildHeightMap(UWorld* World, const FBox& WorldBounds)
+{
+	Bounds = FBox2D(FVector2D(WorldBounds.Min), FVector2D(WorldBounds.Max));
+	const FVector2D Size = Bounds.GetSize();
+	SizeX = FMath::Max(FMath::CeilToInt(Size.X / CellSize), 1);
+	SizeY = FMath::Max(FMath::CeilToInt(Size.Y / CellSize), 1);
+
+	const int32 NumCells = SizeX * SizeY;
+	Heights.SetNumUninitialized(NumCells);
+	CellStamps.SetNumZeroed(NumCells);
+	for (int32 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		TeamVisibility[TeamNum].SetNumZeroed(NumCells);
+	}
+
+	// only static geometry blocks the sight, units don't
+	static const FName HeightTraceTag(TEXT("VisibilityHeight"));
+	const FCollisionObjectQueryParams ObjectParams(FCollisionObjectQueryParams::AllStaticObjects);
+	const FCollisionQueryParams QueryParams(HeightTraceTag, false);
+	const float TraceTop = WorldBounds.Max.Z + HeightTraceRange;
+	const float TraceBottom = WorldBounds.Min.Z - HeightTraceRange;
+
+	// traces run together in the background, viewers wait for all of them
+	HeightMapStartTime = FPlatformTime::Seconds();
+	NumPendingHeights = NumCells;
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const FVector2D CellCenter = Bounds.Min + FVector2D((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize);
+			FStrategySceneQueries::LineTraceSingleByObjectType(World, FVector(CellCenter, TraceTop), FVector(CellCenter, TraceBottom), ObjectParams, QueryParams,
+				FOnStrategySceneQueryDone::CreateRaw(this, &FStrategyVisibilityGrid::OnHeightTraced, Y * SizeX + X, HeightMapBuild, WorldBounds.Min.Z));
+		}
+	}
+}
+
+void FStrategyVisibilityGrid::OnHeightTraced(const TArray<FHitResult>& Hits, int32 CellIndex, uint32 Build, float FloorHeight)
+{
+	// grid was rebuilt since
+	if (Build != HeightMapBuild || !Heights.IsValidIndex(CellIndex))
+	{
+		return;
+	}
+
+	Heights[CellIndex] = Hits.Num() > 0 ? Hits[0].ImpactPoint.Z : FloorHeight;
+	if (--NumPendingHeights == 0)
+	{
+		UE_LOG(LogGame, Log, TEXT("Visibility grid %dx%d (cell %.0f) built in %.3f s"), SizeX, SizeY, CellSize, FPlatformTime::Seconds() - HeightMapStartTime);
+	}
+}
+
+void FStrategyVisibilityGrid::UpdateViewers(UWorld* World)
+{
+	bool bChanged = false;
+
+	for (TPair<TWeakObjectPtr<AActor>, FViewer>& Pair : Viewers)
+	{
+		Pair.Value.bSeen = false;
+	}
+
+	for (ABaseCharacter* TestChar : TActorRange<ABaseCharacter>(World))
+	{
+		const uint8 TeamNum = TestChar->GetTeamNum();
+		if (TestChar->GetHealth() <= 0 || TeamNum == EStrategyTeam::Unknown || TeamNum >= EStrategyTeam::MAX)
+		{
+			continue;
+		}
+
+		FViewer* Viewer = Viewers.Find(TestChar);
+		if (Viewer == nullptr)
+		{
+			Viewer = &Viewers.Add(TestChar);
+			Viewer->CellIndex = INDEX_NONE;
+		}
+		Viewer->bSeen = true;
+
+		const AStrategyAIController* const AIController = Cast<AStrategyAIController>(TestChar->Controller);
+		const float SightRadius = (AIController && AIController->GetSensingComponent()) ? AIController->GetSensingComponent()->SightRadius : DefaultSightRadius;
+		const int32 RadiusCells = FMath::CeilToInt(SightRadius / CellSize);
+		const int32 CellIndex = GetCellIndex(TestChar->GetActorLocation());
+
+		// only units which changed the cell (or team, or sight) are recomputed
+		if (CellIndex != Viewer->CellIndex || RadiusCells != Viewer->RadiusCells || TeamNum != Viewer->TeamNum)
+		{
+			if (Viewer->CellIndex != INDEX_NONE)
+			{
+				ApplyViewer(*Viewer, -1);
+			}
+			Viewer->TeamNum = TeamNum;
+			Viewer->CellIndex = CellIndex;
+			Viewer->RadiusCells = RadiusCells;
+			ComputeVisibleCells(*Viewer);
+			ApplyViewer(*Viewer, 1);
+			bChanged = true;
+		}
+	}
+
+	// units which died or were destroyed don't reveal anything anymore
+	for (auto It = Viewers.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().bSeen)
+		{
+			if (It.Value().CellIndex != INDEX_NONE)
+			{
+				ApplyViewer(It.Value(), -1);
+			}
+			It.RemoveCurrent();
+			bChanged = true;
+		}
+	}
+
+	if (bChanged)
+	{
+		Version++;
+	}
+}
+
+void FStrategyVisibilityGrid::ApplyViewer(const FViewer& Viewer, int32 Delta)
+{
+	TArray<uint16>& Visibility = TeamVisibility[Viewer.TeamNum];
+	for (const int32 CellIndex : Viewer.VisibleCells)
+	{
+		Visibility[CellIndex] += Delta;
+	}
+}
+
+void FStrategyVisibilityGrid::ComputeVisibleCells(FViewer& Viewer)
+{
+	Viewer.VisibleCells.Reset();
+	if (Viewer.CellIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// octants share their edges, stamp makes sure every cell is added once
+	Stamp++;
+	if (Stamp == 0)
+	{
+		FMemory::Memzero(CellStamps.GetData(), CellStamps.Num() * CellStamps.GetTypeSize());
+		Stamp = 1;
+	}
+
+	const int32 OriginX = Viewer.CellIndex % SizeX;
+	const int32 OriginY = Viewer.CellIndex / SizeX;
+	CellStamps[Viewer.CellIndex] = Stamp;
+	Viewer.VisibleCells.Add(Viewer.CellIndex);
+
+	const float ViewerHeight = Heights[Viewer.CellIndex];
+	for (int32 Octant = 0; Octant < 8; Octant++)
+	{
+		CastOctant(OriginX, OriginY, ViewerHeight, Viewer.RadiusCells, 1, 1.0f, 0.0f,
+			OctantTransforms[Octant][0], OctantTransforms[Octant][1], OctantTransforms[Octant][2], OctantTransforms[Octant][3], Viewer.VisibleCells);
+	}
+}
+
+void FStrategyVisibilityGrid::CastOctant(int32 OriginX, int32 OriginY, float ViewerHeight, int32 RadiusCells, int32 Row, float StartSlope, float EndSlope,
+	int32 XX, int32 XY, int32 YX, int32 YY, TArray<int32>& OutCells)
+{
+	if (StartSlope < EndSlope)
+	{
+		return;
+	}
+
+	const int32 RadiusSquared = RadiusCells * RadiusCells;
+	float NextStartSlope = StartSlope;
+	for (int32 Distance = Row; Distance <= RadiusCells; Distance++)
+	{
+		bool bBlocked = false;
+		for (int32 DeltaX = -Distance, DeltaY = -Distance; DeltaX <= 0; DeltaX++)
+		{
+			const float LeftSlope = (DeltaX - 0.5f) / (DeltaY + 0.5f);
+			const float RightSlope = (DeltaX + 0.5f) / (DeltaY - 0.5f);
+			if (StartSlope < RightSlope)
+			{
+				continue;
+			}
+			if (EndSlope > LeftSlope)
+			{
+				break;
+			}
+
+			const int32 CellX = OriginX + DeltaX * XX + DeltaY * XY;
+			const int32 CellY = OriginY + DeltaX * YX + DeltaY * YY;
+			const bool bInside = CellX >= 0 && CellX < SizeX && CellY >= 0 && CellY < SizeY;
+			const int32 CellIndex = CellY * SizeX + CellX;
+			if (bInside && DeltaX * DeltaX + DeltaY * DeltaY <= RadiusSquared && CellStamps[CellIndex] != Stamp)
+			{
+				CellStamps[CellIndex] = Stamp;
+				OutCells.Add(CellIndex);
+			}
+
+			// outside of the raster counts as a wall
+			const bool bOpaque = !bInside || Heights[CellIndex] > ViewerHeight + BlockerHeight;
+			if (bBlocked)
+			{
+				if (bOpaque)
+				{
+					NextStartSlope = RightSlope;
+					continue;
+				}
+				bBlocked = false;
+				StartSlope = NextStartSlope;
+			}
+			else if (bOpaque && Distance < RadiusCells)
+			{
+				bBlocked = true;
+				CastOctant(OriginX, OriginY, ViewerHeight, RadiusCells, Distance + 1, StartSlope, LeftSlope, XX, XY, YX, YY, OutCells);
+				NextStartSlope = RightSlope;
+			}
+		}
+
+		if (bBlocked)
+		{
+			break;
+		}
+	}
+}
+
+int32 FStrategyVisibilityGrid::GetCellIndex(const FVector& Location) const
+{
+	const int32 X = FMath::FloorToInt((Location.X - Bounds.Min.X) / CellSize);
+	const int32 Y = FMath::FloorToInt((Location.Y - Bounds.Min.Y) / CellSize);
+	return (X >= 0 && X < SizeX && Y >= 0 && Y < SizeY) ? Y * SizeX + X : INDEX_NONE;
+}
+
+bool FStrategyVisibilityGrid::IsVisible(uint8 TeamNum, const FVector& Location) const
+{
+	if (!IsValid() || TeamNum >= EStrategyTeam::MAX)
+	{
+		return false;
+	}
+
+	const int32 CellIndex = GetCellIndex(Location);
+	return CellIndex != INDEX_NONE && TeamVisibility[TeamNum][CellIndex] > 0;
+}
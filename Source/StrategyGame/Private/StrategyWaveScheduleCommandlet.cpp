@@ -0,0 +1,91 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyWaveScheduleCommandlet.h"
+#include "StrategyWaveSchedule.h"
+
+UStrategyWaveScheduleCommandlet::UStrategyWaveScheduleCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UStrategyWaveScheduleCommandlet::Main(const FString& Params)
+{
+	FString SchedulePath;
+	if (!FParse::Value(*Params, TEXT("Schedule="), SchedulePath))
+	{
+		UE_LOG(LogGame, Error, TEXT("Usage: -run=StrategyWaveSchedule -Schedule=<asset path> [-FPS=30] [-Waves=<count>]"));
+		return 1;
+	}
+
+	float FramesPerSecond = 30.0f;
+	FParse::Value(*Params, TEXT("FPS="), FramesPerSecond);
+	FramesPerSecond = FMath::Max(FramesPerSecond, 1.0f);
+
+	const UStrategyWaveSchedule* const Schedule = LoadObject<UStrategyWaveSchedule>(nullptr, *SchedulePath);
+	if (Schedule == nullptr)
+	{
+		UE_LOG(LogGame, Error, TEXT("Failed to load wave schedule %s"), *SchedulePath);
+		return 1;
+	}
+
+	TArray<FString> Errors;
+	if (!Schedule->Validate(Errors))
+	{
+		for (const FString& Error : Errors)
+		{
+			UE_LOG(LogGame, Error, TEXT("%s: %s"), *SchedulePath, *Error);
+		}
+		return 1;
+	}
+
+	// repeated last wave is played once more
+	int32 NumWaves = Schedule->Waves.Num() + (Schedule->bRepeatLastWave ? 1 : 0);
+	FParse::Value(*Params, TEXT("Waves="), NumWaves);
+
+	// same stepping as the director: due spawns each frame, at most the game's budget of them, as if the
+	// director had the budget to itself
+	const float FrameTime = 1.0f / FramesPerSecond;
+	const int32 SpawnBudget = FMath::Max(GetDefault<AStrategyGameState>()->UnitSpawnsPerFrame, 1);
+	float MatchTime = 0.0f;
+	TArray<FStrategyWaveSpawn> Spawns;
+	for (int32 WaveIndex = 0; WaveIndex < NumWaves && Schedule->PlanWave(WaveIndex, Spawns); WaveIndex++)
+	{
+		const FStrategyWave* const Wave = Schedule->GetWave(WaveIndex);
+		const float StartTime = MatchTime + Wave->StartDelay;
+
+		int32 NumFrames = 0;
+		int32 NumBusyFrames = 0;
+		float MaxDelay = 0.0f;
+		int32 NextSpawn = 0;
+		float WaveTime = 0.0f;
+		while (NextSpawn < Spawns.Num())
+		{
+			int32 FrameSpawns = 0;
+			while (FrameSpawns < SpawnBudget && NextSpawn < Spawns.Num() && Spawns[NextSpawn].Time <= WaveTime)
+			{
+				MaxDelay = FMath::Max(MaxDelay, WaveTime - Spawns[NextSpawn].Time);
+				NextSpawn++;
+				FrameSpawns++;
+			}
+			NumBusyFrames += FrameSpawns > 0 ? 1 : 0;
+			NumFrames++;
+			WaveTime += FrameTime;
+		}
+		MatchTime = StartTime + FMath::Max(WaveTime - FrameTime, 0.0f);
+
+		UE_LOG(LogGame, Display, TEXT("Wave %d: %d units from %.1fs to %.1fs, spawning in %d of %d frames, up to %.2fs behind plan"),
+			WaveIndex, Spawns.Num(), StartTime, MatchTime, NumBusyFrames, NumFrames, MaxDelay);
+		for (int32 UnitIndex = 0; UnitIndex < Wave->Units.Num(); UnitIndex++)
+		{
+			const FStrategyWaveUnit& Unit = Wave->Units[UnitIndex];
+			UE_LOG(LogGame, Display, TEXT("    %d x %s"), Unit.Count, *GetNameSafe(Unit.UnitClass));
+		}
+	}
+
+	UE_LOG(LogGame, Display, TEXT("Wave schedule %s is valid"), *SchedulePath);
+	return 0;
+}
@@ -0,0 +1,32 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyDamage.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStrategyFriendlyFireTest, "StrategyGame.Damage.FriendlyFire",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter | EAutomationTestFlags::SmokeFilter)
+
+/** Damage is dropped between the same or allied teams only, teamless sides always take it. */
+bool FStrategyFriendlyFireTest::RunTest(const FString& Parameters)
+{
+	// extra teams for the alliance, relations have room for them
+	const uint8 AllyA = EStrategyTeam::MAX;
+	const uint8 AllyB = EStrategyTeam::MAX + 1;
+
+	FStrategyTeamRelations Relations;
+	Relations.SetAllied(AllyA, AllyB, true);
+
+	TestFalse(TEXT("Teamless instigator hurts teamless victim"), FStrategyDamageQueue::IsFriendlyFire(Relations, EStrategyTeam::Unknown, EStrategyTeam::Unknown));
+	TestFalse(TEXT("Teamless instigator hurts team unit"), FStrategyDamageQueue::IsFriendlyFire(Relations, EStrategyTeam::Unknown, EStrategyTeam::Player));
+	TestFalse(TEXT("Team unit hurts teamless victim"), FStrategyDamageQueue::IsFriendlyFire(Relations, EStrategyTeam::Player, EStrategyTeam::Unknown));
+	TestFalse(TEXT("Enemies hurt each other"), FStrategyDamageQueue::IsFriendlyFire(Relations, EStrategyTeam::Player, EStrategyTeam::Enemy));
+	TestTrue(TEXT("Same team is friendly fire"), FStrategyDamageQueue::IsFriendlyFire(Relations, EStrategyTeam::Enemy, EStrategyTeam::Enemy));
+	TestTrue(TEXT("Allies are friendly fire"), FStrategyDamageQueue::IsFriendlyFire(Relations, AllyA, AllyB));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
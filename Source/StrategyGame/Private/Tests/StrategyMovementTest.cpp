@@ -0,0 +1,332 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyCharMovement.h"
+#include "StrategyAIController.h"
+#include "StrategyBuilding_Brewery.h"
+#include "NavigationSystem.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** map with both breweries on one navmesh */
+static const TCHAR* const MovementTestMap = TEXT("/Game/Maps/TowerDefenseMap");
+
+/** units ordered in each movement mode */
+static const int32 MovementTestUnits = 20;
+
+/** units in a row of the starting block */
+static const int32 MovementTestUnitsPerRow = 5;
+
+/** distance between units of the starting block */
+static const float MovementTestSpacing = 150.0f;
+
+/** distance of start and goal from the breweries, their footprints are cut out of the navmesh */
+static const float MovementTestBreweryOffset = 1000.0f;
+
+/** units closer to the goal than this have arrived */
+static const float MovementTestArrivalDistance = 500.0f;
+
+/** simulated seconds the units have to arrive in */
+static const float MovementTestTimeout = 60.0f;
+
+/** real seconds the map has to load and reach the warmup in */
+static const double MovementTestWarmupTimeout = 300.0;
+
+/** units stuck for longer than this in total count as stuck */
+static const float MovementTestStuckSeconds = 2.0f;
+
+/** nav walking may take this much longer on average than walking */
+static const float MaxNavWalkingArrivalRatio = 1.1f;
+
+/** Same move order given to a block of units in one movement mode */
+struct FStrategyMovementTrial
+{
+	/** true for nav walking, false for walking */
+	bool bNavWalking;
+
+	/** set once the units are spawned and ordered */
+	bool bStarted;
+
+	/** world time of the order */
+	float StartTime;
+
+	/** where the units are sent */
+	FVector Goal;
+
+	/** ordered units */
+	TArray<TWeakObjectPtr<ABaseCharacter>> Units;
+
+	/** seconds from the order to arrival of each unit, negative until it arrives */
+	TArray<float> ArrivalTimes;
+
+	/** units stuck for longer than MovementTestStuckSeconds */
+	int32 NumStuck;
+
+	explicit FStrategyMovementTrial(bool bInNavWalking)
+		: bNavWalking(bInNavWalking)
+		, bStarted(false)
+		, StartTime(0.0f)
+		, Goal(FVector::ZeroVector)
+		, NumStuck(0)
+	{
+	}
+
+	/** @return name of the movement mode */
+	const TCHAR* GetName() const { return bNavWalking ? TEXT("Nav walking") : TEXT("Walking"); }
+
+	/** @return units that reached the goal */
+	int32 GetNumArrived() const
+	{
+		int32 NumArrived = 0;
+		for (float ArrivalTime : ArrivalTimes)
+		{
+			NumArrived += ArrivalTime >= 0.0f ? 1 : 0;
+		}
+		return NumArrived;
+	}
+
+	/** @return average seconds to the goal, units that didn't make it count with the timeout */
+	float GetAverageArrivalTime() const
+	{
+		float Total = 0.0f;
+		for (float ArrivalTime : ArrivalTimes)
+		{
+			Total += ArrivalTime >= 0.0f ? ArrivalTime : MovementTestTimeout;
+		}
+		return ArrivalTimes.Num() > 0 ? Total / ArrivalTimes.Num() : MovementTestTimeout;
+	}
+};
+
+/**
+ * Spawns the units of the trial in front of the player brewery and sends them to the enemy one.
+ *
+ * @param	Test	Test to report errors to.
+ * @param	World	Game world with the match.
+ * @param	Trial	Trial to start.
+ * @returns false if the trial can't run on this map.
+ */
+static bool StartMovementTrial(FAutomationTestBase* Test, UWorld* World, FStrategyMovementTrial& Trial)
+{
+	const AStrategyGameState* const GameState = World->GetGameState<AStrategyGameState>();
+	const FPlayerData* const PlayerData = GameState->GetPlayerData(EStrategyTeam::Player);
+	const FPlayerData* const EnemyData = GameState->GetPlayerData(EStrategyTeam::Enemy);
+	const AStrategyBuilding_Brewery* const PlayerBrewery = PlayerData ? PlayerData->Brewery.Get() : nullptr;
+	const AStrategyBuilding_Brewery* const EnemyBrewery = EnemyData ? EnemyData->Brewery.Get() : nullptr;
+	UNavigationSystemV1* const NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	if (PlayerBrewery == nullptr || EnemyBrewery == nullptr || PlayerBrewery->DwarfCharClass == nullptr || NavSys == nullptr)
+	{
+		Test->AddError(TEXT("Movement test map needs breweries of both teams, dwarfs to spawn and navigation"));
+		return false;
+	}
+
+	const FVector Dir = (EnemyBrewery->GetActorLocation() - PlayerBrewery->GetActorLocation()).GetSafeNormal2D();
+	const FVector Side(-Dir.Y, Dir.X, 0.0f);
+	const FVector QueryExtent(500.0f, 500.0f, 1000.0f);
+	FNavLocation Origin;
+	FNavLocation Goal;
+	if (!NavSys->ProjectPointToNavigation(PlayerBrewery->GetActorLocation() + Dir * MovementTestBreweryOffset, Origin, QueryExtent) ||
+		!NavSys->ProjectPointToNavigation(EnemyBrewery->GetActorLocation() - Dir * MovementTestBreweryOffset, Goal, QueryExtent))
+	{
+		Test->AddError(TEXT("No navmesh in front of the breweries"));
+		return false;
+	}
+	Trial.Goal = Goal.Location;
+
+	// the mode is picked when the movement component initializes
+	IConsoleVariable* const NavWalkingVar = IConsoleManager::Get().FindConsoleVariable(TEXT("strategy.NavWalking"));
+	const int32 PrevNavWalking = NavWalkingVar->GetInt();
+	NavWalkingVar->Set(Trial.bNavWalking ? 1 : 0, ECVF_SetByConsole);
+
+	TSubclassOf<AStrategyChar> UnitClass = PlayerBrewery->DwarfCharClass;
+	const float HalfHeight = UnitClass->GetDefaultObject<AStrategyChar>()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	for (int32 Idx = 0; Idx < MovementTestUnits; Idx++)
+	{
+		const float Column = (Idx % MovementTestUnitsPerRow) - (MovementTestUnitsPerRow - 1) * 0.5f;
+		const float Row = Idx / MovementTestUnitsPerRow;
+		FNavLocation SpawnLoc;
+		if (!NavSys->ProjectPointToNavigation(Origin.Location + (Side * Column - Dir * Row) * MovementTestSpacing, SpawnLoc, QueryExtent))
+		{
+			Test->AddError(FString::Printf(TEXT("No navmesh for unit %d of the starting block"), Idx));
+			continue;
+		}
+
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AStrategyChar* const UnitChar = World->SpawnActor<AStrategyChar>(UnitClass, SpawnLoc.Location + FVector(0.0f, 0.0f, HalfHeight), Dir.Rotation(), SpawnInfo);
+		if (UnitChar == nullptr)
+		{
+			Test->AddError(FString::Printf(TEXT("Failed to spawn %s"), *UnitClass->GetName()));
+			continue;
+		}
+		UnitChar->SetTeamNum(EStrategyTeam::Player);
+		UnitChar->SpawnDefaultController();
+
+		const UStrategyCharMovement* const Movement = Cast<UStrategyCharMovement>(UnitChar->GetCharacterMovement());
+		AStrategyAIController* const AI = Cast<AStrategyAIController>(UnitChar->GetController());
+		if (Movement == nullptr || AI == nullptr)
+		{
+			Test->AddError(FString::Printf(TEXT("%s has no strategy movement or AI controller"), *UnitClass->GetName()));
+			UnitChar->Destroy();
+			continue;
+		}
+		Test->TestTrue(FString::Printf(TEXT("%s unit uses its movement mode"), Trial.GetName()),
+			Movement->DefaultLandMovementMode == (Trial.bNavWalking ? MOVE_NavWalking : MOVE_Walking));
+
+		// the order alone moves the unit, its actions would pick their own; no corridor cache, so the
+		// second trial doesn't get its paths quicker than the first
+		AI->EnableLogic(false);
+		AI->MoveToLocationAsync(Trial.Goal, MovementTestArrivalDistance * 0.5f, false, false);
+		Trial.Units.Add(UnitChar);
+		Trial.ArrivalTimes.Add(-1.0f);
+	}
+
+	NavWalkingVar->Set(PrevNavWalking, ECVF_SetByConsole);
+	Trial.StartTime = World->GetTimeSeconds();
+	return Trial.Units.Num() > 0;
+}
+
+/** counts stuck units of the trial and removes them from the map */
+static void FinishMovementTrial(FStrategyMovementTrial& Trial)
+{
+	for (const TWeakObjectPtr<ABaseCharacter>& Unit : Trial.Units)
+	{
+		ABaseCharacter* const UnitChar = Unit.Get();
+		if (UnitChar == nullptr)
+		{
+			continue;
+		}
+
+		const UStrategyCharMovement* const Movement = Cast<UStrategyCharMovement>(UnitChar->GetCharacterMovement());
+		if (Movement && Movement->GetStuckTime() > MovementTestStuckSeconds)
+		{
+			Trial.NumStuck++;
+		}
+
+		AController* const Controller = UnitChar->GetController();
+		UnitChar->Destroy();
+		if (Controller)
+		{
+			Controller->Destroy();
+		}
+	}
+}
+
+/** waits for the warmup countdown of the match and holds it, so no waves come while units are timed */
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FHoldStrategyWarmupCommand, FAutomationTestBase*, Test, double, CreateTime);
+
+bool FHoldStrategyWarmupCommand::Update()
+{
+	UWorld* const World = AutomationCommon::GetAnyGameWorld();
+	AStrategyGameState* const GameState = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	if (GameState && GameState->IsGameActive())
+	{
+		Test->AddError(TEXT("Match started before the movement test could hold it"));
+		return true;
+	}
+	if (GameState && GameState->GetRemainingWaitTime() > 0.0f)
+	{
+		GameState->SetTimersPause(true);
+		return true;
+	}
+	if (FPlatformTime::Seconds() - CreateTime > MovementTestWarmupTimeout)
+	{
+		Test->AddError(FString::Printf(TEXT("Match warmup didn't start in %.0f seconds"), MovementTestWarmupTimeout));
+		return true;
+	}
+	return false;
+}
+
+/** orders the units of the trial and times them until all arrive or the timeout */
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FRunMovementTrialCommand, FAutomationTestBase*, Test, TSharedRef<FStrategyMovementTrial>, Trial);
+
+bool FRunMovementTrialCommand::Update()
+{
+	UWorld* const World = AutomationCommon::GetAnyGameWorld();
+	if (Test->HasAnyErrors() || World == nullptr || World->GetGameState<AStrategyGameState>() == nullptr)
+	{
+		FinishMovementTrial(*Trial);
+		return true;
+	}
+
+	if (!Trial->bStarted)
+	{
+		Trial->bStarted = true;
+		return !StartMovementTrial(Test, World, *Trial);
+	}
+
+	const float TrialTime = World->GetTimeSeconds() - Trial->StartTime;
+	bool bAllArrived = true;
+	for (int32 Idx = 0; Idx < Trial->Units.Num(); Idx++)
+	{
+		const ABaseCharacter* const UnitChar = Trial->Units[Idx].Get();
+		if (UnitChar && Trial->ArrivalTimes[Idx] < 0.0f)
+		{
+			if (FVector::DistSquared2D(UnitChar->GetActorLocation(), Trial->Goal) <= FMath::Square(MovementTestArrivalDistance))
+			{
+				Trial->ArrivalTimes[Idx] = TrialTime;
+			}
+			else
+			{
+				bAllArrived = false;
+			}
+		}
+	}
+
+	if (!bAllArrived && TrialTime < MovementTestTimeout)
+	{
+		return false;
+	}
+	FinishMovementTrial(*Trial);
+	return true;
+}
+
+/** checks nav walking against walking and lets the match start */
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FCompareMovementTrialsCommand, FAutomationTestBase*, Test, TSharedRef<FStrategyMovementTrial>, Walking, TSharedRef<FStrategyMovementTrial>, NavWalking);
+
+bool FCompareMovementTrialsCommand::Update()
+{
+	UWorld* const World = AutomationCommon::GetAnyGameWorld();
+	AStrategyGameState* const GameState = World ? World->GetGameState<AStrategyGameState>() : nullptr;
+	if (GameState)
+	{
+		GameState->SetTimersPause(false);
+	}
+	if (Test->HasAnyErrors())
+	{
+		return true;
+	}
+
+	const FStrategyMovementTrial* const Trials[] = { &Walking.Get(), &NavWalking.Get() };
+	for (const FStrategyMovementTrial* Trial : Trials)
+	{
+		Test->AddInfo(FString::Printf(TEXT("%s: %d/%d units arrived, %.2f s on average, %d stuck"), Trial->GetName(),
+			Trial->GetNumArrived(), Trial->ArrivalTimes.Num(), Trial->GetAverageArrivalTime(), Trial->NumStuck));
+		Test->TestEqual(FString::Printf(TEXT("%s units arrived in %.0f seconds"), Trial->GetName(), MovementTestTimeout), Trial->GetNumArrived(), Trial->ArrivalTimes.Num());
+	}
+
+	Test->TestTrue(FString::Printf(TEXT("Nav walking arrives within %.0f%% of walking time"), MaxNavWalkingArrivalRatio * 100.0f),
+		NavWalking->GetAverageArrivalTime() <= Walking->GetAverageArrivalTime() * MaxNavWalkingArrivalRatio);
+	Test->TestTrue(TEXT("Nav walking gets no more units stuck than walking"), NavWalking->NumStuck <= Walking->NumStuck);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStrategyNavWalkingTest, "StrategyGame.Units.NavWalking",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+/** Dwarfs sent across the map arrive as fast and get stuck as rarely with nav walking as with walking. */
+bool FStrategyNavWalkingTest::RunTest(const FString& Parameters)
+{
+	AutomationOpenMap(MovementTestMap);
+
+	TSharedRef<FStrategyMovementTrial> Walking = MakeShareable(new FStrategyMovementTrial(false));
+	TSharedRef<FStrategyMovementTrial> NavWalking = MakeShareable(new FStrategyMovementTrial(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FHoldStrategyWarmupCommand(this, FPlatformTime::Seconds()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRunMovementTrialCommand(this, Walking));
+	ADD_LATENT_AUTOMATION_COMMAND(FRunMovementTrialCommand(this, NavWalking));
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareMovementTrialsCommand(this, Walking, NavWalking));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,86 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyStressRun.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** map the scenarios run on */
+static const TCHAR* const StressTestMap = TEXT("/Game/Maps/TowerDefenseMap");
+
+/** units per side of each scenario */
+static const int32 StressTestUnits[] = { 100, 500, 2000 };
+
+/** real seconds a scenario has to finish in, slow frames stretch its simulated time */
+static const double StressTestTimeout = 3600.0;
+
+/** loads the map with the scenario and checks its frame times once it's over */
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FRunStressScenarioCommand, FAutomationTestBase*, Test, int32, NumUnits, double, StartTime);
+
+bool FRunStressScenarioCommand::Update()
+{
+	if (StartTime <= 0.0)
+	{
+		UWorld* const World = AutomationCommon::GetAnyGameWorld();
+		if (World == nullptr)
+		{
+			Test->AddError(TEXT("No game world to open the stress map from"));
+			return true;
+		}
+
+		// game state of the new map picks the scenario up
+		FStrategyStressRun::RequestScenario(NumUnits);
+		GEngine->Exec(World, *FString::Printf(TEXT("open %s"), StressTestMap));
+		StartTime = FPlatformTime::Seconds();
+		return false;
+	}
+
+	if (FStrategyStressRun::IsScenarioPending())
+	{
+		if (FPlatformTime::Seconds() - StartTime < StressTestTimeout)
+		{
+			return false;
+		}
+		Test->AddError(FString::Printf(TEXT("Stress scenario didn't finish in %.0f seconds"), StressTestTimeout));
+		return true;
+	}
+
+	const FStrategyStressResult& Result = FStrategyStressRun::GetLastResult();
+	if (!Result.bFinished || Result.NumUnits != NumUnits)
+	{
+		Test->AddError(FString::Printf(TEXT("Stress scenario of %d units didn't run, see the log"), NumUnits));
+		return true;
+	}
+
+	const float BudgetMs = GetDefault<AStrategyGameState>()->StressFrameTimeBudget;
+	if (!Result.StopReason.IsEmpty())
+	{
+		Test->AddError(FString::Printf(TEXT("Stress scenario cut short: %s"), *Result.StopReason));
+	}
+	Test->TestTrue(FString::Printf(TEXT("95th percentile frame time %.2f ms within %.2f ms"), Result.FrameTimeP95, BudgetMs), Result.FrameTimeP95 <= BudgetMs);
+	return true;
+}
+
+// game only, frame times in the editor say little about the shipped game
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FStrategyStressTest, "StrategyGame.Stress",
+	EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FStrategyStressTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (int32 NumUnits : StressTestUnits)
+	{
+		OutBeautifiedNames.Add(FString::Printf(TEXT("%d Units"), NumUnits));
+		OutTestCommands.Add(FString::FromInt(NumUnits));
+	}
+}
+
+/** Wave scenario with the given units per side keeps 95th percentile frame time within StressFrameTimeBudget. */
+bool FStrategyStressTest::RunTest(const FString& Parameters)
+{
+	ADD_LATENT_AUTOMATION_COMMAND(FRunStressScenarioCommand(this, FCString::Atoi(*Parameters), 0.0));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,64 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyUnitMemory.h"
+#include "StrategyAttachment.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** units measured for each loadout, enough to average out per unit rounding */
+static const int32 TestUnitsPerLoadout = 20;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStrategyUnitMemoryBudgetTest, "StrategyGame.Units.MemoryBudget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+/** Dwarf without attachments and with both of them stays within UnitMemoryBudgetKB, by counted bytes. */
+bool FStrategyUnitMemoryBudgetTest::RunTest(const FString& Parameters)
+{
+	TSubclassOf<ABaseCharacter> UnitClass = LoadClass<ABaseCharacter>(nullptr, TEXT("/Game/Characters/DwarfGrunt/Blueprint/Minion.Minion_C"));
+	TSubclassOf<UStrategyAttachment> Weapon = LoadClass<UStrategyAttachment>(nullptr, TEXT("/Game/Characters/DwarfGrunt/Blueprint/Attachment_Smithy.Attachment_Smithy_C"));
+	TSubclassOf<UStrategyAttachment> Armor = LoadClass<UStrategyAttachment>(nullptr, TEXT("/Game/Characters/DwarfGrunt/Blueprint/Attachment_Armorer.Attachment_Armorer_C"));
+	if (UnitClass == nullptr || Weapon == nullptr || Armor == nullptr)
+	{
+		AddError(TEXT("Failed to load dwarf unit or attachment classes"));
+		return false;
+	}
+
+	FStrategyUnitMemorySetup Setups[2];
+	Setups[0].UnitClass = UnitClass;
+	Setups[1].UnitClass = UnitClass;
+	Setups[1].Weapon = Weapon;
+	Setups[1].Armor = Armor;
+
+	// units are spawned without a match, begin play and AI don't run
+	UWorld* const World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	const float BudgetKB = GetDefault<AStrategyGameState>()->UnitMemoryBudgetKB;
+	for (int32 Idx = 0; Idx < UE_ARRAY_COUNT(Setups); Idx++)
+	{
+		FStrategyUnitMemoryReport Report;
+		if (!Report.Measure(World, Setups[Idx], TestUnitsPerLoadout, FVector::ZeroVector))
+		{
+			AddError(FString::Printf(TEXT("Failed to spawn units of %s"), *UnitClass->GetName()));
+			continue;
+		}
+
+		TArray<FString> Lines;
+		Report.GetLines(BudgetKB, Lines);
+		for (const FString& Line : Lines)
+		{
+			AddInfo(Line);
+		}
+		TestTrue(FString::Printf(TEXT("%s within %.1f counted KB per unit"), *Lines[0], BudgetKB), Report.IsInBudget(BudgetKB));
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return !HasAnyErrors();
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -8,41 +8,33 @@
 #include "StrategyAIController.h"
 #include "StrategyBuilding.h"
 #include "StrategyBuilding_Brewery.h"
+#include "StrategyMapWarmup.h"
+#include "StrategyTelemetry.h"
 
 AStrategyHUD::AStrategyHUD(const FObjectInitializer& ObjectInitializer) :
 	Super(ObjectInitializer)
 {
-	static ConstructorHelpers::FObjectFinder<UTexture2D> BarFillObj(TEXT("/Game/UI/HUD/BarFill"));
-	static ConstructorHelpers::FObjectFinder<UTexture2D> PlayerTeamHPObj(TEXT("/Game/UI/HUD/PlayerTeamHealthBar"));
-	static ConstructorHelpers::FObjectFinder<UTexture2D> EnemyTeamHPObj(TEXT("/Game/UI/HUD/EnemyTeamHealthBar"));
-
-	static ConstructorHelpers::FObjectFinder<UTexture2D> DefaultActionObj(TEXT("/Game/UI/HUD/Actions/DefaultAction"));
-	static ConstructorHelpers::FObjectFinder<UTexture2D> DefaultCenterActionObj(TEXT("/Game/UI/HUD/Actions/DefaultActionBig"));
-	static ConstructorHelpers::FObjectFinder<UTexture2D> ActionPauseObj(TEXT("/Game/UI/HUD/Actions/ActionPause"));
-	static ConstructorHelpers::FObjectFinder<UTexture2D> MenuButtonObj(TEXT("/Game/UI/MainMenu/MenuButton"));
-	static ConstructorHelpers::FObjectFinder<UTexture2D> ResourceObj(TEXT("/Game/UI/HUD/Coin"));
-	static ConstructorHelpers::FObjectFinder<UTexture2D> LivesObj(TEXT("/Game/UI/HUD/Actions/Barrel"));
-	
-
-	static ConstructorHelpers::FObjectFinder<UMaterial> HUDMousePointerNeutralObj(TEXT("/Game/UI/Pointers/Neutral"));
-	static ConstructorHelpers::FObjectFinder<UMaterial> HUDMousePointerAttackObj(TEXT("/Game/UI/Pointers/Enemy"));
-
-	BarFillTexture = BarFillObj.Object;
-	PlayerTeamHPTexture = PlayerTeamHPObj.Object;
-	EnemyTeamHPTexture = EnemyTeamHPObj.Object;
-	LivesTexture = LivesObj.Object;
-
-	DefaultActionTexture = DefaultActionObj.Object;
-	DefaultCenterActionTexture = DefaultCenterActionObj.Object;
-	ActionPauseTexture = ActionPauseObj.Object;
-	MenuButtonTexture = MenuButtonObj.Object;
-	ResourceTexture =  ResourceObj.Object;
-
-	MousePointerNeutral = HUDMousePointerNeutralObj.Object;
-	MousePointerAttack = HUDMousePointerAttackObj.Object;
+	// soft references only, these are streamed in by the map warmup before the HUD is drawn
+	BarFillTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/BarFill.BarFill")));
+	PlayerTeamHPTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/PlayerTeamHealthBar.PlayerTeamHealthBar")));
+	EnemyTeamHPTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/EnemyTeamHealthBar.EnemyTeamHealthBar")));
+	LivesTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/Actions/Barrel.Barrel")));
+
+	DefaultActionTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/Actions/DefaultAction.DefaultAction")));
+	DefaultCenterActionTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/Actions/DefaultActionBig.DefaultActionBig")));
+	ActionPauseTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/Actions/ActionPause.ActionPause")));
+	MenuButtonTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/MainMenu/MenuButton.MenuButton")));
+	ResourceTexture = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/UI/HUD/Coin.Coin")));
+
+	MousePointerNeutral = TSoftObjectPtr<UMaterial>(FSoftObjectPath(TEXT("/Game/UI/Pointers/Neutral.Neutral")));
+	MousePointerAttack = TSoftObjectPtr<UMaterial>(FSoftObjectPath(TEXT("/Game/UI/Pointers/Enemy.Enemy")));
 
 	MiniMapMargin = 40;
 	bBlackScreenActive = false;
+	bShowTelemetryGraph = false;
+	bShowFogOfWar = false;
+	FogOfWarVersion = 0;
+	FogOfWarTexture = nullptr;
 }
 
 
@@ -60,6 +52,12 @@ void AStrategyHUD::DrawHUD()
 		return;
 	}
 
+	// nothing to draw with until the map is warmed up
+	if (!FStrategyMapWarmup::Get().IsWarmupComplete())
+	{
+		return;
+	}
+
 	if ( GEngine && GEngine->GameViewport )
 	{
 		FVector2D ViewportSize;
@@ -83,6 +81,11 @@ void AStrategyHUD::DrawHUD()
 		DrawMiniMap();
 		DrawLives();
 
+		if (bShowTelemetryGraph)
+		{
+			DrawTelemetryGraph();
+		}
+
 		if (IsPauseMenuUp())
 		{
 			/*FCanvasTileItem TileItem( FVector2D( 0.0f, 0.0f ), FVector2D( Canvas->ClipX,Canvas->ClipY ), FLinearColor( 0.0f, 0.0f, 0.0f, 0.25f ) );
@@ -104,6 +107,113 @@ void AStrategyHUD::ShowBlackScreen()
 	GEngine->GameViewport->RemoveAllViewportWidgets();
 }
 
+void AStrategyHUD::ToggleFogOfWar()
+{
+	bShowFogOfWar = !bShowFogOfWar;
+}
+
+void AStrategyHUD::UpdateFogOfWarTexture(const FStrategyVisibilityGrid& VisibilityGrid)
+{
+	// mini map is drawn rotated by 270 yaw: texture U follows world Y, V follows negative world X
+	const int32 TextureWidth = VisibilityGrid.GetSizeY();
+	const int32 TextureHeight = VisibilityGrid.GetSizeX();
+	if (FogOfWarTexture == nullptr || FogOfWarTexture->GetSizeX() != TextureWidth || FogOfWarTexture->GetSizeY() != TextureHeight)
+	{
+		FogOfWarTexture = UTexture2D::CreateTransient(TextureWidth, TextureHeight, PF_B8G8R8A8);
+		FogOfWarTexture->Filter = TF_Bilinear;
+		FogOfWarTexture->SRGB = false;
+		FogOfWarVersion = VisibilityGrid.GetVersion() - 1;
+	}
+	if (FogOfWarVersion == VisibilityGrid.GetVersion())
+	{
+		return;
+	}
+	FogOfWarVersion = VisibilityGrid.GetVersion();
+
+	const AStrategyPlayerController* const PC = Cast<AStrategyPlayerController>(PlayerOwner);
+	const uint8 TeamNum = PC ? PC->GetTeamNum() : EStrategyTeam::Player;
+	FTexture2DMipMap& Mip = FogOfWarTexture->PlatformData->Mips[0];
+	FColor* const Texels = static_cast<FColor*>(Mip.BulkData.Lock(LOCK_READ_WRITE));
+	for (int32 V = 0; V < TextureHeight; V++)
+	{
+		for (int32 U = 0; U < TextureWidth; U++)
+		{
+			const bool bVisible = VisibilityGrid.IsCellVisible(TeamNum, TextureHeight - 1 - V, U);
+			Texels[V * TextureWidth + U] = bVisible ? FColor(0, 0, 0, 0) : FColor(0, 0, 0, 160);
+		}
+	}
+	Mip.BulkData.Unlock();
+	FogOfWarTexture->UpdateResource();
+}
+
+void AStrategyHUD::ToggleTelemetryGraph()
+{
+	bShowTelemetryGraph = !bShowTelemetryGraph;
+}
+
+void AStrategyHUD::DrawTelemetryGraph()
+{
+	AStrategyGameState const* const MyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+	const FStrategyTelemetryRecorder* const Recorder = MyGameState ? MyGameState->GetTelemetryRecorder() : nullptr;
+	if (Recorder == nullptr)
+	{
+		Canvas->DrawText(GEngine->GetSmallFont(), TEXT("Telemetry is not recorded (StrategyGameState bRecordTelemetry)"), 20.0f * UIScale, 20.0f * UIScale);
+		return;
+	}
+
+	const TArray<FStrategyTelemetrySample>& Samples = Recorder->GetRecentSamples();
+	const FVector2D GraphSize(400.0f * UIScale, 150.0f * UIScale);
+	const FVector2D GraphPos(20.0f * UIScale, 40.0f * UIScale);
+
+	FCanvasTileItem Background(GraphPos, GraphSize, FLinearColor(0.0f, 0.0f, 0.0f, 0.5f));
+	Background.BlendMode = SE_BLEND_Translucent;
+	Canvas->DrawItem(Background);
+	if (Samples.Num() < 2)
+	{
+		return;
+	}
+
+	// resources and live pawns of both teams, each scaled to its own maximum
+	uint32 MaxResources = 1;
+	uint32 MaxPawns = 1;
+	for (const FStrategyTelemetrySample& Sample : Samples)
+	{
+		for (uint8 TeamNum = EStrategyTeam::Player; TeamNum < EStrategyTeam::MAX; TeamNum++)
+		{
+			MaxResources = FMath::Max(MaxResources, Sample.GetTeam(TeamNum).ResourcesAvailable);
+			MaxPawns = FMath::Max(MaxPawns, Sample.GetTeam(TeamNum).LivePawns);
+		}
+	}
+
+	const float StepX = GraphSize.X / (Samples.Num() - 1);
+	for (uint8 TeamNum = EStrategyTeam::Player; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		const FLinearColor TeamColor = TeamNum == EStrategyTeam::Player ? FLinearColor::Green : FLinearColor::Red;
+		for (int32 Idx = 1; Idx < Samples.Num(); Idx++)
+		{
+			const FStrategyTelemetryTeamSample& Prev = Samples[Idx - 1].GetTeam(TeamNum);
+			const FStrategyTelemetryTeamSample& Curr = Samples[Idx].GetTeam(TeamNum);
+			const float X0 = GraphPos.X + StepX * (Idx - 1);
+			const float X1 = GraphPos.X + StepX * Idx;
+
+			FCanvasLineItem ResourceLine(FVector2D(X0, GraphPos.Y + GraphSize.Y * (1.0f - (float)Prev.ResourcesAvailable / MaxResources)),
+				FVector2D(X1, GraphPos.Y + GraphSize.Y * (1.0f - (float)Curr.ResourcesAvailable / MaxResources)));
+			ResourceLine.SetColor(TeamColor);
+			Canvas->DrawItem(ResourceLine);
+
+			FCanvasLineItem PawnsLine(FVector2D(X0, GraphPos.Y + GraphSize.Y * (1.0f - (float)Prev.LivePawns / MaxPawns)),
+				FVector2D(X1, GraphPos.Y + GraphSize.Y * (1.0f - (float)Curr.LivePawns / MaxPawns)));
+			PawnsLine.SetColor(TeamColor * 0.5f);
+			Canvas->DrawItem(PawnsLine);
+		}
+	}
+
+	const FStrategyTelemetrySample& Last = Samples.Last();
+	const FString Legend = FString::Printf(TEXT("resources (max %u), pawns (max %u)   frame %.1f ms (max %.1f)   AI %.2f ms"),
+		MaxResources, MaxPawns, Last.FrameTimeMs, Last.MaxFrameTimeMs, Last.AITimeMs);
+	Canvas->DrawText(GEngine->GetSmallFont(), Legend, GraphPos.X, GraphPos.Y + GraphSize.Y + 4.0f * UIScale);
+}
+
 void AStrategyHUD::DrawActorsHealth()
 {
 	for (ABaseCharacter* TestChar : TActorRange<ABaseCharacter>(GetWorld()))
@@ -121,17 +231,15 @@ void AStrategyHUD::DrawActorsHealth()
 	if (MyGameState)
 	{
 		// 0 - unknown/neutral team, two teams in total
+		const FStrategyEntityTable& Entities = MyGameState->GetEntities();
 		for (int8 Team = 1; Team < EStrategyTeam::MAX; Team++)
 		{
 			for (int32 i = 0; i < MyGameState->GetPlayerData(Team)->BuildingsList.Num(); i++) 
 			{
-				if (MyGameState->GetPlayerData(Team)->BuildingsList[i].IsValid())
+				AStrategyBuilding* const TestBuilding = Entities.Get<AStrategyBuilding>(MyGameState->GetPlayerData(Team)->BuildingsList[i]);
+				if (TestBuilding != NULL && TestBuilding->GetHealth() > 0 && !TestBuilding->IsBuildFinished())
 				{
-					AStrategyBuilding* const TestBuilding = Cast<AStrategyBuilding>(MyGameState->GetPlayerData(Team)->BuildingsList[i].Get());
-					if (TestBuilding != NULL && TestBuilding->GetHealth() > 0 && !TestBuilding->IsBuildFinished())
-					{
-						DrawHealthBar(TestBuilding, TestBuilding->GetHealth()/(float)TestBuilding->GetMaxHealth(), 30*UIScale);
-					}
+					DrawHealthBar(TestBuilding, TestBuilding->GetHealth()/(float)TestBuilding->GetMaxHealth(), 30*UIScale);
 				}
 			}
 		}
@@ -164,6 +272,16 @@ void AStrategyHUD::DrawMiniMap()
 			MapTileItem.BlendMode = SE_BLEND_Opaque;
 			Canvas->DrawItem( MapTileItem, FVector2D( MiniMapMargin * UIScale, Canvas->ClipY - MapHeight - MiniMapMargin * UIScale ) );
 		}
+		if (bShowFogOfWar && MyGameState->GetVisibilityGrid().IsValid())
+		{
+			UpdateFogOfWarTexture(MyGameState->GetVisibilityGrid());
+			if (FogOfWarTexture)
+			{
+				FCanvasTileItem FogTileItem( FVector2D( 0.0f, 0.0f), FogOfWarTexture->Resource, FVector2D( MapWidth, MapHeight ), FLinearColor::White );
+				FogTileItem.BlendMode = SE_BLEND_Translucent;
+				Canvas->DrawItem( FogTileItem, FVector2D( MiniMapMargin * UIScale, Canvas->ClipY - MapHeight - MiniMapMargin * UIScale ) );
+			}
+		}
 		FCanvasTileItem TileItem( FVector2D( 0.0f, 0.0f), FVector2D( 0.0f, 0.0f ), FLinearColor::White );
 		TileItem.Size = FVector2D( 6 * UIScale, 6 * UIScale );
 		for (AStrategyChar* TestChar : TActorRange<AStrategyChar>(GetWorld()))
@@ -232,16 +350,16 @@ void AStrategyHUD::BuildMenuWidgets()
 				MyHUDMenuWidget->ActionButtonsWidget->SetVisibility(EVisibility::Visible);
 				MyHUDMenuWidget->ActionWidgetPosition.BindUObject(this,&AStrategyHUD::GetActionsWidgetPos);
 
-				if (ActionPauseTexture != NULL)
+				if (ActionPauseTexture.Get() != NULL)
 				{
-					MyHUDMenuWidget->PauseButton->SetImage(ActionPauseTexture);
+					MyHUDMenuWidget->PauseButton->SetImage(ActionPauseTexture.Get());
 					MyHUDMenuWidget->PauseButton->DeferredShow();
 				}
-				if (MenuButtonTexture != NULL)
+				if (MenuButtonTexture.Get() != NULL)
 				{
 					for (uint8 i = 0; i < MyHUDMenuWidget->PauseMenuButtons.Num(); i++)
 					{
-						MyHUDMenuWidget->PauseMenuButtons[i]->SetImage(MenuButtonTexture);
+						MyHUDMenuWidget->PauseMenuButtons[i]->SetImage(MenuButtonTexture.Get());
 					}
 				}
 			}
@@ -304,11 +422,16 @@ void AStrategyHUD::DrawLives() const
 	AStrategyBuilding_Brewery const* const Brewery = MyGameState ? MyGameState->GetPlayerData(EStrategyTeam::Player)->Brewery.Get() : NULL;
 
 	uint8 const Lives = Brewery ? Brewery->GetNumberOfLives() : 0;
+	UTexture2D* const LivesTextureObj = LivesTexture.Get();
+	if (LivesTextureObj == NULL)
+	{
+		return;
+	}
 
-	float const TextureDrawWidth = LivesTexture->GetSurfaceWidth() * UIScale;
-	float const TextureDrawHeight =  LivesTexture->GetSurfaceHeight() * UIScale;
+	float const TextureDrawWidth = LivesTextureObj->GetSurfaceWidth() * UIScale;
+	float const TextureDrawHeight =  LivesTextureObj->GetSurfaceHeight() * UIScale;
 
-	FCanvasTileItem TileItem(FVector2D(0,0), LivesTexture->Resource, 
+	FCanvasTileItem TileItem(FVector2D(0,0), LivesTextureObj->Resource, 
 							 FVector2D(TextureDrawWidth, TextureDrawHeight), FLinearColor::White );
 	TileItem.BlendMode = SE_BLEND_Translucent;
 	for (int32 i=0; i < Lives; i++)
@@ -345,12 +468,17 @@ void AStrategyHUD::DrawHealthBar(AActor* ForActor, float HealthPercentage, int32
 
 	AStrategyPlayerController* MyPC = GetPlayerController();
 	IStrategyTeamInterface* ActorTeam = Cast<IStrategyTeamInterface>(ForActor);
-	UTexture2D* HealthBarTexture = EnemyTeamHPTexture;
+	UTexture2D* HealthBarTexture = EnemyTeamHPTexture.Get();
 
 	if (ActorTeam != NULL && MyPC != NULL && ActorTeam->GetTeamNum() == MyPC->GetTeamNum())
 	{
-		HealthBarTexture = PlayerTeamHPTexture;
+		HealthBarTexture = PlayerTeamHPTexture.Get();
 	} 
+	UTexture2D* const FillTexture = BarFillTexture.Get();
+	if (HealthBarTexture == NULL || FillTexture == NULL)
+	{
+		return;
+	}
 	float X = Center2D.X - HealthBarLength/2;
 	float Y = Center2D.Y + OffsetY;
 	FCanvasTileItem TileItem( FVector2D( X, Y ), HealthBarTexture->Resource, FVector2D( HealthBarLength * HealthPercentage,  BarHeight ), FLinearColor::White );
@@ -362,7 +490,7 @@ void AStrategyHUD::DrawHealthBar(AActor* ForActor, float HealthPercentage, int32
 	X = Center2D.X-HealthBarLength/2 + HealthBarLength * HealthPercentage;
 	Y = Center2D.Y + OffsetY;
 	TileItem.Position = FVector2D( X, Y );
-	TileItem.Texture = BarFillTexture->Resource;
+	TileItem.Texture = FillTexture->Resource;
 	TileItem.UV1 = FVector2D(1.0f, 1.0f);
 	TileItem.Size = FVector2D( HealthBarLength * (1.0f - HealthPercentage), BarHeight );
 	TileItem.SetColor(FLinearColor(0.5f, 0.5f, 0.5f, 0.5f));
@@ -382,7 +510,7 @@ void AStrategyHUD::DrawMousePointer()
 		const FVector2D PointerSize(60.0f, 30.0f);
 		const FVector2D DrawPos(MousePosition.X - PointerSize.X * 0.5f, MousePosition.Y - PointerSize.Y * 0.5f);
 
-		DrawMaterialSimple(MousePointerNeutral, DrawPos.X, DrawPos.Y, PointerSize.X, PointerSize.Y);
+		DrawMaterialSimple(MousePointerNeutral.Get(), DrawPos.X, DrawPos.Y, PointerSize.X, PointerSize.Y);
 	}
 #endif
 }
@@ -417,3 +545,25 @@ void AStrategyHUD::SetActionGridActor(AActor* InSelectedActor)
 	SelectedActor.Reset();
 	SelectedActor = MakeWeakObjectPtr(InSelectedActor);
 }
+
+void AStrategyHUD::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	const TSoftObjectPtr<UTexture2D>* const Textures[] = { &BarFillTexture, &PlayerTeamHPTexture, &EnemyTeamHPTexture, &LivesTexture,
+		&DefaultActionTexture, &DefaultCenterActionTexture, &ActionPauseTexture, &MenuButtonTexture, &ResourceTexture };
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Textures); i++)
+	{
+		if (!Textures[i]->IsNull())
+		{
+			OutAssets.AddUnique(Textures[i]->ToSoftObjectPath());
+		}
+	}
+
+	const TSoftObjectPtr<UMaterial>* const Materials[] = { &MousePointerNeutral, &MousePointerAttack };
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Materials); i++)
+	{
+		if (!Materials[i]->IsNull())
+		{
+			OutAssets.AddUnique(Materials[i]->ToSoftObjectPath());
+		}
+	}
+}
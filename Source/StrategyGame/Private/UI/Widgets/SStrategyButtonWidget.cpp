@@ -54,13 +54,13 @@ void SStrategyButtonWidget::Construct(const FArguments& InArgs)
 		+SOverlay::Slot()
 		.HAlign(TextHAlign.Get().IsSet() ? TextHAlign.Get().GetValue() : EHorizontalAlignment::HAlign_Center)
 		.VAlign(TextVAlign.Get().IsSet() ? TextVAlign.Get().GetValue() : EVerticalAlignment::VAlign_Bottom)
-		.Padding(TAttribute<FMargin>(this, &SStrategyButtonWidget::GetTextMargin))
+		.Padding(GetTextMargin())
 		[
 			SNew(STextBlock)
 			.ShadowColorAndOpacity(this,&SStrategyButtonWidget::GetTextShadowColor)
 			.ColorAndOpacity(this,&SStrategyButtonWidget::GetTextColor)
 			.ShadowOffset(FIntPoint(-1,1))
-			.Font(this, &SStrategyButtonWidget::GetTextFont)
+			.Font(GetTextFont())
 			.Text(ButtonText)
 		]
 		+SOverlay::Slot()
@@ -71,7 +71,7 @@ void SStrategyButtonWidget::Construct(const FArguments& InArgs)
 			.ShadowColorAndOpacity(this,&SStrategyButtonWidget::GetTextShadowColor)
 			.ColorAndOpacity(this,&SStrategyButtonWidget::GetTextColor)
 			.ShadowOffset(FIntPoint(-1,1))
-			.Font(this, &SStrategyButtonWidget::GetTextFont)
+			.Font(GetTextFont())
 			.Text(CenterText)
 		]
 		+SOverlay::Slot()
@@ -153,22 +153,40 @@ void SStrategyButtonWidget::SetImage(UTexture2D* Texture)
 		ButtonImage = FDeferredCleanupSlateBrush::CreateBrush(Texture, FVector2D(Texture->GetSizeX(), Texture->GetSizeY()));
 		AlphaMap.Reset();
 		AlphaMap = FStrategyHelpers::CreateAlphaMapFromTexture(Texture);
+		Invalidate(EInvalidateWidgetReason::Layout);
+	}
+}
+
+void SStrategyButtonWidget::UpdateState(bool& bState, bool bNewState)
+{
+	if (bState != bNewState)
+	{
+		bState = bNewState;
+		Invalidate(EInvalidateWidgetReason::Paint);
 	}
 }
 
 void SStrategyButtonWidget::SetActionAllowed(bool bEnabled)
 {
-	bIsActionAllowed = bEnabled;
+	UpdateState(bIsActionAllowed, bEnabled);
 }
 
 void SStrategyButtonWidget::SetActionActive(bool bIsActive)
 {
-	bIsActiveAction = bIsActive;
+	UpdateState(bIsActiveAction, bIsActive);
 }
 
 void SStrategyButtonWidget::SetUserActionRequired(bool bIsWaitingForUser)
 {
-	bIsUserActionRequired = bIsWaitingForUser;
+	UpdateState(bIsUserActionRequired, bIsWaitingForUser);
+}
+
+void SStrategyButtonWidget::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
+{
+	SCompoundWidget::Tick(AllottedGeometry, InCurrentTime, InDeltaTime);
+
+	// fading and pulsing buttons are redrawn every frame, switching back invalidates the cache once more
+	ForceVolatile(WidgetAnimation.IsPlaying() || bIsUserActionRequired);
 }
 
 
@@ -209,7 +227,7 @@ FSlateColor SStrategyButtonWidget::GetTintColor() const
 
 FReply SStrategyButtonWidget::OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
 {
-	bIsMouseButtonDown = true;
+	UpdateState(bIsMouseButtonDown, true);
 	return FReply::Handled();
 }
 
@@ -231,7 +249,7 @@ void SStrategyButtonWidget::OnMouseEnter(const FGeometry& MyGeometry, const FPoi
 
 void SStrategyButtonWidget::OnMouseLeave(const FPointerEvent& MouseEvent)
 {
-	bIsMouseButtonDown = false;
+	UpdateState(bIsMouseButtonDown, false);
 	OnMouseLeaveDel.ExecuteIfBound(MouseEvent);
 }
 
@@ -245,7 +263,7 @@ FReply SStrategyButtonWidget::OnMouseButtonUp(const FGeometry& MyGeometry, const
 {
 	if (bIsMouseButtonDown)
 	{
-		bIsMouseButtonDown = false;
+		UpdateState(bIsMouseButtonDown, false);
 		if (bIsActionAllowed)
 		{
 			//execute our "OnClicked" delegate, if we have one
@@ -274,6 +292,7 @@ FReply SStrategyButtonWidget::OnTouchForceChanged(const FGeometry& MyGeometry, c
 
 void SStrategyButtonWidget::DeferredShow()
 {
+	ForceVolatile(true);
 	if (WidgetAnimation.IsAtStart() && !WidgetAnimation.IsPlaying())
 	{
 		WidgetAnimation.Play(this->AsShared());
@@ -289,9 +308,11 @@ void SStrategyButtonWidget::DeferredHide(bool bInstant)
 	if (bInstant)
 	{
 		WidgetAnimation.JumpToStart();
+		Invalidate(EInvalidateWidgetReason::Paint);
 	}  
 	else
 	{
+		ForceVolatile(true);
 		if (WidgetAnimation.IsAtEnd() && !WidgetAnimation.IsPlaying())
 		{
 			WidgetAnimation.PlayReverse(this->AsShared());
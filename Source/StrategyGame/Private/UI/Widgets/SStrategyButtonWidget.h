@@ -71,6 +71,8 @@ public:
 	virtual void OnMouseLeave(const FPointerEvent& MouseEvent) override;
 	virtual FReply OnTouchForceChanged(const FGeometry& MyGeometry, const FPointerEvent& TouchEvent);
 	virtual FCursorReply OnCursorQuery( const FGeometry& MyGeometry, const FPointerEvent& CursorEvent ) const override;
+	/** keeps the button volatile only while it animates, it's painted from the HUD cache otherwise */
+	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
 
 	void SetImage(UTexture2D* Texture);
 	void SetActionAllowed(bool bIsAllowed);
@@ -95,6 +97,9 @@ protected:
 	/** the delegate to execute when mouse leave active button area */
 	FOnMouseLeave OnMouseLeaveDel;
 
+	/** repaints the button after its state changed */
+	void UpdateState(bool& bState, bool bNewState);
+
 	const FSlateBrush* GetButtonImage() const;
 	FSlateColor GetTintColor() const;
 	FSlateColor GetImageColor() const;
@@ -10,6 +10,7 @@
 #include "StrategyCheatManager.h"
 
 #include "Engine/Console.h"
+#include "Widgets/SInvalidationPanel.h"
 
 
 void SStrategySlateHUDWidget::Construct(const FArguments& InArgs)
@@ -18,10 +19,10 @@ void SStrategySlateHUDWidget::Construct(const FArguments& InArgs)
 
 	OwnerHUD = InArgs._OwnerHUD;
 	bIsPauseMenuActive = false;
+	bConsoleVisible = false;
 	PauseMenuButtons.AddZeroed((SupportsQuitButton ? 3 : 2));
-	Visibility.Bind(this, &SStrategySlateHUDWidget::GetSlateVisibility);
-	UIScale.Bind(this, &SStrategySlateHUDWidget::GetUIScale);
 	MiniMapBorderMargin = 20;
+	CachedSecondsRemaining = -1;
 
 	TSharedPtr<SVerticalBox> MenuBox;
 	int32 ButtonIndex = 0;
@@ -29,8 +30,8 @@ void SStrategySlateHUDWidget::Construct(const FArguments& InArgs)
 	.VAlign(VAlign_Fill)
 	.HAlign(HAlign_Fill)
 	[
-		SNew(SDPIScaler)
-		.DPIScale(UIScale)
+		SAssignNew(DPIScaler, SDPIScaler)
+		.DPIScale(GetUIScale())
 		[
 
 			SNew(SOverlay)
@@ -56,147 +57,150 @@ void SStrategySlateHUDWidget::Construct(const FArguments& InArgs)
 				.BorderImage(&HUDStyle->MinimapFrameBrush)
 				.Padding(FMargin(0))
 				[
-					SNew(SBox)
+					SAssignNew(MiniMapBox, SBox)
 					.Padding(FMargin(MiniMapBorderMargin,MiniMapBorderMargin))
-					.WidthOverride(this,&SStrategySlateHUDWidget::GetMiniMapWidth)
-					.HeightOverride(this,&SStrategySlateHUDWidget::GetMiniMapHeight)
+					.WidthOverride(0.0f)
+					.HeightOverride(0.0f)
 					[
 						SAssignNew(MiniMapWidget,SStrategyMiniMapWidget)
 						.OwnerHUD(OwnerHUD)
 					]
 				]
 			]
+			// everything below only changes when the game pushes an update, it's painted from cache otherwise
 			+SOverlay::Slot()
-			.VAlign(VAlign_Top)
-			.HAlign(HAlign_Center)
+			.VAlign(VAlign_Fill)
+			.HAlign(HAlign_Fill)
 			[
-				SNew(SBorder)
-				.BorderImage(&HUDStyle->ResourcesBackgroundBrush)
-				.Padding(FMargin(30.0f,10.0f))
+				SNew(SInvalidationPanel)
 				[
-					SNew(SBox)
+					SNew(SOverlay)
+					+SOverlay::Slot()
+					.VAlign(VAlign_Top)
 					.HAlign(HAlign_Center)
-					.VAlign(VAlign_Center)
-					.WidthOverride(200)
-					.HeightOverride(60)
 					[
-						SNew(SHorizontalBox)
-						.Visibility(this, &SStrategySlateHUDWidget::GetResourcesVisibility)
-						+SHorizontalBox::Slot()
-						.AutoWidth()
-						[
-							SNew(STextBlock)
-							.TextStyle(FStrategyStyle::Get(), "StrategyGame.ResourcesTextStyle")
-							.Text(this, &SStrategySlateHUDWidget::GetResourcesAmount)
-						]
-						+SHorizontalBox::Slot()
-						.AutoWidth()
+						SNew(SBorder)
+						.BorderImage(&HUDStyle->ResourcesBackgroundBrush)
+						.Padding(FMargin(30.0f,10.0f))
 						[
-							SNew(SVerticalBox)
-							+SVerticalBox::Slot()
-							.VAlign(EVerticalAlignment::VAlign_Center)
+							SNew(SBox)
+							.HAlign(HAlign_Center)
+							.VAlign(VAlign_Center)
+							.WidthOverride(200)
+							.HeightOverride(60)
 							[
-								SNew(SBox)
-								.WidthOverride(48)
-								.HeightOverride(48)
+								SAssignNew(ResourcesPanel, SHorizontalBox)
+								.Visibility(EVisibility::Collapsed)
+								+SHorizontalBox::Slot()
+								.AutoWidth()
+								[
+									SAssignNew(ResourcesText, STextBlock)
+									.TextStyle(FStrategyStyle::Get(), "StrategyGame.ResourcesTextStyle")
+								]
+								+SHorizontalBox::Slot()
+								.AutoWidth()
 								[
-									SNew(SImage)
-									.Image(&HUDStyle->ResourcesImage)
+									SNew(SVerticalBox)
+									+SVerticalBox::Slot()
+									.VAlign(EVerticalAlignment::VAlign_Center)
+									[
+										SNew(SBox)
+										.WidthOverride(48)
+										.HeightOverride(48)
+										[
+											SNew(SImage)
+											.Image(&HUDStyle->ResourcesImage)
+										]
+									]
 								]
 							]
 						]
 					]
-				]
-			]
-			+SOverlay::Slot()
-			.VAlign(VAlign_Top)
-			.HAlign(HAlign_Left)
-			[
-				SNew(STextBlock)
-				.TextStyle(FStrategyStyle::Get(), "StrategyGame.ResourcesTextStyle")
-				.Text(this, &SStrategySlateHUDWidget::GetGameTime)
-			]
-			/* Result screen { */
-			+SOverlay::Slot()
-			.VAlign(VAlign_Center)
-			.HAlign(HAlign_Center)
-			[
-				SNew(SOverlay)
-				+SOverlay::Slot()
-				.VAlign(VAlign_Center)
-				.HAlign(HAlign_Center)
-				[
-					SNew(SImage)
-					.Image(this, &SStrategySlateHUDWidget::GetGameResultImage)
-					.Visibility(this, &SStrategySlateHUDWidget::GetResultScreenVisibility)
-				]
-
-				+SOverlay::Slot()
-				.VAlign(VAlign_Bottom)
-				.HAlign(HAlign_Center)
-				[
-					SNew(SBox)
-					.HAlign(HAlign_Center)
-					.VAlign(VAlign_Center)
-					.WidthOverride(675)
-					.HeightOverride(310)
+					+SOverlay::Slot()
+					.VAlign(VAlign_Top)
+					.HAlign(HAlign_Left)
 					[
-						SNew(STextBlock)
-						.Visibility(this, &SStrategySlateHUDWidget::GetResultScreenVisibility)
-						.ShadowColorAndOpacity(FLinearColor::Black)
-						.ColorAndOpacity(this, &SStrategySlateHUDWidget::GetGameResultColor)
-						.ShadowOffset(FIntPoint(-1,1))
-						.Font(this, &SStrategySlateHUDWidget::GetGameResultFont)
-						.Text(this, &SStrategySlateHUDWidget::GetGameResultText)
+						SAssignNew(GameTimeText, STextBlock)
+						.TextStyle(FStrategyStyle::Get(), "StrategyGame.ResourcesTextStyle")
 					]
-				]
-			]
-
-			/* Result screen } */
-			+SOverlay::Slot() // pause menu background overlay
-			.VAlign(VAlign_Fill)
-			.HAlign(HAlign_Fill)
-			[
-				SNew(SBorder)
-				.Visibility(this, &SStrategySlateHUDWidget::GetPauseMenuBgVisibility)
-				.VAlign(VAlign_Fill)
-				.HAlign(HAlign_Fill)
-				.BorderImage(FCoreStyle::Get().GetBrush("BlackBrush"))
-				.BorderBackgroundColor(this, &SStrategySlateHUDWidget::GetOverlayColor)
-				[
-					SNew(SOverlay)
-					// Return to main
+					/* Result screen { */
 					+SOverlay::Slot()
 					.VAlign(VAlign_Center)
 					.HAlign(HAlign_Center)
 					[
-						SAssignNew(MenuBox, SVerticalBox)
-						+SVerticalBox::Slot()
+						SNew(SOverlay)
+						+SOverlay::Slot()
+						.VAlign(VAlign_Center)
+						.HAlign(HAlign_Center)
 						[
-							SAssignNew(PauseMenuButtons[ButtonIndex++], SStrategyButtonWidget)
-							.OwnerHUD(OwnerHUD)
-							.Visibility(EVisibility::Visible)
-							.TextFont(FStrategyStyle::Get().GetFontStyle(TEXT("StrategyGame.MenuFont")))
-							.TextVAlign(EVerticalAlignment::VAlign_Center)
-							.TextMargin(FMargin(0))
-							.ButtonText(NSLOCTEXT("SStrategySlateHUDWidget", "MainMenu", "Main Menu"))
-							.OnClicked(this, &SStrategySlateHUDWidget::OnReturnToMainMenu)
+							SAssignNew(GameResultImage, SImage)
+							.Visibility(EVisibility::Collapsed)
+						]
+
+						+SOverlay::Slot()
+						.VAlign(VAlign_Bottom)
+						.HAlign(HAlign_Center)
+						[
+							SNew(SBox)
+							.HAlign(HAlign_Center)
+							.VAlign(VAlign_Center)
+							.WidthOverride(675)
+							.HeightOverride(310)
+							[
+								SAssignNew(GameResultText, STextBlock)
+								.Visibility(EVisibility::Collapsed)
+								.ShadowColorAndOpacity(FLinearColor::Black)
+								.ShadowOffset(FIntPoint(-1,1))
+							]
 						]
 					]
+
+					/* Result screen } */
+					+SOverlay::Slot() // pause menu background overlay
+					.VAlign(VAlign_Fill)
+					.HAlign(HAlign_Fill)
+					[
+						SAssignNew(PauseMenuBackground, SBorder)
+						.Visibility(EVisibility::Collapsed)
+						.VAlign(VAlign_Fill)
+						.HAlign(HAlign_Fill)
+						.BorderImage(FCoreStyle::Get().GetBrush("BlackBrush"))
+						[
+							SNew(SOverlay)
+							// Return to main
+							+SOverlay::Slot()
+							.VAlign(VAlign_Center)
+							.HAlign(HAlign_Center)
+							[
+								SAssignNew(MenuBox, SVerticalBox)
+								+SVerticalBox::Slot()
+								[
+									SAssignNew(PauseMenuButtons[ButtonIndex++], SStrategyButtonWidget)
+									.OwnerHUD(OwnerHUD)
+									.Visibility(EVisibility::Visible)
+									.TextFont(FStrategyStyle::Get().GetFontStyle(TEXT("StrategyGame.MenuFont")))
+									.TextVAlign(EVerticalAlignment::VAlign_Center)
+									.TextMargin(FMargin(0))
+									.ButtonText(NSLOCTEXT("SStrategySlateHUDWidget", "MainMenu", "Main Menu"))
+									.OnClicked(this, &SStrategySlateHUDWidget::OnReturnToMainMenu)
+								]
+							]
 					
+						]
+					]
+					+SOverlay::Slot()
+					.VAlign(VAlign_Bottom)
+					.HAlign(HAlign_Right)
+					.Padding(FMargin(0,0,20,20))
+					[
+						SAssignNew(PauseButton,SStrategyButtonWidget)
+						.OwnerHUD(OwnerHUD)
+						.Visibility(EVisibility::Visible)
+						.OnClicked(this, &SStrategySlateHUDWidget::TogglePauseMenu)
+						.ButtonText(FText::GetEmpty())
+					]
 				]
 			]
-			+SOverlay::Slot()
-			.VAlign(VAlign_Bottom)
-			.HAlign(HAlign_Right)
-			.Padding(FMargin(0,0,20,20))
-			[
-				SAssignNew(PauseButton,SStrategyButtonWidget)
-				.OwnerHUD(OwnerHUD)
-				.Visibility(EVisibility::Visible)
-				.OnClicked(this, &SStrategySlateHUDWidget::TogglePauseMenu)
-				.ButtonText(FText::GetEmpty())
-			]
 		]
 	];
 
@@ -229,6 +233,30 @@ void SStrategySlateHUDWidget::Construct(const FArguments& InArgs)
 			.OnClicked(this, &SStrategySlateHUDWidget::OnExitGame)
 		];
 	}
+
+	// everything below changes rarely, so the game pushes it instead of the HUD polling it every frame
+	ViewportResizedHandle = FViewport::ViewportResizedEvent.AddSP(this, &SStrategySlateHUDWidget::OnViewportResized);
+
+	GameState = OwnerHUD.IsValid() ? OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>() : nullptr;
+	if (GameState.IsValid())
+	{
+		GameplayEventHandle = GameState->GetEventBus().Subscribe(
+			EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::GameplayStateChanged) | EStrategyGameplayEvent::Mask(EStrategyGameplayEvent::ResourcesChanged),
+			EStrategyTeam::AllMask, FOnStrategyGameplayEvent::CreateSP(this, &SStrategySlateHUDWidget::OnGameplayEvent));
+
+		RefreshMiniMapSize();
+		RefreshGameplayState();
+		RefreshResources();
+	}
+}
+
+SStrategySlateHUDWidget::~SStrategySlateHUDWidget()
+{
+	FViewport::ViewportResizedEvent.Remove(ViewportResizedHandle);
+	if (GameState.IsValid())
+	{
+		GameState->GetEventBus().Unsubscribe(GameplayEventHandle);
+	}
 }
 
 FSlateColor SStrategySlateHUDWidget::GetOverlayColor() const
@@ -274,6 +302,7 @@ void SStrategySlateHUDWidget::Tick( const FGeometry& AllottedGeometry, const dou
 		if (!bConsoleVisible)
 		{
 			bConsoleVisible = true;
+			SetVisibility(EVisibility::HitTestInvisible);
 			FSlateApplication::Get().SetAllUserFocusToGameViewport();
 		}
 	}
@@ -282,136 +311,151 @@ void SStrategySlateHUDWidget::Tick( const FGeometry& AllottedGeometry, const dou
 		if (bConsoleVisible)
 		{
 			bConsoleVisible = false;
+			SetVisibility(EVisibility::Visible);
 			FSlateApplication::Get().SetKeyboardFocus(SharedThis(this));
 		}
 	}
 }
 
-EVisibility SStrategySlateHUDWidget::GetSlateVisibility() const
+void SStrategySlateHUDWidget::OnViewportResized(FViewport* Viewport, uint32 Unused)
 {
-	return bConsoleVisible ? EVisibility::HitTestInvisible : EVisibility::Visible;
+	DPIScaler->SetDPIScale(GetUIScale());
 }
 
-FOptionalSize SStrategySlateHUDWidget::GetMiniMapWidth() const
+void SStrategySlateHUDWidget::OnGameplayEvent(const FStrategyGameplayEvent& Event)
 {
-	float Result = 0.0f;
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	if (MyGameState && MyGameState->MiniMapCamera.IsValid())
+	if (Event.Type == EStrategyGameplayEvent::GameplayStateChanged)
 	{
-		Result = MyGameState->MiniMapCamera->MiniMapWidth;
+		RefreshMiniMapSize();
+		RefreshGameplayState();
+	}
+	else if (Event.Type == EStrategyGameplayEvent::ResourcesChanged)
+	{
+		RefreshResources();
 	}
-	return Result;
 }
 
-FOptionalSize SStrategySlateHUDWidget::GetMiniMapHeight() const
+void SStrategySlateHUDWidget::RefreshMiniMapSize()
 {
-	float Result = 0.0f;
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	if (MyGameState && MyGameState->MiniMapCamera.IsValid())
+	if (GameState.IsValid() && GameState->MiniMapCamera.IsValid())
 	{
-		Result = MyGameState->MiniMapCamera->MiniMapHeight;
+		MiniMapBox->SetWidthOverride(GameState->MiniMapCamera->MiniMapWidth);
+		MiniMapBox->SetHeightOverride(GameState->MiniMapCamera->MiniMapHeight);
 	}
-	return Result;
 }
 
-FCursorReply SStrategySlateHUDWidget::OnCursorQuery( const FGeometry& MyGeometry, const FPointerEvent& CursorEvent ) const
+void SStrategySlateHUDWidget::RefreshGameplayState()
 {
-	return FCursorReply::Cursor(EMouseCursor::Default);
-}
+	AStrategyGameState const* const MyGameState = GameState.Get();
+	if (MyGameState == NULL)
+	{
+		return;
+	}
 
-FText SStrategySlateHUDWidget::GetResourcesAmount() const
-{
-	const AStrategyPlayerController* const PC = Cast<AStrategyPlayerController>(OwnerHUD->PlayerOwner);
-	AStrategyGameState* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	if (MyGameState && PC)
+	ResourcesPanel->SetVisibility(MyGameState->IsGameActive() ? EVisibility::Visible : EVisibility::Collapsed);
+	if (MyGameState->GameplayState == EGameplayState::Waiting)
 	{
-		FPlayerData* const PlayerData = MyGameState->GetPlayerData(PC->GetTeamNum());
-		if (PlayerData)
+		if (!CountdownTimer.IsValid())
 		{
-			return FText::AsNumber(PlayerData->ResourcesAvailable);
+			CountdownTimer = RegisterActiveTimer(0.1f, FWidgetActiveTimerDelegate::CreateSP(this, &SStrategySlateHUDWidget::UpdateCountdown));
 		}
 	}
-	return FText::GetEmpty();
-}
+	else
+	{
+		CachedSecondsRemaining = -1;
+		GameTimeText->SetText(FText::GetEmpty());
+	}
 
-FText SStrategySlateHUDWidget::GetGameTime() const
-{
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	if (MyGameState != NULL)
+	if (MyGameState->GameplayState == EGameplayState::Finished)
 	{
-		if (MyGameState->GameplayState == EGameplayState::Waiting)
+		const bool bVictory = MyGameState->GetWinningTeam() == EStrategyTeam::Player;
+		GameResultImage->SetImage(bVictory ? &HUDStyle->VictoryImage : &HUDStyle->DefeatImage);
+		GameResultImage->SetVisibility(EVisibility::Visible);
+		GameResultText->SetText(bVictory ? NSLOCTEXT("GameFlow", "GameWon", "VICTORY") : NSLOCTEXT("GameFlow", "GameLost", "DEFEAT"));
+		GameResultText->SetColorAndOpacity(bVictory ? HUDStyle->VictoryTextColor : HUDStyle->DefeatTextColor);
+		GameResultText->SetFont(GetGameResultFont());
+		GameResultText->SetVisibility(EVisibility::Visible);
+		if (!GameResultTimer.IsValid())
 		{
-			int32 const DisplaySecondsRemaining = FMath::CeilToInt(MyGameState->GetRemainingWaitTime());
-			return FText::Format( NSLOCTEXT("GameFlow", "GameStartsIn", "Game starts in {0}"), FText::AsNumber(DisplaySecondsRemaining) );
+			GameResultTimer = RegisterActiveTimer(0.0f, FWidgetActiveTimerDelegate::CreateSP(this, &SStrategySlateHUDWidget::UpdateGameResultFont));
 		}
 	}
-	return FText::GetEmpty();
 }
 
-FSlateFontInfo SStrategySlateHUDWidget::GetGameResultFont() const
+void SStrategySlateHUDWidget::RefreshResources()
 {
-	FSlateFontInfo ResultFont;
-	const float AnimTime = 1.0f;
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	const float GameFinishedTime = MyGameState ? MyGameState->GetGameFinishedTime() : 0.0f;
-	float AnimPercentage = FMath::Min(1.0f, (OwnerHUD->GetWorld()->GetRealTimeSeconds() - GameFinishedTime) / AnimTime);
-	if (GameFinishedTime > 0)
-	{
-		const int32 StartFontSize = 8;
-		const int32 AnimatedFontSize = 70;
-		ResultFont = FSlateFontInfo( FPaths::ProjectContentDir() / TEXT("Slate/Fonts/Roboto-Regular.ttf"), FMath::TruncToInt(StartFontSize + AnimatedFontSize * AnimPercentage));
-	}
-	else
+	const AStrategyPlayerController* const PC = OwnerHUD.IsValid() ? Cast<AStrategyPlayerController>(OwnerHUD->PlayerOwner) : NULL;
+	const FPlayerData* const PlayerData = (PC && GameState.IsValid()) ? GameState->GetPlayerData(PC->GetTeamNum()) : NULL;
+	if (PlayerData)
 	{
-		ResultFont = FCoreStyle::Get().GetFontStyle(TEXT("NormalFont"));
+		ResourcesText->SetText(FText::AsNumber(PlayerData->ResourcesAvailable));
 	}
-	return ResultFont;
 }
 
-FSlateColor SStrategySlateHUDWidget::GetGameResultColor() const
+EActiveTimerReturnType SStrategySlateHUDWidget::UpdateCountdown(double InCurrentTime, float InDeltaTime)
 {
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	return (MyGameState && MyGameState->GetWinningTeam() == EStrategyTeam::Player) ? HUDStyle->VictoryTextColor : HUDStyle->DefeatTextColor;
+	AStrategyGameState const* const MyGameState = GameState.Get();
+	if (MyGameState == NULL || MyGameState->GameplayState != EGameplayState::Waiting)
+	{
+		return EActiveTimerReturnType::Stop;
+	}
+
+	const int32 DisplaySecondsRemaining = FMath::CeilToInt(MyGameState->GetRemainingWaitTime());
+	if (DisplaySecondsRemaining != CachedSecondsRemaining)
+	{
+		CachedSecondsRemaining = DisplaySecondsRemaining;
+		GameTimeText->SetText(FText::Format(NSLOCTEXT("GameFlow", "GameStartsIn", "Game starts in {0}"), FText::AsNumber(DisplaySecondsRemaining)));
+	}
+	return EActiveTimerReturnType::Continue;
 }
 
-FText SStrategySlateHUDWidget::GetGameResultText() const
+EActiveTimerReturnType SStrategySlateHUDWidget::UpdateGameResultFont(double InCurrentTime, float InDeltaTime)
 {
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	if (MyGameState != NULL)
+	AStrategyGameState const* const MyGameState = GameState.Get();
+	if (MyGameState == NULL || !OwnerHUD.IsValid())
 	{
-		return MyGameState->GetWinningTeam() == EStrategyTeam::Player ? NSLOCTEXT("GameFlow", "GameWon", "VICTORY") : NSLOCTEXT("GameFlow", "GameLost", "DEFEAT");
+		return EActiveTimerReturnType::Stop;
 	}
-	return FText::GetEmpty();
+
+	const float AnimTime = 1.0f;
+	GameResultText->SetFont(GetGameResultFont());
+	return OwnerHUD->GetWorld()->GetRealTimeSeconds() - MyGameState->GetGameFinishedTime() < AnimTime ? EActiveTimerReturnType::Continue : EActiveTimerReturnType::Stop;
 }
 
-const FSlateBrush* SStrategySlateHUDWidget::GetGameResultImage() const
+EActiveTimerReturnType SStrategySlateHUDWidget::UpdateOverlayColor(double InCurrentTime, float InDeltaTime)
 {
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	bool const bVictory = (MyGameState && MyGameState->GetWinningTeam() == EStrategyTeam::Player);
-	return bVictory ?  &HUDStyle->VictoryImage : &HUDStyle->DefeatImage;
+	if (!bIsPauseMenuActive || !OwnerHUD.IsValid())
+	{
+		return EActiveTimerReturnType::Stop;
+	}
+
+	PauseMenuBackground->SetBorderBackgroundColor(GetOverlayColor());
+	return EActiveTimerReturnType::Continue;
 }
 
-EVisibility SStrategySlateHUDWidget::GetResourcesVisibility() const
+FCursorReply SStrategySlateHUDWidget::OnCursorQuery( const FGeometry& MyGeometry, const FPointerEvent& CursorEvent ) const
 {
-	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	return MyGameState && MyGameState->IsGameActive() ? EVisibility::Visible : EVisibility::Collapsed;
+	return FCursorReply::Cursor(EMouseCursor::Default);
 }
 
-EVisibility SStrategySlateHUDWidget::GetResultScreenVisibility() const
+FSlateFontInfo SStrategySlateHUDWidget::GetGameResultFont() const
 {
-	EVisibility ResultVisibility = EVisibility::Collapsed;
+	FSlateFontInfo ResultFont;
+	const float AnimTime = 1.0f;
 	AStrategyGameState const* const MyGameState = OwnerHUD->GetWorld()->GetGameState<AStrategyGameState>();
-	if ( MyGameState && (MyGameState->GameplayState == EGameplayState::Finished) )
+	const float GameFinishedTime = MyGameState ? MyGameState->GetGameFinishedTime() : 0.0f;
+	float AnimPercentage = FMath::Min(1.0f, (OwnerHUD->GetWorld()->GetRealTimeSeconds() - GameFinishedTime) / AnimTime);
+	if (GameFinishedTime > 0)
+	{
+		const int32 StartFontSize = 8;
+		const int32 AnimatedFontSize = 70;
+		ResultFont = FSlateFontInfo( FPaths::ProjectContentDir() / TEXT("Slate/Fonts/Roboto-Regular.ttf"), FMath::TruncToInt(StartFontSize + AnimatedFontSize * AnimPercentage));
+	}
+	else
 	{
-		ResultVisibility = EVisibility::Visible;
+		ResultFont = FCoreStyle::Get().GetFontStyle(TEXT("NormalFont"));
 	}
-
-	return ResultVisibility;
-}
-
-EVisibility SStrategySlateHUDWidget::GetPauseMenuBgVisibility() const
-{
-	return bIsPauseMenuActive ? EVisibility::Visible : EVisibility::Collapsed;
+	return ResultFont;
 }
 
 FVector2D SStrategySlateHUDWidget::GetActionsWidgetPos() const
@@ -427,6 +471,11 @@ FReply SStrategySlateHUDWidget::TogglePauseMenu()
 		const FStrategyHUDSoundsStyle& HUDSounds = FStrategyStyle::Get().GetWidgetStyle<FStrategyHUDSoundsStyle>("DefaultStrategyHUDSoundsStyle");
 		FSlateApplication::Get().PlaySound(HUDSounds.MenuItemChangeSound);
 		bIsPauseMenuActive = !bIsPauseMenuActive;
+		PauseMenuBackground->SetVisibility(bIsPauseMenuActive ? EVisibility::Visible : EVisibility::Collapsed);
+		if (bIsPauseMenuActive)
+		{
+			PauseMenuBackground->SetBorderBackgroundColor(GetOverlayColor());
+		}
 		//Do not trigger pause when game is already finished
 		if (MyGameState->GameplayState != EGameplayState::Finished)
 		{
@@ -466,6 +515,12 @@ FReply SStrategySlateHUDWidget::OnExitGame()
 	}
 	const FStrategyHUDSoundsStyle& HUDSounds = FStrategyStyle::Get().GetWidgetStyle<FStrategyHUDSoundsStyle>("DefaultStrategyHUDSoundsStyle");
 	ExitGameTimerHandle = MenuHelper::PlaySoundAndCallSP(OwnerHUD->PlayerOwner->GetWorld(), HUDSounds.ExitGameSound, this, &SStrategySlateHUDWidget::ExitGame);
+
+	// fades to black while exiting
+	if (!OverlayTimer.IsValid())
+	{
+		OverlayTimer = RegisterActiveTimer(0.0f, FWidgetActiveTimerDelegate::CreateSP(this, &SStrategySlateHUDWidget::UpdateOverlayColor));
+	}
 	return FReply::Handled();
 }
 
@@ -493,6 +548,12 @@ FReply SStrategySlateHUDWidget::OnReturnToMainMenu()
 	}
 	const FStrategyHUDSoundsStyle& HUDSounds = FStrategyStyle::Get().GetWidgetStyle<FStrategyHUDSoundsStyle>("DefaultStrategyHUDSoundsStyle");
 	ReturnToMainMenuTimerHandle = MenuHelper::PlaySoundAndCallSP(OwnerHUD->PlayerOwner->GetWorld(), HUDSounds.ExitGameSound, this, &SStrategySlateHUDWidget::ReturnToMainMenu);
+
+	// fades to black while exiting
+	if (!OverlayTimer.IsValid())
+	{
+		OverlayTimer = RegisterActiveTimer(0.0f, FWidgetActiveTimerDelegate::CreateSP(this, &SStrategySlateHUDWidget::UpdateOverlayColor));
+	}
 	return FReply::Handled();
 }
 
@@ -7,6 +7,7 @@
 #include "SStrategyActionGrid.h"
 #include "SStrategyMiniMapWidget.h"
 #include "StrategyHUDWidgetStyle.h"
+#include "StrategyGameplayEvents.h"
 
 class SStrategyButtonWidget;
 class AStrategyHUD;
@@ -26,6 +27,9 @@ public:
 	/** Needed for every widget */
 	void Construct(const FArguments& InArgs);
 
+	/** stops listening to the game */
+	virtual ~SStrategySlateHUDWidget();
+
 	/** If we want to recieve mouse/keyboard events */
 	virtual bool SupportsKeyboardFocus() const override { return true; }
 
@@ -62,8 +66,29 @@ public:
 
 protected:
 
-	/** sets hit test invisibility when console is up */
-	EVisibility GetSlateVisibility() const;
+	/** gameplay state and resources changes, pushed into the HUD widgets */
+	void OnGameplayEvent(const FStrategyGameplayEvent& Event);
+
+	/** shows panels for current gameplay state and starts its animations */
+	void RefreshGameplayState();
+
+	/** sizes the box to the mini map */
+	void RefreshMiniMapSize();
+
+	/** shows resources of the player's team */
+	void RefreshResources();
+
+	/** rescales the HUD when game viewport changes size */
+	void OnViewportResized(FViewport* Viewport, uint32 Unused);
+
+	/** updates game start countdown while waiting */
+	EActiveTimerReturnType UpdateCountdown(double InCurrentTime, float InDeltaTime);
+
+	/** animates game result font until the animation is done */
+	EActiveTimerReturnType UpdateGameResultFont(double InCurrentTime, float InDeltaTime);
+
+	/** fades the pause menu overlay while exiting */
+	EActiveTimerReturnType UpdateOverlayColor(double InCurrentTime, float InDeltaTime);
 
 	/** gets current scale for drawing menu */
 	float GetUIScale() const;
@@ -86,41 +111,52 @@ protected:
 	/** returns to the main menu */
 	void ReturnToMainMenu() const;
 
-	/** should we display pause menu? */
-	EVisibility GetPauseMenuBgVisibility() const;
+	/** returns game result font (used for animation) */
+	FSlateFontInfo GetGameResultFont() const;
+
+	/** gets game menu overlay color and animates it */
+	FSlateColor GetOverlayColor() const;
 
-	/** should we display resource amount? */
-	EVisibility GetResourcesVisibility() const;
+	/** scales the whole HUD with viewport size */
+	TSharedPtr<SDPIScaler> DPIScaler;
 
-	/** should we display game results? */
-	EVisibility GetResultScreenVisibility() const;
+	/** box sized to the mini map */
+	TSharedPtr<SBox> MiniMapBox;
 
-	/** returns resources amount to display */
-	FText GetResourcesAmount() const;
+	/** resources panel, visible while the game is active */
+	TSharedPtr<SHorizontalBox> ResourcesPanel;
 
-	/** returns game timer information to display */
-	FText GetGameTime() const;
+	/** resources amount */
+	TSharedPtr<STextBlock> ResourcesText;
 
-	/** returns game result font (used for animation) */
-	FSlateFontInfo GetGameResultFont() const;
+	/** game start countdown */
+	TSharedPtr<STextBlock> GameTimeText;
 
-	/** returns game result string to display */
-	FText GetGameResultText() const;
+	/** win/lose logo */
+	TSharedPtr<SImage> GameResultImage;
 
-	/** returns game result text font color */
-	FSlateColor GetGameResultColor() const;
+	/** win/lose text */
+	TSharedPtr<STextBlock> GameResultText;
 
-	/** displays win/lose logo */
-	const FSlateBrush* GetGameResultImage() const;
+	/** pause menu background overlay */
+	TSharedPtr<SBorder> PauseMenuBackground;
 
-	/** gets mini map width */
-	FOptionalSize GetMiniMapWidth() const;
+	/** last countdown pushed to the widgets */
+	int32 CachedSecondsRemaining;
 
-	/** gets mini map height */
-	FOptionalSize GetMiniMapHeight() const;
+	/** game state whose events are shown */
+	TWeakObjectPtr<AStrategyGameState> GameState;
 
-	/** gets game menu overlay color and animates it */
-	FSlateColor GetOverlayColor() const;
+	/** subscription to gameplay state and resources changes */
+	FDelegateHandle GameplayEventHandle;
+
+	/** subscription to viewport size changes */
+	FDelegateHandle ViewportResizedHandle;
+
+	/** timers running while something animates */
+	TWeakPtr<FActiveTimerHandle> CountdownTimer;
+	TWeakPtr<FActiveTimerHandle> GameResultTimer;
+	TWeakPtr<FActiveTimerHandle> OverlayTimer;
 
 	/** is pause menu active? */
 	bool bIsPauseMenuActive;
@@ -128,9 +164,6 @@ protected:
 	/** margin for border */
 	float MiniMapBorderMargin;
 
-	/** current UI scale attribute */
-	TAttribute<float> UIScale;
-
 	/** if console is currently opened */
 	bool bConsoleVisible;
 
@@ -4,9 +4,10 @@
 #include "ZombieCharacter.h"
 
 #include "StrategyAIController.h"
+#include "StrategyCharMovement.h"
 
 AZombieCharacter::AZombieCharacter(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UStrategyCharMovement>(ACharacter::CharacterMovementComponentName))
 {
 	// no collisions in mesh
 	GetMesh()->BodyInstance.SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -2,40 +2,93 @@
 #pragma once
 
 
+#include "StrategyEntities.h"
 #include "StrategyAIAction.generated.h"
 
 class AStrategyAIController;
 
+/** State of the running action, kept inline in the controller. Reset when action activates. */
+struct FStrategyAIActionState
+{
+	/** entity to attack */
+	FStrategyEntityHandle Target;
+
+	/** destination we are moving to */
+	FVector Destination;
+
+	/** time when we will finish playing melee animation */
+	float MeleeAttackAnimationEndTime;
+
+	/** last time without movement */
+	float NotMovingFromTime;
+
+	/**	Tells us if we are already executed. */
+	uint32 bIsExecuted : 1;
+
+	/** set to true when we are moving to our destination */
+	uint32 bIsMoving : 1;
+
+	/** if pawn is playing attack animation */
+	uint32 bIsPlayingAnimation : 1;
+
+	/** set to true when we hold slot around the target, Destination is its location then */
+	uint32 bHasSlot : 1;
+
+	/** set to true when we stand on a queue slot out of reach, waiting for a closer one */
+	uint32 bWaitingForSlot : 1;
+
+	FStrategyAIActionState()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		Target = FStrategyEntityHandle();
+		Destination = FVector::ZeroVector;
+		MeleeAttackAnimationEndTime = 0.0f;
+		NotMovingFromTime = 0.0f;
+		bIsExecuted = false;
+		bIsMoving = false;
+		bIsPlayingAnimation = false;
+		bHasSlot = false;
+		bWaitingForSlot = false;
+	}
+};
+
+/**
+ * AI action logic. Actions are stateless, single shared instance (class default object) of each action class
+ * serves all controllers, which keep state of their running action in FStrategyAIActionState.
+ */
 UCLASS(abstract, BlueprintType)
 class UStrategyAIAction : public UObject
 {
 	GENERATED_UCLASS_BODY()
 
-	/** 
+	/**
 	 * Update this action.
 	 * @return false to finish this action, true to continue
 	 */
-	virtual bool Tick(float DeltaTime);
+	virtual bool Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const;
 
 	/** Activate action. */
-	virtual void Activate();
+	virtual void Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
 	/** Should we activate action this time ? */
-	virtual bool ShouldActivate() const;
+	virtual bool ShouldActivate(AStrategyAIController* Controller) const;
 
 	/** Abort action to start something else. */
-	virtual void Abort();
+	virtual void Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
 	/** Can we abort this action? */
-	virtual bool IsSafeToAbort() const;
+	virtual bool IsSafeToAbort(const FStrategyAIActionState& State) const;
 
-	/** Set owning AI controller. */
-	void SetController(AStrategyAIController* InOwner);
+	/** Notify about completing current move. */
+	virtual void OnMoveCompleted(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
-protected:
-	/** Weak pointer to AI controller, to have faster access (cached information). */
-	TWeakObjectPtr<AStrategyAIController>	MyAIController;
+	/** Pawn has hit something. */
+	virtual void NotifyBump(AStrategyAIController* Controller, FStrategyAIActionState& State, FHitResult const& Hit) const;
 
-	/**	Tells us if we are already executed. */
-	bool bIsExecuted;
+	/** @return shared instance of the action class */
+	static const UStrategyAIAction* GetShared(TSubclassOf<UStrategyAIAction> ActionClass);
 };
@@ -6,6 +6,8 @@
 #include "StrategyAIAction.h"
 #include "StrategyAIAction_AttackTarget.generated.h"
 
+class FStrategyAttackSlots;
+
 UCLASS()
 class UStrategyAIAction_AttackTarget : public UStrategyAIAction
 {
@@ -16,47 +18,44 @@ public:
 	// Begin StrategyAIAction interface
 
 	/** Update in time current action */
-	virtual bool Tick(float DeltaTime) override;
+	virtual bool Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const override;
 
 	/** activate action */
-	virtual void Activate() override;
+	virtual void Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** abort action to start something else */
-	virtual void Abort() override;
+	virtual void Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** can we abort this action? */
-	virtual bool IsSafeToAbort() const override;
+	virtual bool IsSafeToAbort(const FStrategyAIActionState& State) const override;
 
 	/** Should we activate action this time ? */
-	virtual bool ShouldActivate() const override;
+	virtual bool ShouldActivate(AStrategyAIController* Controller) const override;
 
-	// End StrategyAIAction interface
+	/** notify about completing current move */
+	virtual void OnMoveCompleted(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
-protected:
 	/** Pawn has hit something */
-	void NotifyBump(FHitResult const& Hit);
+	virtual void NotifyBump(AStrategyAIController* Controller, FStrategyAIActionState& State, FHitResult const& Hit) const override;
 
-	/** notify about completing current move */
-	void OnMoveCompleted();
+	// End StrategyAIAction interface
 
+protected:
 	/** move closer to target */
-	void MoveCloser();
+	void MoveCloser(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
 	/** updates any information about target, his location, target changes in ai controller, etc. */
-	void UpdateTargetInformation();
-
-	/** target actor to attack */
-	TWeakObjectPtr<AActor> TargetActor;
+	void UpdateTargetInformation(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
-	/** destination to move closer */
-	FVector	TargetDestination;
+	/** follows our slot when target moves */
+	void UpdateSlotMove(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
-	/** time when we will finish playing melee animation */
-	float MeleeAttackAnimationEndTime;
+	/** frees our slot around the target */
+	void ReleaseSlot(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
-	/** if pawn is playing attack animation */
-	uint32 bIsPlayingAnimation : 1;
+	/** @return attack slots of the match, null without strategy game state */
+	static FStrategyAttackSlots* GetAttackSlots(const AStrategyAIController* Controller);
 
-	/** set to true when we are moving to our target */
-	uint32 bMovingToTarget : 1;
+	/** @return actor of the target entity, null once it died or left play */
+	static AActor* GetTargetActor(const AStrategyAIController* Controller, const FStrategyAIActionState& State);
 };
@@ -19,38 +19,32 @@ public:
 	// Begin StrategyAIAction interface
 
 	/** Update in time current action */
-	virtual bool Tick(float DeltaTime) override;
+	virtual bool Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const override;
 
 	/** activate action */
-	virtual void Activate() override;
+	virtual void Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** abort action to start something else */
-	virtual void Abort() override;
+	virtual void Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** can we abort this action? */
-	virtual bool IsSafeToAbort() const override;
+	virtual bool IsSafeToAbort(const FStrategyAIActionState& State) const override;
 
 	/** Should we activate action this time ? */
-	virtual bool ShouldActivate() const override;
+	virtual bool ShouldActivate(AStrategyAIController* Controller) const override;
+
+	/** notify about completing current move */
+	virtual void OnMoveCompleted(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	// End StrategyAIAction interface
 
 protected:
 	/** Called from owning controller when given PathGenerator updated it's path. */
-	void OnPathUpdated(INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType);
+	void OnPathUpdated(AStrategyAIController* Controller, FStrategyAIActionState& State, INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType) const;
 
-	/** notify about completing current move */
-	void OnMoveCompleted();
+	/** @return location of enemy brewery, zero vector if there's none */
+	static FVector GetEnemyBreweryLocation(const AStrategyAIController* Controller);
 
 	/** Acceptable distance to target destination */
 	float TargetAcceptanceRadius;
-
-	/** current destination we are moving to */
-	FVector	Destination;
-
-	/** tells if we stared moving to target */
-	uint8	bIsMoving : 1;
-
-	/** last time without movement */
-	float	NotMovingFromTime;
 };
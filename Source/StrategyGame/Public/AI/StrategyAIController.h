@@ -3,6 +3,8 @@
 
 #include "AIController.h"
 #include "StrategyTeamInterface.h"
+#include "StrategyEntities.h"
+#include "StrategyAIAction.h"
 #include "StrategyAIController.generated.h"
 
 
@@ -18,12 +20,8 @@ namespace EPathUpdate
 	};
 }
 
-DECLARE_DELEGATE_OneParam(FOnBumpEvent, FHitResult const&);
-DECLARE_DELEGATE(FOnMovementEvent);
-
 class APawn;
 class AActor;
-class UStrategyAIAction;
 class UStrategyAISensingComponent;
 
 UCLASS()
@@ -41,13 +39,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=AIController)
 	TArray<TSubclassOf<UStrategyAIAction> > AllowedActions;
 
-	/** List for all actions for this logic instance */
-	UPROPERTY()
-	TArray<UStrategyAIAction*> AllActions;
+	/** List for all actions for this logic instance, shared by all controllers */
+	TArray<const UStrategyAIAction*> AllActions;
 
 	/** Current, selected action to execute */
-	UPROPERTY()
-	UStrategyAIAction* CurrentAction;
+	const UStrategyAIAction* CurrentAction;
+
+	/** State of current action */
+	FStrategyAIActionState ActionState;
 
 	/** List of all possible targets for us */
 	UPROPERTY()
@@ -61,6 +60,9 @@ public:
 	// Begin AActor Interface
 	virtual void Tick(float DeltaTime) override;
 
+	/** adds action and claim arrays to the memory size */
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 #if ENABLE_VISUAL_LOG
 	/** Display additional data in visual logger */
 	virtual void GrabDebugSnapshot(struct FVisualLogEntry* Snapshot) const override;
@@ -86,7 +88,10 @@ public:
 	bool IsActionAllowed(TSubclassOf<UStrategyAIAction> inClass) const;
 
 	/** Return instance of action we are allowed to use */
-	UStrategyAIAction* GetInstanceOfAction(TSubclassOf<UStrategyAIAction> inClass) const;
+	const UStrategyAIAction* GetInstanceOfAction(TSubclassOf<UStrategyAIAction> inClass) const;
+
+	/** Aborts current action and starts the new one */
+	void ActivateAction(const UStrategyAIAction* NewAction);
 
 	/** pawn has hit something */
 	void NotifyBump(FHitResult const& Hit);
@@ -104,44 +109,56 @@ public:
 	bool IsTargetValid(AActor* InActor) const;
 
 	/** Claim controller as target */
-	void ClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController);
+	void ClaimAsTarget(const AStrategyAIController* InController);
 
 	/** UnClaim controller as target */
-	void UnClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController);
+	void UnClaimAsTarget(const AStrategyAIController* InController);
 
 	/** Check if desired controller claimed this one */
-	bool IsClaimedBy(TWeakObjectPtr<AStrategyAIController> InController) const;
+	bool IsClaimedBy(const AStrategyAIController* InController) const;
 
 	/** get number of enemies who claimed this one as target */
 	int32 GetNumberOfAttackers() const;
 
-	/** register movement related notify, to get notify about completed movement */
-	void RegisterMovementEventDelegate(FOnMovementEvent);
-	/** unregister movement related notify*/
-	void UnregisterMovementEventDelegate();
-
-	/** register bump notify, to get notify when pawn bumps with something */
-	void RegisterBumpEventDelegate(FOnBumpEvent);
-	/** unregister bump notify */
-	void UnregisterBumpEventDelegate();
-
 	/** @return If this is a pawn return its location or the actor location */
 	virtual FVector GetAdjustLocation();
 
+	/**
+	 * Moves to location with path found in the background by the match path service, falls back to MoveToLocation without it.
+	 *
+	 * @param	Dest				Location to move to.
+	 * @param	AcceptanceRadius	Distance from destination the move is finished at.
+	 * @param	bStopOnOverlap		Whether pawn radius counts to the acceptance radius.
+	 * @param	bCacheCorridor		Whether the path is worth sharing with later units, for long lived destinations.
+	 */
+	void MoveToLocationAsync(const FVector& Dest, float AcceptanceRadius, bool bStopOnOverlap, bool bCacheCorridor);
+
+	/**
+	 * Moves to actor with path found in the background by the match path service, falls back to MoveToActor without it.
+	 *
+	 * @param	Goal				Actor to move to, followed as it moves.
+	 * @param	AcceptanceRadius	Distance from the actor the move is finished at.
+	 * @param	bStopOnOverlap		Whether pawn radius counts to the acceptance radius.
+	 */
+	void MoveToActorAsync(AActor* Goal, float AcceptanceRadius, bool bStopOnOverlap);
+
+	/** Drops move waiting for its path. */
+	void CancelAsyncMove();
+
+	/** @return true if we wait for a path from the path service */
+	bool HasPendingAsyncMove() const;
+
 
 protected:
 	/** Check targets list and select one as current target */
 	virtual void SelectTarget();
 
-protected:
-	/** array of controllers claimed this one as target */
-	TArray< TWeakObjectPtr<AStrategyAIController> > ClaimedBy;
-
-	/** Event delegate for when pawn movement is complete. */
-	FOnMovementEvent OnMoveCompletedDelegate;
+	/** @return path service of the match, null without strategy game state */
+	class FStrategyPathService* GetPathService() const;
 
-	/** Event delegate for when pawn has hit something. */
-	FOnBumpEvent OnNotifyBumpDelegate;
+protected:
+	/** entity handles of pawns whose controllers claimed this one as target */
+	TArray<FStrategyEntityHandle> ClaimedBy;
 
 	/** master switch state */
 	uint8 bLogicEnabled : 1;
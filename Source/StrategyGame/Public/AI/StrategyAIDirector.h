@@ -3,12 +3,55 @@
 #pragma once
 
 #include "StrategyTypes.h"
+#include "StrategyEntities.h"
+#include "StrategyWaveSchedule.h"
 #include "StrategyAIDirector.generated.h"
 
+class ABaseCharacter;
 class AStrategyBuilding_Brewery;
 class AStrategyChar;
 class UStrategyAttachment;
 
+/** Unit waiting for ground trace before it's spawned */
+struct FStrategyUnitSpawn
+{
+	/** class of the unit */
+	TSubclassOf<ABaseCharacter> UnitClass;
+
+	/** buff given to minions */
+	FBuffData Buff;
+
+	/** weapon given to minions, can be null */
+	TSubclassOf<UStrategyAttachment> Weapon;
+
+	/** armor given to minions, can be null */
+	TSubclassOf<UStrategyAttachment> Armor;
+
+	/** scale of the unit */
+	float Scale;
+
+	/** animation rate of the unit */
+	float AnimationRate;
+
+	/** spawn location before ground is found */
+	FVector Location;
+
+	/** minion requested through WaveSize, counted down when spawned */
+	bool bRequestedMinion;
+
+	/** scheduled wave the unit belongs to, INDEX_NONE for other spawns */
+	int32 WaveIndex;
+
+	FStrategyUnitSpawn()
+		: Scale(1.0f)
+		, AnimationRate(1.0f)
+		, Location(FVector::ZeroVector)
+		, bRequestedMinion(false)
+		, WaveIndex(INDEX_NONE)
+	{
+	}
+};
+
 UCLASS()
 class UStrategyAIDirector : public UActorComponent
 {
@@ -28,6 +71,12 @@ class UStrategyAIDirector : public UActorComponent
 	UFUNCTION(BlueprintCallable, Category=Pawn)
 	void SetDefaultWeaponClass(TSubclassOf<UStrategyAttachment> InWeapon);
 
+	/** @return default armor for spawns */
+	TSubclassOf<UStrategyAttachment> GetDefaultArmorClass() const { return DefaultArmor; }
+
+	/** @return default weapon for spawns */
+	TSubclassOf<UStrategyAttachment> GetDefaultWeaponClass() const { return DefaultWeapon; }
+
 	/** set default buff modifier for spawns */
 	UFUNCTION(BlueprintCallable, Category=Pawn, meta=(DisplayName = "Set Unit Properties"))
 	void SetBuffModifier(AStrategyChar* Pawn, int32 AttackMin, int32 AttackMax, int32 DamageReduction, int32 MaxHealthBonus, int32 HealthRegen, float Speed, int32 DrunkLevel, float Duration, bool bInfiniteDuration, float CustomScale = 1.0, float AnimaRate = 1);
@@ -42,6 +91,10 @@ class UStrategyAIDirector : public UActorComponent
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=Minions)
 	float RadiusToSpawnOn;
 
+	/** waves to spawn instead of zombies, requested minions still spawn on top */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Minions)
+	UStrategyWaveSchedule* WaveSchedule;
+
 protected:
 	/** default armor for spawns */
 	UPROPERTY()
@@ -76,10 +129,52 @@ public:
 
 	/** request spawn from AI Director */
 	void RequestSpawn();
+
+	/**
+	 * Replaces the wave schedule and starts its first wave.
+	 *
+	 * @param	Schedule	Waves to spawn.
+	 */
+	void StartWaveSchedule(UStrategyWaveSchedule* Schedule);
 protected:
 	/** check conditions and spawn minions if possible */
 	void SpawnDwarfs();
 
+	/** spawn units of scheduled wave due by now, within frame budget */
+	void SpawnScheduledWaves();
+
+	/** plan scheduled wave and set its start time */
+	void StartScheduledWave(int32 WaveIndex);
+
+	/**
+	 * Looks for ground in front of the brewery, the unit is spawned there when it's found.
+	 *
+	 * @param	Spawn	Unit to spawn.
+	 */
+	void SpawnUnit(const FStrategyUnitSpawn& Spawn);
+
+	/** spawns unit on the ground found and counts requested minions */
+	void OnSpawnGroundFound(const TArray<FHitResult>& Hits, FStrategyUnitSpawn Spawn);
+
+	/**
+	 * Spawns unit and sets it up.
+	 *
+	 * @param	Hits	Hits of the ground trace.
+	 * @param	Spawn	Unit to spawn.
+	 * @returns spawned unit, null if it failed or died right away.
+	 */
+	ABaseCharacter* FinishSpawnUnit(const TArray<FHitResult>& Hits, const FStrategyUnitSpawn& Spawn);
+
+	/** let the listeners know the whole wave is out */
+	void NotifyWaveSpawned();
+
+	/**
+	 * Counts down work left on scheduled wave, the wave is out when all of its spawns are done.
+	 *
+	 * @param	WaveIndex	Wave a spawn of which finished, or which was fully issued.
+	 */
+	void OnWaveSpawnDone(int32 WaveIndex);
+
 	/** Custom scale for spawns */
 	float CustomScale;
 
@@ -95,6 +190,23 @@ protected:
 	uint8 MyTeamNum;
 
 	/** Brewery of my biggest enemy */
-	TWeakObjectPtr<AStrategyBuilding_Brewery> EnemyBrewery;
+	FStrategyEntityHandle EnemyBrewery;
+
+	/** wave of the schedule being spawned, INDEX_NONE when the schedule ran out of units */
+	int32 ScheduledWave;
+
+	/** time first spawn of the scheduled wave is due */
+	float ScheduledWaveStartTime;
+
+	/** planned spawns of the scheduled wave */
+	TArray<FStrategyWaveSpawn> ScheduledSpawns;
+
+	/** next planned spawn */
+	int32 NextScheduledSpawn;
+
+	/** spawns still looking for ground by scheduled wave, plus one for the wave until all are issued */
+	TMap<int32, int32> WaveSpawnsInFlight;
+
+	friend class FStrategyMatchSnapshot;
 };
 
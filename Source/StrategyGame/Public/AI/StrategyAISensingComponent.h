@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Perception/PawnSensingComponent.h"
+#include "StrategyEntities.h"
 #include "StrategyAISensingComponent.generated.h"
 
 /**
@@ -15,9 +16,8 @@ class UStrategyAISensingComponent : public UPawnSensingComponent
 {
 	GENERATED_UCLASS_BODY()
 
-	/** list of known targets */
-	UPROPERTY()
-	TArray<TWeakObjectPtr<AActor> > KnownTargets;
+	/** list of known targets, stale handles are dropped on next update */
+	TArray<FStrategyEntityHandle> KnownTargets;
 
 	// Begin PawnSensingComponent interface
 
@@ -32,10 +32,16 @@ class UStrategyAISensingComponent : public UPawnSensingComponent
 	/** Are we capable of sensing anything (and do we have any callbacks that care about sensing)? If so, calls UpdateAISensing(). */
 	virtual bool CanSenseAnything() const;
 
+	/** Sight distance from config, applied to SightRadius on initialization. */
+	float GetSightDistance() const { return SightDistance; }
+
 	// Begin UActorComponent interface.
 	virtual void InitializeComponent() override;
 	// End UActorComponent interface.
 
+	/** adds known targets to the memory size */
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 protected:
 	UPROPERTY(config)
 	float SightDistance;
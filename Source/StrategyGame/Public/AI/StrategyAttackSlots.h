@@ -0,0 +1,74 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+/**
+ * Hands out positions on rings around attack targets, so attackers of one target spread around it
+ * instead of all walking to the same point. Slots are kept as offsets from the target and follow it
+ * when it moves. New attackers take the free spot closest to them, the others keep theirs. Rings are
+ * sized by the attack distance and capsule radius, attackers not fitting the inner ring wait on outer ones.
+ */
+class FStrategyAttackSlots
+{
+public:
+	/**
+	 * Gives attacker a slot around the target, keeps the current one if it has it already.
+	 *
+	 * @param	Target			Actor to attack.
+	 * @param	Attacker		Pawn attacking.
+	 * @param	AttackDistance	Distance attacker can hit from.
+	 * @param	OutLocation		World location of the slot.
+	 * @returns true if slot was found.
+	 */
+	bool Claim(const AActor* Target, const AActor* Attacker, float AttackDistance, FVector& OutLocation);
+
+	/**
+	 * Frees slot held by the attacker.
+	 *
+	 * @param	Attacker	Pawn attacking.
+	 */
+	void Release(const AActor* Attacker);
+
+	/** Frees slots of dead targets and attackers. */
+	void Tick();
+
+	/** Drops all slots. */
+	void Reset();
+
+	/** @return number of attackers holding slot around the target */
+	int32 GetNumAttackers(const AActor* Target) const;
+
+private:
+	/** Attacker holding a slot */
+	struct FSlot
+	{
+		TWeakObjectPtr<const AActor> Attacker;
+
+		/** slot location relative to the target */
+		FVector2D Offset;
+
+		/** attacker's capsule radius */
+		float Radius;
+	};
+
+	/** Target with its attackers */
+	struct FTargetSlots
+	{
+		TWeakObjectPtr<const AActor> Target;
+		TArray<FSlot> Slots;
+	};
+
+	/** @return true if there's room for attacker of given radius at offset */
+	static bool IsFree(const FTargetSlots& TargetSlots, const FVector2D& Offset, float Radius);
+
+	/** @return false for destroyed or dead actors */
+	static bool IsAlive(const AActor* Actor);
+
+	/** slots of each target */
+	TMap<const AActor*, FTargetSlots> Targets;
+
+	/** target of each attacker */
+	TMap<const AActor*, const AActor*> AttackerTargets;
+};
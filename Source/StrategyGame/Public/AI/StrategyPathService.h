@@ -0,0 +1,210 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "AI/Navigation/NavigationTypes.h"
+
+class AStrategyAIController;
+class ANavigationData;
+
+DECLARE_STATS_GROUP(TEXT("StrategyPath"), STATGROUP_StrategyPath, STATCAT_Advanced);
+
+/**
+ * Collects unit move requests during the frame and finds their paths in the background.
+ * Requests starting close to each other with the same goal share one query, at most MaxQueriesPerFrame
+ * queries are started each frame and the rest waits for the next one. Paths toward the breweries are
+ * kept in a small LRU cache of corridors, so the waves following each other don't search the navmesh again.
+ * Found paths are handed to the controllers' path following when the navigation system delivers them. Shared
+ * path is joined from where the unit stands and extended to its own goal when navmesh raycasts show the way
+ * is clear; otherwise the unit gets a query of its own.
+ */
+class FStrategyPathService
+{
+public:
+	FStrategyPathService();
+	~FStrategyPathService();
+
+	/**
+	 * Sets up the service parameters.
+	 *
+	 * @param	InMaxQueriesPerFrame	Most path queries started in single frame.
+	 * @param	InMergeDistance			Requests with goals and starts this close share a query.
+	 * @param	InCacheSize				Most corridors kept in the cache.
+	 * @param	InCacheLifetime			Seconds a cached corridor is used for.
+	 */
+	void Configure(int32 InMaxQueriesPerFrame, float InMergeDistance, int32 InCacheSize, float InCacheLifetime);
+
+	/**
+	 * Queues move of the controlled pawn, replaces its previous pending request.
+	 *
+	 * @param	Controller			Controller to move.
+	 * @param	Goal				Location to move to.
+	 * @param	AcceptanceRadius	Distance from goal the move is finished at.
+	 * @param	bStopOnOverlap		Whether pawn radius counts to the acceptance radius.
+	 * @param	bCacheCorridor		Whether the path is worth caching, for moves to long lived goals.
+	 */
+	void RequestMove(AStrategyAIController* Controller, const FVector& Goal, float AcceptanceRadius, bool bStopOnOverlap, bool bCacheCorridor);
+
+	/**
+	 * Queues move toward the actor, followed as it moves once the path is delivered. Replaces previous pending request.
+	 *
+	 * @param	Controller			Controller to move.
+	 * @param	GoalActor			Actor to move to.
+	 * @param	AcceptanceRadius	Distance from goal the move is finished at.
+	 * @param	bStopOnOverlap		Whether pawn radius counts to the acceptance radius.
+	 */
+	void RequestMoveToActor(AStrategyAIController* Controller, AActor* GoalActor, float AcceptanceRadius, bool bStopOnOverlap);
+
+	/**
+	 * Drops pending request of the controller, path found for it later is ignored.
+	 *
+	 * @param	Controller	Controller whose request to drop.
+	 */
+	void Cancel(const AStrategyAIController* Controller);
+
+	/** @return true if controller waits for a path */
+	bool IsPending(const AStrategyAIController* Controller) const;
+
+	/**
+	 * Starts queries of this frame's requests.
+	 *
+	 * @param	World	World with the navigation.
+	 */
+	void Tick(UWorld* World);
+
+	/** Aborts queries in flight and drops all requests and corridors. */
+	void Reset();
+
+	/** Drops all cached corridors. */
+	void InvalidateCorridors();
+
+	/**
+	 * Drops cached corridors crossing changed navmesh areas, again once the tiles are rebuilt.
+	 *
+	 * @param	Tiles	Navmesh tiles being rebuilt.
+	 * @param	Areas	Changed areas.
+	 */
+	void OnNavTilesChanged(const TArray<FIntPoint>& Tiles, const TArray<FBox>& Areas);
+
+private:
+	/** Single move request */
+	struct FRequest
+	{
+		TWeakObjectPtr<AStrategyAIController> Controller;
+		TWeakObjectPtr<AActor> GoalActor;
+		FVector Start;
+		FVector Goal;
+		float AcceptanceRadius;
+		uint32 Serial;
+		bool bStopOnOverlap;
+		bool bCacheCorridor;
+		bool bExclusive;
+	};
+
+	/** Start and goal cells, requests with the same key share the path */
+	struct FPathKey
+	{
+		FIntPoint StartCell;
+		FIntVector GoalCell;
+
+		bool operator==(const FPathKey& Other) const { return StartCell == Other.StartCell && GoalCell == Other.GoalCell; }
+		friend uint32 GetTypeHash(const FPathKey& Key) { return HashCombine(GetTypeHash(Key.StartCell), GetTypeHash(Key.GoalCell)); }
+	};
+
+	/** Query in flight with all requests waiting for it */
+	struct FQuery
+	{
+		FPathKey Key;
+		FVector Start;
+		FVector Goal;
+		bool bCacheCorridor;
+		TArray<FRequest> Requests;
+	};
+
+	/** Cached path */
+	struct FCorridor
+	{
+		TArray<FVector> Points;
+		FVector Start;
+		FVector Goal;
+		float CreationTime;
+		uint64 LastUsedFrame;
+	};
+
+	/** queues the request, replacing previous one of its controller */
+	void AddRequest(const FRequest& Request);
+
+	/** @return key of the request */
+	FPathKey GetKey(const FVector& Start, const FVector& Goal) const;
+
+	/** @return true if the request is still the latest of its controller */
+	bool IsCurrent(const FRequest& Request) const;
+
+	/** called by navigation system with found path */
+	void OnPathFound(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/**
+	 * Hands the path to controller's path following, joined to where the pawn is and extended to its goal.
+	 *
+	 * @param	Request		Request to deliver.
+	 * @param	PathPoints	Path found for the query.
+	 * @param	PathStart	Start of the query.
+	 * @param	PathGoal	Goal of the query.
+	 */
+	void Deliver(const FRequest& Request, const TArray<FVector>& PathPoints, const FVector& PathStart, const FVector& PathGoal);
+
+	/** @return true if navmesh raycast between the points doesn't hit anything */
+	bool IsDirectlyReachable(const FVector& From, const FVector& To, const AStrategyAIController* Controller) const;
+
+	/** moves the controller without the service, when path couldn't be found */
+	void Fallback(const FRequest& Request);
+
+	/** @return cached corridor for the key, null if none or expired */
+	const FCorridor* FindCorridor(const FPathKey& Key, float Now);
+
+	/** drops corridors crossing any of the areas */
+	void InvalidateCorridors(const TArray<FBox>& Areas);
+
+	/** adds corridor, evicts least recently used one when full */
+	void AddCorridor(const FPathKey& Key, const FQuery& Query, const TArray<FVector>& PathPoints, float Now);
+
+	/** most path queries started in single frame */
+	int32 MaxQueriesPerFrame;
+
+	/** requests with goals and starts this close share a query */
+	float MergeDistance;
+
+	/** most corridors kept in the cache */
+	int32 CacheSize;
+
+	/** seconds a cached corridor is used for */
+	float CacheLifetime;
+
+	/** requests waiting for a query */
+	TArray<FRequest> PendingRequests;
+
+	/** serial of the latest request of each controller, until its path is delivered */
+	TMap<const AStrategyAIController*, uint32> LatestSerials;
+
+	/** queries in flight, by navigation system query id */
+	TMap<uint32, FQuery> Queries;
+
+	/** cached corridors */
+	TMap<FPathKey, FCorridor> Corridors;
+
+	/** world the queries run in */
+	TWeakObjectPtr<UWorld> QueryWorld;
+
+	/** navigation data queried */
+	TWeakObjectPtr<ANavigationData> NavData;
+
+	/** serial of the last request */
+	uint32 NextSerial;
+
+	/** areas changed since navigation finished rebuilding */
+	TArray<FBox> RebuildingAreas;
+
+	/** navigation was being rebuilt last tick */
+	bool bWasBuildingNavigation;
+};
@@ -0,0 +1,133 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "Engine/DataAsset.h"
+#include "StrategyWaveSchedule.generated.h"
+
+class ABaseCharacter;
+class UStrategyAttachment;
+
+/** Group of identical units in a wave */
+USTRUCT()
+struct FStrategyWaveUnit
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** class of the units */
+	UPROPERTY(EditAnywhere, Category=Wave)
+	TSubclassOf<ABaseCharacter> UnitClass;
+
+	/** number of units */
+	UPROPERTY(EditAnywhere, Category=Wave, meta=(ClampMin="1"))
+	int32 Count;
+
+	/** buff applied on spawn, minions only */
+	UPROPERTY(EditAnywhere, Category=Wave)
+	FBuffData Buff;
+
+	/** weapon given on spawn, minions only */
+	UPROPERTY(EditAnywhere, Category=Wave)
+	TSubclassOf<UStrategyAttachment> Weapon;
+
+	/** armor given on spawn, minions only */
+	UPROPERTY(EditAnywhere, Category=Wave)
+	TSubclassOf<UStrategyAttachment> Armor;
+
+	/** scale of the units */
+	UPROPERTY(EditAnywhere, Category=Wave)
+	float Scale;
+
+	/** animation rate of the units */
+	UPROPERTY(EditAnywhere, Category=Wave)
+	float AnimationRate;
+
+	FStrategyWaveUnit()
+		: Count(1)
+		, Scale(1.0f)
+		, AnimationRate(1.0f)
+	{
+		Buff.BuffData.AttackMin = 0;
+		Buff.BuffData.AttackMax = 0;
+		Buff.BuffData.DamageReduction = 0;
+		Buff.BuffData.MaxHealthBonus = 0;
+		Buff.BuffData.HealthRegen = 0;
+		Buff.BuffData.Speed = 0;
+		Buff.Duration = 0;
+	}
+};
+
+/** Single wave of the schedule */
+USTRUCT()
+struct FStrategyWave
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** units of the wave, interleaved when spawned */
+	UPROPERTY(EditAnywhere, Category=Wave)
+	TArray<FStrategyWaveUnit> Units;
+
+	/** seconds from the end of previous wave (or match start) to the first spawn */
+	UPROPERTY(EditAnywhere, Category=Wave, meta=(ClampMin="0"))
+	float StartDelay;
+
+	/** seconds the spawns are spread over */
+	UPROPERTY(EditAnywhere, Category=Wave, meta=(ClampMin="0"))
+	float Duration;
+
+	FStrategyWave()
+		: StartDelay(5.0f)
+		, Duration(10.0f)
+	{
+	}
+};
+
+/** Planned spawn of a wave */
+struct FStrategyWaveSpawn
+{
+	/** seconds after wave start */
+	float Time;
+
+	/** index of the unit group in the wave */
+	int32 UnitIndex;
+};
+
+/**
+ * Waves spawned by AI director of a brewery. Every wave is planned up front: spawns of all its unit groups
+ * are interleaved and spread evenly over the wave duration. Spawns of all directors share the per frame budget
+ * of the game state (UnitSpawnsPerFrame), late ones wait for the next frames.
+ */
+UCLASS(BlueprintType)
+class UStrategyWaveSchedule : public UDataAsset
+{
+	GENERATED_UCLASS_BODY()
+
+	/** waves in order */
+	UPROPERTY(EditAnywhere, Category=Schedule)
+	TArray<FStrategyWave> Waves;
+
+	/** keep spawning the last wave when the schedule runs out */
+	UPROPERTY(EditAnywhere, Category=Schedule)
+	uint32 bRepeatLastWave : 1;
+
+	/**
+	 * Plans spawns of a wave.
+	 *
+	 * @param	WaveIndex	Wave to plan, past the end is the last wave when repeating.
+	 * @param	OutSpawns	Spawns sorted by time.
+	 * @returns false if there is no such wave.
+	 */
+	bool PlanWave(int32 WaveIndex, TArray<FStrategyWaveSpawn>& OutSpawns) const;
+
+	/** @return wave data for index, last wave past the end when repeating, null otherwise */
+	const FStrategyWave* GetWave(int32 WaveIndex) const;
+
+	/**
+	 * Checks the schedule for mistakes.
+	 *
+	 * @param	OutErrors	Description of each problem found.
+	 * @returns true if the schedule can be used.
+	 */
+	bool Validate(TArray<FString>& OutErrors) const;
+};
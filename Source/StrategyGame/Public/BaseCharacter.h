@@ -6,10 +6,12 @@
 
 #include "StrategyTeamInterface.h"
 #include "StrategyTypes.h"
+#include "StrategyEntities.h"
+#include "StrategyCrowdRenderer.h"
 #include "GameFramework/Character.h"
 #include "BaseCharacter.generated.h"
 
-UCLASS()
+UCLASS(config=Game)
 class STRATEGYGAME_API ABaseCharacter : public ACharacter, public IStrategyTeamInterface
 
 {
@@ -23,12 +25,22 @@ class STRATEGYGAME_API ABaseCharacter : public ACharacter, public IStrategyTeamI
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Health)
 	float Health;
 
+	/** Take damage through TakeDamage and its Blueprint events, instead of the batched damage pass */
+	UPROPERTY(EditDefaultsOnly, Category = Health)
+	uint32 bDamageThroughTakeDamage : 1;
+
 	const FPawnData* GetDefaultPawnData() const { return &DefaultPawnData; }
 
 	/** get all modifiers we have now on pawn */
 	const FPawnData& GetModifiedPawnData() const  { return PawnData; }
 
+	/** get montages the pawn plays, for map warmup */
+	void GetMontages(TArray<UAnimMontage*>& OutMontages) const;
+
 	virtual void PostInitializeComponents() override;
+
+	/** adds buff array to the memory size */
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
 	
 	/** Identifies if pawn is in its dying state */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Health)
@@ -36,6 +48,7 @@ class STRATEGYGAME_API ABaseCharacter : public ACharacter, public IStrategyTeamI
 	
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	/** melee anim */
 	UPROPERTY(EditDefaultsOnly, Category = "Animation")
@@ -44,10 +57,17 @@ protected:
 	/** death anim */
 	UPROPERTY(EditDefaultsOnly, Category = "Animation")
 	UAnimMontage* DeathAnim;
+
+	/** vertex animated look used far from the camera, baked by StrategyCrowdBake commandlet */
+	UPROPERTY(EditDefaultsOnly, config, Category = "Animation")
+	FStrategyCrowdRenderData CrowdRender;
 	
 	/** team number */
 	uint8 MyTeamNum;
 
+	/** handle in the entity table, goes stale when we die */
+	FStrategyEntityHandle EntityHandle;
+
 	/** base pawn data */
 	UPROPERTY(EditDefaultsOnly, Category = Pawn)
 	FPawnData DefaultPawnData;
@@ -61,6 +81,8 @@ protected:
 	/** update pawn data after changes in active buffs */
 	virtual void UpdatePawnData();
 
+	friend class FStrategyMatchSnapshot;
+
 public:	
 
 	/**
@@ -73,6 +95,15 @@ public:
 	/** Notification triggered from the melee animation to signal impact. */
 	virtual void OnMeleeAttackFinishedNotify();
 
+	/** 
+	 * Damages first enemy hit by the melee sweep.
+	 *
+	 * @param	Hits		Hits of the sweep.
+	 * @param	MeleeDamage	Damage rolled when the blow landed.
+	 * @param	TraceDir	Direction of the blow.
+	 */
+	void OnMeleeSweepDone(const TArray<FHitResult>& Hits, int32 MeleeDamage, FVector TraceDir);
+
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
 	/**
@@ -99,6 +130,17 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Health)
 	virtual int32 GetMaxHealth() const;
 
+	/** get handle in the entity table */
+	virtual FStrategyEntityHandle GetEntityHandle() const override { return EntityHandle; }
+
+	/** get instanced look used far from the camera */
+	const FStrategyCrowdRenderData& GetCrowdRenderData() const { return CrowdRender; }
+
+#if WITH_EDITOR
+	/** set instanced look, for the baker */
+	void SetCrowdRenderData(const FStrategyCrowdRenderData& InCrowdRender) { CrowdRender = InCrowdRender; }
+#endif
+
 	/** event called after die animation  to hide character and delete it asap */
 	void OnDieAnimationEnd();
 private:
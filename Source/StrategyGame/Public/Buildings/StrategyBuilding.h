@@ -3,6 +3,7 @@
 #pragma once
 
 #include "StrategyTypes.h"
+#include "StrategyEntities.h"
 #include "StrategyInputInterface.h"
 #include "StrategyTeamInterface.h"
 #include "StrategySelectionInterface.h"
@@ -27,12 +28,17 @@ class AStrategyBuilding : public AActor,
 	FBuildFinishedDelegate BuildFinishedDelegate;
 
 	// Begin Actor interface
+	virtual void PostActorCreated() override;
 	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
 	virtual void Destroyed() override;
 	virtual void Tick(float DeltaTime) override;
 	virtual void PostLoad() override;
 	// End Actor Interface
 
+	/** buildings placed in the level are baked into the navmesh, ones spawned during the match are carved by game state instead */
+	virtual bool IsComponentRelevantForNavigation(UActorComponent* Component) const override;
+
 	//////////////////////////////////////////////////////////////////////////
 	// Begin StrategySelectionInterface interface
 
@@ -74,6 +80,9 @@ class AStrategyBuilding : public AActor,
 	/** set team number */
 	virtual void SetTeamNum(uint8 NewTeamNum); 
 
+	/** get handle in the entity table */
+	virtual FStrategyEntityHandle GetEntityHandle() const override { return EntityHandle; }
+
 	//////////////////////////////////////////////////////////////////////////
 	// Touch
 
@@ -84,6 +93,40 @@ class AStrategyBuilding : public AActor,
 	UFUNCTION(BlueprintCallable, Category=Building)
 	bool CanAffectChar(const AStrategyChar* Char) const;
 
+	//////////////////////////////////////////////////////////////////////////
+	// Targeting
+
+	/** 
+	 * Find enemy units closest to the building, result is reused for the rest of the frame.
+	 *
+	 * @param Radius	Search radius.
+	 * @param MaxCount	Most enemies returned.
+	 * @returns enemies, closest first.
+	 */
+	UFUNCTION(BlueprintCallable, Category=Building)
+	TArray<class ABaseCharacter*> FindNearestEnemies(float Radius, int32 MaxCount = 1);
+
+	/** 
+	 * Find enemy unit with lowest health in range, result is reused for the rest of the frame.
+	 *
+	 * @param Radius	Search radius.
+	 * @returns enemy, null if there is none in range.
+	 */
+	UFUNCTION(BlueprintCallable, Category=Building)
+	class ABaseCharacter* FindWeakestEnemy(float Radius);
+
+	/** 
+	 * Find where projectile has to be aimed to hit moving target.
+	 *
+	 * @param Target			Actor to hit.
+	 * @param ShotOrigin		Location projectile is spawned at.
+	 * @param ProjectileSpeed	Speed of the projectile.
+	 * @param InterceptPoint	Point to aim at, current target location when it can't be caught.
+	 * @returns true if projectile can catch the target.
+	 */
+	UFUNCTION(BlueprintCallable, Category=Building)
+	bool GetInterceptPoint(const AActor* Target, const FVector& ShotOrigin, float ProjectileSpeed, FVector& InterceptPoint) const;
+
 	//////////////////////////////////////////////////////////////////////////
 	// Construction
 
@@ -125,18 +168,21 @@ class AStrategyBuilding : public AActor,
 	/** return cost needed to finish building */
 	float GetRemainingBuildCost() const;
 
+	/** collect soft references which have to be loaded before the building is used */
+	void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const;
+
 protected:
 	/** construction start sound stinger */
 	UPROPERTY(EditDefaultsOnly, Category=Building)
-	USoundCue* ConstructionStartStinger;
+	TSoftObjectPtr<USoundCue> ConstructionStartStinger;
 
 	/** construction end sound stinger */
 	UPROPERTY(EditDefaultsOnly, Category=Building)
-	USoundCue* ConstructionEndStinger;
+	TSoftObjectPtr<USoundCue> ConstructionEndStinger;
 
 	/** upgrade construction sound stinger */
 	UPROPERTY(EditDefaultsOnly, Category=Building)
-	USoundCue* UpgradeStinger;
+	TSoftObjectPtr<USoundCue> UpgradeStinger;
 
 	/** cost of building */
 	UPROPERTY(EditDefaultsOnly, Category=Building)
@@ -193,9 +239,24 @@ protected:
 	/** is custom action displayed? */
 	uint8 bIsCustomActionDisplayed : 1;
 
+	/** spawned during the match, navmesh gets its footprint instead of its collisions */
+	uint8 bIsNavFootprint : 1;
+
 	/** current team number */
 	uint8 MyTeamNum;
 
+	/** team whose buildings list this building is registered in */
+	uint8 RegisteredTeamNum;
+
+	/** index in buildings list of the registered team, maintained by FPlayerData */
+	int32 TeamBuildingIndex;
+
+	/** handle in the entity table, goes stale when destroyed */
+	FStrategyEntityHandle EntityHandle;
+
+	friend struct FPlayerData;
+	friend class FStrategyMatchSnapshot;
+
 	/** Built time if building is not attacked in the meantime */
 	float InitialBuildTime;
 
@@ -85,6 +85,12 @@ public:
 	// Begin Actor interface
 	/** initial setup */
 	virtual void PostInitializeComponents() override;
+
+	/** starts listening to gameplay state changes */
+	virtual void BeginPlay() override;
+
+	/** stops listening to gameplay state changes */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	// End Actor interface
 
 
@@ -114,6 +120,12 @@ protected:
 	/** Number of lives. */
 	uint8	NumberOfLives;
 
+	/** gameplay state changed, passes it on to the AI director */
+	void OnGameplayEvent(const struct FStrategyGameplayEvent& Event);
+
+	/** subscription to gameplay state changes */
+	FDelegateHandle GameplayStateHandle;
+
 public:
 	/** Returns AIDirector subobject **/
 	FORCEINLINE UStrategyAIDirector* GetAIDirector() const { return AIDirector; }
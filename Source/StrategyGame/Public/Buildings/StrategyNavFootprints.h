@@ -0,0 +1,149 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "AI/Navigation/NavRelevantInterface.h"
+#include "UObject/GCObject.h"
+#include "StrategyNavFootprints.generated.h"
+
+class AStrategyBuilding;
+class UNavArea;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnNavTilesChanged, const TArray<FIntPoint>& /*Tiles*/, const TArray<FBox>& /*Areas*/);
+
+/** Navigation modifier of one building footprint, registered to navigation octree instead of building's geometry */
+UCLASS(Transient)
+class UStrategyNavFootprint : public UObject, public INavRelevantInterface
+{
+	GENERATED_UCLASS_BODY()
+
+	// Begin INavRelevantInterface
+	virtual void GetNavigationData(FNavigationRelevantData& Data) const override;
+	virtual FBox GetNavigationBounds() const override { return Bounds; }
+	virtual bool IsNavigationRelevant() const override { return Bounds.IsValid != 0; }
+	// End INavRelevantInterface
+
+	/**
+	 * Sets the blocked area.
+	 *
+	 * @param	InLocalBounds	Footprint in building space.
+	 * @param	InTransform		Building location and rotation.
+	 */
+	void SetFootprint(const FBox& InLocalBounds, const FTransform& InTransform);
+
+	/** @return true if the footprint matches this one */
+	bool IsSameFootprint(const FBox& InLocalBounds, const FTransform& InTransform) const;
+
+	/** world bounds of the blocked area */
+	FBox Bounds;
+
+	/** blocked area in building space, rotated walls get a rotated box instead of their world bounds */
+	FBox LocalBounds;
+
+	/** building location and rotation */
+	FTransform Transform;
+
+	/** area class applied to the footprint */
+	TSubclassOf<UNavArea> AreaClass;
+};
+
+/**
+ * Keeps navigation in sync with buildings spawned during the match. Those don't feed their geometry to the
+ * navmesh, each one is a single oriented box modifier instead; buildings placed in the level stay baked. Footprints are keyed by building location, so replacing a building
+ * with one of the same footprint (upgrades) doesn't touch the navmesh at all, and walls coming and going only
+ * dirty their own box. Changes are collected for RebuildDelay and applied in one batch, the navmesh then
+ * rebuilds just the affected tiles in the background and listeners get the list of those tiles.
+ */
+class FStrategyNavFootprints : public FGCObject
+{
+public:
+	FStrategyNavFootprints();
+
+	/**
+	 * Sets up the footprint parameters.
+	 *
+	 * @param	InRebuildDelay	Seconds changes are collected for before being applied.
+	 * @param	InPadding		Extra room kept around buildings, on top of agent radius added by navmesh generation.
+	 */
+	void Configure(float InRebuildDelay, float InPadding);
+
+	/**
+	 * Starts tracking the building.
+	 *
+	 * @param	Building	Building which began play.
+	 */
+	void AddBuilding(AStrategyBuilding* Building);
+
+	/**
+	 * Stops tracking the building, its footprint is removed unless other building takes its place.
+	 *
+	 * @param	Building	Building being destroyed.
+	 */
+	void RemoveBuilding(AStrategyBuilding* Building);
+
+	/**
+	 * Applies collected changes when the delay is over.
+	 *
+	 * @param	World			World with the navigation.
+	 * @param	DeltaSeconds	Frame time.
+	 */
+	void Tick(UWorld* World, float DeltaSeconds);
+
+	/** Unregisters all footprints. */
+	void Reset();
+
+	/** @return delegate broadcast with navmesh tiles and areas changed by footprints */
+	FOnNavTilesChanged& OnTilesChanged() { return TilesChangedDelegate; }
+
+	// Begin FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	// End FGCObject interface
+
+private:
+	/** Footprint at one building location */
+	struct FFootprint
+	{
+		/** navigation octree element, null until registered */
+		UStrategyNavFootprint* Element;
+
+		/** building standing here now */
+		TWeakObjectPtr<AStrategyBuilding> Building;
+	};
+
+	/** applies all collected changes */
+	void Flush(UWorld* World);
+
+	/**
+	 * Finds the area blocked by the building.
+	 *
+	 * @param	Building		Building to check.
+	 * @param	OutTransform	Building location and rotation, the box is relative to it.
+	 * @returns blocked area in building space, invalid box if none.
+	 */
+	FBox GetBuildingFootprint(const AStrategyBuilding* Building, FTransform& OutTransform) const;
+
+	/** @return key of building location */
+	static FIntVector GetKey(const AStrategyBuilding* Building);
+
+	/** seconds changes are collected for */
+	float RebuildDelay;
+
+	/** extra room kept around buildings */
+	float Padding;
+
+	/** time left to apply collected changes, negative when nothing is collected */
+	float TimeToFlush;
+
+	/** footprints by building location */
+	TMap<FIntVector, FFootprint> Footprints;
+
+	/** locations changed since last flush */
+	TSet<FIntVector> DirtyKeys;
+
+	/** world the footprints are registered in */
+	TWeakObjectPtr<UWorld> FootprintWorld;
+
+	/** listeners of changed tiles */
+	FOnNavTilesChanged TilesChangedDelegate;
+};
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "StrategyTypes.h"
 #include "StrategyTeamInterface.generated.h"
 
 /** Interface for actors which can be associated with teams */
@@ -17,4 +18,7 @@ class IStrategyTeamInterface
 
 	/** returns the team number of the actor */
 	virtual uint8 GetTeamNum() const = 0;
+
+	/** returns handle in the entity table, unset for actors which are not entities */
+	virtual FStrategyEntityHandle GetEntityHandle() const { return FStrategyEntityHandle(); }
 };
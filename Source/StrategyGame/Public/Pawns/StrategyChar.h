@@ -54,6 +54,9 @@ public:
 	/** adds active buff to this pawn */
 	void ApplyBuff(const struct FBuffData& Buff);
 
+	/** draws body and mergeable attachments as one merged mesh if it's ready, the rest as separate components */
+	void UpdateMergedMesh();
+
 	virtual int32 GetMaxHealth() const override;
 
 protected:
@@ -65,12 +68,24 @@ protected:
 	UPROPERTY()
 	UStrategyAttachment* WeaponSlot;
 
+	/** Body mesh without attachments, set when merged mesh is used */
+	UPROPERTY()
+	USkeletalMesh* BodyMesh;
+
+	/** draws body mesh with attachments as separate components */
+	void RestoreSeparateMeshes();
+
+	/** @return true if the attachment is skinned to body's skeleton and attached to its root as it is */
+	bool CanMergeAttachment(const UStrategyAttachment* Attachment) const;
+
 	/** update pawn data after changes in active buffs */
 	virtual void UpdatePawnData() override;
 
 	/** update pawn's health */
 	void TickHealth();
 
+	friend class FStrategyMatchSnapshot;
+
 private:
 
 	/** Handle for efficient management of TickHealth timer */
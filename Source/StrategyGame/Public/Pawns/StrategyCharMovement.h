@@ -0,0 +1,94 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "StrategyCharMovement.generated.h"
+
+/**
+ * Character movement steered by the crowd avoidance of the game state. Classes can switch to nav walking:
+ * the capsule is projected on the navmesh and moved without floor sweeps, step ups or collision, optionally
+ * pushed out of enemy capsules only, as friends are kept apart by the crowd avoidance already.
+ */
+UCLASS()
+class UStrategyCharMovement : public UCharacterMovementComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	/** walk on the navmesh instead of full walking, overridden by strategy.NavWalking */
+	UPROPERTY(EditDefaultsOnly, Category="Character Movement: NavMesh Movement")
+	uint32 bUseNavWalking : 1;
+
+	/** when nav walking, don't walk through enemies */
+	UPROPERTY(EditDefaultsOnly, Category="Character Movement: NavMesh Movement")
+	uint32 bNavWalkingEnemyCollision : 1;
+
+	/** picks the land movement mode */
+	virtual void InitializeComponent() override;
+
+	/** gathers time spent moving and stuck */
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+	/** path following requests are replaced by the avoidance velocity while it's fresh */
+	virtual void RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed) override;
+
+	/** drops the avoidance velocity with the path */
+	virtual void StopActiveMovement() override;
+
+	/**
+	 * Sets velocity to use instead of path following request for next move.
+	 *
+	 * @param	InVelocity	Collision free velocity found by crowd avoidance.
+	 */
+	void SetAvoidanceVelocity(const FVector& InVelocity);
+
+	/** @return true when path following requested a move last frame */
+	bool HasPreferredVelocity() const;
+
+	/** @return velocity path following wants, before avoidance */
+	const FVector& GetPreferredVelocity() const { return PreferredVelocity; }
+
+	/** @return seconds spent following path */
+	float GetMovingTime() const { return MovingTime; }
+
+	/** @return seconds spent following path without getting anywhere */
+	float GetStuckTime() const { return StuckTime; }
+
+	/** @return seconds stuck without a break */
+	float GetCurrentStuckTime() const { return CurrentStuckTime; }
+
+	/** @return distance covered while following path */
+	float GetMovedDistance() const { return MovedDistance; }
+
+protected:
+	/** pushes out of enemy capsules after the move */
+	virtual void PhysNavWalking(float deltaTime, int32 Iterations) override;
+
+	/** moves capsule out of overlapping enemy units, in 2D, swept and kept on the navmesh */
+	void ResolveEnemyOverlaps();
+
+	/** velocity requested by path following */
+	FVector PreferredVelocity;
+
+	/** frame of the last path following request */
+	uint64 PreferredVelocityFrame;
+
+	/** collision free velocity from crowd avoidance */
+	FVector AvoidanceVelocity;
+
+	/** frame the avoidance velocity was solved in */
+	uint64 AvoidanceVelocityFrame;
+
+	/** seconds spent following path */
+	float MovingTime;
+
+	/** seconds spent following path below stuck speed */
+	float StuckTime;
+
+	/** seconds stuck without a break */
+	float CurrentStuckTime;
+
+	/** distance covered while following path */
+	float MovedDistance;
+};
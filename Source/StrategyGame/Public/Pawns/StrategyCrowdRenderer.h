@@ -0,0 +1,213 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "StrategyCrowdRenderer.generated.h"
+
+class ABaseCharacter;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+class UMaterialInterface;
+class FStrategyGameplayEventBus;
+struct FStrategyGameplayEvent;
+enum class EVisibilityBasedAnimTickOption : uint8;
+
+namespace EStrategyCrowdClip
+{
+	enum Type
+	{
+		Idle,
+		Walk,
+		Attack,
+		Death,
+		MAX
+	};
+}
+
+/** Frames of one animation in vertex animation texture */
+USTRUCT()
+struct FStrategyVATClip
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** first frame of the clip */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	int32 StartFrame;
+
+	/** number of frames, looped except for death */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	int32 NumFrames;
+
+	FStrategyVATClip()
+		: StartFrame(0)
+		, NumFrames(0)
+	{
+	}
+};
+
+/**
+ * Instanced look of the unit, used when it's far from the camera. Animations are baked to vertex animation
+ * texture by StrategyCrowdBake commandlet, the material plays frames StartFrame to StartFrame + NumFrames at
+ * FrameRate. Clip is passed in VATStartFrame and VATNumFrames scalar parameters, phase of looped clips comes
+ * from PerInstanceRandom. Death is played once from VATStartTime (game time) when VATLoop is 0.
+ */
+USTRUCT()
+struct FStrategyCrowdRenderData
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** static version of the skeletal mesh, in reference pose */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	UStaticMesh* Mesh;
+
+	/** material sampling vertex animation texture */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	UMaterialInterface* Material;
+
+	/** frames per second baked */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	float FrameRate;
+
+	/** standing */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	FStrategyVATClip Idle;
+
+	/** moving */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	FStrategyVATClip Walk;
+
+	/** playing attack anim */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	FStrategyVATClip Attack;
+
+	/** dying, holds the last frame */
+	UPROPERTY(EditDefaultsOnly, Category=VAT)
+	FStrategyVATClip Death;
+
+	FStrategyCrowdRenderData()
+		: Mesh(nullptr)
+		, Material(nullptr)
+		, FrameRate(30.0f)
+	{
+	}
+
+	/** @return true if unit can be drawn instanced */
+	bool IsValid() const { return Mesh != nullptr && Material != nullptr; }
+
+	/** @return frames of the clip */
+	const FStrategyVATClip& GetClip(EStrategyCrowdClip::Type Clip) const;
+};
+
+/**
+ * Draws units far from the camera as instanced static meshes with vertex animation, instead of skinned meshes.
+ * Units of the same mesh playing the same clip share one instanced component, so a whole wave costs a few draw
+ * calls. Skeletal mesh of instanced unit is hidden and evaluates only montages, which keeps melee notifies
+ * working. Units are registered by spawn events and leave by death events; instanced units play death clip until
+ * their corpse is gone, with units dying in the same moment sharing a component. Living units move every frame,
+ * so their batches are plain instanced components without a cluster tree to rebuild; corpses don't move, their
+ * batches are hierarchical and culled by clusters. Units come back to skeletal mesh when close to the camera or
+ * selected.
+ */
+class FStrategyCrowdRenderer
+{
+public:
+	FStrategyCrowdRenderer();
+
+	/**
+	 * Sets up the renderer parameters and starts listening to unit spawns and deaths.
+	 *
+	 * @param	InEventBus			Gameplay events of the match.
+	 * @param	InInstanceDistance	Units farther from the camera are drawn instanced.
+	 */
+	void Configure(FStrategyGameplayEventBus& InEventBus, float InInstanceDistance);
+
+	/**
+	 * Swaps units between skeletal and instanced look and moves the instances.
+	 *
+	 * @param	World	World with the units.
+	 */
+	void Tick(UWorld* World);
+
+	/** Brings all units back to skeletal meshes, removes the instances and stops listening. */
+	void Reset();
+
+private:
+	/** Instanced component of one mesh and clip */
+	struct FBatchKey
+	{
+		const UStaticMesh* Mesh;
+		const UMaterialInterface* Material;
+		int32 Clip;
+
+		/** death time step the clip starts at, 0 for looped clips */
+		int32 StartStep;
+
+		bool operator==(const FBatchKey& Other) const { return Mesh == Other.Mesh && Material == Other.Material && Clip == Other.Clip && StartStep == Other.StartStep; }
+		friend uint32 GetTypeHash(const FBatchKey& Key) { return HashCombine(HashCombine(PointerHash(Key.Mesh), PointerHash(Key.Material)), HashCombine(GetTypeHash(Key.Clip), GetTypeHash(Key.StartStep))); }
+	};
+
+	/** Units sharing instanced component, instance index is index in Units */
+	struct FBatch
+	{
+		TWeakObjectPtr<UInstancedStaticMeshComponent> Component;
+		TArray<TWeakObjectPtr<ABaseCharacter>> Units;
+		TArray<FTransform> Transforms;
+
+		/** corpses, instances are placed once */
+		bool bStatic;
+	};
+
+	/** Instanced unit */
+	struct FUnit
+	{
+		TWeakObjectPtr<ABaseCharacter> Char;
+		FBatchKey Key;
+		EVisibilityBasedAnimTickOption SavedTickOption;
+	};
+
+	/** registers spawned units, plays death of instanced ones */
+	void OnGameplayEvent(const FStrategyGameplayEvent& Event);
+
+	/** @return clip the unit plays now */
+	static EStrategyCrowdClip::Type GetClip(const ABaseCharacter* Char);
+
+	/** @return batch for the key, creates its component if needed */
+	FBatch* FindOrAddBatch(UWorld* World, const FBatchKey& Key, const FStrategyCrowdRenderData& RenderData);
+
+	/** moves instances of the batch to their units, drops instances of destroyed units */
+	void UpdateBatch(FBatch& Batch);
+
+	/** adds instance of the unit to batch */
+	void AddInstance(UWorld* World, ABaseCharacter* Char, const FBatchKey& Key, const FStrategyCrowdRenderData& RenderData);
+
+	/** removes instance of the unit from its batch */
+	void RemoveInstance(const ABaseCharacter* Char, const FBatchKey& Key);
+
+	/** removes instance from the batch, last instance takes its place */
+	static void RemoveBatchInstance(FBatch& Batch, int32 Idx);
+
+	/** shows or hides skeletal mesh of the unit */
+	static void SetSkeletalVisible(ABaseCharacter* Char, bool bVisible, FUnit& Unit);
+
+	/** units farther from the camera are drawn instanced */
+	float InstanceDistance;
+
+	/** batches by mesh and clip */
+	TMap<FBatchKey, FBatch> Batches;
+
+	/** living units with instanced look */
+	TArray<TWeakObjectPtr<ABaseCharacter>> Registered;
+
+	/** instanced units */
+	TMap<const ABaseCharacter*, FUnit> Units;
+
+	/** bus the renderer listens to */
+	FStrategyGameplayEventBus* EventBus;
+
+	/** subscription to unit spawns and deaths */
+	FDelegateHandle EventHandle;
+
+	/** actor owning instanced components */
+	TWeakObjectPtr<AActor> BatchOwner;
+};
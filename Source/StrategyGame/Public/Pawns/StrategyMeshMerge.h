@@ -0,0 +1,80 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "UObject/GCObject.h"
+
+class AStrategyChar;
+class USkeletalMesh;
+
+/**
+ * Skeletal meshes merged from unit body and its attachments, one per loadout and shared by all units wearing it.
+ * Unit with merged mesh draws and updates one skinned mesh instead of body plus attachment components.
+ * Loadouts not merged yet are queued and built a few per frame on the game thread, which the engine merge
+ * requires; units waiting for them keep their separate components and get notified when the mesh is ready.
+ * Only attachments skinned to the body's skeleton, attached to its root without offset, can be merged; the unit
+ * keeps the others as separate components.
+ */
+class FStrategyMeshMergeCache : public FGCObject
+{
+public:
+	FStrategyMeshMergeCache();
+
+	/**
+	 * Sets up the cache parameters.
+	 *
+	 * @param	InMaxMergesPerFrame		Most meshes merged in single frame.
+	 */
+	void Configure(int32 InMaxMergesPerFrame);
+
+	/**
+	 * Gets merged mesh of the loadout, queues its merge if it's not built yet.
+	 *
+	 * @param	Body		Body mesh of the unit.
+	 * @param	Parts		Attachment meshes sharing body's skeleton.
+	 * @param	Requester	Unit notified when queued mesh is ready.
+	 * @returns merged mesh, null if not ready or the meshes can't be merged.
+	 */
+	USkeletalMesh* FindOrQueue(USkeletalMesh* Body, const TArray<USkeletalMesh*>& Parts, AStrategyChar* Requester);
+
+	/** Merges queued loadouts and notifies their units. */
+	void Tick();
+
+	/** Drops all merged meshes and queued loadouts. */
+	void Reset();
+
+	// Begin FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	// End FGCObject interface
+
+private:
+	/** Meshes of one loadout, body first */
+	struct FMergeKey
+	{
+		TArray<USkeletalMesh*> Meshes;
+
+		bool operator==(const FMergeKey& Other) const { return Meshes == Other.Meshes; }
+		friend uint32 GetTypeHash(const FMergeKey& Key)
+		{
+			uint32 Hash = 0;
+			for (const USkeletalMesh* Mesh : Key.Meshes)
+			{
+				Hash = HashCombine(Hash, PointerHash(Mesh));
+			}
+			return Hash;
+		}
+	};
+
+	/** @return merged mesh, null if merge failed */
+	static USkeletalMesh* Merge(const FMergeKey& Key);
+
+	/** most meshes merged in single frame */
+	int32 MaxMergesPerFrame;
+
+	/** merged meshes by loadout, null for loadouts which couldn't be merged */
+	TMap<FMergeKey, USkeletalMesh*> MergedMeshes;
+
+	/** queued loadouts with units waiting for them, in request order */
+	TArray<TPair<FMergeKey, TArray<TWeakObjectPtr<AStrategyChar>>>> Queue;
+};
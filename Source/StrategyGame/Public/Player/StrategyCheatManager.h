@@ -16,4 +16,46 @@ class UStrategyCheatManager : public UCheatManager
 	 */
 	UFUNCTION(exec)
 	void AddGold(uint32 NewGold);
+
+	/** Toggle graph of recent match telemetry on the HUD. */
+	UFUNCTION(exec)
+	void ShowTelemetry();
+
+	/** Toggle fog of war of player team on the mini map. */
+	UFUNCTION(exec)
+	void ShowFogOfWar();
+
+	/**
+	 * Save the match to Saved/Snapshots.
+	 *
+	 * @param SnapshotName	Name of the snapshot, quick snapshot when empty.
+	 */
+	UFUNCTION(exec)
+	void SaveSnapshot(const FString& SnapshotName);
+
+	/**
+	 * Replace the match with a saved snapshot.
+	 *
+	 * @param SnapshotName	Name of the snapshot, quick snapshot when empty.
+	 */
+	UFUNCTION(exec)
+	void LoadSnapshot(const FString& SnapshotName);
+
+	/**
+	 * Print movement counters of living units, by walking and nav walking: ground covered against max speed
+	 * while following paths and time spent stuck. Counters only, it doesn't judge either mode.
+	 *
+	 * @param StuckSeconds	Units stuck longer than this are counted as stuck now, 2 seconds when zero.
+	 */
+	UFUNCTION(exec)
+	void MovementReport(float StuckSeconds);
+
+	/**
+	 * Spawn units of each brewery, the way its AI director would, and report their memory per unit by class
+	 * of the objects they own. The units are destroyed right away and don't count for the teams.
+	 *
+	 * @param NumUnits	Units of each kind to spawn, 100 when zero.
+	 */
+	UFUNCTION(exec)
+	void UnitMemoryReport(int32 NumUnits);
 };
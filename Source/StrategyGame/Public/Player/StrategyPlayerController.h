@@ -60,6 +60,9 @@ public:
 	/** Handler for mouse release over minimap. */
 	void MouseReleasedOverMinimap();
 
+	/** get currently selected actor */
+	AActor* GetSelectedActor() const { return SelectedActor.Get(); }
+
 protected:
 	/** if set, input and camera updates will be ignored */
 	uint8 bIgnoreInput : 1;
@@ -0,0 +1,90 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+class UAudioComponent;
+class USoundBase;
+
+DECLARE_STATS_GROUP(TEXT("StrategyAudio"), STATGROUP_StrategyAudio, STATCAT_Advanced);
+
+/**
+ * Plays gameplay sounds from pooled audio components instead of spawning a new one for every sound. Each
+ * sound gets a significance from its distance to the camera, lowered when out of view; sounds without
+ * attenuation always have full significance and play unspatialized. Sounds too far to be heard are dropped,
+ * and each category has a voice limit: a more significant sound takes the voice of the least significant one
+ * playing, a less significant one is dropped. Playing voices are rated again from the current camera.
+ */
+class FStrategyAudioRouter
+{
+public:
+	FStrategyAudioRouter();
+
+	/**
+	 * Sets up the router parameters.
+	 *
+	 * @param	InVoicesPerCategory	Most sounds of single category playing at once.
+	 * @param	InCullDistance		Sounds farther from the camera are dropped.
+	 * @param	InPoolSize			Most audio components kept.
+	 */
+	void Configure(int32 InVoicesPerCategory, float InCullDistance, int32 InPoolSize);
+
+	/**
+	 * Plays sound if it's significant enough.
+	 *
+	 * @param	World				World to play in.
+	 * @param	Sound				Sound to play.
+	 * @param	Location			Where to play it.
+	 * @param	Category			Category of the sound.
+	 * @param	VolumeMultiplier	Volume of the sound.
+	 * @param	PitchMultiplier		Pitch of the sound.
+	 * @returns true if the sound plays.
+	 */
+	bool Play(UWorld* World, USoundBase* Sound, const FVector& Location, EStrategySoundCategory::Type Category, float VolumeMultiplier = 1.0f, float PitchMultiplier = 1.0f);
+
+	/** Updates voice stats. */
+	void Tick();
+
+	/** Stops all sounds and destroys the pool. */
+	void Reset();
+
+	/**
+	 * Helper for gameplay code, replacement of UGameplayStatics::PlaySoundAtLocation. Goes through the router
+	 * of the match, or plays the sound directly when there is none.
+	 */
+	static void PlaySoundAtLocation(const UObject* WorldContextObject, USoundBase* Sound, const FVector& Location, EStrategySoundCategory::Type Category, float VolumeMultiplier = 1.0f, float PitchMultiplier = 1.0f);
+
+private:
+	/** Pooled audio component */
+	struct FVoice
+	{
+		TWeakObjectPtr<UAudioComponent> Component;
+		EStrategySoundCategory::Type Category;
+		float Significance;
+	};
+
+	/** @return significance in 0-1 for sound at location, zero if it can't be heard */
+	float GetSignificance(UWorld* World, const USoundBase* Sound, const FVector& Location) const;
+
+	/** @return true if the sound has attenuation, others are 2D */
+	static bool IsAttenuated(const USoundBase* Sound);
+
+	/** @return index of voice to play sound of the category with, INDEX_NONE if there is none */
+	int32 FindVoice(UWorld* World, EStrategySoundCategory::Type Category, float Significance);
+
+	/** most sounds of single category playing at once */
+	int32 VoicesPerCategory;
+
+	/** sounds farther from the camera are dropped */
+	float CullDistance;
+
+	/** most audio components kept */
+	int32 PoolSize;
+
+	/** pooled audio components */
+	TArray<FVoice> Voices;
+
+	/** actor owning pooled components */
+	TWeakObjectPtr<AActor> VoiceOwner;
+};
@@ -0,0 +1,107 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+class UStrategyCharMovement;
+
+DECLARE_STATS_GROUP(TEXT("StrategyCrowd"), STATGROUP_StrategyCrowd, STATCAT_Advanced);
+
+/**
+ * Reciprocal collision avoidance (ORCA) for all units of both teams, solved once per frame.
+ * Every moving unit picks the velocity closest to the one its path following wants, that doesn't
+ * collide with its nearest neighbors within the time horizon. Units which don't move (attacking,
+ * waiting) are obstacles, the others take half of the responsibility for each pair.
+ * Agents are gathered on the game thread, solved in parallel and the result is passed to
+ * UStrategyCharMovement, which uses it for the next path following move.
+ */
+class FStrategyCrowdAvoidance
+{
+public:
+	FStrategyCrowdAvoidance();
+
+	/**
+	 * Sets up the solver parameters.
+	 *
+	 * @param	InNeighborDistance	Only units closer than this are avoided.
+	 * @param	InTimeHorizon		Seconds ahead the velocities have to be collision free.
+	 * @param	InMaxNeighbors		Most units avoided by single unit, closest are picked.
+	 * @param	InNavProbeTime		Seconds of avoidance move checked against the navmesh.
+	 */
+	void Configure(float InNeighborDistance, float InTimeHorizon, int32 InMaxNeighbors, float InNavProbeTime);
+
+	/**
+	 * Solves avoidance of all units.
+	 *
+	 * @param	World			World with the units.
+	 * @param	DeltaSeconds	Frame time.
+	 */
+	void Tick(UWorld* World, float DeltaSeconds);
+
+	/** Drops all agents. */
+	void Reset();
+
+private:
+	/** Unit taking part in avoidance */
+	struct FAgent
+	{
+		UStrategyCharMovement* Movement;
+		FVector2D Location;
+		FVector2D Velocity;
+		FVector2D PreferredVelocity;
+		FVector2D NewVelocity;
+		float Radius;
+		float MaxSpeed;
+
+		/** false for units standing still, they are avoided but not steered */
+		bool bSteered;
+	};
+
+	/** Half plane of allowed velocities */
+	struct FLine
+	{
+		FVector2D Point;
+		FVector2D Direction;
+	};
+
+	typedef TArray<FLine, TInlineAllocator<16>> FLineArray;
+
+	/** collects units and sorts them to grid cells */
+	void GatherAgents(UWorld* World);
+
+	/** finds new velocity of single agent */
+	void SolveAgent(int32 AgentIndex, float DeltaSeconds);
+
+	/** passes solved velocities to movement components, rejects the ones leaving navmesh */
+	void ApplyVelocities(UWorld* World);
+
+	/** @return key of the grid cell */
+	FIntPoint GetCell(const FVector2D& Location) const;
+
+	/** linear programs from RVO2, see "Reciprocal n-body Collision Avoidance" (van den Berg et al.) */
+	static bool LinearProgram1(const FLineArray& Lines, int32 LineNo, float Radius, const FVector2D& OptVelocity, bool bDirectionOpt, FVector2D& Result);
+	static int32 LinearProgram2(const FLineArray& Lines, float Radius, const FVector2D& OptVelocity, bool bDirectionOpt, FVector2D& Result);
+	static void LinearProgram3(const FLineArray& Lines, int32 BeginLine, float Radius, FVector2D& Result);
+
+	/** only units closer than this are avoided */
+	float NeighborDistance;
+
+	/** seconds ahead the velocities have to be collision free */
+	float TimeHorizon;
+
+	/** most units avoided by single unit */
+	int32 MaxNeighbors;
+
+	/** seconds of avoidance move checked against the navmesh */
+	float NavProbeTime;
+
+	/** units of this frame */
+	TArray<FAgent> Agents;
+
+	/** agent indices sorted by cell */
+	TArray<int32> SortedAgents;
+
+	/** first sorted agent and count for each occupied cell */
+	TMap<FIntPoint, FIntPoint> Cells;
+};
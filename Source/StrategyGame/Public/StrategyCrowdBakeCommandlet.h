@@ -0,0 +1,23 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "StrategyCrowdBakeCommandlet.generated.h"
+
+/**
+ * Bakes the instanced crowd look of a unit class: static mesh of its skeletal mesh in reference pose, vertex
+ * animation texture with the clips and the material playing them. Clip layout (frame rate, first frame and
+ * frame count of each clip) is read from CrowdRender of the nearest native class of the unit, each animation
+ * is resampled to fill its clip. Baked mesh and material are written back to that class's config.
+ * Usage: -run=StrategyCrowdBake -Unit=<class path> -Output=<package path> -Idle=<anim> -Walk=<anim> -Attack=<anim> [-Death=<anim>] [-BaseColor=<texture>]
+ */
+UCLASS()
+class UStrategyCrowdBakeCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	// Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End UCommandlet interface
+};
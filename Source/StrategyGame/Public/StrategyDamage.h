@@ -0,0 +1,85 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyEntities.h"
+
+class ABaseCharacter;
+
+/** Single hit waiting for the damage pass, game rules are already applied to it. */
+struct FStrategyDamageRecord
+{
+	/** unit taking the damage */
+	FStrategyEntityHandle Victim;
+
+	/** entity which dealt the damage, unit or projectile */
+	FStrategyEntityHandle Causer;
+
+	/** controller responsible for the damage, may be null */
+	TWeakObjectPtr<AController> Instigator;
+
+	/** team of the instigator, unknown when there is none */
+	uint8 InstigatorTeamNum;
+
+	/** health taken, after damage reduction */
+	float Damage;
+};
+
+/**
+ * Damage of units, queued during the frame and applied in one pass. Team and damage reduction rules are
+ * resolved when the hit is queued, from the entity table, so the pass only subtracts health. Deaths are
+ * raised together after all health changes. Units which need TakeDamage (Blueprint damage events) opt out
+ * with bDamageThroughTakeDamage and are damaged right away through UGameplayStatics, as is every other actor.
+ */
+class FStrategyDamageQueue
+{
+public:
+	FStrategyDamageQueue();
+
+	/**
+	 * Queues damage of unit.
+	 *
+	 * @param	Entities	Entity table of the match.
+	 * @param	Victim		Unit taking the damage.
+	 * @param	Damage		Damage before game rules.
+	 * @param	Instigator	Controller responsible for the damage.
+	 * @param	Causer		Actor which dealt the damage.
+	 * @returns damage which will be applied, zero if game rules dropped it.
+	 */
+	float Queue(const FStrategyEntityTable& Entities, ABaseCharacter* Victim, float Damage, AController* Instigator, AActor* Causer);
+
+	/**
+	 * Applies all queued damage and kills units out of health.
+	 *
+	 * @param	World	World of the match.
+	 */
+	void Tick(UWorld* World);
+
+	/** Drops queued damage. */
+	void Reset();
+
+	/**
+	 * Helper for damage dealers, replacement of UGameplayStatics::ApplyPointDamage. Queues damage of units when
+	 * the match uses direct damage, passes the rest to TakeDamage.
+	 *
+	 * @returns damage which was or will be applied.
+	 */
+	static float ApplyPointDamage(AActor* DamagedActor, float Damage, const FVector& HitFromDirection, const FHitResult& HitInfo, AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageTypeClass);
+
+	/**
+	 * Friendly fire rule of queued damage, damage is dropped only between known teams.
+	 *
+	 * @param	Relations			Relations between teams.
+	 * @param	InstigatorTeamNum	Team dealing the damage, unknown for environment and neutral instigators.
+	 * @param	VictimTeamNum		Team of the unit taking the damage.
+	 * @returns true if the damage is friendly fire.
+	 */
+	static bool IsFriendlyFire(const FStrategyTeamRelations& Relations, uint8 InstigatorTeamNum, uint8 VictimTeamNum);
+
+private:
+	/** damage queued since last pass */
+	TArray<FStrategyDamageRecord> Records;
+
+	/** records which killed their victim in current pass */
+	TArray<int32> KillingRecords;
+};
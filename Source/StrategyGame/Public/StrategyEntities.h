@@ -0,0 +1,165 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "StrategyTeamRelations.h"
+
+namespace EStrategyEntity
+{
+	enum Type
+	{
+		None,
+		Unit,
+		Building,
+		Projectile,
+	};
+}
+
+/**
+ * Units, buildings and projectiles of the match, addressed by generational handles. Checking a handle is
+ * an array lookup and generation compare, no object array access. Entities are removed when they die or
+ * leave play, which bumps the generation of their slot, so all handles to them go stale at that moment.
+ * Freed slots are reused oldest first, and only once enough of them are free, so generations of single slot
+ * advance slowly; slot which runs out of generations is retired, an old handle can never match a new entity.
+ * Team and type are kept in dense arrays next to the actor, for code which filters entities without
+ * touching the actors.
+ */
+class FStrategyEntityTable
+{
+public:
+	FStrategyEntityTable();
+	~FStrategyEntityTable();
+
+	/**
+	 * Makes the table the one of the world for Get, done on first Get of the world.
+	 *
+	 * @param	InWorld		World the match is played in.
+	 */
+	void Register(const UWorld* InWorld);
+
+	/** Stops being the table of its world. */
+	void Unregister();
+
+	/**
+	 * Adds entity to the table.
+	 *
+	 * @param	Actor	Actor of the entity.
+	 * @param	Type	Kind of the entity.
+	 * @param	TeamNum	Team of the entity.
+	 * @returns handle of the entity.
+	 */
+	FStrategyEntityHandle Add(AActor* Actor, EStrategyEntity::Type Type, uint8 TeamNum);
+
+	/**
+	 * Removes entity, its handles go stale.
+	 *
+	 * @param	Handle	Handle of the entity, stale handles are ignored.
+	 */
+	void Remove(FStrategyEntityHandle Handle);
+
+	/** @return true if the entity is still in play */
+	bool IsValid(FStrategyEntityHandle Handle) const
+	{
+		const uint32 Index = Handle.GetIndex();
+		return Handle.IsSet() && Generations.IsValidIndex(Index) && Generations[Index] == Handle.GetGeneration();
+	}
+
+	/** @return actor of the entity, null if stale */
+	AActor* Get(FStrategyEntityHandle Handle) const
+	{
+		return IsValid(Handle) ? Actors[Handle.GetIndex()] : nullptr;
+	}
+
+	/** @return actor of the entity cast to the class, null if stale */
+	template<class T>
+	T* Get(FStrategyEntityHandle Handle) const
+	{
+		return Cast<T>(Get(Handle));
+	}
+
+	/** @return team of the entity, unknown if stale */
+	uint8 GetTeamNum(FStrategyEntityHandle Handle) const
+	{
+		return IsValid(Handle) ? Teams[Handle.GetIndex()] : (uint8)EStrategyTeam::Unknown;
+	}
+
+	/** @return kind of the entity, none if stale */
+	EStrategyEntity::Type GetType(FStrategyEntityHandle Handle) const
+	{
+		return IsValid(Handle) ? (EStrategyEntity::Type)Types[Handle.GetIndex()] : EStrategyEntity::None;
+	}
+
+	/**
+	 * Updates team of the entity.
+	 *
+	 * @param	Handle	Handle of the entity.
+	 * @param	TeamNum	New team.
+	 */
+	void SetTeamNum(FStrategyEntityHandle Handle, uint8 TeamNum);
+
+	/**
+	 * Calls function for every entity of the type, in table order.
+	 *
+	 * @param	Type	Kind of entities to visit.
+	 * @param	Func	Called with handle and actor of each entity.
+	 */
+	template<typename FuncType>
+	void ForEach(EStrategyEntity::Type Type, FuncType Func) const
+	{
+		for (int32 Index = 0; Index < Actors.Num(); Index++)
+		{
+			if (Types[Index] == Type)
+			{
+				Func(FStrategyEntityHandle(Index, Generations[Index]), Actors[Index]);
+			}
+		}
+	}
+
+	/** @return number of entities in play */
+	int32 Num() const { return Actors.Num() - (FreeIndices.Num() - FreeHead) - NumRetired; }
+
+	/** @return relations between teams of the match */
+	const FStrategyTeamRelations& GetTeamRelations() const { return TeamRelations; }
+	FStrategyTeamRelations& GetTeamRelations() { return TeamRelations; }
+
+	/** Removes all entities and alliances. */
+	void Reset();
+
+	/** @return handle of unit, building or projectile, unset for other actors; one interface cast */
+	static FStrategyEntityHandle GetHandle(const AActor* Actor);
+
+	/** @return entity table of the match, null without strategy game state */
+	static FStrategyEntityTable* Get(const UWorld* InWorld);
+
+private:
+	/** current generation of each slot */
+	TArray<uint32> Generations;
+
+	/** actor of each slot, null for free slots */
+	TArray<AActor*> Actors;
+
+	/** team of each slot */
+	TArray<uint8> Teams;
+
+	/** entity type of each slot */
+	TArray<uint8> Types;
+
+	/** slots free for reuse, oldest first from FreeHead on */
+	TArray<uint32> FreeIndices;
+
+	/** first slot of FreeIndices still free */
+	int32 FreeHead;
+
+	/** slots out of generations, never used again */
+	int32 NumRetired;
+
+	/** relations between teams */
+	FStrategyTeamRelations TeamRelations;
+
+	/** world of the match, while registered */
+	const UWorld* World;
+
+	/** registered tables, one per world with a match */
+	static TArray<FStrategyEntityTable*, TInlineAllocator<4>> ActiveTables;
+};
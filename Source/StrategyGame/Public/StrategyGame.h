@@ -17,6 +17,9 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogGame, Log, All);
 
+/** match systems shown by "stat StrategyGame" */
+DECLARE_STATS_GROUP(TEXT("StrategyGame"), STATGROUP_StrategyGame, STATCAT_Advanced);
+
 /** when you modify this, please note that this information can be saved with instances
  * also DefaultEngine.ini [/Script/Engine.CollisionProfile] should match with this list **/
 #define COLLISION_WEAPON		ECC_GameTraceChannel1
@@ -55,6 +55,54 @@ class UStrategyGameBlueprintLibrary : public UBlueprintFunctionLibrary
 	static class AStrategyProjectile* SpawnProjectileFromClass(UObject* WorldContextObject, TSubclassOf<class AStrategyProjectile> ProjectileClass,
 		const FVector& SpawnLocation, const FVector& ShootDirection, TEnumAsByte<EStrategyTeam::Type> OwnerTeam, int32 ImpactDamage, float LifeSpan=10.0f, class AStrategyBuilding* InOwner = NULL);
 
+	/** 
+	 * Find enemy units closest to location. Buildings should use their own FindNearestEnemies, which is cached.
+	 *
+	 * @param Origin	Location to search around.
+	 * @param Team		Team enemies are searched for.
+	 * @param Radius	Search radius.
+	 * @param MaxCount	Most enemies returned.
+	 * @returns enemies, closest first.
+	 */
+	UFUNCTION(BlueprintCallable, Category=Game, meta=(WorldContext="WorldContextObject"))
+	static TArray<class ABaseCharacter*> FindNearestEnemies(UObject* WorldContextObject, const FVector& Origin, TEnumAsByte<EStrategyTeam::Type> Team, float Radius, int32 MaxCount = 1);
+
+	/** 
+	 * Find enemy unit with lowest health in range. Buildings should use their own FindWeakestEnemy, which is cached.
+	 *
+	 * @param Origin	Location to search around.
+	 * @param Team		Team enemies are searched for.
+	 * @param Radius	Search radius.
+	 * @returns enemy, null if there is none in range.
+	 */
+	UFUNCTION(BlueprintCallable, Category=Game, meta=(WorldContext="WorldContextObject"))
+	static class ABaseCharacter* FindWeakestEnemy(UObject* WorldContextObject, const FVector& Origin, TEnumAsByte<EStrategyTeam::Type> Team, float Radius);
+
+	/** 
+	 * Find where projectile has to be aimed to hit moving target.
+	 *
+	 * @param ShotOrigin		Location projectile is spawned at.
+	 * @param ProjectileSpeed	Speed of the projectile.
+	 * @param Target			Actor to hit.
+	 * @param InterceptPoint	Point to aim at, current target location when it can't be caught.
+	 * @returns true if projectile can catch the target.
+	 */
+	UFUNCTION(BlueprintPure, Category=Game)
+	static bool PredictInterceptPoint(const FVector& ShotOrigin, float ProjectileSpeed, AActor* Target, FVector& InterceptPoint);
+
+	/** 
+	 * Play gameplay sound from pooled voices, use instead of PlaySoundAtLocation for combat, projectile and death sounds.
+	 * Sounds too far from the camera or over the voice limit of their category are dropped.
+	 *
+	 * @param Sound				Sound to play.
+	 * @param Location			Where to play it.
+	 * @param Category			Category of the sound.
+	 * @param VolumeMultiplier	Volume of the sound.
+	 * @param PitchMultiplier	Pitch of the sound.
+	 */
+	UFUNCTION(BlueprintCallable, Category=Audio, meta=(WorldContext="WorldContextObject"))
+	static void PlayGameplaySound(UObject* WorldContextObject, class USoundBase* Sound, const FVector& Location, TEnumAsByte<EStrategySoundCategory::Type> Category, float VolumeMultiplier = 1.0f, float PitchMultiplier = 1.0f);
+
 
 	/** 
 	 * Adds buff for specified strategy character.
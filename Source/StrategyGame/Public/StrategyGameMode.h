@@ -14,9 +14,9 @@ class AStrategyGameMode : public AGameModeBase
 {
 	GENERATED_UCLASS_BODY()
 
-	/** Class for empty wall slot. */
+	/** Class for empty wall slot, streamed in by the map warmup. */
 	UPROPERTY()
-	TSubclassOf<AStrategyBuilding> EmptyWallSlotClass;
+	TSoftClassPtr<AStrategyBuilding> EmptyWallSlotClass;
 
 	/** Time before game returns to menu after finish. */
 	UPROPERTY(config)
@@ -67,7 +67,7 @@ class AStrategyGameMode : public AGameModeBase
 	 * @param ActorA		First actor to test against
 	 * @param ActorB		Second actor to test against
 	 *
-	 * @return true if the two actors are on the same team.
+	 * @return true if the two actors are on the same or allied teams.
 	 */
 	static bool OnFriendlyTeam(const AActor* ActorA, const AActor* ActorB);
 
@@ -84,6 +84,13 @@ class AStrategyGameMode : public AGameModeBase
 	/** Helper method for UI, to exit game. */
 	void ExitGame();
 
+	/** 
+	 * Collect soft references which have to be loaded before the map is interactive.
+	 *
+	 * @param OutAssets		Array to add asset paths to.
+	 */
+	void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const;
+
 	/** Pointer to title text widget. */
 	TSharedPtr<SStrategyTitle> StrategyTitle;
 
@@ -91,6 +98,9 @@ protected:
 	/* Helper to return the current gameplay state. */
 	EGameplayState::Type GetGameplayState() const;
 
+	/** Map warmup finished, starts the game. */
+	void OnWarmupComplete();
+
 	/** Handle for efficient management of TickHealth timer */
 	FTimerHandle TimerHandle_ReturnToMenu;
 };
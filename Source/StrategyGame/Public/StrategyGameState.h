@@ -5,9 +5,24 @@
 #include "BaseCharacter.h"
 #include "StrategyTypes.h"
 #include "StrategyMiniMapCapture.h"
+#include "StrategyGameplayEvents.h"
+#include "StrategyEntities.h"
+#include "StrategyDamage.h"
+#include "StrategyTargetIndex.h"
+#include "StrategyAudio.h"
+#include "StrategySceneQueries.h"
+#include "StrategyVisibilityGrid.h"
+#include "StrategyCrowdAvoidance.h"
+#include "StrategyAttackSlots.h"
+#include "StrategyPathService.h"
+#include "StrategyNavFootprints.h"
+#include "StrategyCrowdRenderer.h"
+#include "StrategyMeshMerge.h"
 #include "StrategyGameState.generated.h"
 
 class AStrategyChar;
+class FStrategyTelemetryRecorder;
+class FStrategyStressRun;
 /*class AStrategyMiniMapCapture;*/
 
 UCLASS(config=Game)
@@ -29,6 +44,118 @@ public:
 	UPROPERTY(config)
 	int32 WarmupTime;
 
+	/** Record match telemetry timeline to Saved/Telemetry */
+	UPROPERTY(config)
+	bool bRecordTelemetry;
+
+	/** Seconds between telemetry samples */
+	UPROPERTY(config)
+	float TelemetrySampleInterval;
+
+	/** Size of team visibility raster cell, in world units */
+	UPROPERTY(config)
+	float VisibilityCellSize;
+
+	/** Seconds between team visibility raster updates */
+	UPROPERTY(config)
+	float VisibilityUpdateInterval;
+
+	/** Static geometry this much above unit's ground blocks its sight */
+	UPROPERTY(config)
+	float VisibilityBlockerHeight;
+
+	/** Most path queries started in single frame, the rest waits */
+	UPROPERTY(config)
+	int32 PathQueriesPerFrame;
+
+	/** Move requests with starts and goals this close share one path query */
+	UPROPERTY(config)
+	float PathMergeDistance;
+
+	/** Most paths toward breweries kept for later units */
+	UPROPERTY(config)
+	int32 PathCacheSize;
+
+	/** Seconds a cached path is used for */
+	UPROPERTY(config)
+	float PathCacheLifetime;
+
+	/** Seconds building changes are collected for before navigation is updated */
+	UPROPERTY(config)
+	float NavFootprintRebuildDelay;
+
+	/** Extra room kept free around buildings */
+	UPROPERTY(config)
+	float NavFootprintPadding;
+
+	/** Steer moving units around each other */
+	UPROPERTY(config)
+	bool bCrowdAvoidance;
+
+	/** Units closer than this are avoided */
+	UPROPERTY(config)
+	float CrowdNeighborDistance;
+
+	/** Seconds ahead unit velocities have to be collision free */
+	UPROPERTY(config)
+	float CrowdTimeHorizon;
+
+	/** Most units avoided by single unit */
+	UPROPERTY(config)
+	int32 CrowdMaxNeighbors;
+
+	/** Seconds of avoidance move checked against the navmesh */
+	UPROPERTY(config)
+	float CrowdNavProbeTime;
+
+	/** Draw units far from the camera as vertex animated instances */
+	UPROPERTY(config)
+	bool bCrowdInstancing;
+
+	/** Units farther from the camera are drawn instanced */
+	UPROPERTY(config)
+	float CrowdInstanceDistance;
+
+	/** Draw units with their attachments as one merged skeletal mesh */
+	UPROPERTY(config)
+	bool bMergeAttachmentMeshes;
+
+	/** Most loadout meshes merged in single frame */
+	UPROPERTY(config)
+	int32 MeshMergesPerFrame;
+
+	/** Queue unit damage and apply it in one pass per frame, instead of going through TakeDamage */
+	UPROPERTY(config)
+	bool bDirectDamage;
+
+	/** Most gameplay sounds of single category playing at once */
+	UPROPERTY(config)
+	int32 SoundVoicesPerCategory;
+
+	/** Gameplay sounds farther from the camera are not played */
+	UPROPERTY(config)
+	float SoundCullDistance;
+
+	/** Most audio components kept for gameplay sounds */
+	UPROPERTY(config)
+	int32 SoundPoolSize;
+
+	/** Issue gameplay traces as async queries with results on the next frame */
+	UPROPERTY(config)
+	bool bAsyncSceneQueries;
+
+	/** Stress runs fail when 95th percentile frame time is over this many milliseconds */
+	UPROPERTY(config)
+	float StressFrameTimeBudget;
+
+	/** Unit memory reports fail when counted objects of a unit with its controller take more KB than this */
+	UPROPERTY(config)
+	float UnitMemoryBudgetKB;
+
+	/** Most scheduled units spawned in single frame, by all AI directors together */
+	UPROPERTY(config)
+	int32 UnitSpawnsPerFrame;
+
 	/** Current difficulty level of the game. */
 	EGameDifficulty::Type GameDifficulty;
 
@@ -49,28 +176,58 @@ public:
 	UFUNCTION(BlueprintCallable, Category=Game)
 	void SetGamePaused(bool bIsPaused);
 
-	/** 
-	 * Notification that a character has died. 
-	 * 
-	 * @param	InChar	The character that has died.
-	 */
-	void OnCharDied(ABaseCharacter* InChar);
+	/** Gameplay event bus of the match, events are delivered once per frame. */
+	FStrategyGameplayEventBus& GetEventBus() { return EventBus; }
 
-	/** 
-	 * Notification that a character has spawned.
-	 * 
-	 * @param	InChar	The character that has died.
-	 */
-	void OnCharSpawned(ABaseCharacter* InChar);
+	/** Team visibility raster, shared by all units of a team. */
+	const FStrategyVisibilityGrid& GetVisibilityGrid() const { return VisibilityGrid; }
 
-	/** 
-	 * Notification that an actor was damaged. 
-	 * 
-	 * @param	InChar	The character that has died.
-	 * @param	Damage	The amount of damage inflicted.
-	 * @param	InChar	The controller that inflicted the damage.
+	/** Positions around attack targets, shared by all attackers. */
+	FStrategyAttackSlots& GetAttackSlots() { return AttackSlots; }
+
+	/** Finds unit paths in the background, shared by all units. */
+	FStrategyPathService& GetPathService() { return PathService; }
+
+	/** Merged meshes of unit loadouts, shared by all units. */
+	FStrategyMeshMergeCache& GetMeshMergeCache() { return MeshMergeCache; }
+
+	/** Navigation footprints of buildings. */
+	FStrategyNavFootprints& GetNavFootprints() { return NavFootprints; }
+
+	/** Units, buildings and projectiles in play, addressed by handles. */
+	FStrategyEntityTable& GetEntities() { return Entities; }
+
+	/** Unit damage waiting for the damage pass. */
+	FStrategyDamageQueue& GetDamageQueue() { return DamageQueue; }
+
+	/** Enemy searches of defensive buildings. */
+	FStrategyTargetIndex& GetTargetIndex() { return TargetIndex; }
+
+	/**
+	 * Takes one unit spawn from the budget all AI directors share this frame.
+	 *
+	 * @returns false if the budget of this frame is used up.
 	 */
-	void OnActorDamaged(AActor* InActor, float Damage, AController* EventInstigator);
+	bool ConsumeUnitSpawn();
+
+	/** Plays gameplay sounds from pooled voices. */
+	FStrategyAudioRouter& GetAudioRouter() { return AudioRouter; }
+
+	/** Gameplay traces waiting for results. */
+	FStrategySceneQueries& GetSceneQueries() { return SceneQueries; }
+
+	/** Telemetry recorder of the match, null when not recording. */
+	const FStrategyTelemetryRecorder* GetTelemetryRecorder() const { return TelemetryRecorder.Get(); }
+	FStrategyTelemetryRecorder* GetTelemetryRecorder() { return TelemetryRecorder.Get(); }
+
+	// Begin Actor interface
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** delivers gameplay events posted this frame */
+	virtual void Tick(float DeltaSeconds) override;
+	// End Actor interface
 	
 	/** 
 	 * Get a team's data. 
@@ -80,6 +237,22 @@ public:
 	 */
 	FPlayerData* GetPlayerData(uint8 TeamNum) const;
 
+	/**
+	 * Changes resources of a team and lets the listeners know.
+	 *
+	 * @param	TeamNum	The team to change.
+	 * @param	Amount	Resources added, negative when spent.
+	 */
+	void AddResources(uint8 TeamNum, int32 Amount);
+
+	/**
+	 * Sets resources of a team and lets the listeners know.
+	 *
+	 * @param	TeamNum		The team to change.
+	 * @param	NewAmount	Resources available.
+	 */
+	void SetResources(uint8 TeamNum, uint32 NewAmount);
+
 	/** 
 	 * Initialize the game-play state machine. 
 	 */
@@ -106,6 +279,13 @@ public:
 	/** Get time until game starts, in seconds. */
 	float GetRemainingWaitTime() const;
 
+	/** 
+	 * Pauses/Unpauses current game timer. 
+	 * 
+	 * @param	bIsPaused The required pause state.
+	 */
+	void SetTimersPause(bool bIsPaused);
+
 	/** Get winning team */
 	EStrategyTeam::Type GetWinningTeam() const;
 
@@ -137,26 +317,76 @@ protected:
 	/** Handle for efficient management of TickHealth timer */
 	FTimerHandle TimerHandle_OnGameStart;
 
+	/** Gameplay events posted during the frame. */
+	FStrategyGameplayEventBus EventBus;
+
+	/** Unit spawns taken from the budget this frame. */
+	int32 UnitSpawnsThisFrame;
+
+	/** What each team can see. */
+	FStrategyVisibilityGrid VisibilityGrid;
+
+	/** Steers units around each other. */
+	FStrategyCrowdAvoidance CrowdAvoidance;
+
+	/** Who attacks each target from where. */
+	FStrategyAttackSlots AttackSlots;
+
+	/** Unit move requests of the frame. */
+	FStrategyPathService PathService;
+
+	/** Buildings carved from the navmesh. */
+	FStrategyNavFootprints NavFootprints;
+
+	/** Draws distant units instanced. */
+	FStrategyCrowdRenderer CrowdRenderer;
+
+	/** Merged meshes of unit loadouts. */
+	FStrategyMeshMergeCache MeshMergeCache;
+
+	/** Entities in play. */
+	FStrategyEntityTable Entities;
+
+	/** Unit damage of this frame. */
+	FStrategyDamageQueue DamageQueue;
+
+	/** Living units sorted to grid for target queries. */
+	FStrategyTargetIndex TargetIndex;
+
+	/** Voices of gameplay sounds. */
+	FStrategyAudioRouter AudioRouter;
+
+	/** Async traces of this and last frame. */
+	FStrategySceneQueries SceneQueries;
+
+	/** Records match timeline, valid while playing if enabled. */
+	TSharedPtr<FStrategyTelemetryRecorder> TelemetryRecorder;
+
+	/** Wave stress scenario, valid when started with -StressUnits. */
+	TSharedPtr<FStrategyStressRun> StressRun;
+
+	friend class FStrategyMatchSnapshot;
+
 	/** 
-	 * Register new char to get information from it.
+	 * Count new char of a team.
 	 * 
-	 * @param	InChar		The character to register.
+	 * @param	Event	Spawn event of the character.
 	 */
-	void AddChar(ABaseCharacter* InChar);
+	void OnCharSpawned(const FStrategyGameplayEvent& Event);
 
 	/** 
-	 * Unregister char after death.
+	 * Uncount char after death and reward the other team.
 	 * 
-	 * @param	NewState	The character to remove/unregister.
+	 * @param	Event	Death event of the character.
 	 */
-	void RemoveChar(ABaseCharacter* InChar);
+	void OnCharDied(const FStrategyGameplayEvent& Event);
 
 	/** 
-	 * Pauses/Unpauses current game timer. 
+	 * Track damage done by each team.
 	 * 
-	 * @param	bIsPaused The required pause state.
+	 * @param	Event	Damage event.
 	 */
-	void SetTimersPause(bool bIsPaused);
+	void OnActorDamaged(const FStrategyGameplayEvent& Event);
 };
 
 
@@ -0,0 +1,140 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+namespace EStrategyGameplayEvent
+{
+	enum Type
+	{
+		CharSpawned,
+		CharDied,
+		ActorDamaged,
+		WaveSpawned,
+		BuildingFinished,
+		GameplayStateChanged,
+		ResourcesChanged,
+		MAX
+	};
+
+	/** @return subscription mask for single event type */
+	inline uint32 Mask(Type EventType) { return 1u << EventType; }
+
+	/** mask subscribing to all event types */
+	static const uint32 AllMask = (1u << MAX) - 1;
+}
+
+namespace EStrategyTeam
+{
+	/** @return subscription mask for single team */
+	inline uint32 Mask(uint8 TeamNum) { return 1u << TeamNum; }
+
+	/** mask subscribing to all teams */
+	static const uint32 AllMask = (1u << MAX) - 1;
+}
+
+/** Single gameplay event, copied into the bus queue. Everything needed by listeners is captured when posted. */
+struct FStrategyGameplayEvent
+{
+	/** what happened */
+	EStrategyGameplayEvent::Type Type;
+
+	/** team of the actor the event is about */
+	uint8 TeamNum;
+
+	/** team of the instigator, unknown when there is none */
+	uint8 InstigatorTeamNum;
+
+	/**
+	 * damage amount for ActorDamaged, resources worth for CharDied, resources available for ResourcesChanged,
+	 * new EGameplayState for GameplayStateChanged, unused otherwise
+	 */
+	float Value;
+
+	/** actor the event is about, may be gone when the event is dispatched */
+	TWeakObjectPtr<AActor> Actor;
+
+	/** instigator of the event, may be null */
+	TWeakObjectPtr<AController> Instigator;
+
+	FStrategyGameplayEvent()
+		: Type(EStrategyGameplayEvent::MAX)
+		, TeamNum(EStrategyTeam::Unknown)
+		, InstigatorTeamNum(EStrategyTeam::Unknown)
+		, Value(0.0f)
+	{
+	}
+};
+
+DECLARE_DELEGATE_OneParam(FOnStrategyGameplayEvent, const FStrategyGameplayEvent&);
+
+/**
+ * Queues gameplay events posted during the frame and delivers them in one batch to the subscribers
+ * interested in their type and team. Queues keep their memory between frames, so posting doesn't allocate
+ * once the match is running.
+ */
+class FStrategyGameplayEventBus
+{
+public:
+	FStrategyGameplayEventBus();
+
+	/**
+	 * Registers listener.
+	 *
+	 * @param	EventTypeMask	Combination of EStrategyGameplayEvent::Mask() of wanted events.
+	 * @param	TeamMask		Combination of EStrategyTeam::Mask() of wanted teams, matched against event TeamNum.
+	 * @param	Delegate		Delegate to call for every matching event.
+	 * @returns handle to unsubscribe with.
+	 */
+	FDelegateHandle Subscribe(uint32 EventTypeMask, uint32 TeamMask, const FOnStrategyGameplayEvent& Delegate);
+
+	/**
+	 * Removes listener.
+	 *
+	 * @param	Handle	Handle returned by Subscribe.
+	 */
+	void Unsubscribe(FDelegateHandle Handle);
+
+	/**
+	 * Queues event, it will be delivered with next Dispatch.
+	 *
+	 * @param	Event	Event to queue.
+	 */
+	void Post(const FStrategyGameplayEvent& Event);
+
+	/** Delivers all queued events. Events posted by listeners are delivered in the next batch. */
+	void Dispatch();
+
+	/** Drops all queued events and subscribers. */
+	void Reset();
+
+	/**
+	 * Helper for publishers, queues event on bus of the world's game state.
+	 *
+	 * @param	World	World the event happened in.
+	 * @param	Event	Event to queue.
+	 */
+	static void Post(const UWorld* World, const FStrategyGameplayEvent& Event);
+
+private:
+	struct FSubscriber
+	{
+		uint32 EventTypeMask;
+		uint32 TeamMask;
+		FOnStrategyGameplayEvent Delegate;
+		FDelegateHandle Handle;
+	};
+
+	/** registered listeners */
+	TArray<FSubscriber> Subscribers;
+
+	/** events posted since last dispatch */
+	TArray<FStrategyGameplayEvent> PendingEvents;
+
+	/** events being delivered, swapped with PendingEvents */
+	TArray<FStrategyGameplayEvent> DispatchedEvents;
+
+	/** true while delivering events */
+	bool bIsDispatching;
+};
@@ -0,0 +1,167 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Engine/StreamableManager.h"
+
+class AStrategyGameMode;
+class UAnimMontage;
+
+/**
+ * Warmup pipeline run behind the loading screen before the strategy map becomes interactive.
+ * Independent stages (asset streaming, navmesh build, shader pipeline precompile) run in parallel,
+ * unit warmup starts once the assets are resident: every unit and attachment mesh is drawn for a few
+ * frames in front of the camera with its anim class and montages playing, so its textures stream in
+ * and its pipeline states are created before the first wave. Every stage reports its progress and
+ * timing to the loading screen module, time-to-interactive of each map load is logged.
+ */
+class FStrategyMapWarmup
+{
+public:
+
+	static void Initialize();
+
+	static void Shutdown();
+
+	/** @return The warmup instance */
+	static FStrategyMapWarmup& Get();
+
+	/**
+	 * Gathers asset manifest for the game mode and starts all warmup stages.
+	 *
+	 * @param	GameMode	Game mode to warm the map up for.
+	 * @param	OnComplete	Called once every stage is finished.
+	 */
+	void StartWarmup(const AStrategyGameMode* GameMode, FSimpleDelegate OnComplete);
+
+	/** Returns true when all stages of the last warmup are finished. */
+	bool IsWarmupComplete() const;
+
+	/**
+	 * Notification that the map can be played, logs time-to-interactive.
+	 *
+	 * @param	World	The world that became interactive.
+	 */
+	void NotifyInteractive(const UWorld* World);
+
+private:
+	FStrategyMapWarmup();
+
+	/** Warmup stages, in the order they are displayed */
+	enum class EStage : uint8
+	{
+		Assets,
+		Navigation,
+		Shaders,
+		Units,
+		MAX
+	};
+
+	/** map load is about to start, used as beginning of time-to-interactive */
+	void OnPreLoadMap(const FString& MapName);
+
+	/** polls the stages which don't report by themselves */
+	bool Tick(float DeltaTime);
+
+	/** streamable handle progress update */
+	void OnAssetsUpdate(TSharedRef<FStreamableHandle> Handle);
+
+	/** streamable handle finished loading */
+	void OnAssetsLoaded();
+
+	/** @return progress of the navmesh build, 1 when there is nothing left to build */
+	float GetNavigationProgress();
+
+	/** @return progress of shader pipeline precompile, 1 when there is nothing left to compile */
+	float GetShadersProgress();
+
+	/** gathers meshes, anim classes and montages of units and attachments spawned during the match */
+	void GatherUnitAssets();
+
+	/** draws a few unit meshes each frame, removes them once all were drawn; @return progress of the stage */
+	float WarmupUnitAssets();
+
+	void BeginStage(EStage Stage);
+
+	void UpdateStage(EStage Stage, float Progress);
+
+	void EndStage(EStage Stage);
+
+	/** finishes warmup once all stages are done */
+	void CheckWarmupComplete();
+
+	/** manager used for async loading */
+	FStreamableManager StreamableManager;
+
+	/** keeps preloaded assets referenced while the map is played */
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+
+	/** delegate to execute when warmup finished */
+	FSimpleDelegate OnCompleteDelegate;
+
+	/** world being warmed up */
+	TWeakObjectPtr<UWorld> WarmupWorld;
+
+	/** Mesh drawn behind the loading screen */
+	struct FWarmupMesh
+	{
+		/** mesh to draw */
+		TWeakObjectPtr<USkeletalMesh> Mesh;
+
+		/** anim class to run on it, can be null */
+		TWeakObjectPtr<UClass> AnimClass;
+
+		/** montages to play on it */
+		TArray<TWeakObjectPtr<UAnimMontage>> Montages;
+	};
+
+	/** meshes left to draw */
+	TArray<FWarmupMesh> PendingMeshes;
+
+	/** number of meshes gathered for warmup */
+	int32 NumWarmupMeshes;
+
+	/** number of unit classes gathered for warmup */
+	int32 NumUnitClasses;
+
+	/** actor holding the meshes being drawn */
+	TWeakObjectPtr<AActor> WarmupActor;
+
+	/** frames left to draw the meshes added last */
+	int32 WarmupFramesLeft;
+
+	/** navmesh build tasks when the stage started */
+	int32 InitialNavigationTasks;
+
+	/** shader pipeline precompiles when the stage started */
+	uint32 InitialShaderPrecompiles;
+
+	/** which stages are running */
+	bool bStageRunning[(uint8)EStage::MAX];
+
+	/** which stages are done */
+	bool bStageDone[(uint8)EStage::MAX];
+
+	/** time when map load started */
+	double MapLoadStartTime;
+
+	/** time when warmup started */
+	double WarmupStartTime;
+
+	/** time when warmup finished */
+	double WarmupEndTime;
+
+	/** set when all stages are finished */
+	bool bIsWarmupComplete;
+
+	/** number of assets in current manifest */
+	int32 NumManifestAssets;
+
+	/** Handle for PreLoadMap delegate */
+	FDelegateHandle PreLoadMapHandle;
+
+	/** Handle for core ticker, valid while warmup runs */
+	FDelegateHandle TickerHandle;
+
+	static TSharedPtr<FStrategyMapWarmup> Instance;
+};
@@ -0,0 +1,269 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "Async/Future.h"
+
+class ABaseCharacter;
+class AStrategyBuilding;
+class AStrategyGameState;
+
+/** Resources of one team */
+struct FStrategySnapshotTeam
+{
+	uint32 ResourcesAvailable;
+	uint32 ResourcesGathered;
+	uint32 DamageDone;
+
+	FStrategySnapshotTeam()
+		: ResourcesAvailable(0)
+		, ResourcesGathered(0)
+		, DamageDone(0)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategySnapshotTeam& Team)
+	{
+		return Ar << Team.ResourcesAvailable << Team.ResourcesGathered << Team.DamageDone;
+	}
+};
+
+/** Brewery and its AI director wave state, breweries are never respawned */
+struct FStrategySnapshotBrewery
+{
+	uint8 TeamNum;
+	uint8 NumberOfLives;
+	int32 WaveSize;
+	int32 ZombieWaveSize;
+
+	/** seconds left to next spawns */
+	float DwarfSpawnDelay;
+	float ZombieSpawnDelay;
+
+	/** upgrades still available, as class table indices */
+	TArray<int32> Upgrades;
+
+	FStrategySnapshotBrewery()
+		: TeamNum(EStrategyTeam::Unknown)
+		, NumberOfLives(0)
+		, WaveSize(0)
+		, ZombieWaveSize(0)
+		, DwarfSpawnDelay(0.0f)
+		, ZombieSpawnDelay(0.0f)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategySnapshotBrewery& Brewery)
+	{
+		return Ar << Brewery.TeamNum << Brewery.NumberOfLives << Brewery.WaveSize << Brewery.ZombieWaveSize
+			<< Brewery.DwarfSpawnDelay << Brewery.ZombieSpawnDelay << Brewery.Upgrades;
+	}
+};
+
+/** Building other than brewery, including empty slots and buildings under construction */
+struct FStrategySnapshotBuilding
+{
+	/** actor name, level placed buildings are matched by it */
+	FString Name;
+	int32 ClassIndex;
+	FTransform Transform;
+	uint8 TeamNum;
+	int32 Health;
+	uint8 bIsBeingBuild;
+	uint8 bIsContructionFinished;
+	float InitialBuildTime;
+	float RemainingBuildTime;
+
+	/** 0 when not in brewery slot, 1 for left, 2 for right */
+	uint8 BrewerySlot;
+
+	FStrategySnapshotBuilding()
+		: ClassIndex(INDEX_NONE)
+		, TeamNum(EStrategyTeam::Unknown)
+		, Health(0)
+		, bIsBeingBuild(0)
+		, bIsContructionFinished(0)
+		, InitialBuildTime(0.0f)
+		, RemainingBuildTime(0.0f)
+		, BrewerySlot(0)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategySnapshotBuilding& Building)
+	{
+		return Ar << Building.Name << Building.ClassIndex << Building.Transform << Building.TeamNum << Building.Health
+			<< Building.bIsBeingBuild << Building.bIsContructionFinished << Building.InitialBuildTime << Building.RemainingBuildTime
+			<< Building.BrewerySlot;
+	}
+};
+
+/** Active buff of a unit */
+struct FStrategySnapshotBuff
+{
+	FPawnData BuffData;
+	uint8 bInfiniteDuration;
+	float Duration;
+
+	/** seconds left until the buff ends */
+	float TimeLeft;
+
+	FStrategySnapshotBuff()
+		: bInfiniteDuration(0)
+		, Duration(0.0f)
+		, TimeLeft(0.0f)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategySnapshotBuff& Buff)
+	{
+		return Ar << Buff.BuffData.AttackMin << Buff.BuffData.AttackMax << Buff.BuffData.AttackDistance << Buff.BuffData.DamageReduction
+			<< Buff.BuffData.MaxHealthBonus << Buff.BuffData.HealthRegen << Buff.BuffData.Speed
+			<< Buff.bInfiniteDuration << Buff.Duration << Buff.TimeLeft;
+	}
+};
+
+/** Live unit with its buffs, attachments and AI action */
+struct FStrategySnapshotUnit
+{
+	int32 ClassIndex;
+	FTransform Transform;
+	float AnimRateScale;
+	uint8 TeamNum;
+	float Health;
+
+	/** class table indices, INDEX_NONE when empty */
+	int32 WeaponClassIndex;
+	int32 ArmorClassIndex;
+	int32 ActionClassIndex;
+
+	TArray<FStrategySnapshotBuff> Buffs;
+
+	FStrategySnapshotUnit()
+		: ClassIndex(INDEX_NONE)
+		, AnimRateScale(1.0f)
+		, TeamNum(EStrategyTeam::Unknown)
+		, Health(0.0f)
+		, WeaponClassIndex(INDEX_NONE)
+		, ArmorClassIndex(INDEX_NONE)
+		, ActionClassIndex(INDEX_NONE)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategySnapshotUnit& Unit)
+	{
+		return Ar << Unit.ClassIndex << Unit.Transform << Unit.AnimRateScale << Unit.TeamNum << Unit.Health
+			<< Unit.WeaponClassIndex << Unit.ArmorClassIndex << Unit.ActionClassIndex << Unit.Buffs;
+	}
+};
+
+/** Header of the snapshot file */
+struct FStrategySnapshotHeader
+{
+	/** file identification */
+	uint32 Magic;
+
+	/** format version */
+	uint32 Version;
+
+	/** map the snapshot was taken on */
+	FString MapName;
+
+	/** game time when the snapshot was taken */
+	float GameTime;
+
+	/** classes referenced by the records, saved once by path */
+	TArray<FString> ClassPaths;
+
+	static const uint32 FileMagic = 0x504E5353; // 'SSNP'
+	static const uint32 FileVersion = 1;
+
+	FStrategySnapshotHeader()
+		: Magic(FileMagic)
+		, Version(FileVersion)
+		, GameTime(0.0f)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategySnapshotHeader& Header)
+	{
+		Ar << Header.Magic << Header.Version;
+		if (Header.Magic != FileMagic || Header.Version != FileVersion)
+		{
+			Ar.SetError();
+			return Ar;
+		}
+		return Ar << Header.MapName << Header.GameTime << Header.ClassPaths;
+	}
+};
+
+/**
+ * Saves and restores the whole match (team resources, breweries with their wave state, buildings with
+ * construction progress and live units) as a single versioned binary blob under Saved/Snapshots.
+ * The state is captured on the game thread and written by a background task. Loading maps the file
+ * when the platform supports it, updates level placed buildings in place and respawns units in one batch.
+ */
+class FStrategyMatchSnapshot
+{
+public:
+	/**
+	 * Captures the match and writes it in the background.
+	 *
+	 * @param	GameState	Game state of the running match.
+	 * @param	Name		Snapshot name, used as file name.
+	 * @returns true if the match was captured.
+	 */
+	static bool Save(AStrategyGameState* GameState, const FString& Name);
+
+	/**
+	 * Replaces current match state with the snapshot.
+	 *
+	 * @param	GameState	Game state of the running match.
+	 * @param	Name		Snapshot name, used as file name.
+	 * @returns true if the snapshot was applied.
+	 */
+	static bool Load(AStrategyGameState* GameState, const FString& Name);
+
+	/** @return path of the snapshot file */
+	static FString GetFilename(const FString& Name);
+
+private:
+	/** Captured match, the order matches the file layout */
+	struct FData
+	{
+		FStrategySnapshotHeader Header;
+		FStrategySnapshotTeam Teams[EStrategyTeam::MAX];
+		TArray<FStrategySnapshotBrewery> Breweries;
+		TArray<FStrategySnapshotBuilding> Buildings;
+		TArray<FStrategySnapshotUnit> Units;
+
+		/** class table lookup while capturing */
+		TMap<const UClass*, int32> ClassIndices;
+
+		/** @return index of the class in the header class table, INDEX_NONE for null */
+		int32 GetClassIndex(const UClass* Class);
+
+		friend FArchive& operator<<(FArchive& Ar, FData& Data)
+		{
+			Ar << Data.Header;
+			if (Ar.IsError())
+			{
+				return Ar;
+			}
+			for (int32 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+			{
+				Ar << Data.Teams[TeamNum];
+			}
+			return Ar << Data.Breweries << Data.Buildings << Data.Units;
+		}
+	};
+
+	static void CaptureBuilding(FData& Data, const AStrategyGameState* GameState, AStrategyBuilding* Building);
+	static void CaptureUnit(FData& Data, ABaseCharacter* Unit, float GameTime);
+
+	static void RestoreBuildings(AStrategyGameState* GameState, const FData& Data, const TArray<UClass*>& Classes);
+	static void RestoreUnits(AStrategyGameState* GameState, const FData& Data, const TArray<UClass*>& Classes);
+
+	/** write in flight, loading waits for it */
+	static TFuture<bool> PendingWrite;
+};
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "StrategyTeamInterface.h"
+#include "StrategyEntities.h"
 #include "StrategyProjectile.generated.h"
 
 class AActor;
@@ -52,6 +53,10 @@ public:
 
 	// Begin Actor interface
 
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void LifeSpanExpired() override;
 
 	/** handle touch to detect enemy pawns */
@@ -71,6 +76,9 @@ public:
 
 	// End StrategyTeamInterface interface
 
+	/** get handle in the entity table */
+	virtual FStrategyEntityHandle GetEntityHandle() const override { return EntityHandle; }
+
 protected:
 	/** deal damage */
 	void DealDamage(FHitResult const& HitResult);
@@ -78,6 +86,9 @@ protected:
 	/** current team number */
 	uint8 MyTeamNum;
 
+	/** handle in the entity table */
+	FStrategyEntityHandle EntityHandle;
+
 	/** remaining damage value */
 	int32 RemainingDamage;
 
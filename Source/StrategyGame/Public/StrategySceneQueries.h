@@ -0,0 +1,95 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+/** Called with hits of finished scene query, blocking hit last for multi queries. */
+DECLARE_DELEGATE_OneParam(FOnStrategySceneQueryDone, const TArray<FHitResult>& /*Hits*/);
+
+/**
+ * Scene queries of gameplay code, issued as async traces during the frame. The engine runs them together
+ * with the rest of the frame, results are handed to the callers on the next frame, before the damage pass.
+ * Callbacks bound to objects are skipped when the object is gone by then, raw callers cancel their queries
+ * before they go away. Without a match (or with async queries off) the query runs right away and the
+ * callback is called before returning.
+ */
+class FStrategySceneQueries
+{
+public:
+	FStrategySceneQueries();
+
+	/**
+	 * Sets up the batcher parameters.
+	 *
+	 * @param	bInAsync	Issue async traces, instead of blocking ones.
+	 */
+	void Configure(bool bInAsync);
+
+	/**
+	 * Hands results of last frame's queries to their callers.
+	 *
+	 * @param	World	World the queries were issued in.
+	 */
+	void Tick(UWorld* World);
+
+	/** Drops queries waiting for results, their callbacks are not called. */
+	void Reset();
+
+	/**
+	 * Drops queries of one caller, their callbacks are not called.
+	 *
+	 * @param	UserObject	Object the callbacks are bound to.
+	 */
+	void Cancel(const void* UserObject);
+
+	/**
+	 * Traces for the first hit of object types.
+	 *
+	 * @param	World			World to trace in.
+	 * @param	Start			Trace start.
+	 * @param	End				Trace end.
+	 * @param	ObjectParams	Object types to hit.
+	 * @param	Params			Query parameters.
+	 * @param	OnDone			Called with the hit, or no hits.
+	 */
+	static void LineTraceSingleByObjectType(UWorld* World, const FVector& Start, const FVector& End, const FCollisionObjectQueryParams& ObjectParams, const FCollisionQueryParams& Params, const FOnStrategySceneQueryDone& OnDone);
+
+	/**
+	 * Sweeps shape for all hits of channel.
+	 *
+	 * @param	World			World to sweep in.
+	 * @param	Start			Sweep start.
+	 * @param	End				Sweep end.
+	 * @param	Channel			Trace channel.
+	 * @param	Shape			Swept shape, not rotated.
+	 * @param	Params			Query parameters.
+	 * @param	ResponseParams	Responses to the channel.
+	 * @param	OnDone			Called with the hits.
+	 */
+	static void SweepMultiByChannel(UWorld* World, const FVector& Start, const FVector& End, ECollisionChannel Channel, const FCollisionShape& Shape, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParams, const FOnStrategySceneQueryDone& OnDone);
+
+private:
+	/** Async trace waiting for results */
+	struct FPendingQuery
+	{
+		FTraceHandle Handle;
+		uint64 Frame;
+		FOnStrategySceneQueryDone OnDone;
+	};
+
+	/** @return batcher of the match, null when queries should run right away */
+	static FStrategySceneQueries* Get(UWorld* World);
+
+	/** remembers async trace for next frame */
+	void AddPending(const FTraceHandle& Handle, const FOnStrategySceneQueryDone& OnDone);
+
+	/** issue async traces, set by the game state config */
+	bool bAsync;
+
+	/** async traces issued and not handed out yet */
+	TArray<FPendingQuery> Pending;
+
+	/** queries finished this frame, kept to avoid reallocations */
+	TArray<FPendingQuery> Finished;
+};
@@ -0,0 +1,285 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+class AStrategyGameState;
+
+CSV_DECLARE_CATEGORY_EXTERN(Strategy);
+
+/** Game systems timed separately by stress runs */
+namespace EStrategySubsystem
+{
+	enum Type
+	{
+		SceneQueries,
+		Damage,
+		Events,
+		Visibility,
+		AttackSlots,
+		NavFootprints,
+		Paths,
+		Crowd,
+		MeshMerge,
+		Audio,
+		CrowdRender,
+		Telemetry,
+		Spawning,
+		MAX
+	};
+
+	/** @return name of the subsystem */
+	const TCHAR* GetName(Type Subsystem);
+}
+
+/** Outcome of the last finished stress scenario */
+struct FStrategyStressResult
+{
+	/** units spawned by each side */
+	int32 NumUnits;
+
+	/** 95th percentile frame time in milliseconds */
+	float FrameTimeP95;
+
+	/** why the scenario was cut short, empty if it ran its time */
+	FString StopReason;
+
+	/** true once the scenario recorded its frames */
+	bool bFinished;
+
+	FStrategyStressResult()
+		: NumUnits(0)
+		, FrameTimeP95(0.0f)
+		, bFinished(false)
+	{
+	}
+};
+
+/**
+ * Scripted wave stress scenarios, started from the command line:
+ *
+ *   StrategyGame <map> -game -nullrhi -unattended -StressUnits=100,500,2000 [-StressSeconds=60] [-StressSpawnSeconds=10] [-StressBudgetMs=]
+ *
+ * Each scenario reloads the map. Once the match is playing, the AI director of each brewery gets a single wave
+ * of dwarfs, and the game runs with fixed time step, so every scenario covers the same simulated time however
+ * slow the frames are. CSV profiler and stat file captures run for the whole scenario. After StressSeconds of
+ * simulated time the frame time percentiles and per-subsystem costs are logged and written to Saved/Profiling,
+ * with the garbage collections of the scenario (a full one is forced once all waves are out) and the number of
+ * AI action objects alive at the end, to compare per-unit object cost between builds.
+ * When all scenarios are done the game exits with code 1 if any of them had 95th percentile frame time over
+ * the budget (StressFrameTimeBudget unless overridden). A scenario cut short, by the match ending or the map
+ * going away, or one that never starts, fails the run right away.
+ * StrategyGame.Stress automation tests run the same scenarios in process, one per map load, see RequestScenario.
+ */
+class FStrategyStressRun
+{
+public:
+	/**
+	 * Reads scenario options from the command line.
+	 *
+	 * @param	InGameState		Game state running the match.
+	 * @param	InNumUnits		Units spawned by each side.
+	 * @param	DefaultBudgetMs	95th percentile frame time budget, when not given on the command line.
+	 */
+	FStrategyStressRun(AStrategyGameState* InGameState, int32 InNumUnits, float DefaultBudgetMs);
+
+	/** Fails the run and exits when the scenario didn't finish. */
+	~FStrategyStressRun();
+
+	/**
+	 * Creates the next scenario of -StressUnits for the match.
+	 *
+	 * @param	InGameState		Game state running the match.
+	 * @param	DefaultBudgetMs	95th percentile frame time budget, when not given on the command line.
+	 * @returns scenario to run, null if stress runs are not requested.
+	 */
+	static TSharedPtr<FStrategyStressRun> CreateFromCommandLine(AStrategyGameState* InGameState, float DefaultBudgetMs);
+
+	/**
+	 * Sets up a single scenario for the next map load, the game keeps running when it's over.
+	 *
+	 * @param	InNumUnits	Units spawned by each side.
+	 */
+	static void RequestScenario(int32 InNumUnits);
+
+	/** @returns true while a scenario waits for its map or runs */
+	static bool IsScenarioPending() { return Scenarios.IsValidIndex(ScenarioIndex); }
+
+	/** @returns outcome of the last finished scenario */
+	static const FStrategyStressResult& GetLastResult() { return LastResult; }
+
+	/**
+	 * Starts the scenario when the match is playing, records frame timing and finishes the run when it's over.
+	 *
+	 * @param	DeltaSeconds	Simulated frame time.
+	 */
+	void Tick(float DeltaSeconds);
+
+	/** @returns true if subsystem timings are collected */
+	static bool IsRecording() { return ActiveRun != nullptr; }
+
+	/**
+	 * Adds time spent in a subsystem this frame.
+	 *
+	 * @param	Subsystem	Subsystem the time was spent in.
+	 * @param	Cycles		Time spent.
+	 */
+	static void AddSubsystemTime(EStrategySubsystem::Type Subsystem, uint64 Cycles);
+
+private:
+	/** progress of the scenario */
+	enum class EState : uint8
+	{
+		WaitingForMatch,
+		Running,
+		Finishing,
+		Done
+	};
+
+	/**
+	 * Stops the scenario, then runs the next one or exits.
+	 *
+	 * @param	Reason	Why the scenario was cut short, empty if it ran its time.
+	 */
+	void Stop(const FString& Reason);
+
+	/** reloads the map for the next scenario, or exits when all are done */
+	void Advance();
+
+	/** switches to fixed time step, starts captures and hands out the waves */
+	void Start();
+
+	/** stops captures and writes the summary */
+	void Finish();
+
+	/** ends the process, failing if any scenario failed; requested scenarios only end the runs */
+	static void ExitProcess();
+
+	/** asks the directors of both sides for the stress wave */
+	void StartWaves();
+
+	/** @return summary of the recorded frames, sets bPassed */
+	FString BuildSummary();
+
+	/** garbage collection starts */
+	void OnPreGarbageCollect();
+
+	/** garbage collection finished */
+	void OnPostGarbageCollect();
+
+	/** game state running the match */
+	TWeakObjectPtr<AStrategyGameState> GameState;
+
+	/** units spawned by each side */
+	int32 NumUnits;
+
+	/** simulated seconds the scenario runs for */
+	float Duration;
+
+	/** simulated seconds the waves are spawned over */
+	float SpawnDuration;
+
+	/** 95th percentile frame time budget in milliseconds */
+	float BudgetMs;
+
+	/** progress of the scenario */
+	EState State;
+
+	/** world time the scenario started at */
+	float StartTime;
+
+	/** real time of the last frame end */
+	double LastFrameTime;
+
+	/** real time the run was created at, for the start timeout */
+	double CreateTime;
+
+	/** fixed time step in use before the run */
+	bool bPrevUseFixedTimeStep;
+
+	/** fixed frame time in use before the run */
+	double PrevFixedDeltaTime;
+
+	/** real frame times in milliseconds */
+	TArray<float> FrameTimes;
+
+	/** per frame milliseconds of each subsystem */
+	TArray<float> SubsystemTimes[EStrategySubsystem::MAX];
+
+	/** cycles spent in each subsystem this frame */
+	uint64 FrameSubsystemCycles[EStrategySubsystem::MAX];
+
+	/** most living units of each team seen */
+	int32 MaxLivePawns[EStrategyTeam::MAX];
+
+	/** true if the scenario stayed in budget */
+	bool bPassed;
+
+	/** 95th percentile frame time in milliseconds, set by BuildSummary */
+	float FrameTimeP95;
+
+	/** why the scenario was cut short, empty if it ran its time */
+	FString StopReason;
+
+	/** milliseconds of each garbage collection during the scenario */
+	TArray<float> GCTimes;
+
+	/** real time the running garbage collection started at */
+	double GCStartTime;
+
+	/** set once the full collection with all units out was requested */
+	bool bForcedGC;
+
+	/** AI action objects alive when the scenario ended, class defaults included */
+	int32 NumAIActionObjects;
+
+	/** handles of garbage collection delegates */
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+
+	/** run collecting subsystem timings */
+	static FStrategyStressRun* ActiveRun;
+
+	/** units per side of each scenario, from the command line or RequestScenario */
+	static TArray<int32> Scenarios;
+
+	/** scenario the current map runs */
+	static int32 ScenarioIndex;
+
+	/** true if any scenario so far failed */
+	static bool bAnyFailed;
+
+	/** false when scenarios were requested in process */
+	static bool bExitWhenDone;
+
+	/** outcome of the last finished scenario */
+	static FStrategyStressResult LastResult;
+};
+
+/** Times the enclosing scope as a subsystem for CSV captures and stress runs */
+struct FStrategySubsystemScope
+{
+	explicit FStrategySubsystemScope(EStrategySubsystem::Type InSubsystem)
+		: Subsystem(InSubsystem)
+		, StartCycles(FStrategyStressRun::IsRecording() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FStrategySubsystemScope()
+	{
+		if (StartCycles != 0)
+		{
+			FStrategyStressRun::AddSubsystemTime(Subsystem, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	EStrategySubsystem::Type Subsystem;
+	uint64 StartCycles;
+};
+
+#define STRATEGY_SUBSYSTEM_SCOPE(Name) \
+	CSV_SCOPED_TIMING_STAT(Strategy, Name); \
+	FStrategySubsystemScope StrategySubsystemScope_##Name(EStrategySubsystem::Name)
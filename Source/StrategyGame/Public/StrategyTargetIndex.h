@@ -0,0 +1,104 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyEntities.h"
+
+class ABaseCharacter;
+
+/**
+ * Grid of living units for target queries of defensive buildings. Built on the first query of a frame from
+ * the entity table, frames without queries cost nothing. Results are cached per querying building for the
+ * rest of the frame, so Blueprints asking every tick don't repeat the search; a cached result with a unit
+ * which died since is searched again. Ranges covering more cells than are occupied check all units instead.
+ */
+class FStrategyTargetIndex
+{
+public:
+	FStrategyTargetIndex();
+
+	/**
+	 * Finds enemies closest to location.
+	 *
+	 * @param	World		World with the units.
+	 * @param	Querier		Building asking, results are cached for it. Unset to skip caching.
+	 * @param	Origin		Location to search around.
+	 * @param	TeamNum		Team enemies are searched for.
+	 * @param	Radius		Search radius.
+	 * @param	MaxCount	Most enemies returned.
+	 * @param	OutEnemies	Enemies, closest first.
+	 */
+	void FindNearestEnemies(UWorld* World, FStrategyEntityHandle Querier, const FVector& Origin, uint8 TeamNum, float Radius, int32 MaxCount, TArray<ABaseCharacter*>& OutEnemies);
+
+	/**
+	 * Finds enemy with lowest health in range, closer one wins ties.
+	 *
+	 * @param	World		World with the units.
+	 * @param	Querier		Building asking, results are cached for it. Unset to skip caching.
+	 * @param	Origin		Location to search around.
+	 * @param	TeamNum		Team enemies are searched for.
+	 * @param	Radius		Search radius.
+	 * @returns enemy, null if there is none in range.
+	 */
+	ABaseCharacter* FindWeakestEnemy(UWorld* World, FStrategyEntityHandle Querier, const FVector& Origin, uint8 TeamNum, float Radius);
+
+	/**
+	 * Finds where projectile has to be shot to meet target moving at constant velocity.
+	 *
+	 * @param	ShotOrigin		Location projectile starts at.
+	 * @param	ProjectileSpeed	Speed of the projectile.
+	 * @param	TargetLocation	Current location of the target.
+	 * @param	TargetVelocity	Velocity of the target.
+	 * @param	OutIntercept	Meeting point, current target location when there is none.
+	 * @returns true if projectile can catch the target.
+	 */
+	static bool PredictIntercept(const FVector& ShotOrigin, float ProjectileSpeed, const FVector& TargetLocation, const FVector& TargetVelocity, FVector& OutIntercept);
+
+	/** Drops the grid and cached results. */
+	void Reset();
+
+private:
+	/** Living unit in the grid */
+	struct FTarget
+	{
+		FStrategyEntityHandle Handle;
+		FVector Location;
+		float Health;
+		uint8 TeamNum;
+	};
+
+	/** Query of single building, weakest enemy queries have no count */
+	struct FQueryKey
+	{
+		FStrategyEntityHandle Querier;
+		float Radius;
+		int32 MaxCount;
+
+		bool operator==(const FQueryKey& Other) const { return Querier == Other.Querier && Radius == Other.Radius && MaxCount == Other.MaxCount; }
+		friend uint32 GetTypeHash(const FQueryKey& Key) { return HashCombine(GetTypeHash(Key.Querier), HashCombine(GetTypeHash(Key.Radius), GetTypeHash(Key.MaxCount))); }
+	};
+
+	/** rebuilds the grid once per frame, drops cached results of the previous frame */
+	const FStrategyEntityTable* Update(UWorld* World);
+
+	/** collects enemies in range with their squared distances */
+	void GatherEnemies(const FStrategyEntityTable& Entities, const FVector& Origin, uint8 TeamNum, float Radius, TArray<TPair<float, int32>>& OutEnemies) const;
+
+	/** @return key of the grid cell */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** living units of this frame */
+	TArray<FTarget> Targets;
+
+	/** target indices sorted by cell */
+	TArray<int32> SortedTargets;
+
+	/** first sorted target and count for each occupied cell */
+	TMap<FIntPoint, FIntPoint> Cells;
+
+	/** frame the grid was built in */
+	uint64 BuiltFrame;
+
+	/** results of this frame, by querying building */
+	TMap<FQueryKey, TArray<FStrategyEntityHandle>> CachedResults;
+};
@@ -0,0 +1,75 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+namespace EStrategyTeamRelation
+{
+	enum Type
+	{
+		Neutral,
+		Friendly,
+		Enemy,
+	};
+}
+
+/**
+ * Relation of every team to every other team, looked up with two array indices. Sized for more factions than
+ * the two of the default match. Unknown team is friendly to everybody, other teams are hostile to each other
+ * unless allied.
+ */
+struct FStrategyTeamRelations
+{
+	/** number of teams the matrix has room for */
+	static constexpr int32 MaxTeams = 8;
+
+	static_assert(EStrategyTeam::MAX <= MaxTeams, "Team relations are too small for EStrategyTeam");
+
+	FStrategyTeamRelations()
+	{
+		Reset();
+	}
+
+	/** @return relation of team A towards team B, neutral for teams out of range */
+	EStrategyTeamRelation::Type GetRelation(int32 TeamA, int32 TeamB) const
+	{
+		return ((uint32)TeamA < (uint32)MaxTeams && (uint32)TeamB < (uint32)MaxTeams) ? (EStrategyTeamRelation::Type)Relations[TeamA][TeamB] : EStrategyTeamRelation::Neutral;
+	}
+
+	bool IsFriendly(int32 TeamA, int32 TeamB) const { return GetRelation(TeamA, TeamB) == EStrategyTeamRelation::Friendly; }
+	bool IsEnemy(int32 TeamA, int32 TeamB) const { return GetRelation(TeamA, TeamB) == EStrategyTeamRelation::Enemy; }
+
+	/**
+	 * Makes two teams allies or enemies, both ways.
+	 *
+	 * @param	TeamA	First team.
+	 * @param	TeamB	Second team.
+	 * @param	bAllied	Whether teams are friendly to each other.
+	 */
+	void SetAllied(int32 TeamA, int32 TeamB, bool bAllied)
+	{
+		if ((uint32)TeamA < (uint32)MaxTeams && (uint32)TeamB < (uint32)MaxTeams && TeamA != TeamB
+			&& TeamA != EStrategyTeam::Unknown && TeamB != EStrategyTeam::Unknown)
+		{
+			Relations[TeamA][TeamB] = Relations[TeamB][TeamA] = bAllied ? EStrategyTeamRelation::Friendly : EStrategyTeamRelation::Enemy;
+		}
+	}
+
+	/** Restores default relations, no alliances. */
+	void Reset()
+	{
+		for (int32 TeamA = 0; TeamA < MaxTeams; TeamA++)
+		{
+			for (int32 TeamB = 0; TeamB < MaxTeams; TeamB++)
+			{
+				const bool bFriendly = TeamA == TeamB || TeamA == EStrategyTeam::Unknown || TeamB == EStrategyTeam::Unknown;
+				Relations[TeamA][TeamB] = bFriendly ? EStrategyTeamRelation::Friendly : EStrategyTeamRelation::Enemy;
+			}
+		}
+	}
+
+private:
+	/** relation of row team towards column team */
+	uint8 Relations[MaxTeams][MaxTeams];
+};
@@ -0,0 +1,219 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyGameplayEvents.h"
+#include "Async/Future.h"
+
+class AStrategyGameState;
+class IFileHandle;
+
+/** Per team values of one telemetry sample */
+struct FStrategyTelemetryTeamSample
+{
+	/** resources available at the end of the interval */
+	uint32 ResourcesAvailable;
+
+	/** total resources gathered */
+	uint32 ResourcesGathered;
+
+	/** total damage done */
+	uint32 DamageDone;
+
+	/** live pawns at the end of the interval */
+	uint32 LivePawns;
+
+	/** pawns spawned during the interval */
+	uint16 Spawns;
+
+	/** pawns died during the interval */
+	uint16 Deaths;
+
+	/** waves finished spawning during the interval */
+	uint16 WavesSpawned;
+
+	/** buildings finished during the interval */
+	uint16 BuildingsFinished;
+
+	FStrategyTelemetryTeamSample()
+	{
+		FMemory::Memzero(*this);
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategyTelemetryTeamSample& Sample)
+	{
+		return Ar << Sample.ResourcesAvailable << Sample.ResourcesGathered << Sample.DamageDone << Sample.LivePawns
+			<< Sample.Spawns << Sample.Deaths << Sample.WavesSpawned << Sample.BuildingsFinished;
+	}
+};
+
+/** One telemetry sample, recorded every SampleInterval seconds */
+struct FStrategyTelemetrySample
+{
+	/** game time at the end of the interval */
+	float Time;
+
+	/** average frame time during the interval, in ms */
+	float FrameTimeMs;
+
+	/** longest frame during the interval, in ms */
+	float MaxFrameTimeMs;
+
+	/** average time spent in AI controllers per frame, in ms */
+	float AITimeMs;
+
+	/** values for player and enemy team */
+	FStrategyTelemetryTeamSample Teams[EStrategyTeam::MAX - 1];
+
+	FStrategyTelemetrySample()
+		: Time(0.0f)
+		, FrameTimeMs(0.0f)
+		, MaxFrameTimeMs(0.0f)
+		, AITimeMs(0.0f)
+	{
+	}
+
+	/** @return values for team, TeamNum must not be unknown */
+	FStrategyTelemetryTeamSample& GetTeam(uint8 TeamNum) { check(TeamNum > EStrategyTeam::Unknown && TeamNum < EStrategyTeam::MAX); return Teams[TeamNum - 1]; }
+	const FStrategyTelemetryTeamSample& GetTeam(uint8 TeamNum) const { check(TeamNum > EStrategyTeam::Unknown && TeamNum < EStrategyTeam::MAX); return Teams[TeamNum - 1]; }
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategyTelemetrySample& Sample)
+	{
+		Ar << Sample.Time << Sample.FrameTimeMs << Sample.MaxFrameTimeMs << Sample.AITimeMs;
+		for (int32 Idx = 0; Idx < UE_ARRAY_COUNT(Sample.Teams); Idx++)
+		{
+			Ar << Sample.Teams[Idx];
+		}
+		return Ar;
+	}
+};
+
+/** Header of the telemetry timeline file, followed by fixed size samples until the end of file */
+struct FStrategyTelemetryHeader
+{
+	/** file identification */
+	uint32 Magic;
+
+	/** format version */
+	uint32 Version;
+
+	/** map the match was played on */
+	FString MapName;
+
+	/** real time when the recording started */
+	FDateTime StartTime;
+
+	/** seconds between samples */
+	float SampleInterval;
+
+	static const uint32 FileMagic = 0x4D4C5453; // 'STLM'
+	static const uint32 FileVersion = 1;
+
+	FStrategyTelemetryHeader()
+		: Magic(FileMagic)
+		, Version(FileVersion)
+		, SampleInterval(1.0f)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FStrategyTelemetryHeader& Header)
+	{
+		return Ar << Header.Magic << Header.Version << Header.MapName << Header.StartTime << Header.SampleInterval;
+	}
+};
+
+/**
+ * Records per second match timeline (team resources, pawns, damage, waves, buildings, frame and AI timings)
+ * into a compact binary file under Saved/Telemetry. Samples are buffered and written by a background task.
+ * The last samples are kept in memory for the in-game graph.
+ */
+class FStrategyTelemetryRecorder
+{
+public:
+	/**
+	 * Opens the timeline file and starts listening to gameplay events.
+	 *
+	 * @param	InGameState		Game state to sample.
+	 * @param	SampleInterval	Seconds between samples.
+	 */
+	FStrategyTelemetryRecorder(AStrategyGameState* InGameState, float SampleInterval);
+
+	/** Writes remaining samples and closes the file. */
+	~FStrategyTelemetryRecorder();
+
+	/**
+	 * Accumulates frame timing, records sample when the interval has passed.
+	 *
+	 * @param	DeltaSeconds	Frame time.
+	 */
+	void Tick(float DeltaSeconds);
+
+	/** @return samples kept in memory for the graph, oldest first */
+	const TArray<FStrategyTelemetrySample>& GetRecentSamples() const { return RecentSamples; }
+
+	/** @return path of the timeline file */
+	const FString& GetFilename() const { return Filename; }
+
+	/**
+	 * Adds time spent in AI logic this frame, called by AI controllers.
+	 *
+	 * @param	Seconds		Time spent.
+	 */
+	void AddAITime(double Seconds) { AccumulatedAITime += Seconds; }
+
+	/**
+	 * Reads timeline file written by the recorder.
+	 *
+	 * @param	InFilename	File to read.
+	 * @param	OutHeader	File header.
+	 * @param	OutSamples	Samples from the file.
+	 * @returns true if the file was read.
+	 */
+	static bool LoadTimeline(const FString& InFilename, FStrategyTelemetryHeader& OutHeader, TArray<FStrategyTelemetrySample>& OutSamples);
+
+private:
+	/** counts events for the current sample */
+	void OnGameplayEvent(const FStrategyGameplayEvent& Event);
+
+	/** fills current sample with team state and queues it for writing */
+	void RecordSample();
+
+	/** hands buffered samples over to the background writer */
+	void FlushBuffer();
+
+	/** game state being sampled */
+	TWeakObjectPtr<AStrategyGameState> GameState;
+
+	/** subscription on the gameplay event bus */
+	FDelegateHandle EventBusHandle;
+
+	/** timeline file, written by the background task */
+	TSharedPtr<IFileHandle> FileHandle;
+
+	/** path of the timeline file */
+	FString Filename;
+
+	/** write in flight, at most one at a time to keep the order */
+	TFuture<void> PendingWrite;
+
+	/** serialized samples waiting for write */
+	TArray<uint8> WriteBuffer;
+
+	/** last samples for the graph */
+	TArray<FStrategyTelemetrySample> RecentSamples;
+
+	/** sample being accumulated */
+	FStrategyTelemetrySample CurrentSample;
+
+	/** seconds between samples */
+	float SampleInterval;
+
+	/** time accumulated since last sample */
+	float IntervalTime;
+
+	/** frames accumulated since last sample */
+	int32 IntervalFrames;
+
+	/** time spent in AI logic since last sample */
+	double AccumulatedAITime;
+};
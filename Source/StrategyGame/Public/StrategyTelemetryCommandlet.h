@@ -0,0 +1,30 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "StrategyTelemetryCommandlet.generated.h"
+
+struct FStrategyTelemetryHeader;
+struct FStrategyTelemetrySample;
+
+/**
+ * Converts telemetry timeline recorded during a match into CSV and JSON.
+ * Usage: -run=StrategyTelemetry -File=<timeline.stlm> [-Format=csv|json|all]
+ */
+UCLASS()
+class UStrategyTelemetryCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	// Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End UCommandlet interface
+
+private:
+	/** writes one row per sample */
+	static FString ToCSV(const FStrategyTelemetryHeader& Header, const TArray<FStrategyTelemetrySample>& Samples);
+
+	/** writes header object with array of samples */
+	static FString ToJSON(const FStrategyTelemetryHeader& Header, const TArray<FStrategyTelemetrySample>& Samples);
+};
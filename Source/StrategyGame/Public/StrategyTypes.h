@@ -51,6 +51,20 @@ namespace EGameDifficulty
 	};
 }
 
+/** Gameplay sound categories, each with its own voice limit */
+UENUM(BlueprintType)
+namespace EStrategySoundCategory
+{
+	enum Type
+	{
+		Building,
+		Combat,
+		Projectile,
+		Death,
+		MAX UMETA(Hidden)
+	};
+}
+
 DECLARE_DELEGATE_RetVal(bool, FActionButtonDelegate);
 DECLARE_DELEGATE_RetVal(FText, FGetQueueLength)
 
@@ -164,8 +178,46 @@ struct FBuffData
 	void ApplyBuff(struct FPawnData& PawnData);
 };
 
+/** Generational handle of game entity, stays invalid forever once the entity is removed */
+struct FStrategyEntityHandle
+{
+	/** bits of table index, the rest is generation */
+	static const uint32 IndexBits = 20;
+	static const uint32 IndexMask = (1u << IndexBits) - 1;
+
+	FStrategyEntityHandle()
+		: Value(0)
+	{
+	}
+
+	FStrategyEntityHandle(uint32 Index, uint32 Generation)
+		: Value((Generation << IndexBits) | (Index & IndexMask))
+	{
+	}
+
+	/** @return true if handle was ever set, it may be stale already */
+	bool IsSet() const { return Value != 0; }
+
+	uint32 GetIndex() const { return Value & IndexMask; }
+	uint32 GetGeneration() const { return Value >> IndexBits; }
+
+	bool operator==(const FStrategyEntityHandle& Other) const { return Value == Other.Value; }
+	bool operator!=(const FStrategyEntityHandle& Other) const { return Value != Other.Value; }
+	friend uint32 GetTypeHash(const FStrategyEntityHandle& Handle) { return Handle.Value; }
+
+private:
+	uint32 Value;
+};
+
 struct FPlayerData
 {
+	FPlayerData()
+		: ResourcesAvailable(0)
+		, ResourcesGathered(0)
+		, DamageDone(0)
+	{
+	}
+
 	/** current resources */
 	uint32 ResourcesAvailable;
 
@@ -178,6 +230,29 @@ struct FPlayerData
 	/** HQ */
 	TWeakObjectPtr<class AStrategyBuilding_Brewery> Brewery;
 
-	/** player owned buildings list */
-	TArray<TWeakObjectPtr<class AActor>> BuildingsList;
+	/** entity handles of player owned buildings, kept compact: removed entries are swapped with the last one. Buildings remove themselves when destroyed. */
+	TArray<FStrategyEntityHandle> BuildingsList;
+
+	/** number of owned buildings per class, the class is only used as a key */
+	TMap<const UClass*, int32> BuildingCounts;
+
+	/** 
+	 * Adds building to the list and class counters, building keeps its list index as a handle.
+	 *
+	 * @param	Building	Building to add.
+	 */
+	void AddBuilding(class AStrategyBuilding* Building);
+
+	/** 
+	 * Removes building from the list and class counters in constant time.
+	 *
+	 * @param	Building	Building added before.
+	 */
+	void RemoveBuilding(class AStrategyBuilding* Building);
+
+	/** 
+	 * @param	BuildingClass	Class to count.
+	 * @returns number of owned buildings of exactly this class.
+	 */
+	int32 GetBuildingCount(const UClass* BuildingClass) const;
 };
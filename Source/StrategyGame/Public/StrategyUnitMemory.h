@@ -0,0 +1,101 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+class ABaseCharacter;
+class UStrategyAttachment;
+
+/** Unit measured by memory report */
+struct FStrategyUnitMemorySetup
+{
+	/** class of the unit */
+	TSubclassOf<ABaseCharacter> UnitClass;
+
+	/** weapon given to minions, can be null */
+	TSubclassOf<UStrategyAttachment> Weapon;
+
+	/** armor given to minions, can be null */
+	TSubclassOf<UStrategyAttachment> Armor;
+};
+
+/** Memory of unit objects of one class */
+struct FStrategyUnitMemoryItem
+{
+	/** class of the objects */
+	FName ClassName;
+
+	/** objects of the class per unit */
+	int32 NumObjects;
+
+	/** bytes of the objects and containers of their properties */
+	int64 ObjectBytes;
+
+	/** bytes of native allocations reported by the objects */
+	int64 NativeBytes;
+};
+
+/**
+ * Memory footprint of single unit: the pawn with its components, anim instance and attachments, and its
+ * controller with everything it owns. Objects are counted by class, with their properties and native
+ * allocations; growth of used process memory is measured as well, it includes allocator overhead and
+ * engine data not owned by the objects (physics bodies, render proxies). Budget is checked against the
+ * counted bytes only, they come out the same on every run; process growth depends on allocator state and
+ * whatever else runs meanwhile, so it's reported for reference.
+ */
+class FStrategyUnitMemoryReport
+{
+public:
+	FStrategyUnitMemoryReport();
+
+	/**
+	 * Spawns units, measures them and destroys them again. Units don't count for the teams.
+	 *
+	 * @param	World		World to spawn in.
+	 * @param	InSetup		Unit to measure.
+	 * @param	InNumUnits	Units spawned, the report is their average.
+	 * @param	Origin		Where to spawn them.
+	 * @returns true if units were spawned.
+	 */
+	bool Measure(UWorld* World, const FStrategyUnitMemorySetup& InSetup, int32 InNumUnits, const FVector& Origin);
+
+	/** @return counted bytes of single unit with its controller */
+	int64 GetBytesPerUnit() const;
+
+	/**
+	 * Checks counted bytes per unit against the budget, process memory growth doesn't count.
+	 *
+	 * @param	BudgetKB	Most counted KB per unit allowed, zero or less for no budget.
+	 * @returns true if the unit is within the budget.
+	 */
+	bool IsInBudget(float BudgetKB) const;
+
+	/** @return growth of used process memory per unit, for reference only */
+	int64 GetProcessBytesPerUnit() const { return ProcessBytesPerUnit; }
+
+	/**
+	 * Formats the report, biggest classes first.
+	 *
+	 * @param	BudgetKB	Most counted KB per unit allowed.
+	 * @param	OutLines	Lines of the report.
+	 * @returns true if the unit is within the budget, see IsInBudget.
+	 */
+	bool GetLines(float BudgetKB, TArray<FString>& OutLines) const;
+
+private:
+	/** adds object and its subobjects to the class items */
+	void CountObject(UObject* Object);
+
+	/** unit measured */
+	FStrategyUnitMemorySetup Setup;
+
+	/** units spawned */
+	int32 NumUnits;
+
+	/** growth of used process memory per unit */
+	int64 ProcessBytesPerUnit;
+
+	/** per unit memory by class */
+	TArray<FStrategyUnitMemoryItem> Items;
+};
@@ -0,0 +1,23 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "StrategyUnitMemoryCommandlet.generated.h"
+
+/**
+ * Spawns units of each given class in an empty world and reports their memory per unit, broken down by class
+ * of the objects they own. Fails when counted bytes of a unit are over UnitMemoryBudgetKB of the game state
+ * (or -BudgetKB); process memory growth is logged, but doesn't fail the run. StrategyGame.Units.MemoryBudget
+ * automation test checks the same for the dwarf loadouts.
+ * Usage: -run=StrategyUnitMemory -Units=<class path>[,<class path>...] [-Weapon=<class path>] [-Armor=<class path>] [-Count=100] [-BudgetKB=<KB>]
+ */
+UCLASS()
+class UStrategyUnitMemoryCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	// Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End UCommandlet interface
+};
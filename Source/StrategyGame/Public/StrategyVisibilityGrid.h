@@ -0,0 +1,143 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+/**
+ * Team shared visibility raster (fog of war) over the world bounds.
+ * Static occluders are sampled once into a height map by async traces, every unit then casts shadows over it
+ * within its sight radius. Visible cells are reference counted per team, so only units which
+ * moved to another cell (or appeared / died) are recomputed on each update.
+ */
+class FStrategyVisibilityGrid
+{
+public:
+	FStrategyVisibilityGrid();
+
+	/**
+	 * Sets up the raster parameters, grid is (re)built on next update.
+	 *
+	 * @param	InCellSize			Size of single cell in world units.
+	 * @param	InUpdateInterval	Seconds between updates.
+	 * @param	InBlockerHeight		Static geometry this much above viewer's ground blocks the sight.
+	 * @param	InDefaultSightRadius	Sight radius of units without sensing component.
+	 */
+	void Configure(float InCellSize, float InUpdateInterval, float InBlockerHeight, float InDefaultSightRadius);
+
+	/**
+	 * Updates the raster at fixed rate.
+	 *
+	 * @param	World			World with the units.
+	 * @param	WorldBounds		Area covered by the raster.
+	 * @param	DeltaSeconds	Frame time.
+	 */
+	void Tick(UWorld* World, const FBox& WorldBounds, float DeltaSeconds);
+
+	/** Drops the raster and all viewers. */
+	void Reset();
+
+	/** @return true when the raster was built and can be queried */
+	bool IsValid() const { return SizeX > 0 && SizeY > 0; }
+
+	/**
+	 * @param	TeamNum		Team to test.
+	 * @param	Location	World location to test.
+	 * @returns true if any unit of the team sees the location.
+	 */
+	bool IsVisible(uint8 TeamNum, const FVector& Location) const;
+
+	/** @return number of cells along world X */
+	int32 GetSizeX() const { return SizeX; }
+
+	/** @return number of cells along world Y */
+	int32 GetSizeY() const { return SizeY; }
+
+	/** @return true if cell is visible for the team */
+	bool IsCellVisible(uint8 TeamNum, int32 X, int32 Y) const { return TeamVisibility[TeamNum][Y * SizeX + X] > 0; }
+
+	/** @return counter incremented each time visibility changes, for overlays to know when to refresh */
+	uint32 GetVersion() const { return Version; }
+
+private:
+	/** Unit revealing the raster for its team */
+	struct FViewer
+	{
+		uint8 TeamNum;
+		int32 CellIndex;
+		int32 RadiusCells;
+		TArray<int32> VisibleCells;
+		bool bSeen;
+	};
+
+	/** starts sampling static geometry height for every cell */
+	void BuildHeightMap(UWorld* World, const FBox& WorldBounds);
+
+	/** stores height of the cell, floor height when nothing was hit */
+	void OnHeightTraced(const TArray<FHitResult>& Hits, int32 CellIndex, uint32 Build, float FloorHeight);
+
+	/** recomputes moved viewers and drops dead ones */
+	void UpdateViewers(UWorld* World);
+
+	/** adds (or removes) viewer's visible cells to its team raster */
+	void ApplyViewer(const FViewer& Viewer, int32 Delta);
+
+	/** computes cells visible from viewer's cell */
+	void ComputeVisibleCells(FViewer& Viewer);
+
+	/** recursive shadowcasting over one octant */
+	void CastOctant(int32 OriginX, int32 OriginY, float ViewerHeight, int32 RadiusCells, int32 Row, float StartSlope, float EndSlope,
+		int32 XX, int32 XY, int32 YX, int32 YY, TArray<int32>& OutCells);
+
+	/** @return cell index for world location, INDEX_NONE when outside */
+	int32 GetCellIndex(const FVector& Location) const;
+
+	/** size of single cell in world units */
+	float CellSize;
+
+	/** seconds between updates */
+	float UpdateInterval;
+
+	/** static geometry this much above viewer's ground blocks the sight */
+	float BlockerHeight;
+
+	/** sight radius of units without sensing component */
+	float DefaultSightRadius;
+
+	/** time left to next update */
+	float TimeToUpdate;
+
+	/** area covered by the raster */
+	FBox2D Bounds;
+
+	/** raster size */
+	int32 SizeX;
+	int32 SizeY;
+
+	/** height of static geometry in each cell */
+	TArray<float> Heights;
+
+	/** number of team units seeing each cell */
+	TArray<uint16> TeamVisibility[EStrategyTeam::MAX];
+
+	/** per cell stamp used to skip cells already found from current viewer */
+	TArray<uint32> CellStamps;
+
+	/** current stamp */
+	uint32 Stamp;
+
+	/** known viewers by unit */
+	TMap<TWeakObjectPtr<AActor>, FViewer> Viewers;
+
+	/** incremented when visibility changes */
+	uint32 Version;
+
+	/** height traces still running, viewers are not updated until they finish */
+	int32 NumPendingHeights;
+
+	/** incremented when the height map is dropped, traces of older builds are ignored */
+	uint32 HeightMapBuild;
+
+	/** time the height map build started */
+	double HeightMapStartTime;
+};
@@ -0,0 +1,21 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "StrategyWaveScheduleCommandlet.generated.h"
+
+/**
+ * Validates wave schedule asset and plays its spawn plan at fixed frame rate, logging per wave how long
+ * the spawns take and how late the frame budget makes them.
+ * Usage: -run=StrategyWaveSchedule -Schedule=<asset path> [-FPS=30] [-Waves=<count>]
+ */
+UCLASS()
+class UStrategyWaveScheduleCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	// Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End UCommandlet interface
+};
@@ -47,6 +47,15 @@ public:
 	/** Enables the black screen, used for transition from game */
 	void ShowBlackScreen();
 
+	/** Toggles graph of recent telemetry samples */
+	void ToggleTelemetryGraph();
+
+	/** Toggles fog of war overlay on the mini map */
+	void ToggleFogOfWar();
+
+	/** collect soft references which have to be loaded before the HUD is drawn */
+	void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const;
+
 	/** position to display action grid */
 	FVector2D ActionGridPos;
 
@@ -55,11 +64,11 @@ public:
 
 	/** default action texture to use */
 	UPROPERTY()
-	UTexture2D* DefaultActionTexture;
+	TSoftObjectPtr<UTexture2D> DefaultActionTexture;
 
 	/** bigger, centered action default texture */
 	UPROPERTY()
-	UTexture2D* DefaultCenterActionTexture;
+	TSoftObjectPtr<UTexture2D> DefaultCenterActionTexture;
 
 	/** minimap frustum points */
 	FVector2D MiniMapPoints[4];
@@ -94,6 +103,25 @@ protected:
 	/** draw health bars for actors */
 	void DrawActorsHealth();
 
+	/** draw graph of recent telemetry samples */
+	void DrawTelemetryGraph();
+
+	/** is telemetry graph displayed? */
+	bool bShowTelemetryGraph;
+
+	/** updates fog of war texture from player team visibility, if it changed */
+	void UpdateFogOfWarTexture(const FStrategyVisibilityGrid& VisibilityGrid);
+
+	/** is fog of war displayed on mini map? */
+	bool bShowFogOfWar;
+
+	/** visibility version the fog of war texture was built from */
+	uint32 FogOfWarVersion;
+
+	/** fog of war drawn over the mini map, one texel per visibility cell */
+	UPROPERTY()
+	UTexture2D* FogOfWarTexture;
+
 	/** gets position to display action grid */
 	FVector2D GetActionsWidgetPos() const;
 
@@ -108,39 +136,39 @@ protected:
 
 	/** gray health bar texture */
 	UPROPERTY()
-	class UTexture2D* BarFillTexture;
+	TSoftObjectPtr<UTexture2D> BarFillTexture;
 
 	/** player team health bar texture */
 	UPROPERTY()
-	class UTexture2D* PlayerTeamHPTexture;
+	TSoftObjectPtr<UTexture2D> PlayerTeamHPTexture;
 
 	/** enemy team health bar texture */
 	UPROPERTY()
-	class UTexture2D* EnemyTeamHPTexture;
+	TSoftObjectPtr<UTexture2D> EnemyTeamHPTexture;
 
 	/** mouse pointer material (default) */
 	UPROPERTY()
-	class UMaterial* MousePointerNeutral;
+	TSoftObjectPtr<UMaterial> MousePointerNeutral;
 
 	/** mouse pointer material (attack) */
 	UPROPERTY()
-	class UMaterial* MousePointerAttack;
+	TSoftObjectPtr<UMaterial> MousePointerAttack;
 
 	/** Pause button texture */
 	UPROPERTY()
-	UTexture2D* ActionPauseTexture;
+	TSoftObjectPtr<UTexture2D> ActionPauseTexture;
 
 	/** menu button texture */
 	UPROPERTY()
-	UTexture2D* MenuButtonTexture;
+	TSoftObjectPtr<UTexture2D> MenuButtonTexture;
 
 	/** resource texture - gold coin */
 	UPROPERTY()
-	UTexture2D* ResourceTexture;
+	TSoftObjectPtr<UTexture2D> ResourceTexture;
 
 	/** lives texture - barrel */
 	UPROPERTY()
-	UTexture2D* LivesTexture;
+	TSoftObjectPtr<UTexture2D> LivesTexture;
 
 	/** if we are currently drawing black screen */
 	uint8 bBlackScreenActive : 1;
@@ -17,6 +17,7 @@ public class StrategyGame : ModuleRules
 				"Engine",
 				"InputCore",
 				"NavigationSystem",
+				"RenderCore",
 				"AIModule",
 				"GameplayTasks",
 			}
@@ -36,6 +37,18 @@ public class StrategyGame : ModuleRules
 		);
 
 
+		if (Target.bBuildEditor)
+		{
+			// crowd baker
+			PrivateDependencyModuleNames.AddRange(
+				new string[] {
+					"UnrealEd",
+					"MeshDescription",
+					"StaticMeshDescription",
+				}
+			);
+		}
+
 		PrivateIncludePaths.AddRange(
 			new string[] {
 				"StrategyGame/Private/UI/Menu",
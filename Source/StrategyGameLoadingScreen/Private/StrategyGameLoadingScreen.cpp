@@ -24,18 +24,156 @@ struct FStrategyGameLoadingScreenBrush : public FSlateDynamicImageBrush, public
 	}
 };
 
+DEFINE_LOG_CATEGORY_STATIC(LogStrategyLoadingScreen, Log, All);
+
+/** Single warmup stage reported by the game */
+struct FStrategyWarmupStage
+{
+	/** unique name of the stage */
+	FName Name;
+
+	/** text displayed on the loading screen */
+	FText DisplayName;
+
+	/** progress in range [0..1] */
+	float Progress;
+
+	/** time the stage started */
+	double StartTime;
+
+	/** time the stage finished, 0 while running */
+	double EndTime;
+
+	/** @return duration of the stage, or time spent so far if it's still running */
+	double GetDuration(double Now) const
+	{
+		return (EndTime > 0.0 ? EndTime : Now) - StartTime;
+	}
+};
+
+/** Warmup stages reported by the game, read by the loading screen widget on the slate loading thread */
+struct FStrategyWarmupProgress
+{
+	void BeginStage(FName StageName, const FText& DisplayName)
+	{
+		FScopeLock Lock(&CriticalSection);
+		FStrategyWarmupStage* Stage = FindStage(StageName);
+		if (Stage == nullptr)
+		{
+			Stage = &Stages[Stages.AddDefaulted()];
+			Stage->Name = StageName;
+		}
+		Stage->DisplayName = DisplayName;
+		Stage->Progress = 0.0f;
+		Stage->StartTime = FPlatformTime::Seconds();
+		Stage->EndTime = 0.0;
+	}
+
+	void UpdateStage(FName StageName, float Progress)
+	{
+		FScopeLock Lock(&CriticalSection);
+		FStrategyWarmupStage* const Stage = FindStage(StageName);
+		if (Stage && Stage->EndTime == 0.0)
+		{
+			Stage->Progress = FMath::Clamp(Progress, 0.0f, 1.0f);
+		}
+	}
+
+	void EndStage(FName StageName)
+	{
+		FScopeLock Lock(&CriticalSection);
+		FStrategyWarmupStage* const Stage = FindStage(StageName);
+		if (Stage && Stage->EndTime == 0.0)
+		{
+			Stage->Progress = 1.0f;
+			Stage->EndTime = FPlatformTime::Seconds();
+			UE_LOG(LogStrategyLoadingScreen, Log, TEXT("Warmup stage %s finished in %.3f s"), *StageName.ToString(), Stage->GetDuration(Stage->EndTime));
+		}
+	}
+
+	/** Logs timing of every stage in one line (for startup regression tracking) and forgets the stages. */
+	void Flush()
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (Stages.Num() > 0)
+		{
+			const double Now = FPlatformTime::Seconds();
+			double FirstStart = Stages[0].StartTime;
+			double LastEnd = 0.0;
+			FString StageTimes;
+			for (const FStrategyWarmupStage& Stage : Stages)
+			{
+				FirstStart = FMath::Min(FirstStart, Stage.StartTime);
+				LastEnd = FMath::Max(LastEnd, Stage.EndTime > 0.0 ? Stage.EndTime : Now);
+				StageTimes += FString::Printf(TEXT(" %s=%.3f"), *Stage.Name.ToString(), Stage.GetDuration(Now));
+			}
+			UE_LOG(LogStrategyLoadingScreen, Display, TEXT("WarmupTimings: Total=%.3f%s"), LastEnd - FirstStart, *StageTimes);
+		}
+		Stages.Reset();
+	}
+
+	/** @return overall progress of all stages, negative when no stage was reported */
+	float GetProgress() const
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (Stages.Num() == 0)
+		{
+			return -1.0f;
+		}
+		float Progress = 0.0f;
+		for (const FStrategyWarmupStage& Stage : Stages)
+		{
+			Progress += Stage.Progress;
+		}
+		return Progress / Stages.Num();
+	}
+
+	/** @return one line per stage with its progress and timing */
+	FText GetStatusText() const
+	{
+		FScopeLock Lock(&CriticalSection);
+		const double Now = FPlatformTime::Seconds();
+		FString Status;
+		for (const FStrategyWarmupStage& Stage : Stages)
+		{
+			if (!Status.IsEmpty())
+			{
+				Status += LINE_TERMINATOR;
+			}
+			Status += FString::Printf(TEXT("%s  %3d%%  %.2f s"), *Stage.DisplayName.ToString(), FMath::RoundToInt(Stage.Progress * 100.0f), Stage.GetDuration(Now));
+		}
+		return FText::FromString(Status);
+	}
+
+private:
+	FStrategyWarmupStage* FindStage(FName StageName)
+	{
+		return Stages.FindByPredicate([StageName](const FStrategyWarmupStage& Stage) { return Stage.Name == StageName; });
+	}
+
+	mutable FCriticalSection CriticalSection;
+
+	/** stages in the order they were started */
+	TArray<FStrategyWarmupStage> Stages;
+};
+
 class SStrategyLoadingScreen : public SCompoundWidget
 {
 public:
 	SLATE_BEGIN_ARGS(SStrategyLoadingScreen) {}
+
+	/** warmup stages reported by the game, may be null */
+	SLATE_ARGUMENT(TSharedPtr<FStrategyWarmupProgress>, WarmupProgress)
+
 	SLATE_END_ARGS()
 
-	
+
 	void Construct(const FArguments& InArgs)
 	{
 		static const FName LoadingScreenName(TEXT("/Game/UI/MainMenu/StrategyGame_LoadingScreen.StrategyGame_LoadingScreen"));
 
 		LoadingScreenBrush = MakeShareable( new FStrategyGameLoadingScreenBrush( LoadingScreenName, FVector2D(1920,1080) ) );
+		WarmupProgress = InArgs._WarmupProgress;
 
 		ChildSlot
 		[
@@ -61,18 +199,64 @@ public:
 					.Visibility(this, &SStrategyLoadingScreen::GetLoadIndicatorVisibility)
 				]
 			]
+			+SOverlay::Slot()
+			.HAlign(HAlign_Center)
+			.VAlign(VAlign_Bottom)
+			.Padding(FMargin(10.0f, 10.0f, 10.0f, 40.0f))
+			[
+				SNew(SBox)
+				.WidthOverride(600.0f)
+				.Visibility(this, &SStrategyLoadingScreen::GetProgressVisibility)
+				[
+					SNew(SVerticalBox)
+					+SVerticalBox::Slot()
+					.AutoHeight()
+					.HAlign(HAlign_Center)
+					.Padding(FMargin(0.0f, 0.0f, 0.0f, 5.0f))
+					[
+						SNew(STextBlock)
+						.Justification(ETextJustify::Center)
+						.ShadowColorAndOpacity(FLinearColor::Black)
+						.ShadowOffset(FIntPoint(-1,1))
+						.Text(this, &SStrategyLoadingScreen::GetStatusText)
+					]
+					+SVerticalBox::Slot()
+					.AutoHeight()
+					[
+						SNew(SProgressBar)
+						.Percent(this, &SStrategyLoadingScreen::GetProgressPercent)
+					]
+				]
+			]
 		];
 	}
 
 private:
 	EVisibility GetLoadIndicatorVisibility() const
 	{
-		bool Vis =  GetMoviePlayer()->IsLoadingFinished();
 		return GetMoviePlayer()->IsLoadingFinished() ? EVisibility::Collapsed : EVisibility::Visible;
 	}
-	
+
+	EVisibility GetProgressVisibility() const
+	{
+		return (WarmupProgress.IsValid() && WarmupProgress->GetProgress() >= 0.0f) ? EVisibility::HitTestInvisible : EVisibility::Collapsed;
+	}
+
+	FText GetStatusText() const
+	{
+		return WarmupProgress.IsValid() ? WarmupProgress->GetStatusText() : FText::GetEmpty();
+	}
+
+	TOptional<float> GetProgressPercent() const
+	{
+		return WarmupProgress.IsValid() ? FMath::Max(WarmupProgress->GetProgress(), 0.0f) : 0.0f;
+	}
+
 	/** loading screen image brush */
 	TSharedPtr<FSlateDynamicImageBrush> LoadingScreenBrush;
+
+	/** warmup stages reported by the game */
+	TSharedPtr<FStrategyWarmupProgress> WarmupProgress;
 };
 
 class FStrategyGameLoadingScreenModule : public IStrategyGameLoadingScreenModule
@@ -80,15 +264,17 @@ class FStrategyGameLoadingScreenModule : public IStrategyGameLoadingScreenModule
 public:
 	virtual void StartupModule() override
 	{
+		WarmupProgress = MakeShareable(new FStrategyWarmupProgress());
+
 		//force load for cooker reference
 		LoadObject<UObject>(NULL, TEXT("/Game/UI/MainMenu/StrategyGame_LoadingScreen.StrategyGame_LoadingScreen") );
 
 		if (IsMoviePlayerEnabled())
 		{
-			CreateScreen();
+			CreateScreen(false);
 		}
 	}
-	
+
 	virtual bool IsGameModule() const override
 	{
 		return true;
@@ -96,18 +282,50 @@ public:
 
 	virtual void StartInGameLoadingScreen() override
 	{
-		CreateScreen();
+		WarmupProgress->Flush();
+		CreateScreen(true);
+	}
+
+	virtual void StopInGameLoadingScreen() override
+	{
+		WarmupProgress->Flush();
+		if (IsMoviePlayerEnabled() && GetMoviePlayer()->IsMovieCurrentlyPlaying())
+		{
+			GetMoviePlayer()->StopMovie();
+		}
 	}
 
-	virtual void CreateScreen()
+	virtual void BeginWarmupStage(FName StageName, const FText& DisplayName) override
+	{
+		WarmupProgress->BeginStage(StageName, DisplayName);
+	}
+
+	virtual void UpdateWarmupStage(FName StageName, float Progress) override
+	{
+		WarmupProgress->UpdateStage(StageName, Progress);
+	}
+
+	virtual void EndWarmupStage(FName StageName) override
+	{
+		WarmupProgress->EndStage(StageName);
+	}
+
+	virtual void CreateScreen(bool bWaitForGame)
 	{
 		FLoadingScreenAttributes LoadingScreen;
-		LoadingScreen.bAutoCompleteWhenLoadingCompletes = true;
+		LoadingScreen.bAutoCompleteWhenLoadingCompletes = !bWaitForGame;
+		// in game loading keeps the screen up while the game runs its warmup stages, ticking the engine so it can progress
+		LoadingScreen.bWaitForManualStop = bWaitForGame;
+		LoadingScreen.bAllowEngineTick = bWaitForGame;
 		LoadingScreen.MinimumLoadingScreenDisplayTime = 0.f;
-		LoadingScreen.WidgetLoadingScreen = SNew(SStrategyLoadingScreen);
+		LoadingScreen.WidgetLoadingScreen = SNew(SStrategyLoadingScreen)
+			.WarmupProgress(WarmupProgress);
 		GetMoviePlayer()->SetupLoadingScreen(LoadingScreen);
 	}
 
+private:
+	/** warmup stages shared with the loading screen widget */
+	TSharedPtr<FStrategyWarmupProgress> WarmupProgress;
 };
 
 IMPLEMENT_GAME_MODULE(FStrategyGameLoadingScreenModule, StrategyGameLoadingScreen);
@@ -11,4 +11,33 @@ class IStrategyGameLoadingScreenModule : public IModuleInterface
 public:
 	/** Kicks off the loading screen for in game loading (not startup) */
 	virtual void StartInGameLoadingScreen() = 0;
+
+	/**
+	 * Ends the in game loading screen. It stays up after the map has loaded until this is called,
+	 * so the game can finish its own warmup stages behind it. Logs the stage timings.
+	 */
+	virtual void StopInGameLoadingScreen() = 0;
+
+	/**
+	 * Starts a warmup stage shown on the loading screen. Stages may run in parallel. Safe to call from any thread.
+	 *
+	 * @param	StageName	Unique name of the stage, also used in the timing log.
+	 * @param	DisplayName	Text displayed on the loading screen.
+	 */
+	virtual void BeginWarmupStage(FName StageName, const FText& DisplayName) = 0;
+
+	/**
+	 * Updates progress of running warmup stage. Safe to call from any thread.
+	 *
+	 * @param	StageName	Name the stage was started with.
+	 * @param	Progress	Progress in range [0..1].
+	 */
+	virtual void UpdateWarmupStage(FName StageName, float Progress) = 0;
+
+	/**
+	 * Finishes warmup stage and logs its duration. Safe to call from any thread.
+	 *
+	 * @param	StageName	Name the stage was started with.
+	 */
+	virtual void EndWarmupStage(FName StageName) = 0;
 };